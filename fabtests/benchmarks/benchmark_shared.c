@@ -53,6 +53,41 @@ static int inject_size_set;
  */
 static int offset_rma_start = 0;
 
+/* With --lat-hist, each timed iteration of a pingpong test (one round trip)
+ * or each completed window of a bandwidth test is recorded as one sample.
+ * Consecutive samples share a timestamp so that only one clock read is added
+ * per sample.
+ */
+static struct ft_hist lat_hist;
+static uint64_t lat_prev;
+
+static void bench_start(void)
+{
+	ft_start();
+	if (opts.lat_hist) {
+		ft_hist_reset(&lat_hist);
+		lat_prev = ft_gettime_ns();
+	}
+}
+
+static void bench_sample(int i)
+{
+	uint64_t now;
+
+	if (!opts.lat_hist || i < opts.warmup_iterations)
+		return;
+
+	now = ft_gettime_ns();
+	ft_hist_record(&lat_hist, now - lat_prev);
+	lat_prev = now;
+}
+
+static void bench_show_perf(int xfers_per_iter)
+{
+	ft_show_perf(opts.transfer_size, opts.iterations, &start, &end,
+		     xfers_per_iter, opts.lat_hist ? &lat_hist : NULL);
+}
+
 void ft_parse_benchmark_opts(int op, char *optarg)
 {
 	switch (op) {
@@ -111,7 +146,7 @@ int pingpong(void)
 	if (opts.dst_addr) {
 		for (i = 0; i < opts.iterations + opts.warmup_iterations; i++) {
 			if (i == opts.warmup_iterations)
-				ft_start();
+				bench_start();
 
 			if (opts.transfer_size <= inject_size)
 				ret = ft_inject(ep, remote_fi_addr, opts.transfer_size);
@@ -123,11 +158,13 @@ int pingpong(void)
 			ret = ft_rx(ep, opts.transfer_size);
 			if (ret)
 				return ret;
+
+			bench_sample(i);
 		}
 	} else {
 		for (i = 0; i < opts.iterations + opts.warmup_iterations; i++) {
 			if (i == opts.warmup_iterations)
-				ft_start();
+				bench_start();
 
 			ret = ft_rx(ep, opts.transfer_size);
 			if (ret)
@@ -139,15 +176,13 @@ int pingpong(void)
 				ret = ft_tx(ep, remote_fi_addr, opts.transfer_size, &tx_ctx);
 			if (ret)
 				return ret;
+
+			bench_sample(i);
 		}
 	}
 	ft_stop();
 
-	if (opts.machr)
-		show_perf_mr(opts.transfer_size, opts.iterations, &start, &end, 2,
-				opts.argc, opts.argv);
-	else
-		show_perf(NULL, opts.transfer_size, opts.iterations, &start, &end, 2);
+	bench_show_perf(2);
 
 	return 0;
 }
@@ -194,7 +229,7 @@ int pingpong_rma(enum ft_rma_opcodes rma_op, struct fi_rma_iov *remote)
 		for (i = 0; i < opts.iterations + opts.warmup_iterations; i++) {
 
 			if (i == opts.warmup_iterations)
-				ft_start();
+				bench_start();
 
 			if (rma_op == FT_RMA_WRITE)
 				*(tx_buf + opts.transfer_size - 1) = (char)i;
@@ -212,11 +247,13 @@ int pingpong_rma(enum ft_rma_opcodes rma_op, struct fi_rma_iov *remote)
 			ret = ft_rx_rma(i, rma_op, ep, opts.transfer_size);
 			if (ret)
 				return ret;
+
+			bench_sample(i);
 		}
 	} else {
 		for (i = 0; i < opts.iterations + opts.warmup_iterations; i++) {
 			if (i == opts.warmup_iterations)
-				ft_start();
+				bench_start();
 
 			ret = ft_rx_rma(i, rma_op, ep, opts.transfer_size);
 			if (ret)
@@ -234,15 +271,13 @@ int pingpong_rma(enum ft_rma_opcodes rma_op, struct fi_rma_iov *remote)
 						opts.transfer_size, &tx_ctx);
 			if (ret)
 				return ret;
+
+			bench_sample(i);
 		}
 	}
 	ft_stop();
 
-	if (opts.machr)
-		show_perf_mr(opts.transfer_size, opts.iterations, &start, &end, 2,
-				opts.argc, opts.argv);
-	else
-		show_perf(NULL, opts.transfer_size, opts.iterations, &start, &end, 2);
+	bench_show_perf(2);
 
 	return 0;
 }
@@ -334,7 +369,7 @@ int bandwidth(void)
 	if (opts.dst_addr) {
 		for (i = j = 0; i < opts.iterations + opts.warmup_iterations; i++) {
 			if (i == opts.warmup_iterations)
-				ft_start();
+				bench_start();
 
 			if (ft_check_opts(FT_OPT_VERIFY_DATA)) {
 				ret = ft_fill_buf(tx_ctx_arr[j].buf,
@@ -366,16 +401,19 @@ int bandwidth(void)
 				ret = bw_tx_comp();
 				if (ret)
 					return ret;
+				bench_sample(i);
 				j = 0;
 			}
 		}
 		ret = bw_tx_comp();
 		if (ret)
 			return ret;
+		if (j)
+			bench_sample(i);
 	} else {
 		for (i = j = 0; i < opts.iterations + opts.warmup_iterations; i++) {
 			if (i == opts.warmup_iterations)
-				ft_start();
+				bench_start();
 
 			ret = ft_post_rx_buf(ep, opts.transfer_size,
 					     &rx_ctx_arr[j].context,
@@ -388,20 +426,19 @@ int bandwidth(void)
 				ret = bw_rx_comp(j);
 				if (ret)
 					return ret;
+				bench_sample(i);
 				j = 0;
 			}
 		}
 		ret = bw_rx_comp(j);
 		if (ret)
 			return ret;
+		if (j)
+			bench_sample(i);
 	}
 	ft_stop();
 
-	if (opts.machr)
-		show_perf_mr(opts.transfer_size, opts.iterations, &start, &end, 1,
-				opts.argc, opts.argv);
-	else
-		show_perf(NULL, opts.transfer_size, opts.iterations, &start, &end, 1);
+	bench_show_perf(1);
 
 	return 0;
 }
@@ -464,7 +501,7 @@ int bandwidth_rma(enum ft_rma_opcodes rma_op, struct fi_rma_iov *remote)
 			   MAX(ft_tx_prefix_size(), ft_rx_prefix_size());
 	for (i = j = 0; i < opts.iterations + opts.warmup_iterations; i++) {
 		if (i == opts.warmup_iterations)
-			ft_start();
+			bench_start();
 		if (j == 0) {
 			offset = offset_rma_start;
 			if (ft_check_opts(FT_OPT_VERIFY_DATA) && opts.transfer_size > 0) {
@@ -545,6 +582,7 @@ int bandwidth_rma(enum ft_rma_opcodes rma_op, struct fi_rma_iov *remote)
 			ret = bw_rma_comp(rma_op, j);
 			if (ret)
 				return ret;
+			bench_sample(i);
 			j = 0;
 		}
 		offset += opts.transfer_size;
@@ -552,12 +590,10 @@ int bandwidth_rma(enum ft_rma_opcodes rma_op, struct fi_rma_iov *remote)
 	ret = bw_rma_comp(rma_op, j);
 	if (ret)
 		return ret;
+	if (j)
+		bench_sample(i);
 	ft_stop();
 
-	if (opts.machr)
-		show_perf_mr(opts.transfer_size, opts.iterations, &start, &end,	1,
-				opts.argc, opts.argv);
-	else
-		show_perf(NULL, opts.transfer_size, opts.iterations, &start, &end, 1);
+	bench_show_perf(1);
 	return 0;
 }
@@ -3198,34 +3198,122 @@ int64_t get_elapsed(const struct timespec *b, const struct timespec *a,
 	return elapsed / p;
 }
 
-void show_perf(char *name, size_t tsize, int iters, struct timespec *start,
-		struct timespec *end, int xfers_per_iter)
+static int ft_hist_index(uint64_t val)
+{
+	int msb, shift;
+
+	if (val < FT_HIST_SUB_CNT)
+		return (int) val;
+
+	for (msb = FT_HIST_SUB_BITS; msb < 63 && (val >> (msb + 1)); msb++)
+		;
+	shift = msb - FT_HIST_SUB_BITS + 1;
+	return (shift + 1) * FT_HIST_HALF_CNT +
+	       (int) (val >> shift) - FT_HIST_HALF_CNT;
+}
+
+static uint64_t ft_hist_lowest(int idx)
+{
+	int shift;
+
+	if (idx < FT_HIST_SUB_CNT)
+		return idx;
+
+	shift = idx / FT_HIST_HALF_CNT - 1;
+	return (uint64_t) (idx % FT_HIST_HALF_CNT + FT_HIST_HALF_CNT) << shift;
+}
+
+void ft_hist_reset(struct ft_hist *hist)
+{
+	memset(hist, 0, sizeof(*hist));
+	hist->min = UINT64_MAX;
+}
+
+void ft_hist_record(struct ft_hist *hist, uint64_t val)
+{
+	hist->bucket[ft_hist_index(val)]++;
+	hist->cnt++;
+	hist->sum += val;
+	if (val < hist->min)
+		hist->min = val;
+	if (val > hist->max)
+		hist->max = val;
+}
+
+/* Returns the upper bound of the bucket holding the pct'th percentile
+ * sample, clamped to the recorded min/max so that p0 and p100 are exact.
+ */
+uint64_t ft_hist_percentile(const struct ft_hist *hist, double pct)
+{
+	uint64_t rank, seen = 0, val;
+	int i;
+
+	if (!hist->cnt)
+		return 0;
+
+	rank = (uint64_t) (pct / 100.0 * hist->cnt + 0.5);
+	if (rank < 1)
+		rank = 1;
+	if (rank > hist->cnt)
+		rank = hist->cnt;
+
+	for (i = 0; i < FT_HIST_BUCKETS - 1; i++) {
+		seen += hist->bucket[i];
+		if (seen >= rank)
+			break;
+	}
+
+	val = i < FT_HIST_BUCKETS - 1 ? ft_hist_lowest(i + 1) - 1 : hist->max;
+	if (val < hist->min)
+		return hist->min;
+	return val > hist->max ? hist->max : val;
+}
+
+static const struct {
+	const char *name;
+	double pct;
+} ft_hist_pcts[] = {
+	{ "min", 0.0 },
+	{ "p50", 50.0 },
+	{ "p90", 90.0 },
+	{ "p99", 99.0 },
+	{ "p99.9", 99.9 },
+	{ "max", 100.0 },
+};
+
+static double ft_hist_pct_usec(const struct ft_hist *hist, int i)
+{
+	if (!i)
+		return hist->cnt ? hist->min / 1000.0 : 0;
+	return ft_hist_percentile(hist, ft_hist_pcts[i].pct) / 1000.0;
+}
+
+static void ft_show_perf_text(char *name, size_t tsize, int iters,
+			      struct timespec *start, struct timespec *end,
+			      int xfers_per_iter, const struct ft_hist *hist)
 {
 	static int header = 1;
 	char str[FT_STR_LEN];
 	int64_t elapsed = get_elapsed(start, end, MICRO);
 	long long bytes = (long long) iters * tsize * xfers_per_iter;
 	float usec_per_xfer;
+	int i;
 
-	if (name) {
-		if (header) {
-			printf("%-50s%-8s%-8s%-8s%8s %10s%13s%13s\n",
-					"name", "bytes", "iters",
-					"total", "time", "MB/sec",
-					"usec/xfer", "Mxfers/sec");
-			header = 0;
-		}
+	if (header) {
+		if (name)
+			printf("%-50s", "name");
+		printf("%-8s%-8s%-8s%8s %10s%13s%13s",
+				"bytes", "iters", "total",
+				"time", "MB/sec", "usec/xfer",
+				"Mxfers/sec");
+		for (i = 0; hist && i < (int) ARRAY_SIZE(ft_hist_pcts); i++)
+			printf("%10s", ft_hist_pcts[i].name);
+		printf("\n");
+		header = 0;
+	}
 
+	if (name)
 		printf("%-50s", name);
-	} else {
-		if (header) {
-			printf("%-8s%-8s%-8s%8s %10s%13s%13s\n",
-					"bytes", "iters", "total",
-					"time", "MB/sec", "usec/xfer",
-					"Mxfers/sec");
-			header = 0;
-		}
-	}
 
 	printf("%-8s", size_str(str, tsize));
 
@@ -3234,13 +3322,23 @@ void show_perf(char *name, size_t tsize, int iters, struct timespec *start,
 	printf("%-8s", size_str(str, bytes));
 
 	usec_per_xfer = ((float)elapsed / iters / xfers_per_iter);
-	printf("%8.2fs%10.2f%11.2f%11.2f\n",
+	printf("%8.2fs%10.2f%11.2f%11.2f",
 		elapsed / 1000000.0, bytes / (1.0 * elapsed),
 		usec_per_xfer, 1.0/usec_per_xfer);
+	for (i = 0; hist && i < (int) ARRAY_SIZE(ft_hist_pcts); i++)
+		printf("%10.2f", ft_hist_pct_usec(hist, i));
+	printf("\n");
 }
 
-void show_perf_mr(size_t tsize, int iters, struct timespec *start,
-		  struct timespec *end, int xfers_per_iter, int argc, char *argv[])
+void show_perf(char *name, size_t tsize, int iters, struct timespec *start,
+		struct timespec *end, int xfers_per_iter)
+{
+	ft_show_perf_text(name, tsize, iters, start, end, xfers_per_iter, NULL);
+}
+
+static void ft_show_perf_mr(size_t tsize, int iters, struct timespec *start,
+			    struct timespec *end, int xfers_per_iter,
+			    int argc, char *argv[], const struct ft_hist *hist)
 {
 	static int header = 1;
 	int64_t elapsed = get_elapsed(start, end, MICRO);
@@ -3268,9 +3366,116 @@ void show_perf_mr(size_t tsize, int iters, struct timespec *start,
 	printf("MB/sec: %f, ", (total) / (1.0 * elapsed));
 	printf("usec/xfer: %f, ", usec_per_xfer);
 	printf("Mxfers/sec: %f", 1.0/usec_per_xfer);
+	if (hist) {
+		printf(", samples: %" PRIu64, hist->cnt);
+		for (i = 0; i < (int) ARRAY_SIZE(ft_hist_pcts); i++)
+			printf(", usec_%s: %f", ft_hist_pcts[i].name,
+			       ft_hist_pct_usec(hist, i));
+	}
 	printf(" }\n");
 }
 
+void show_perf_mr(size_t tsize, int iters, struct timespec *start,
+		  struct timespec *end, int xfers_per_iter, int argc, char *argv[])
+{
+	ft_show_perf_mr(tsize, iters, start, end, xfers_per_iter, argc, argv,
+			NULL);
+}
+
+/* One JSON object per line (JSON Lines), so that results can be streamed
+ * as each transfer size completes.
+ */
+static void ft_show_perf_json(size_t tsize, int iters, struct timespec *start,
+			      struct timespec *end, int xfers_per_iter,
+			      const struct ft_hist *hist)
+{
+	int64_t elapsed = get_elapsed(start, end, MICRO);
+	long long total = (long long) iters * tsize * xfers_per_iter;
+	double usec_per_xfer = (double) elapsed / iters / xfers_per_iter;
+	const char *test = opts.argc ? opts.argv[0] : test_name;
+	const char *slash;
+	int i;
+
+	slash = strrchr(test, '/');
+	if (slash)
+		test = slash + 1;
+
+	printf("{\"test\": \"%s\", \"provider\": \"%s\", ", test,
+	       fi && fi->fabric_attr->prov_name ?
+	       fi->fabric_attr->prov_name : "");
+	printf("\"xfer_size\": %zu, \"iterations\": %d, \"total\": %lld, ",
+	       tsize, iters, total);
+	printf("\"time\": %f, \"MB/sec\": %f, \"usec/xfer\": %f, "
+	       "\"Mxfers/sec\": %f", elapsed / 1000000.0,
+	       total / (1.0 * elapsed), usec_per_xfer, 1.0 / usec_per_xfer);
+	if (hist) {
+		printf(", \"latency_usec\": {\"samples\": %" PRIu64, hist->cnt);
+		for (i = 0; i < (int) ARRAY_SIZE(ft_hist_pcts); i++)
+			printf(", \"%s\": %f", ft_hist_pcts[i].name,
+			       ft_hist_pct_usec(hist, i));
+		printf("}");
+	}
+	printf("}\n");
+}
+
+static void ft_show_perf_csv(size_t tsize, int iters, struct timespec *start,
+			     struct timespec *end, int xfers_per_iter,
+			     const struct ft_hist *hist)
+{
+	static int header = 1;
+	int64_t elapsed = get_elapsed(start, end, MICRO);
+	long long total = (long long) iters * tsize * xfers_per_iter;
+	double usec_per_xfer = (double) elapsed / iters / xfers_per_iter;
+	int i;
+
+	if (header) {
+		printf("xfer_size,iterations,total,time,MB/sec,usec/xfer,"
+		       "Mxfers/sec");
+		if (hist) {
+			printf(",samples");
+			for (i = 0; i < (int) ARRAY_SIZE(ft_hist_pcts); i++)
+				printf(",usec_%s", ft_hist_pcts[i].name);
+		}
+		printf("\n");
+		header = 0;
+	}
+
+	printf("%zu,%d,%lld,%f,%f,%f,%f", tsize, iters, total,
+	       elapsed / 1000000.0, total / (1.0 * elapsed), usec_per_xfer,
+	       1.0 / usec_per_xfer);
+	if (hist) {
+		printf(",%" PRIu64, hist->cnt);
+		for (i = 0; i < (int) ARRAY_SIZE(ft_hist_pcts); i++)
+			printf(",%f", ft_hist_pct_usec(hist, i));
+	}
+	printf("\n");
+}
+
+/* Report results in the format selected by -m / --perf-format.  hist is
+ * optional and adds per-sample latency percentiles to the output.
+ */
+void ft_show_perf(size_t tsize, int iters, struct timespec *start,
+		  struct timespec *end, int xfers_per_iter,
+		  const struct ft_hist *hist)
+{
+	switch (opts.perf_format) {
+	case FT_PERF_FMT_JSON:
+		ft_show_perf_json(tsize, iters, start, end, xfers_per_iter, hist);
+		break;
+	case FT_PERF_FMT_CSV:
+		ft_show_perf_csv(tsize, iters, start, end, xfers_per_iter, hist);
+		break;
+	default:
+		if (opts.machr)
+			ft_show_perf_mr(tsize, iters, start, end, xfers_per_iter,
+					opts.argc, opts.argv, hist);
+		else
+			ft_show_perf_text(NULL, tsize, iters, start, end,
+					  xfers_per_iter, hist);
+		break;
+	}
+}
+
 void ft_addr_usage()
 {
 	FT_PRINT_OPTS_USAGE("-B <src_port>", "non default source port number");
@@ -4244,6 +4449,10 @@ void ft_longopts_usage()
 		"Run tests with FI_MORE");
 	FT_PRINT_OPTS_USAGE("--threading",
 		"threading model: safe|completion|domain (default:domain)");
+	FT_PRINT_OPTS_USAGE("--lat-hist",
+		"record per-iteration latency and report percentiles");
+	FT_PRINT_OPTS_USAGE("--perf-format <format>",
+		"performance output format: text|json|csv (default:text)");
 }
 
 int debug_assert;
@@ -4258,6 +4467,8 @@ struct option long_opts[] = {
 	{"max-msg-size", required_argument, NULL, LONG_OPT_MAX_MSG_SIZE},
 	{"use-fi-more", no_argument, NULL, LONG_OPT_USE_FI_MORE},
 	{"threading", required_argument, NULL, LONG_OPT_THREADING},
+	{"lat-hist", no_argument, NULL, LONG_OPT_LAT_HIST},
+	{"perf-format", required_argument, NULL, LONG_OPT_PERF_FORMAT},
 	{NULL, 0, NULL, 0},
 };
 
@@ -4289,8 +4500,24 @@ static int ft_parse_threading_string(char* threading_str)
 	return ret;
 }
 
+static int ft_parse_perf_format_string(char *format_str)
+{
+	int ret = -1;
+
+	if (!strcasecmp("text", format_str))
+		ret = FT_PERF_FMT_TEXT;
+	else if (!strcasecmp("json", format_str))
+		ret = FT_PERF_FMT_JSON;
+	else if (!strcasecmp("csv", format_str))
+		ret = FT_PERF_FMT_CSV;
+
+	return ret;
+}
+
 int ft_parse_long_opts(int op, char *optarg)
 {
+	int ret;
+
 	switch (op) {
 	case LONG_OPT_PIN_CORE:
 		return ft_parse_pin_core_opt(optarg);
@@ -4318,6 +4545,15 @@ int ft_parse_long_opts(int op, char *optarg)
 	case LONG_OPT_THREADING:
 		opts.threading = ft_parse_threading_string(optarg);
 		return 0;
+	case LONG_OPT_LAT_HIST:
+		opts.lat_hist = 1;
+		return 0;
+	case LONG_OPT_PERF_FORMAT:
+		ret = ft_parse_perf_format_string(optarg);
+		if (ret == -1)
+			return EXIT_FAILURE;
+		opts.perf_format = ret;
+		return 0;
 	default:
 		return EXIT_FAILURE;
 	}
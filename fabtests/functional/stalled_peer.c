@@ -0,0 +1,366 @@
+/*
+ * Copyright (c) 2026 Intel Corporation.  All rights reserved.
+ *
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Two connections share a domain.  The client floods the first one while
+ * the server has no receive posted on it, then runs a ping-pong over the
+ * second one.  The ping-pong must complete while the first connection is
+ * stalled.  The server then posts receives for the stalled data.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#include <rdma/fabric.h>
+#include <rdma/fi_errno.h>
+#include <rdma/fi_endpoint.h>
+#include <rdma/fi_cm.h>
+
+#include "shared.h"
+
+static struct fid_ep *stall_ep;
+static struct fid_cq *stall_txcq, *stall_rxcq;
+static struct fid_mr *stall_mr;
+static void *stall_desc;
+static char *stall_buf;
+static struct fi_context *stall_ctx;
+static int stall_cnt = 256;
+static int stall_posted, stall_done;
+
+static int stall_alloc_res(void)
+{
+	struct fi_cq_attr attr = {
+		.format = FI_CQ_FORMAT_CONTEXT,
+		.wait_obj = FI_WAIT_NONE,
+	};
+	int ret, i;
+
+	stall_buf = calloc(stall_cnt, opts.transfer_size);
+	stall_ctx = calloc(stall_cnt, sizeof(*stall_ctx));
+	if (!stall_buf || !stall_ctx)
+		return -FI_ENOMEM;
+
+	ret = ft_reg_mr(fi, stall_buf, stall_cnt * opts.transfer_size,
+			ft_info_to_mr_access(fi), FT_MR_KEY + 1,
+			FI_HMEM_SYSTEM, 0, &stall_mr, &stall_desc);
+	if (ret)
+		return ret;
+
+	if (opts.dst_addr && ft_check_opts(FT_OPT_VERIFY_DATA)) {
+		for (i = 0; i < stall_cnt; i++) {
+			ret = ft_fill_buf(stall_buf + i * opts.transfer_size,
+					  opts.transfer_size);
+			if (ret)
+				return ret;
+		}
+	}
+
+	attr.size = stall_cnt;
+	ret = fi_cq_open(domain, &attr, &stall_txcq, NULL);
+	if (ret) {
+		FT_PRINTERR("fi_cq_open", ret);
+		return ret;
+	}
+
+	ret = fi_cq_open(domain, &attr, &stall_rxcq, NULL);
+	if (ret) {
+		FT_PRINTERR("fi_cq_open", ret);
+		return ret;
+	}
+	return 0;
+}
+
+static void stall_free_res(void)
+{
+	FT_CLOSE_FID(stall_ep);
+	FT_CLOSE_FID(stall_mr);
+	FT_CLOSE_FID(stall_txcq);
+	FT_CLOSE_FID(stall_rxcq);
+	free(stall_ctx);
+	free(stall_buf);
+}
+
+static int stall_enable_ep(struct fi_info *info)
+{
+	int ret;
+
+	ret = fi_endpoint(domain, info, &stall_ep, NULL);
+	if (ret) {
+		FT_PRINTERR("fi_endpoint", ret);
+		return ret;
+	}
+
+	FT_EP_BIND(stall_ep, eq, 0);
+	FT_EP_BIND(stall_ep, stall_txcq, FI_TRANSMIT);
+	FT_EP_BIND(stall_ep, stall_rxcq, FI_RECV);
+
+	ret = fi_enable(stall_ep);
+	if (ret) {
+		FT_PRINTERR("fi_enable", ret);
+		return ret;
+	}
+	return 0;
+}
+
+static int stall_connect(void)
+{
+	struct fi_info *info;
+	int ret;
+
+	if (opts.dst_addr) {
+		ret = stall_enable_ep(fi);
+		if (ret)
+			return ret;
+
+		return ft_connect_ep(stall_ep, eq, fi->dest_addr);
+	}
+
+	ret = ft_retrieve_conn_req(eq, &info);
+	if (ret)
+		return ret;
+
+	ret = stall_enable_ep(info);
+	if (!ret)
+		ret = ft_accept_connection(stall_ep, eq);
+	if (ret)
+		fi_reject(pep, info->handle, NULL, 0);
+
+	fi_freeinfo(info);
+	return ret;
+}
+
+static int stall_read_cq(void)
+{
+	struct fid_cq *cq;
+	struct fi_cq_entry comp;
+	int ret;
+
+	cq = opts.dst_addr ? stall_txcq : stall_rxcq;
+	ret = fi_cq_read(cq, &comp, 1);
+	if (ret > 0) {
+		stall_done++;
+		return 0;
+	}
+
+	if (ret == -FI_EAVAIL)
+		return ft_cq_readerr(cq);
+
+	return ret == -FI_EAGAIN ? 0 : ret;
+}
+
+/* Posts until the provider pushes back, unless wait is set */
+static int stall_post(bool wait)
+{
+	char *msg;
+	int ret;
+
+	while (stall_posted < stall_cnt) {
+		msg = stall_buf + stall_posted * opts.transfer_size;
+		if (opts.dst_addr) {
+			ret = fi_send(stall_ep, msg, opts.transfer_size,
+				      stall_desc, 0, &stall_ctx[stall_posted]);
+		} else {
+			ret = fi_recv(stall_ep, msg, opts.transfer_size,
+				      stall_desc, 0, &stall_ctx[stall_posted]);
+		}
+
+		if (!ret) {
+			stall_posted++;
+		} else if (ret == -FI_EAGAIN) {
+			if (!wait)
+				return 0;
+
+			ret = stall_read_cq();
+			if (ret)
+				return ret;
+		} else {
+			FT_PRINTERR(opts.dst_addr ? "fi_send" : "fi_recv", ret);
+			return ret;
+		}
+	}
+	return 0;
+}
+
+static int stall_drain(void)
+{
+	int ret, i;
+
+	ret = stall_post(true);
+	if (ret)
+		return ret;
+
+	while (stall_done < stall_cnt) {
+		ret = stall_read_cq();
+		if (ret)
+			return ret;
+	}
+
+	if (!opts.dst_addr && ft_check_opts(FT_OPT_VERIFY_DATA)) {
+		for (i = 0; i < stall_cnt; i++) {
+			ret = ft_check_buf(stall_buf + i * opts.transfer_size,
+					   opts.transfer_size);
+			if (ret)
+				return ret;
+		}
+		printf("Data check OK\n");
+	}
+	return 0;
+}
+
+static int run_active(void)
+{
+	int ret, i;
+
+	for (i = 0; i < opts.iterations; i++) {
+		if (opts.dst_addr) {
+			ret = ft_tx(ep, remote_fi_addr, opts.transfer_size,
+				    &tx_ctx);
+			if (ret)
+				return ret;
+
+			ret = ft_rx(ep, opts.transfer_size);
+		} else {
+			ret = ft_rx(ep, opts.transfer_size);
+			if (ret)
+				return ret;
+
+			ret = ft_tx(ep, remote_fi_addr, opts.transfer_size,
+				    &tx_ctx);
+		}
+		if (ret)
+			return ret;
+	}
+	return 0;
+}
+
+static int run_test(void)
+{
+	int ret;
+
+	ret = ft_init_fabric_cm();
+	if (ret)
+		return ret;
+
+	ret = stall_alloc_res();
+	if (ret)
+		goto out;
+
+	ret = stall_connect();
+	if (ret)
+		goto out;
+
+	if (opts.dst_addr) {
+		ret = stall_post(false);
+		if (ret)
+			goto out;
+		printf("Posted %d of %d sends to the stalled peer\n",
+		       stall_posted, stall_cnt);
+	}
+
+	ret = run_active();
+	if (ret)
+		goto out;
+	printf("PASSED %d iterations next to a stalled peer\n",
+	       opts.iterations);
+
+	ret = stall_drain();
+	if (ret)
+		goto out;
+	printf("PASSED %d messages to the stalled peer\n", stall_cnt);
+
+	ret = ft_finalize();
+out:
+	stall_free_res();
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	int op;
+	int ret;
+
+	opts = INIT_OPTS;
+	opts.iterations = 100;
+	opts.transfer_size = 16384;
+	opts.options |= FT_OPT_SIZE;
+
+	hints = fi_allocinfo();
+	if (!hints)
+		return EXIT_FAILURE;
+
+	while ((op = getopt(argc, argv, "c:vh" CS_OPTS INFO_OPTS)) != -1) {
+		switch (op) {
+		default:
+			ft_parsecsopts(op, optarg, &opts);
+			ft_parse_addr_opts(op, optarg, &opts);
+			ft_parseinfo(op, optarg, hints, &opts);
+			break;
+		case 'c':
+			stall_cnt = atoi(optarg);
+			break;
+		case 'v':
+			opts.options |= FT_OPT_VERIFY_DATA;
+			break;
+		case '?':
+		case 'h':
+			ft_csusage(argv[0],
+				   "Transfers next to a connection that is not "
+				   "receiving.");
+			FT_PRINT_OPTS_USAGE("-c <int>",
+				"number of messages sent to the stalled peer "
+				"(def 256)");
+			FT_PRINT_OPTS_USAGE("-v", "Enable data verification");
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (optind < argc)
+		opts.dst_addr = argv[optind];
+
+	if (stall_cnt <= 0) {
+		FT_ERR("invalid message count %d", stall_cnt);
+		return EXIT_FAILURE;
+	}
+
+	hints->ep_attr->type = FI_EP_MSG;
+	hints->caps = FI_MSG;
+	hints->mode = FI_CONTEXT;
+	hints->domain_attr->mr_mode = opts.mr_mode;
+	hints->addr_format = opts.address_format;
+
+	ret = run_test();
+
+	ft_free_res();
+	return ft_exit_code(ret);
+}
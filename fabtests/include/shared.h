@@ -173,6 +173,30 @@ enum op_state {
 	OP_PENDING
 };
 
+enum ft_perf_format {
+	FT_PERF_FMT_TEXT,
+	FT_PERF_FMT_JSON,
+	FT_PERF_FMT_CSV,
+};
+
+/* Log-linear latency histogram.  Values below FT_HIST_SUB_CNT are counted
+ * exactly; above that, every power of two is split into FT_HIST_HALF_CNT
+ * linear buckets, bounding the relative error of a reported percentile to
+ * 1 / FT_HIST_HALF_CNT (~6%) over the full 64-bit range.
+ */
+#define FT_HIST_SUB_BITS	5
+#define FT_HIST_SUB_CNT		(1 << FT_HIST_SUB_BITS)
+#define FT_HIST_HALF_CNT	(FT_HIST_SUB_CNT >> 1)
+#define FT_HIST_BUCKETS		((64 - FT_HIST_SUB_BITS + 2) * FT_HIST_HALF_CNT)
+
+struct ft_hist {
+	uint64_t cnt;
+	uint64_t min;
+	uint64_t max;
+	uint64_t sum;
+	uint64_t bucket[FT_HIST_BUCKETS];
+};
+
 struct ft_context {
 	char *buf;
 	void *desc;
@@ -202,6 +226,8 @@ struct ft_opts {
 	int options;
 	enum ft_comp_method comp_method;
 	int machr;
+	int lat_hist;
+	enum ft_perf_format perf_format;
 	enum ft_rma_opcodes rma_op;
 	enum ft_cqdata_opcodes cqdata_op;
 	char *oob_port;
@@ -637,6 +663,13 @@ void show_perf(char *name, size_t tsize, int iters, struct timespec *start,
 		struct timespec *end, int xfers_per_iter);
 void show_perf_mr(size_t tsize, int iters, struct timespec *start,
 		struct timespec *end, int xfers_per_iter, int argc, char *argv[]);
+void ft_show_perf(size_t tsize, int iters, struct timespec *start,
+		  struct timespec *end, int xfers_per_iter,
+		  const struct ft_hist *hist);
+
+void ft_hist_reset(struct ft_hist *hist);
+void ft_hist_record(struct ft_hist *hist, uint64_t val);
+uint64_t ft_hist_percentile(const struct ft_hist *hist, double pct);
 void ft_parse_opts_range(char *optarg);
 int ft_send_recv_greeting(struct fid_ep *ep);
 int ft_send_greeting(struct fid_ep *ep);
@@ -664,6 +697,8 @@ enum {
 	LONG_OPT_MAX_MSG_SIZE,
 	LONG_OPT_USE_FI_MORE,
 	LONG_OPT_THREADING,
+	LONG_OPT_LAT_HIST,
+	LONG_OPT_PERF_FORMAT,
 };
 
 extern int debug_assert;
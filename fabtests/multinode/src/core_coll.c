@@ -276,6 +276,78 @@ static int sum_all_reduce_test_run(enum fi_collective_op coll_op, enum fi_op op,
 	return -FI_ENOEQ;
 }
 
+/*
+ * Large enough to select the bandwidth optimal allreduce algorithms, and not
+ * a multiple of the member count so that the blocks are uneven.
+ */
+#define LARGE_ALLREDUCE_COUNT (64 * 1024 + 3)
+
+static int sum_all_reduce_large_test_run(enum fi_collective_op coll_op,
+		enum fi_op op, enum fi_datatype datatype)
+{
+	uint64_t done_flag;
+	uint64_t *data, *result;
+	uint64_t expect_result;
+	size_t count = LARGE_ALLREDUCE_COUNT;
+	size_t num_participants = 0;
+	uint64_t rank_sum = 0;
+	uint64_t i;
+	int err;
+
+	assert(coll_op == FI_ALLREDUCE);
+	assert(op == FI_SUM);
+	assert(datatype == FI_UINT64);
+
+	if (!is_my_rank_participating())
+		return FI_SUCCESS;
+
+	for (i = av_set_attr.start_addr;
+	     i <= av_set_attr.end_addr;
+	     i += av_set_attr.stride) {
+		rank_sum += i;
+		num_participants++;
+	}
+
+	data = malloc(count * sizeof(*data));
+	result = malloc(count * sizeof(*result));
+	if (!data || !result) {
+		err = -FI_ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < count; i++) {
+		data[i] = pm_job.my_rank + i;
+		result[i] = 0;
+	}
+
+	coll_addr = fi_mc_addr(coll_mc);
+	err = fi_allreduce(ep, data, count, NULL, result, NULL, coll_addr,
+		FI_UINT64, FI_SUM, 0, &done_flag);
+	if (err) {
+		FT_PRINTERR("collective allreduce failed - fi_allreduce", err);
+		goto out;
+	}
+
+	err = wait_for_comp(&done_flag);
+	if (err)
+		goto out;
+
+	for (i = 0; i < count; i++) {
+		expect_result = rank_sum + i * num_participants;
+		if (result[i] != expect_result) {
+			FT_DEBUG("allreduce failed at %ld; expect: %ld, "
+				 "actual: %ld", i, expect_result, result[i]);
+			err = -FI_ENOEQ;
+			goto out;
+		}
+	}
+
+out:
+	free(data);
+	free(result);
+	return err;
+}
+
 static int all_gather_test_run(enum fi_collective_op coll_op, enum fi_op op,
 		enum fi_datatype datatype)
 {
@@ -450,6 +522,290 @@ out:
 	return err;
 }
 
+static uint64_t alltoall_value(uint64_t src, uint64_t dst, uint64_t idx)
+{
+	return (src << 40) | (dst << 20) | idx;
+}
+
+static int alltoall_test_common(size_t count)
+{
+	uint64_t done_flag;
+	uint64_t *data, *result;
+	uint64_t i, j, expect;
+	size_t total = pm_job.num_ranks * count;
+	int err;
+
+	data = malloc(total * sizeof(*data));
+	result = calloc(total, sizeof(*result));
+	if (!data || !result) {
+		err = -FI_ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < pm_job.num_ranks; i++) {
+		for (j = 0; j < count; j++)
+			data[i * count + j] = alltoall_value(pm_job.my_rank,
+							     i, j);
+	}
+
+	coll_addr = fi_mc_addr(coll_mc);
+	err = fi_alltoall(ep, data, count, NULL, result, NULL, coll_addr,
+			  FI_UINT64, 0, &done_flag);
+	if (err) {
+		FT_PRINTERR("collective alltoall failed - fi_alltoall", err);
+		goto out;
+	}
+
+	err = wait_for_comp(&done_flag);
+	if (err)
+		goto out;
+
+	for (i = 0; i < pm_job.num_ranks; i++) {
+		for (j = 0; j < count; j++) {
+			expect = alltoall_value(i, pm_job.my_rank, j);
+			if (result[i * count + j] != expect) {
+				FT_DEBUG("alltoall failed; expect: %ld, "
+					 "actual: %ld\n", expect,
+					 result[i * count + j]);
+				err = -FI_ENOEQ;
+				goto out;
+			}
+		}
+	}
+
+out:
+	free(data);
+	free(result);
+	return err;
+}
+
+static int alltoall_test_run(enum fi_collective_op coll_op, enum fi_op op,
+		enum fi_datatype datatype)
+{
+	assert(coll_op == FI_ALLTOALL);
+	assert(datatype == FI_UINT64);
+
+	return alltoall_test_common(1);
+}
+
+static int alltoall_large_test_run(enum fi_collective_op coll_op,
+		enum fi_op op, enum fi_datatype datatype)
+{
+	assert(coll_op == FI_ALLTOALL);
+	assert(datatype == FI_UINT64);
+
+	return alltoall_test_common(1031);
+}
+
+static int reduce_scatter_test_common(size_t count)
+{
+	uint64_t done_flag;
+	uint64_t *data, *result;
+	uint64_t i, expect, rank_sum = 0;
+	size_t total = pm_job.num_ranks * count;
+	int err;
+
+	data = malloc(total * sizeof(*data));
+	result = calloc(count, sizeof(*result));
+	if (!data || !result) {
+		err = -FI_ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < total; i++)
+		data[i] = pm_job.my_rank + i;
+
+	for (i = 0; i < pm_job.num_ranks; i++)
+		rank_sum += i;
+
+	coll_addr = fi_mc_addr(coll_mc);
+	err = fi_reduce_scatter(ep, data, count, NULL, result, NULL,
+				coll_addr, FI_UINT64, FI_SUM, 0, &done_flag);
+	if (err) {
+		FT_PRINTERR("collective reduce_scatter failed - "
+			    "fi_reduce_scatter", err);
+		goto out;
+	}
+
+	err = wait_for_comp(&done_flag);
+	if (err)
+		goto out;
+
+	for (i = 0; i < count; i++) {
+		expect = rank_sum + pm_job.num_ranks *
+			 (pm_job.my_rank * count + i);
+		if (result[i] != expect) {
+			FT_DEBUG("reduce_scatter failed; expect: %ld, "
+				 "actual: %ld\n", expect, result[i]);
+			err = -FI_ENOEQ;
+			goto out;
+		}
+	}
+
+out:
+	free(data);
+	free(result);
+	return err;
+}
+
+static int sum_reduce_scatter_test_run(enum fi_collective_op coll_op,
+		enum fi_op op, enum fi_datatype datatype)
+{
+	assert(coll_op == FI_REDUCE_SCATTER);
+	assert(op == FI_SUM);
+	assert(datatype == FI_UINT64);
+
+	return reduce_scatter_test_common(3);
+}
+
+static int sum_reduce_scatter_large_test_run(enum fi_collective_op coll_op,
+		enum fi_op op, enum fi_datatype datatype)
+{
+	assert(coll_op == FI_REDUCE_SCATTER);
+	assert(op == FI_SUM);
+	assert(datatype == FI_UINT64);
+
+	return reduce_scatter_test_common(4099);
+}
+
+static int reduce_test_common(size_t count)
+{
+	uint64_t done_flag;
+	uint64_t *data, *result;
+	uint64_t i, expect, rank_sum = 0;
+	fi_addr_t root = pm_job.num_ranks - 1;
+	int err;
+
+	data = malloc(count * sizeof(*data));
+	result = calloc(count, sizeof(*result));
+	if (!data || !result) {
+		err = -FI_ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < count; i++)
+		data[i] = pm_job.my_rank + i;
+
+	for (i = 0; i < pm_job.num_ranks; i++)
+		rank_sum += i;
+
+	coll_addr = fi_mc_addr(coll_mc);
+	err = fi_reduce(ep, data, count, NULL,
+			pm_job.my_rank == root ? result : NULL, NULL,
+			coll_addr, root, FI_UINT64, FI_SUM, 0, &done_flag);
+	if (err) {
+		FT_PRINTERR("collective reduce failed - fi_reduce", err);
+		goto out;
+	}
+
+	err = wait_for_comp(&done_flag);
+	if (err || pm_job.my_rank != root)
+		goto out;
+
+	for (i = 0; i < count; i++) {
+		expect = rank_sum + pm_job.num_ranks * i;
+		if (result[i] != expect) {
+			FT_DEBUG("reduce failed; expect: %ld, actual: %ld\n",
+				 expect, result[i]);
+			err = -FI_ENOEQ;
+			goto out;
+		}
+	}
+
+out:
+	free(data);
+	free(result);
+	return err;
+}
+
+static int sum_reduce_test_run(enum fi_collective_op coll_op, enum fi_op op,
+		enum fi_datatype datatype)
+{
+	assert(coll_op == FI_REDUCE);
+	assert(op == FI_SUM);
+	assert(datatype == FI_UINT64);
+
+	return reduce_test_common(1);
+}
+
+static int sum_reduce_large_test_run(enum fi_collective_op coll_op,
+		enum fi_op op, enum fi_datatype datatype)
+{
+	assert(coll_op == FI_REDUCE);
+	assert(op == FI_SUM);
+	assert(datatype == FI_UINT64);
+
+	return reduce_test_common(LARGE_ALLREDUCE_COUNT);
+}
+
+static int gather_test_common(size_t count)
+{
+	uint64_t done_flag;
+	uint64_t *data, *result;
+	uint64_t i, j, expect;
+	fi_addr_t root = pm_job.num_ranks - 1;
+	int err;
+
+	data = malloc(count * sizeof(*data));
+	result = calloc(pm_job.num_ranks * count, sizeof(*result));
+	if (!data || !result) {
+		err = -FI_ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < count; i++)
+		data[i] = (pm_job.my_rank << 32) | i;
+
+	coll_addr = fi_mc_addr(coll_mc);
+	err = fi_gather(ep, data, count, NULL,
+			pm_job.my_rank == root ? result : NULL, NULL,
+			coll_addr, root, FI_UINT64, 0, &done_flag);
+	if (err) {
+		FT_PRINTERR("collective gather failed - fi_gather", err);
+		goto out;
+	}
+
+	err = wait_for_comp(&done_flag);
+	if (err || pm_job.my_rank != root)
+		goto out;
+
+	for (i = 0; i < pm_job.num_ranks; i++) {
+		for (j = 0; j < count; j++) {
+			expect = (i << 32) | j;
+			if (result[i * count + j] != expect) {
+				FT_DEBUG("gather failed; expect: %ld, "
+					 "actual: %ld\n", expect,
+					 result[i * count + j]);
+				err = -FI_ENOEQ;
+				goto out;
+			}
+		}
+	}
+
+out:
+	free(data);
+	free(result);
+	return err;
+}
+
+static int gather_test_run(enum fi_collective_op coll_op, enum fi_op op,
+		enum fi_datatype datatype)
+{
+	assert(coll_op == FI_GATHER);
+	assert(datatype == FI_UINT64);
+
+	return gather_test_common(1);
+}
+
+static int gather_large_test_run(enum fi_collective_op coll_op,
+		enum fi_op op, enum fi_datatype datatype)
+{
+	assert(coll_op == FI_GATHER);
+	assert(datatype == FI_UINT64);
+
+	return gather_test_common(2048);
+}
+
 struct coll_test tests[] = {
 	{
 		.name = "join_test",
@@ -487,6 +843,24 @@ struct coll_test tests[] = {
 		.op = FI_SUM,
 		.datatype = FI_UINT64,
 	},
+	{
+		.name = "sum_all_reduce_large_test",
+		.setup = coll_setup,
+		.run = sum_all_reduce_large_test_run,
+		.teardown = coll_teardown,
+		.coll_op = FI_ALLREDUCE,
+		.op = FI_SUM,
+		.datatype = FI_UINT64,
+	},
+	{
+		.name = "sum_all_reduce_large_w_stride_test",
+		.setup = coll_setup_w_stride,
+		.run = sum_all_reduce_large_test_run,
+		.teardown = coll_teardown,
+		.coll_op = FI_ALLREDUCE,
+		.op = FI_SUM,
+		.datatype = FI_UINT64,
+	},
 	{
 		.name = "all_gather_test",
 		.setup = coll_setup,
@@ -514,6 +888,78 @@ struct coll_test tests[] = {
 		.op = FI_NOOP,
 		.datatype = FI_UINT64
 	},
+	{
+		.name = "alltoall_test",
+		.setup = coll_setup,
+		.run = alltoall_test_run,
+		.teardown = coll_teardown,
+		.coll_op = FI_ALLTOALL,
+		.op = FI_NOOP,
+		.datatype = FI_UINT64,
+	},
+	{
+		.name = "alltoall_large_test",
+		.setup = coll_setup,
+		.run = alltoall_large_test_run,
+		.teardown = coll_teardown,
+		.coll_op = FI_ALLTOALL,
+		.op = FI_NOOP,
+		.datatype = FI_UINT64,
+	},
+	{
+		.name = "sum_reduce_scatter_test",
+		.setup = coll_setup,
+		.run = sum_reduce_scatter_test_run,
+		.teardown = coll_teardown,
+		.coll_op = FI_REDUCE_SCATTER,
+		.op = FI_SUM,
+		.datatype = FI_UINT64,
+	},
+	{
+		.name = "sum_reduce_scatter_large_test",
+		.setup = coll_setup,
+		.run = sum_reduce_scatter_large_test_run,
+		.teardown = coll_teardown,
+		.coll_op = FI_REDUCE_SCATTER,
+		.op = FI_SUM,
+		.datatype = FI_UINT64,
+	},
+	{
+		.name = "sum_reduce_test",
+		.setup = coll_setup,
+		.run = sum_reduce_test_run,
+		.teardown = coll_teardown,
+		.coll_op = FI_REDUCE,
+		.op = FI_SUM,
+		.datatype = FI_UINT64,
+	},
+	{
+		.name = "sum_reduce_large_test",
+		.setup = coll_setup,
+		.run = sum_reduce_large_test_run,
+		.teardown = coll_teardown,
+		.coll_op = FI_REDUCE,
+		.op = FI_SUM,
+		.datatype = FI_UINT64,
+	},
+	{
+		.name = "gather_test",
+		.setup = coll_setup,
+		.run = gather_test_run,
+		.teardown = coll_teardown,
+		.coll_op = FI_GATHER,
+		.op = FI_NOOP,
+		.datatype = FI_UINT64,
+	},
+	{
+		.name = "gather_large_test",
+		.setup = coll_setup,
+		.run = gather_large_test_run,
+		.teardown = coll_teardown,
+		.coll_op = FI_GATHER,
+		.op = FI_NOOP,
+		.datatype = FI_UINT64,
+	},
 	{
 		.name = "empty_test_to_stop_the_sequence_of_execution",
 		.run = NULL,
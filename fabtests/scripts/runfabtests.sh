@@ -146,6 +146,7 @@ functional_tests=(
 	"fi_recv_cancel -e rdm -V"
 	"fi_unexpected_msg -e msg -I 10 -v"
 	"fi_unexpected_msg -e rdm -I 10 -v"
+	"fi_stalled_peer -v"
 	"fi_inject_test -A inject -v"
 	"fi_inject_test -N -A inject -v"
 	"fi_inject_test -A inj_complete -v"
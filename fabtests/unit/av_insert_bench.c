@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2026 Intel Corporation.  All rights reserved.
+ *
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+#include <limits.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <rdma/fi_errno.h>
+
+#include "shared.h"
+#include "unit_common.h"
+
+/*
+ * Measures the cost of populating an AV with a large number of peers, as
+ * done at job startup.  The same set of synthetic IPv4 addresses is inserted
+ * one address per fi_av_insert call and then in batches of -b addresses.
+ */
+
+static size_t addr_cnt = 100000;
+static size_t batch_size;
+static int iterations = 3;
+
+static struct sockaddr_in *addrs;
+static fi_addr_t *fi_addrs;
+
+static void usage(char *name)
+{
+	ft_unit_usage(name, "AV insertion benchmark");
+	FT_PRINT_OPTS_USAGE("-n <count>", "number of addresses to insert "
+			    "(default 100000)");
+	FT_PRINT_OPTS_USAGE("-b <count>", "addresses per fi_av_insert call "
+			    "for the batched run (default: all)");
+	FT_PRINT_OPTS_USAGE("-I <iter>", "number of iterations (default 3)");
+}
+
+static int parse_size(const char *arg, size_t *val)
+{
+	unsigned long long v;
+	char *ptr;
+
+	errno = 0;
+	v = strtoull(arg, &ptr, 10);
+	if (ptr == arg || *ptr != '\0' || errno == ERANGE || !v) {
+		fprintf(stderr, "Invalid count: %s\n", arg);
+		return -FI_EINVAL;
+	}
+	*val = v;
+	return 0;
+}
+
+/* 10.0.0.0/8 with a rotating port gives every entry a distinct valid key */
+static void init_addrs(void)
+{
+	size_t i;
+
+	for (i = 0; i < addr_cnt; i++) {
+		addrs[i].sin_family = AF_INET;
+		addrs[i].sin_addr.s_addr = htonl(0x0a000001 + (i >> 4));
+		addrs[i].sin_port = htons(10000 + (i & 0xf));
+	}
+}
+
+static int insert_run(size_t batch, int64_t *elapsed)
+{
+	struct fi_av_attr attr = {0};
+	struct fid_av *bench_av;
+	size_t i, cnt;
+	int ret, close_ret;
+
+	attr.type = fi->domain_attr->av_type == FI_AV_UNSPEC ?
+		    FI_AV_TABLE : fi->domain_attr->av_type;
+
+	ret = fi_av_open(domain, &attr, &bench_av, NULL);
+	if (ret) {
+		FT_PRINTERR("fi_av_open", ret);
+		return ret;
+	}
+
+	ft_start();
+	for (i = 0; i < addr_cnt; i += cnt) {
+		cnt = MIN(batch, addr_cnt - i);
+		ret = fi_av_insert(bench_av, &addrs[i], cnt, &fi_addrs[i],
+				   0, NULL);
+		if (ret != (int) cnt) {
+			FT_ERR("fi_av_insert returned %d, expected %zu",
+			       ret, cnt);
+			ret = ret < 0 ? ret : -FI_EOTHER;
+			goto close;
+		}
+	}
+	ft_stop();
+	*elapsed = get_elapsed(&start, &end, NANO);
+	ret = 0;
+
+	for (i = 1; i < addr_cnt; i++) {
+		if (fi_addrs[i] == fi_addrs[i - 1] ||
+		    fi_addrs[i] == FI_ADDR_NOTAVAIL) {
+			FT_ERR("duplicate or invalid fi_addr at index %zu", i);
+			ret = -FI_EOTHER;
+			break;
+		}
+	}
+
+close:
+	close_ret = fi_close(&bench_av->fid);
+	if (close_ret) {
+		FT_PRINTERR("fi_close", close_ret);
+		if (!ret)
+			ret = close_ret;
+	}
+	return ret;
+}
+
+static int run_bench(const char *name, size_t batch)
+{
+	int64_t elapsed = 0, best = INT64_MAX;
+	int i, ret;
+
+	for (i = 0; i < iterations; i++) {
+		ret = insert_run(batch, &elapsed);
+		if (ret)
+			return ret;
+		best = MIN(best, elapsed);
+	}
+
+	printf("%-10s %10zu %10zu %14.3f %10.1f\n", name, addr_cnt, batch,
+	       best / 1e6, (double) best / addr_cnt);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	int op, ret;
+
+	hints = fi_allocinfo();
+	if (!hints)
+		return EXIT_FAILURE;
+
+	while ((op = getopt(argc, argv, FAB_OPTS "n:b:I:h")) != -1) {
+		switch (op) {
+		case 'n':
+			if (parse_size(optarg, &addr_cnt))
+				return EXIT_FAILURE;
+			break;
+		case 'b':
+			if (parse_size(optarg, &batch_size))
+				return EXIT_FAILURE;
+			break;
+		case 'I':
+			iterations = atoi(optarg);
+			if (iterations <= 0) {
+				fprintf(stderr, "Invalid iterations: %s\n",
+					optarg);
+				return EXIT_FAILURE;
+			}
+			break;
+		default:
+			ft_parseinfo(op, optarg, hints, &opts);
+			break;
+		case '?':
+		case 'h':
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (!batch_size || batch_size > addr_cnt)
+		batch_size = addr_cnt;
+
+	hints->mode = ~0;
+	hints->domain_attr->mode = ~0;
+	hints->domain_attr->mr_mode = ~OFI_MR_DEPRECATED;
+	hints->ep_attr->type = FI_EP_RDM;
+	hints->addr_format = FI_SOCKADDR_IN;
+
+	ret = fi_getinfo(FT_FIVERSION, NULL, 0, 0, hints, &fi);
+	if (ret) {
+		FT_PRINTERR("fi_getinfo", ret);
+		goto out;
+	}
+
+	ret = ft_open_fabric_res();
+	if (ret)
+		goto out;
+
+	addrs = calloc(addr_cnt, sizeof(*addrs));
+	fi_addrs = calloc(addr_cnt, sizeof(*fi_addrs));
+	if (!addrs || !fi_addrs) {
+		ret = -FI_ENOMEM;
+		goto free;
+	}
+	init_addrs();
+
+	printf("AV insertion on %s, best of %d\n", fi->fabric_attr->prov_name,
+	       iterations);
+	printf("%-10s %10s %10s %14s %10s\n", "mode", "addrs", "batch",
+	       "total (ms)", "ns/addr");
+
+	ret = run_bench("single", 1);
+	if (ret)
+		goto free;
+
+	ret = run_bench("batched", batch_size);
+
+free:
+	free(fi_addrs);
+	free(addrs);
+out:
+	ft_free_res();
+	return ft_exit_code(ret);
+}
@@ -65,6 +65,10 @@ static inline int ofi_shm_remap(struct util_shm *shm,
 ssize_t ofi_get_addr_page_size(const void *addr);
 ssize_t ofi_get_hugepage_size(void);
 
+int ofi_numa_node(void);
+int ofi_numa_bind(void *addr, size_t len, int policy, int node);
+int ofi_numa_addr_node(const void *addr);
+
 static inline int ofi_alloc_hugepage_buf(void **memptr, size_t size)
 {
 	return ofi_mmap_anon_pages(memptr, size, MAP_HUGETLB);
@@ -287,6 +287,16 @@ enum {
 	OFI_CLFLUSHOPT_BIT	= (1 << 23),
 	OFI_CLFLUSH_REG		= 3,
 	OFI_CLFLUSH_BIT		= (1 << 19),
+	OFI_OSXSAVE_REG		= 2,
+	OFI_OSXSAVE_BIT		= (1 << 27),
+	OFI_AVX2_REG		= 1,
+	OFI_AVX2_BIT		= (1 << 5),
+	OFI_AVX512F_REG		= 1,
+	OFI_AVX512F_BIT		= (1 << 16),
+	OFI_AVX512DQ_REG	= 1,
+	OFI_AVX512DQ_BIT	= (1 << 17),
+	OFI_AVX512BW_REG	= 1,
+	OFI_AVX512BW_BIT	= (1 << 30),
 };
 
 int ofi_cpu_supports(unsigned func, unsigned reg, unsigned bit);
@@ -428,6 +438,8 @@ uint8_t ofi_lsb(uint64_t num);
 
 extern size_t ofi_universe_size;
 extern int ofi_av_remove_cleanup;
+extern int ofi_srx_tag_hash;
+extern int ofi_wait_spin_usec;
 extern char *ofi_offload_coll_prov_name;
 extern int ofi_prefer_sysconfig;
 
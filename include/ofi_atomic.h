@@ -78,14 +78,21 @@ extern void (*ofi_atomic_swap_handlers[OFI_SWAP_OP_CNT][OFI_DATATYPE_CNT])
 			(void *dst, const void *src, const void *cmp,
 			 void *res, size_t cnt);
 
+/* Non-atomic handlers for targets only accessed by the caller */
+extern void (*ofi_atomic_reduce_handlers[OFI_WRITE_OP_CNT][OFI_DATATYPE_CNT])
+			(void *dst, const void *src, size_t cnt);
+
 #define ofi_atomic_write_handler(op, datatype, dst, src, cnt) \
 	ofi_atomic_write_handlers[op][datatype](dst, src, cnt)
+#define ofi_atomic_reduce_handler(op, datatype, dst, src, cnt) \
+	ofi_atomic_reduce_handlers[op][datatype](dst, src, cnt)
 #define ofi_atomic_readwrite_handler(op, datatype, dst, src, res, cnt) \
 	ofi_atomic_readwrite_handlers[op][datatype](dst, src, res, cnt)
 #define ofi_atomic_swap_handler(op, datatype, dst, src, cmp, res, cnt) \
 	ofi_atomic_swap_handlers[op - OFI_SWAP_OP_START][datatype](dst, src, \
 								cmp, res, cnt)
 
+void ofi_atomic_init(void);
 int ofi_atomic_valid(const struct fi_provider *prov,
 		     enum fi_datatype datatype, enum fi_op op, uint64_t flags);
 
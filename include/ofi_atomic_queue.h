@@ -62,6 +62,7 @@
 #define OFI_ATOMIC_QUEUE_H
 
 #include <ofi_atom.h>
+#include <ofi_osd.h>
 
 /*
  * This is an atomic queue, meaning no need for locking. One example usage
@@ -135,17 +136,31 @@ static inline void name ## _init(struct name *aq, size_t size)	\
 static inline struct name * name ## _create(size_t size)	\
 {								\
 	struct name *aq;					\
-	aq = (struct name*) calloc(1, sizeof(*aq) +		\
-		sizeof(struct name ## _entry) *			\
-		(roundup_power_of_two(size)));			\
-	if (aq)							\
-		name ##_init(aq, roundup_power_of_two(size));	\
+	size_t len;						\
+	len = sizeof(*aq) + sizeof(struct name ## _entry) *	\
+	      roundup_power_of_two(size);			\
+	if (ofi_memalign((void **) &aq, OFI_CACHE_LINE_SIZE,	\
+			 len))					\
+		return NULL;					\
+	memset(aq, 0, len);					\
+	name ##_init(aq, roundup_power_of_two(size));		\
 	return aq;						\
 }								\
 								\
 static inline void name ## _free(struct name *aq)		\
 {								\
-	free(aq);						\
+	ofi_freealign(aq);					\
+}								\
+								\
+static inline bool name ## _isempty(struct name *aq)		\
+{								\
+	struct name ## _entry *ce;				\
+	int64_t pos;						\
+	pos = ofi_atomic_load_explicit64(&aq->read_pos,		\
+				    memory_order_relaxed);	\
+	ce = &aq->entry[pos & aq->size_mask];			\
+	return ofi_atomic_load_explicit64(&ce->seq,		\
+			memory_order_acquire) != pos + 1;	\
 }								\
 static inline int name ## _next(struct name *aq,		\
 		entrytype **buf, int64_t *pos)			\
@@ -50,6 +50,10 @@ enum util_coll_op_type {
 	UTIL_COLL_BROADCAST_OP,
 	UTIL_COLL_ALLGATHER_OP,
 	UTIL_COLL_SCATTER_OP,
+	UTIL_COLL_ALLTOALL_OP,
+	UTIL_COLL_REDUCE_SCATTER_OP,
+	UTIL_COLL_REDUCE_OP,
+	UTIL_COLL_GATHER_OP,
 };
 
 static const char * const log_util_coll_op_type[] = {
@@ -58,7 +62,11 @@ static const char * const log_util_coll_op_type[] = {
 	[UTIL_COLL_ALLREDUCE_OP] = "COLL_ALLREDUCE",
 	[UTIL_COLL_BROADCAST_OP] = "COLL_BROADCAST",
 	[UTIL_COLL_ALLGATHER_OP] = "COLL_ALLGATHER",
-	[UTIL_COLL_SCATTER_OP] = "COLL_SCATTER"
+	[UTIL_COLL_SCATTER_OP] = "COLL_SCATTER",
+	[UTIL_COLL_ALLTOALL_OP] = "COLL_ALLTOALL",
+	[UTIL_COLL_REDUCE_SCATTER_OP] = "COLL_REDUCE_SCATTER",
+	[UTIL_COLL_REDUCE_OP] = "COLL_REDUCE",
+	[UTIL_COLL_GATHER_OP] = "COLL_GATHER"
 };
 
 enum coll_work_type {
@@ -99,6 +107,7 @@ struct util_coll_xfer_item {
 	enum fi_datatype		datatype;
 	uint64_t			tag;
 	int				remote_rank;
+	fi_addr_t			addr;
 };
 
 struct util_coll_copy_item {
@@ -122,6 +131,8 @@ struct join_data {
 	struct util_coll_mc *new_mc;
 	struct ofi_bitmask data;
 	struct ofi_bitmask tmp;
+	uint64_t node_id;
+	uint64_t *node_ids;
 };
 
 struct barrier_data {
@@ -157,6 +168,10 @@ struct util_coll_operation {
 		struct allreduce_data	allreduce;
 		void			*scatter;
 		struct broadcast_data	broadcast;
+		void			*alltoall;
+		void			*reduce_scatter;
+		void			*reduce;
+		void			*gather;
 	} data;
 	util_coll_comp_fn_t		comp_fn;
 	uint64_t			flags;
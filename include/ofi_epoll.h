@@ -187,6 +187,29 @@ static inline int ofi_epoll_fd(int ep)
 	return ep;
 }
 
+/* Ask epoll_wait() to busy poll the NAPI context of the monitored sockets
+ * for up to usec before sleeping.  Requires kernel and libc support.
+ */
+#ifdef EPIOCSPARAMS
+#include <sys/ioctl.h>
+
+static inline int ofi_epoll_busy_poll(int ep, uint32_t usec)
+{
+	struct epoll_params params = {
+		.busy_poll_usecs = usec,
+		.busy_poll_budget = 8,
+		.prefer_busy_poll = 1,
+	};
+
+	return ioctl(ep, EPIOCSPARAMS, &params) ? -ofi_syserr() : 0;
+}
+#else
+static inline int ofi_epoll_busy_poll(int ep, uint32_t usec)
+{
+	return -FI_ENOSYS;
+}
+#endif
+
 #else
 
 #define OFI_EPOLL_IN  POLLIN
@@ -210,6 +233,11 @@ static inline int ofi_epoll_fd(ofi_epoll_t ep)
 	return INVALID_SOCKET;
 }
 
+static inline int ofi_epoll_busy_poll(ofi_epoll_t ep, uint32_t usec)
+{
+	return -FI_ENOSYS;
+}
+
 #define EPOLL_CTL_ADD POLLFDS_CTL_ADD
 #define EPOLL_CTL_DEL POLLFDS_CTL_DEL
 #define EPOLL_CTL_MOD POLLFDS_CTL_MOD
@@ -295,4 +323,12 @@ ofi_dynpoll_get_fd(struct ofi_dynpoll *dynpoll)
 	return dynpoll->get_fd(dynpoll);
 }
 
+static inline int
+ofi_dynpoll_busy_poll(struct ofi_dynpoll *dynpoll, uint32_t usec)
+{
+	if (dynpoll->type != OFI_DYNPOLL_EPOLL)
+		return -FI_ENOSYS;
+	return ofi_epoll_busy_poll(dynpoll->ep, usec);
+}
+
 #endif  /* _OFI_EPOLL_H_ */
@@ -327,10 +327,34 @@ enum {
 	OFI_BUFPOOL_NO_TRACK		= 1 << 2,
 	OFI_BUFPOOL_HUGEPAGES		= 1 << 3,
 	OFI_BUFPOOL_NONSHARED		= 1 << 4,
+	OFI_BUFPOOL_MT			= 1 << 5,
+	/* keep regions on the NUMA node of the thread creating the pool */
+	OFI_BUFPOOL_NUMA_LOCAL		= 1 << 6,
 };
 
 struct ofi_bufpool_region;
 
+/*
+ * OFI_BUFPOOL_MT: ofi_buf_alloc() and ofi_buf_free() may be called from
+ * any thread without external locking.  Each thread caches free entries
+ * in a magazine that it refills from, and spills back to, the shared free
+ * list in batches of OFI_BUFPOOL_MAG_BATCH under the pool lock.  Entries
+ * may be freed by a different thread than the one that allocated them.
+ * Not supported with OFI_BUFPOOL_INDEXED, and ofi_bufpool_empty() only
+ * reflects the shared list.
+ */
+enum {
+	OFI_BUFPOOL_MAG_SIZE		= 64,
+	OFI_BUFPOOL_MAG_BATCH		= OFI_BUFPOOL_MAG_SIZE / 2,
+};
+
+struct ofi_bufpool_mag {
+	struct slist			entries;
+	size_t				cnt;
+	struct dlist_entry		entry;
+	struct ofi_bufpool		*pool;
+};
+
 struct ofi_bufpool_attr {
 	size_t 		size;
 	size_t 		alignment;
@@ -357,6 +381,14 @@ struct ofi_bufpool {
 	size_t				alloc_size;
 	size_t				region_size;
 	struct ofi_bufpool_attr		attr;
+	int				numa_node;
+
+	/* OFI_BUFPOOL_MT only */
+	pthread_key_t			mag_key;
+	pthread_mutex_t			lock;
+	struct dlist_entry		mag_list;
+	size_t				region_table_size;
+	struct slist			retired_tables;
 };
 
 struct ofi_bufpool_region {
@@ -451,16 +483,36 @@ static inline bool ofi_bufpool_ibuf_is_valid(struct ofi_bufpool *pool, size_t in
 	return ofi_buf_is_valid(buf);
 }
 
+struct ofi_bufpool_mag *ofi_bufpool_mag_refill(struct ofi_bufpool *pool,
+					       struct ofi_bufpool_mag *mag);
+void ofi_bufpool_mag_free(struct ofi_bufpool *pool, void *buf);
+
 static inline void ofi_buf_free(void *buf)
 {
+	struct ofi_bufpool *pool = ofi_buf_pool(buf);
+	struct ofi_bufpool_mag *mag;
+
 	assert(ofi_atomic_dec32(&ofi_buf_region(buf)->use_cnt) >= 0);
-	assert(!(ofi_buf_pool(buf)->attr.flags & OFI_BUFPOOL_INDEXED));
+	assert(!(pool->attr.flags & OFI_BUFPOOL_INDEXED));
 	assert(ofi_buf_hdr(buf)->magic == OFI_MAGIC_SIZE_T);
 	assert(ofi_buf_hdr(buf)->ftr->magic == OFI_MAGIC_SIZE_T);
 	assert(ofi_buf_is_valid(buf));
 
+	if (pool->attr.flags & OFI_BUFPOOL_MT) {
+		mag = (struct ofi_bufpool_mag *)
+		      pthread_getspecific(pool->mag_key);
+		if (OFI_UNLIKELY(!mag || mag->cnt >= OFI_BUFPOOL_MAG_SIZE)) {
+			ofi_bufpool_mag_free(pool, buf);
+			return;
+		}
+		slist_insert_head(&ofi_buf_hdr(buf)->entry.slist,
+				  &mag->entries);
+		mag->cnt++;
+		return;
+	}
+
 	slist_insert_head(&ofi_buf_hdr(buf)->entry.slist,
-			  &ofi_buf_pool(buf)->free_list.entries);
+			  &pool->free_list.entries);
 }
 
 int ofi_ibuf_is_lower(struct dlist_entry *item, const void *arg);
@@ -519,14 +571,26 @@ static inline int ofi_ibufpool_empty(struct ofi_bufpool *pool)
 static inline void *ofi_buf_alloc(struct ofi_bufpool *pool)
 {
 	struct ofi_bufpool_hdr *buf_hdr;
+	struct ofi_bufpool_mag *mag;
+	struct slist *entries = &pool->free_list.entries;
 
 	assert(!(pool->attr.flags & OFI_BUFPOOL_INDEXED));
-	if (ofi_bufpool_empty(pool)) {
+	if (pool->attr.flags & OFI_BUFPOOL_MT) {
+		mag = (struct ofi_bufpool_mag *)
+		      pthread_getspecific(pool->mag_key);
+		if (OFI_UNLIKELY(!mag || !mag->cnt)) {
+			mag = ofi_bufpool_mag_refill(pool, mag);
+			if (!mag)
+				return NULL;
+		}
+		entries = &mag->entries;
+		mag->cnt--;
+	} else if (ofi_bufpool_empty(pool)) {
 		if (ofi_bufpool_grow(pool))
 			return NULL;
 	}
 
-	slist_remove_head_container(&pool->free_list.entries,
+	slist_remove_head_container(entries,
 				struct ofi_bufpool_hdr, buf_hdr, entry.slist);
 	assert(ofi_atomic_inc32(&buf_hdr->region->use_cnt));
 	assert(!ofi_buf_is_valid(ofi_buf_data(buf_hdr)));
@@ -369,6 +369,9 @@ struct ofi_mr_cache {
 	struct dlist_entry		lru_list;
 	struct dlist_entry		dead_region_list;
 	pthread_mutex_t 		lock;
+	/* Write locked along with mm_lock to change the tree, so cache hits
+	 * can be looked up without mm_lock. */
+	pthread_rwlock_t		tree_lock;
 
 	size_t				cached_cnt;
 	size_t				cached_size;
@@ -380,6 +383,7 @@ struct ofi_mr_cache {
 	size_t				delete_cnt;
 	size_t				hit_cnt;
 	size_t				notify_cnt;
+	size_t				contended_cnt;
 	struct ofi_bufpool		*entry_pool;
 
 	int				(*add_region)(struct ofi_mr_cache *cache,
@@ -152,11 +152,32 @@ typedef struct {
 struct ofi_sockctx {
 	void *context;
 	bool uring_sqe_inuse;
+	/* zero-copy send waiting for the kernel to release its buffer */
+	bool uring_zc;
+	int uring_zc_res;
+	/* registered file and buffer slot, or -1 */
+	int uring_fixed;
+#ifdef HAVE_LIBURING_FIXED
+	struct msghdr uring_msg;
+#endif
 };
 
 struct ofi_sockapi_uring {
 	ofi_io_uring_t *io_uring;
 	uint64_t credits;
+
+	/* Registered file and buffer slots, one per socket.  Sends larger
+	 * than zc_size use zero-copy requests.
+	 */
+	int *fixed_free;
+	unsigned int fixed_free_cnt;
+	struct iovec *fixed_bufs;
+	size_t zc_size;
+
+	uint64_t send_cnt;
+	uint64_t send_fixed_file_cnt;
+	uint64_t send_fixed_buf_cnt;
+	uint64_t send_zc_cnt;
 };
 
 struct ofi_sockapi {
@@ -182,11 +203,43 @@ struct ofi_sockapi {
 			 struct ofi_sockctx *ctx);
 };
 
+/*
+ * Provided buffer ring: receive buffers shared by all sockets using an
+ * io_uring.  The kernel picks a buffer for each completion of a multishot
+ * receive, and the buffer goes back to the ring once it has been read.
+ * Buffers are indexed by their io_uring buffer id.
+ */
+struct ofi_bufring_buf {
+	struct slist_entry entry;
+	uint32_t offset;
+	uint32_t len;
+};
+
+struct ofi_bufring {
+	ofi_io_uring_t *io_uring;
+	void *ring;
+	uint8_t *data;
+	struct ofi_bufring_buf *bufs;
+	size_t buf_size;
+	unsigned int cnt;
+	unsigned int avail;
+	int bgid;
+};
+
+static inline void *
+ofi_bufring_data(struct ofi_bufring *bufring, struct ofi_bufring_buf *buf)
+{
+	return bufring->data + (buf - bufring->bufs) * bufring->buf_size +
+	       buf->offset;
+}
+
 static inline void
 ofi_sockctx_init(struct ofi_sockctx *sockctx, void *context)
 {
 	sockctx->context = context;
 	sockctx->uring_sqe_inuse = false;
+	sockctx->uring_zc = false;
+	sockctx->uring_fixed = -1;
 }
 
 static inline int
@@ -325,6 +378,28 @@ int ofi_sockctx_uring_poll_add(struct ofi_sockapi_uring *uring,
 int ofi_uring_init(ofi_io_uring_t *io_uring, size_t entries);
 int ofi_uring_destroy(ofi_io_uring_t *io_uring);
 
+#ifdef HAVE_LIBURING_FIXED
+int ofi_uring_init_fixed(struct ofi_sockapi_uring *uring, unsigned int cnt);
+void ofi_uring_cleanup_fixed(struct ofi_sockapi_uring *uring);
+int ofi_sockctx_uring_register(struct ofi_sockapi_uring *uring,
+			       struct ofi_sockctx *ctx, SOCKET sock,
+			       void *buf, size_t len);
+void ofi_sockctx_uring_unregister(struct ofi_sockapi_uring *uring,
+				  struct ofi_sockctx *ctx);
+#endif
+
+#ifdef HAVE_LIBURING_BUFRING
+int ofi_bufring_init(struct ofi_bufring *bufring, ofi_io_uring_t *io_uring,
+		     unsigned int cnt, size_t buf_size, int bgid);
+void ofi_bufring_cleanup(struct ofi_bufring *bufring);
+void ofi_bufring_put(struct ofi_bufring *bufring, struct ofi_bufring_buf *buf);
+struct ofi_bufring_buf *ofi_bufring_get(struct ofi_bufring *bufring,
+					uint32_t cqe_flags, size_t len);
+int ofi_sockctx_uring_recv_multishot(struct ofi_sockapi_uring *uring,
+				     SOCKET sock, struct ofi_bufring *bufring,
+				     struct ofi_sockctx *ctx);
+#endif
+
 static inline int ofi_uring_get_fd(ofi_io_uring_t *io_uring)
 {
 	return io_uring->ring_fd;
@@ -362,8 +437,6 @@ static inline void ofi_uring_cq_advance(ofi_io_uring_t *io_uring, unsigned int c
 	io_uring_cq_advance(io_uring, count);
 }
 #else
-#define IORING_CQE_F_MORE	(1U << 1)
-
 static inline int
 ofi_sockapi_connect_uring(struct ofi_sockapi *sockapi, SOCKET sock,
 			  const struct sockaddr *addr, socklen_t addrlen,
@@ -438,6 +511,77 @@ ofi_sockctx_uring_poll_add(struct ofi_sockapi_uring *uring,
 #define ofi_uring_cq_advance(io_uring, count) do {} while(0)
 #endif
 
+/* Older liburing headers predate some of the cqe flags */
+#ifndef IORING_CQE_F_BUFFER
+#define IORING_CQE_F_BUFFER	(1U << 0)
+#endif
+#ifndef IORING_CQE_F_MORE
+#define IORING_CQE_F_MORE	(1U << 1)
+#endif
+#ifndef IORING_CQE_F_NOTIF
+#define IORING_CQE_F_NOTIF	(1U << 3)
+#endif
+
+#ifndef HAVE_LIBURING_FIXED
+static inline int
+ofi_uring_init_fixed(struct ofi_sockapi_uring *uring, unsigned int cnt)
+{
+	return -FI_ENOSYS;
+}
+
+static inline void ofi_uring_cleanup_fixed(struct ofi_sockapi_uring *uring)
+{
+}
+
+static inline int
+ofi_sockctx_uring_register(struct ofi_sockapi_uring *uring,
+			   struct ofi_sockctx *ctx, SOCKET sock,
+			   void *buf, size_t len)
+{
+	return -FI_ENOSYS;
+}
+
+static inline void
+ofi_sockctx_uring_unregister(struct ofi_sockapi_uring *uring,
+			     struct ofi_sockctx *ctx)
+{
+}
+#endif
+
+#ifndef HAVE_LIBURING_BUFRING
+static inline int
+ofi_bufring_init(struct ofi_bufring *bufring, ofi_io_uring_t *io_uring,
+		 unsigned int cnt, size_t buf_size, int bgid)
+{
+	return -FI_ENOSYS;
+}
+
+static inline void ofi_bufring_cleanup(struct ofi_bufring *bufring)
+{
+}
+
+static inline void
+ofi_bufring_put(struct ofi_bufring *bufring, struct ofi_bufring_buf *buf)
+{
+	assert(0);
+}
+
+static inline struct ofi_bufring_buf *
+ofi_bufring_get(struct ofi_bufring *bufring, uint32_t cqe_flags, size_t len)
+{
+	assert(0);
+	return NULL;
+}
+
+static inline int
+ofi_sockctx_uring_recv_multishot(struct ofi_sockapi_uring *uring,
+				 SOCKET sock, struct ofi_bufring *bufring,
+				 struct ofi_sockctx *ctx)
+{
+	return -FI_ENOSYS;
+}
+#endif
+
 /*
  * Byte queue - streaming socket staging buffer
  */
@@ -542,6 +686,11 @@ struct ofi_bsock {
 	uint32_t async_index;
 	uint32_t done_index;
 	bool async_prefetch;
+	/* data received into a provided buffer ring, in order */
+	struct ofi_bufring *bufring;
+	struct slist rbufs;
+	size_t rbufs_len;
+	unsigned int rbufs_cnt;
 };
 
 static inline void
@@ -561,17 +710,37 @@ ofi_bsock_init(struct ofi_bsock *bsock, struct ofi_sockapi *sockapi,
 	/* first async op will wrap back to 0 as the starting index */
 	bsock->async_index = UINT32_MAX;
 	bsock->done_index = UINT32_MAX;
+	bsock->bufring = NULL;
+	slist_init(&bsock->rbufs);
+	bsock->rbufs_len = 0;
+	bsock->rbufs_cnt = 0;
 }
 
+void ofi_bsock_put_rbufs(struct ofi_bsock *bsock);
+
 static inline void ofi_bsock_discard(struct ofi_bsock *bsock)
 {
 	ofi_byteq_discard(&bsock->rq);
 	ofi_byteq_discard(&bsock->sq);
+	ofi_bsock_put_rbufs(bsock);
 }
 
 static inline size_t ofi_bsock_readable(struct ofi_bsock *bsock)
 {
-	return ofi_byteq_readable(&bsock->rq);
+	return ofi_byteq_readable(&bsock->rq) + bsock->rbufs_len;
+}
+
+/* Queue data from a multishot receive completion for ofi_bsock_recv(v) */
+static inline void ofi_bsock_rbuf_done(struct ofi_bsock *bsock,
+				       uint32_t cqe_flags, size_t len)
+{
+	struct ofi_bufring_buf *buf;
+
+	assert(bsock->bufring);
+	buf = ofi_bufring_get(bsock->bufring, cqe_flags, len);
+	slist_insert_tail(&buf->entry, &bsock->rbufs);
+	bsock->rbufs_len += len;
+	bsock->rbufs_cnt++;
 }
 
 static inline size_t ofi_bsock_tosend(struct ofi_bsock *bsock)
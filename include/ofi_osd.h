@@ -56,6 +56,13 @@ typedef long double long_double;
  */
 
 
+/* Memory placement policies for ofi_numa_bind() */
+enum {
+	OFI_NUMA_NONE,
+	OFI_NUMA_LOCAL,		/* prefer the given node */
+	OFI_NUMA_INTERLEAVE,	/* interleave over all nodes with memory */
+};
+
 #ifdef __APPLE__
 #include <osx/osd.h>
 #include <unix/osd.h>
@@ -56,6 +56,7 @@
 #include <rdma/providers/fi_peer.h>
 
 #include <ofi.h>
+#include <ofi_atomic_queue.h>
 #include <ofi_mr.h>
 #include <ofi_list.h>
 #include <ofi_mem.h>
@@ -434,6 +435,14 @@ struct util_wait_fd {
 		struct ofi_pollfds	*pollfds;
 	};
 	uint64_t		change_index;
+
+	/* adaptive spin before blocking, all in ns, protected by lock */
+	uint64_t		spin_max;
+	uint64_t		spin_avg;
+	uint64_t		spin_time;
+	size_t			spin_miss;
+	size_t			spin_hits;
+	size_t			parks;
 };
 
 typedef int (*ofi_wait_try_func)(void *arg);
@@ -497,6 +506,20 @@ struct util_cq_aux_entry {
 
 OFI_DECLARE_CIRQUE(struct fi_cq_tagged_entry, util_comp_cirq);
 
+/* ofi_cq_init2 flag for providers that only use the ofi_cq_write* calls.
+ * Completions are written to a lock-free queue instead of the cirq.
+ * The aux queue, still protected by cq_lock, holds errors and entries
+ * that found the queue full.  Ignored unless cq_lock is a real lock.
+ */
+#define OFI_CQ_ATOMIC_QUEUE	BIT(0)
+
+struct util_atomq_comp {
+	struct fi_cq_tagged_entry	comp;
+	fi_addr_t			src;
+};
+
+OFI_DECLARE_ATOMIC_Q(struct util_atomq_comp, util_comp_atomq);
+
 typedef void (*ofi_cq_progress_func)(struct util_cq *cq);
 
 struct util_cq {
@@ -525,11 +548,19 @@ struct util_cq {
 	fi_addr_t		*src;
 	struct slist		aux_queue;
 	fi_cq_read_func		read_entry;
+
+	/* Replaces cirq if OFI_CQ_ATOMIC_QUEUE, aux_cnt tracks aux_queue */
+	struct util_comp_atomq	*atomq;
+	ofi_atomic32_t		aux_cnt;
 };
 
 int ofi_cq_init(const struct fi_provider *prov, struct fid_domain *domain,
 		 struct fi_cq_attr *attr, struct util_cq *cq,
 		 ofi_cq_progress_func progress, void *context);
+int ofi_cq_init2(const struct fi_provider *prov, struct fid_domain *domain,
+		  struct fi_cq_attr *attr, struct util_cq *cq,
+		  ofi_cq_progress_func progress, uint64_t init_flags,
+		  void *context);
 int ofi_check_bind_cq_flags(struct util_ep *ep, struct util_cq *cq,
 			    uint64_t flags);
 void ofi_cq_progress(struct util_cq *cq);
@@ -552,6 +583,17 @@ const char *ofi_cq_strerror(struct fid_cq *cq, int prov_errno,
 int ofi_cq_write_overflow(struct util_cq *cq, void *context, uint64_t flags,
 			  size_t len, void *buf, uint64_t data, uint64_t tag,
 			  fi_addr_t src);
+ssize_t ofi_cq_read_atomq(struct util_cq *cq, void *buf, size_t count,
+			  fi_addr_t *src_addr);
+
+static inline bool ofi_cq_isempty(struct util_cq *cq)
+{
+	if (cq->atomq)
+		return util_comp_atomq_isempty(cq->atomq) &&
+		       !ofi_atomic_get32(&cq->aux_cnt);
+
+	return ofi_cirque_isempty(cq->cirq);
+}
 
 static inline
 ssize_t ofi_cq_read_entries(struct util_cq *cq, void *buf, size_t count,
@@ -561,6 +603,9 @@ ssize_t ofi_cq_read_entries(struct util_cq *cq, void *buf, size_t count,
 	struct util_cq_aux_entry *aux_entry;
 	ssize_t i;
 
+	if (cq->atomq)
+		return ofi_cq_read_atomq(cq, buf, count, src_addr);
+
 	ofi_genlock_lock(&cq->cq_lock);
 
 	if (cq->err_data) {
@@ -640,12 +685,46 @@ ofi_cq_write_src_entry(struct util_cq *cq, void *context, uint64_t flags,
 	ofi_cq_write_entry(cq, context, flags, len, buf, data, tag);
 }
 
+static inline int
+ofi_cq_write_atomq(struct util_cq *cq, void *context, uint64_t flags,
+		   size_t len, void *buf, uint64_t data, uint64_t tag,
+		   fi_addr_t src)
+{
+	struct util_atomq_comp *entry;
+	int64_t pos;
+	int ret;
+
+	/* Once anything is in the aux queue, later entries follow it */
+	if (!ofi_atomic_get32(&cq->aux_cnt) &&
+	    !util_comp_atomq_next(cq->atomq, &entry, &pos)) {
+		entry->comp.op_context = context;
+		entry->comp.flags = flags;
+		entry->comp.len = len;
+		entry->comp.buf = buf;
+		entry->comp.data = data;
+		entry->comp.tag = tag;
+		entry->src = src;
+		util_comp_atomq_commit(entry, pos);
+		return 0;
+	}
+
+	ofi_genlock_lock(&cq->cq_lock);
+	ret = ofi_cq_write_overflow(cq, context, flags, len, buf, data,
+				    tag, src);
+	ofi_genlock_unlock(&cq->cq_lock);
+	return ret;
+}
+
 static inline int
 ofi_cq_write(struct util_cq *cq, void *context, uint64_t flags, size_t len,
 	     void *buf, uint64_t data, uint64_t tag)
 {
 	int ret;
 
+	if (cq->atomq)
+		return ofi_cq_write_atomq(cq, context, flags, len, buf, data,
+					  tag, FI_ADDR_NOTAVAIL);
+
 	ofi_genlock_lock(&cq->cq_lock);
 	if (ofi_cirque_freecnt(cq->cirq) > 1) {
 		ofi_cq_write_entry(cq, context, flags, len, buf, data, tag);
@@ -664,6 +743,10 @@ ofi_cq_write_src(struct util_cq *cq, void *context, uint64_t flags, size_t len,
 {
 	int ret;
 
+	if (cq->atomq)
+		return ofi_cq_write_atomq(cq, context, flags, len, buf, data,
+					  tag, src);
+
 	ofi_genlock_lock(&cq->cq_lock);
 	if (ofi_cirque_freecnt(cq->cirq) > 1) {
 		ofi_cq_write_src_entry(cq, context, flags, len, buf, data,
@@ -677,6 +760,8 @@ ofi_cq_write_src(struct util_cq *cq, void *context, uint64_t flags, size_t len,
 	return ret;
 }
 
+int ofi_cq_insert_error(struct util_cq *cq,
+			const struct fi_cq_err_entry *err_entry);
 int ofi_cq_write_error(struct util_cq *cq,
 		       const struct fi_cq_err_entry *err_entry);
 int ofi_cq_write_error_peek(struct util_cq *cq, uint64_t tag, void *context);
@@ -850,6 +935,9 @@ struct util_coll_mc {
 	uint16_t		group_id;
 	uint16_t		seq;
 	ofi_atomic32_t		ref;
+	/* per node and node leader sub-groups of a group spanning nodes */
+	struct util_coll_mc	*node_mc;
+	struct util_coll_mc	*leader_mc;
 };
 
 struct util_av_set {
@@ -1268,6 +1356,29 @@ struct ofi_ops_flow_ctrl {
 			ssize_t (*send_handler)(struct fid_ep *ep, uint64_t credits));
 };
 
+/* Segmentation offload for datagram endpoints (UDP GSO/GRO), opened on
+ * the core endpoint.
+ * query - Returns the max number of datagrams and total bytes that may be
+ *     passed to a single sendv call.  Fails if offload is unavailable.
+ * sendv - Sends each iov as a separate datagram to dest_addr.  All iovs
+ *     except the last must have the same length.  A send completion is
+ *     generated for every context[i].
+ * recv - Posts a buffer which may receive several coalesced datagrams
+ *     from the same peer.  On completion, *seg_size holds the length of
+ *     each datagram except the last, which may be shorter.  Once used,
+ *     all receives on the endpoint must be posted through recv.
+ */
+#define OFI_OPS_DGRAM_SEG "ofix_dgram_seg_v1"
+
+struct ofi_ops_dgram_seg {
+	size_t	size;
+	int	(*query)(struct fid_ep *ep, size_t *max_cnt, size_t *max_len);
+	ssize_t	(*sendv)(struct fid_ep *ep, const struct iovec *iov,
+			 void **context, size_t count, fi_addr_t dest_addr);
+	ssize_t	(*recv)(struct fid_ep *ep, void *buf, size_t len,
+			void *context, size_t *seg_size);
+};
+
 struct util_rx_entry {
 	struct fi_peer_rx_entry	peer_entry;
 	uint64_t		seq_no;
@@ -1310,6 +1421,12 @@ struct util_srx_ctx {
 	struct ofi_dyn_arr	src_recv_queues;
 	struct ofi_dyn_arr	src_trecv_queues;
 
+	/* Tagged receives with ignore == 0, hashed by (tag, addr) when
+	 * FI_SRX_TAG_HASH is enabled.  NULL otherwise.
+	 */
+	struct slist		*tag_buckets;
+	size_t			tag_bucket_cnt;
+
 	struct dlist_entry	unspec_unexp_msg_queue;
 	struct dlist_entry	unspec_unexp_tag_queue;
 
@@ -1344,6 +1461,13 @@ ssize_t util_srx_generic_trecv(struct fid_ep *ep_fid, const struct iovec *iov,
 			       void **desc, size_t iov_count, fi_addr_t addr,
 			       void *context, uint64_t tag, uint64_t ignore,
 			       uint64_t flags);
+struct fi_peer_rx_entry *util_srx_claim_recv(struct fid_peer_srx *srx,
+					     fi_addr_t addr, bool tagged,
+					     uint64_t *ignore);
+void util_srx_unclaim_recv(struct fi_peer_rx_entry *rx_entry, bool tagged);
+struct fi_peer_rx_entry *util_srx_claimed_entry(struct fi_peer_rx_entry *rx_entry,
+						fi_addr_t addr, size_t msg_size,
+						bool tagged);
 
 static inline void ofi_cq_err_memcpy(uint32_t api_version,
 				     struct fi_cq_err_entry *user_buf,
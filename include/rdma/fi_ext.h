@@ -78,6 +78,18 @@ enum {
 	FI_OPT_EFA_WRITE_IN_ORDER_ALIGNED_128_BYTES, /* bool */
 };
 
+/* Entry of the rxd "rxd_peer_stats" profiling variable, one per peer */
+struct fi_rxd_peer_stats {
+	fi_addr_t	addr;		/* FI_ADDR_NOTAVAIL if not in the AV */
+	uint64_t	cwnd;		/* packets */
+	uint64_t	srtt;		/* usec */
+	uint64_t	rttvar;		/* usec */
+	uint64_t	rto;		/* usec */
+	uint64_t	retx_cnt;
+	uint64_t	fast_retx_cnt;
+	uint64_t	timeout_cnt;
+};
+
 struct fi_fid_export {
 	struct fid **fid;
 	uint64_t flags;
@@ -306,6 +306,15 @@ ofi_cpuid(unsigned func, unsigned subfunc, unsigned cpuinfo[4])
 	asm volatile("clflush %0" : "+m" (*(volatile char *) addr))
 #define ofi_sfence() asm volatile("sfence" ::: "memory")
 
+/* Only valid if cpuid reports OSXSAVE */
+static inline uint64_t ofi_xgetbv(unsigned index)
+{
+	unsigned eax, edx;
+
+	asm volatile("xgetbv" : "=a" (eax), "=d" (edx) : "c" (index));
+	return ((uint64_t) edx << 32) | eax;
+}
+
 #elif  (defined(__riscv) && \
 	defined(__riscv_xlen) && \
 	(__riscv_xlen == 64) && \
@@ -316,6 +325,7 @@ ofi_cpuid(unsigned func, unsigned subfunc, unsigned cpuinfo[4])
 #define ofi_clflushopt(addr)
 #define ofi_clflush(addr)
 #define ofi_sfence() asm volatile("fence w,w" ::: "memory")
+#define ofi_xgetbv(index) 0
 
 #else /* defined(__x86_64__) || defined(__amd64__) || defined(__riscv) */
 
@@ -324,6 +334,7 @@ ofi_cpuid(unsigned func, unsigned subfunc, unsigned cpuinfo[4])
 #define ofi_clflushopt(addr)
 #define ofi_clflush(addr)
 #define ofi_sfence()
+#define ofi_xgetbv(index) 0
 
 #endif /* defined(__x86_64__) || defined(__amd64__) */
 
@@ -980,6 +980,21 @@ static inline ssize_t ofi_get_hugepage_size(void)
 	return -FI_ENOSYS;
 }
 
+static inline int ofi_numa_node(void)
+{
+	return -1;
+}
+
+static inline int ofi_numa_bind(void *addr, size_t len, int policy, int node)
+{
+	return -FI_ENOSYS;
+}
+
+static inline int ofi_numa_addr_node(const void *addr)
+{
+	return -1;
+}
+
 static inline int ofi_alloc_hugepage_buf(void **memptr, size_t size)
 {
 	return -FI_ENOSYS;
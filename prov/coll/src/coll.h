@@ -72,6 +72,26 @@ enum {
 	COLL_TX_SIZE = 16384,
 };
 
+enum coll_allreduce_algo {
+	COLL_ALLREDUCE_AUTO,
+	COLL_ALLREDUCE_RECURSIVE_DOUBLING,
+	COLL_ALLREDUCE_RABENSEIFNER,
+	COLL_ALLREDUCE_RING,
+};
+
+struct coll_env {
+	enum coll_allreduce_algo allreduce_algo;
+	size_t allreduce_threshold;
+	size_t alltoall_threshold;
+	size_t reduce_scatter_threshold;
+	size_t reduce_threshold;
+	size_t gather_threshold;
+	int hierarchical;
+	uint64_t node_id;
+};
+
+extern struct coll_env coll_env;
+
 struct coll_domain {
 	struct util_domain util_domain;
 	struct fid_domain *peer_domain;
@@ -175,5 +195,28 @@ ssize_t coll_ep_broadcast(struct fid_ep *ep, void *buf, size_t count,
 			  void *desc, fi_addr_t coll_addr, fi_addr_t root_addr,
 			  enum fi_datatype datatype, uint64_t flags,
 			  void *context);
+
+ssize_t coll_ep_alltoall(struct fid_ep *ep, const void *buf, size_t count,
+			 void *desc, void *result, void *result_desc,
+			 fi_addr_t coll_addr, enum fi_datatype datatype,
+			 uint64_t flags, void *context);
+
+ssize_t coll_ep_reduce_scatter(struct fid_ep *ep, const void *buf,
+			       size_t count, void *desc, void *result,
+			       void *result_desc, fi_addr_t coll_addr,
+			       enum fi_datatype datatype, enum fi_op op,
+			       uint64_t flags, void *context);
+
+ssize_t coll_ep_reduce(struct fid_ep *ep, const void *buf, size_t count,
+		       void *desc, void *result, void *result_desc,
+		       fi_addr_t coll_addr, fi_addr_t root_addr,
+		       enum fi_datatype datatype, enum fi_op op,
+		       uint64_t flags, void *context);
+
+ssize_t coll_ep_gather(struct fid_ep *ep, const void *buf, size_t count,
+		       void *desc, void *result, void *result_desc,
+		       fi_addr_t coll_addr, fi_addr_t root_addr,
+		       enum fi_datatype datatype, uint64_t flags,
+		       void *context);
 #endif /* _COLL_H_ */
 
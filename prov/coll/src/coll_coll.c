@@ -251,6 +251,7 @@ static int coll_sched_send(struct util_coll_operation *coll_op,
 	xfer_item->count = (int) count;
 	xfer_item->datatype = datatype;
 	xfer_item->remote_rank = (int) dest;
+	xfer_item->addr = coll_op->mc->av_set->fi_addr_array[dest];
 
 	coll_bind_work(coll_op, &xfer_item->hdr);
 	return FI_SUCCESS;
@@ -274,6 +275,7 @@ static int coll_sched_recv(struct util_coll_operation *coll_op,
 	xfer_item->count = (int) count;
 	xfer_item->datatype = datatype;
 	xfer_item->remote_rank = (int) src;
+	xfer_item->addr = coll_op->mc->av_set->fi_addr_array[src];
 
 	coll_bind_work(coll_op, &xfer_item->hdr);
 	return FI_SUCCESS;
@@ -341,6 +343,328 @@ static int coll_sched_comp(struct util_coll_operation *coll_op)
 	return FI_SUCCESS;
 }
 
+/* map a rank within the power of two subset back to its member rank */
+static uint64_t coll_pof2_to_rank(uint64_t new_id, uint64_t rem)
+{
+	return (new_id < rem) ? new_id * 2 + 1 : new_id + rem;
+}
+
+/* offset of block idx, in elements, when count is split into nblocks */
+static size_t coll_block_offset(size_t count, uint64_t nblocks, uint64_t idx)
+{
+	return idx * (count / nblocks) + MIN(idx, count % nblocks);
+}
+
+static int coll_do_recursive_doubling(struct util_coll_operation *coll_op,
+				      uint64_t my_new_id, uint64_t pof2,
+				      uint64_t rem, void *result, void *tmp_buf,
+				      size_t count, enum fi_datatype datatype,
+				      enum fi_op op)
+{
+	uint64_t local, remote;
+	uint64_t mask = 1;
+	int ret;
+
+	local = coll_op->mc->local_rank;
+
+	while (mask < pof2) {
+		remote = coll_pof2_to_rank(my_new_id ^ mask, rem);
+
+		/* receive remote data into tmp buf */
+		ret = coll_sched_recv(coll_op, remote, tmp_buf,
+				      count, datatype, 0);
+		if (ret)
+			return ret;
+
+		/* send result buf, which has the current total */
+		ret = coll_sched_send(coll_op, remote, result,
+				      count, datatype, 1);
+		if (ret)
+			return ret;
+
+		if (remote < local) {
+			/* reduce received remote into result buf */
+			ret = coll_sched_reduce(coll_op, tmp_buf,
+					        result, count,
+					        datatype, op, 1);
+			if (ret)
+				return ret;
+		} else {
+			/* reduce local result into received data */
+			ret = coll_sched_reduce(coll_op, result,
+						tmp_buf, count,
+						datatype, op, 1);
+			if (ret)
+				return ret;
+
+			/* copy total into result */
+			ret = coll_sched_copy(coll_op, tmp_buf,
+					      result, count,
+					      datatype, 1);
+			if (ret)
+				return ret;
+		}
+		mask <<= 1;
+	}
+	return FI_SUCCESS;
+}
+
+/*
+ * Rabenseifner's algorithm: a reduce-scatter by recursive halving followed
+ * by an allgather by recursive doubling.  Each step exchanges half as much
+ * (then twice as much) data as the last, so every member moves about 2 *
+ * count values in total rather than count * log2(pof2).  The result is split
+ * into pof2 blocks; after the reduce-scatter each member owns the total for
+ * one block.
+ */
+static int coll_do_reduce_scatter_allgather(struct util_coll_operation *coll_op,
+					    uint64_t my_new_id, uint64_t pof2,
+					    uint64_t rem, void *result,
+					    void *tmp_buf, size_t count,
+					    enum fi_datatype datatype,
+					    enum fi_op op)
+{
+	uint64_t remote, new_remote, mask, step;
+	uint64_t send_idx = 0, recv_idx = 0, last_idx = pof2;
+	size_t send_off, send_cnt, recv_off, recv_cnt;
+	size_t dsize = ofi_datatype_size(datatype);
+	int ret;
+
+	for (mask = 1; mask < pof2; mask <<= 1) {
+		new_remote = my_new_id ^ mask;
+		remote = coll_pof2_to_rank(new_remote, rem);
+		step = pof2 / (mask * 2);
+
+		/* keep the lower half if we're the lower rank of the pair */
+		if (my_new_id < new_remote) {
+			send_idx = recv_idx + step;
+			send_off = coll_block_offset(count, pof2, send_idx);
+			send_cnt = coll_block_offset(count, pof2, last_idx) -
+				   send_off;
+			recv_off = coll_block_offset(count, pof2, recv_idx);
+			recv_cnt = send_off - recv_off;
+		} else {
+			recv_idx = send_idx + step;
+			send_off = coll_block_offset(count, pof2, send_idx);
+			recv_off = coll_block_offset(count, pof2, recv_idx);
+			send_cnt = recv_off - send_off;
+			recv_cnt = coll_block_offset(count, pof2, last_idx) -
+				   recv_off;
+		}
+
+		ret = coll_sched_recv(coll_op, remote,
+				      (char *) tmp_buf + recv_off * dsize,
+				      recv_cnt, datatype, 0);
+		if (ret)
+			return ret;
+
+		ret = coll_sched_send(coll_op, remote,
+				      (char *) result + send_off * dsize,
+				      send_cnt, datatype, 1);
+		if (ret)
+			return ret;
+
+		ret = coll_sched_reduce(coll_op,
+					(char *) tmp_buf + recv_off * dsize,
+					(char *) result + recv_off * dsize,
+					recv_cnt, datatype, op, 1);
+		if (ret)
+			return ret;
+
+		send_idx = recv_idx;
+		if ((mask << 1) < pof2)
+			last_idx = recv_idx + step;
+	}
+
+	/* gather the reduced blocks back, retracing the pairs in reverse */
+	for (mask = pof2 >> 1; mask > 0; mask >>= 1) {
+		new_remote = my_new_id ^ mask;
+		remote = coll_pof2_to_rank(new_remote, rem);
+		step = pof2 / (mask * 2);
+
+		if (my_new_id < new_remote) {
+			if (mask != pof2 >> 1)
+				last_idx += step;
+			recv_idx = send_idx + step;
+			send_off = coll_block_offset(count, pof2, send_idx);
+			recv_off = coll_block_offset(count, pof2, recv_idx);
+			send_cnt = recv_off - send_off;
+			recv_cnt = coll_block_offset(count, pof2, last_idx) -
+				   recv_off;
+		} else {
+			recv_idx = send_idx - step;
+			send_off = coll_block_offset(count, pof2, send_idx);
+			send_cnt = coll_block_offset(count, pof2, last_idx) -
+				   send_off;
+			recv_off = coll_block_offset(count, pof2, recv_idx);
+			recv_cnt = send_off - recv_off;
+		}
+
+		ret = coll_sched_recv(coll_op, remote,
+				      (char *) result + recv_off * dsize,
+				      recv_cnt, datatype, 0);
+		if (ret)
+			return ret;
+
+		ret = coll_sched_send(coll_op, remote,
+				      (char *) result + send_off * dsize,
+				      send_cnt, datatype, 1);
+		if (ret)
+			return ret;
+
+		if (my_new_id > new_remote)
+			send_idx = recv_idx;
+	}
+
+	return FI_SUCCESS;
+}
+
+/*
+ * Ring reduce-scatter of buf split into numranks blocks, passing partial sums
+ * to the right.  After numranks - 1 steps we hold the total for block
+ * owned_idx.  tmp_buf must hold the largest block.
+ */
+static int coll_do_ring_reduce_scatter(struct util_coll_operation *coll_op,
+				       void *buf, void *tmp_buf, size_t count,
+				       uint64_t owned_idx,
+				       enum fi_datatype datatype,
+				       enum fi_op op)
+{
+	uint64_t i, local_rank, left_rank, right_rank, send_idx, recv_idx;
+	size_t numranks, send_off, recv_off, recv_cnt;
+	size_t dsize = ofi_datatype_size(datatype);
+	int ret;
+
+	local_rank = coll_op->mc->local_rank;
+	numranks = coll_op->mc->av_set->fi_addr_count;
+	left_rank = (numranks + local_rank - 1) % numranks;
+	right_rank = (local_rank + 1) % numranks;
+
+	send_idx = (numranks + owned_idx - 1) % numranks;
+	for (i = 1; i < numranks; i++) {
+		recv_idx = (numranks + send_idx - 1) % numranks;
+		send_off = coll_block_offset(count, numranks, send_idx);
+		recv_off = coll_block_offset(count, numranks, recv_idx);
+		recv_cnt = coll_block_offset(count, numranks, recv_idx + 1) -
+			   recv_off;
+
+		ret = coll_sched_recv(coll_op, left_rank, tmp_buf, recv_cnt,
+				      datatype, 0);
+		if (ret)
+			return ret;
+
+		ret = coll_sched_send(coll_op, right_rank,
+				      (char *) buf + send_off * dsize,
+				      coll_block_offset(count, numranks,
+							send_idx + 1) - send_off,
+				      datatype, 1);
+		if (ret)
+			return ret;
+
+		ret = coll_sched_reduce(coll_op, tmp_buf,
+					(char *) buf + recv_off * dsize,
+					recv_cnt, datatype, op, 1);
+		if (ret)
+			return ret;
+
+		send_idx = recv_idx;
+	}
+
+	return FI_SUCCESS;
+}
+
+/*
+ * Ring allreduce: a ring reduce-scatter followed by a ring allgather of
+ * numranks blocks.  Bandwidth optimal for any number of members, but takes
+ * 2 * (numranks - 1) steps, so it is only used for large messages when the
+ * member count is not a power of two.
+ */
+static int coll_do_allreduce_ring(struct util_coll_operation *coll_op,
+				  const void *send_buf, void *result,
+				  void *tmp_buf, size_t count,
+				  enum fi_datatype datatype, enum fi_op op)
+{
+	uint64_t i, local_rank, left_rank, right_rank, send_idx, recv_idx;
+	size_t numranks, send_off, recv_off;
+	size_t dsize = ofi_datatype_size(datatype);
+	int ret;
+
+	local_rank = coll_op->mc->local_rank;
+	numranks = coll_op->mc->av_set->fi_addr_count;
+	left_rank = (numranks + local_rank - 1) % numranks;
+	right_rank = (local_rank + 1) % numranks;
+
+	if (result != send_buf)
+		memcpy(result, send_buf, count * dsize);
+
+	ret = coll_do_ring_reduce_scatter(coll_op, result, tmp_buf, count,
+					  right_rank, datatype, op);
+	if (ret)
+		return ret;
+
+	/* circulate the totals */
+	send_idx = right_rank;
+	for (i = 1; i < numranks; i++) {
+		recv_idx = (numranks + send_idx - 1) % numranks;
+		send_off = coll_block_offset(count, numranks, send_idx);
+		recv_off = coll_block_offset(count, numranks, recv_idx);
+
+		ret = coll_sched_recv(coll_op, left_rank,
+				      (char *) result + recv_off * dsize,
+				      coll_block_offset(count, numranks,
+							recv_idx + 1) - recv_off,
+				      datatype, 0);
+		if (ret)
+			return ret;
+
+		ret = coll_sched_send(coll_op, right_rank,
+				      (char *) result + send_off * dsize,
+				      coll_block_offset(count, numranks,
+							send_idx + 1) - send_off,
+				      datatype, 1);
+		if (ret)
+			return ret;
+
+		send_idx = recv_idx;
+	}
+
+	return FI_SUCCESS;
+}
+
+/*
+ * All members compute the same choice from the same inputs, so the
+ * schedules on every member pair up.
+ */
+static enum coll_allreduce_algo
+coll_select_allreduce(size_t numranks, size_t count, enum fi_datatype datatype)
+{
+	enum coll_allreduce_algo algo = coll_env.allreduce_algo;
+	uint64_t pof2 = rounddown_power_of_two(numranks);
+
+	if (algo == COLL_ALLREDUCE_AUTO) {
+		if (count * ofi_datatype_size(datatype) <
+		    coll_env.allreduce_threshold)
+			algo = COLL_ALLREDUCE_RECURSIVE_DOUBLING;
+		else if (pof2 == numranks)
+			algo = COLL_ALLREDUCE_RABENSEIFNER;
+		else
+			algo = COLL_ALLREDUCE_RING;
+	}
+
+	/* every block must hold at least one value */
+	if ((algo == COLL_ALLREDUCE_RABENSEIFNER && count < pof2) ||
+	    (algo == COLL_ALLREDUCE_RING && count < numranks) ||
+	    numranks < 2)
+		algo = COLL_ALLREDUCE_RECURSIVE_DOUBLING;
+
+	return algo;
+}
+
+static int coll_do_allreduce_hier(struct util_coll_operation *coll_op,
+				  const void *send_buf, void *result,
+				  void *tmp_buf, uint64_t count,
+				  enum fi_datatype datatype, enum fi_op op);
+
 /*
  * TODO:
  * when this fails, clean up the already scheduled work in this function
@@ -350,18 +674,37 @@ static int coll_do_allreduce(struct util_coll_operation *coll_op,
 			     void* tmp_buf, uint64_t count,
 			     enum fi_datatype datatype, enum fi_op op)
 {
-	uint64_t rem, pof2, my_new_id;
-	uint64_t local, remote, next_remote;
+	enum coll_allreduce_algo algo;
+	uint64_t numranks, rem, pof2, my_new_id;
+	uint64_t local;
 	int ret;
-	uint64_t mask = 1;
 
-	pof2 = rounddown_power_of_two(coll_op->mc->av_set->fi_addr_count);
-	rem = coll_op->mc->av_set->fi_addr_count - pof2;
+	if (coll_op->mc->node_mc)
+		return coll_do_allreduce_hier(coll_op, send_buf, result,
+					      tmp_buf, count, datatype, op);
+
+	numranks = coll_op->mc->av_set->fi_addr_count;
+	algo = coll_select_allreduce(numranks, count, datatype);
+	FI_DBG(coll_op->mc->av_set->av->prov, FI_LOG_CQ,
+	       "allreduce cnt: %ld ranks: %ld algo: %d\n", count, numranks,
+	       algo);
+
+	if (algo == COLL_ALLREDUCE_RING)
+		return coll_do_allreduce_ring(coll_op, send_buf, result,
+					      tmp_buf, count, datatype, op);
+
+	pof2 = rounddown_power_of_two(numranks);
+	rem = numranks - pof2;
 	local = coll_op->mc->local_rank;
 
 	/* copy initial send data to result */
-	memcpy(result, send_buf, count * ofi_datatype_size(datatype));
+	if (result != send_buf)
+		memcpy(result, send_buf, count * ofi_datatype_size(datatype));
 
+	/*
+	 * Fold the first 2 * rem members in pairs so that a power of two
+	 * remain.
+	 */
 	if (local < 2 * rem) {
 		if (local % 2 == 0) {
 			ret = coll_sched_send(coll_op, local + 1, result,
@@ -388,47 +731,16 @@ static int coll_do_allreduce(struct util_coll_operation *coll_op,
 	}
 
 	if (my_new_id != -1) {
-		while (mask < pof2) {
-			next_remote = my_new_id ^ mask;
-			remote = (next_remote < rem) ? next_remote * 2 + 1 :
-				next_remote + rem;
-
-			/* receive remote data into tmp buf */
-			ret = coll_sched_recv(coll_op, remote, tmp_buf,
-					      count, datatype, 0);
-			if (ret)
-				return ret;
-
-			/* send result buf, which has the current total */
-			ret = coll_sched_send(coll_op, remote, result,
-					      count, datatype, 1);
-			if (ret)
-				return ret;
-
-			if (remote < local) {
-				/* reduce received remote into result buf */
-				ret = coll_sched_reduce(coll_op, tmp_buf,
-						        result, count,
-						        datatype, op, 1);
-				if (ret)
-					return ret;
-			} else {
-				/* reduce local result into received data */
-				ret = coll_sched_reduce(coll_op, result,
-							tmp_buf, count,
-							datatype, op, 1);
-				if (ret)
-					return ret;
-
-				/* copy total into result */
-				ret = coll_sched_copy(coll_op, tmp_buf,
-						      result, count,
-						      datatype, 1);
-				if (ret)
-					return ret;
-			}
-			mask <<= 1;
-		}
+		if (algo == COLL_ALLREDUCE_RABENSEIFNER)
+			ret = coll_do_reduce_scatter_allgather(coll_op,
+					my_new_id, pof2, rem, result, tmp_buf,
+					count, datatype, op);
+		else
+			ret = coll_do_recursive_doubling(coll_op, my_new_id,
+					pof2, rem, result, tmp_buf, count,
+					datatype, op);
+		if (ret)
+			return ret;
 	}
 
 	if (local < 2 * rem) {
@@ -561,83 +873,746 @@ static int coll_do_scatter(struct util_coll_operation *coll_op,
 			if (ret)
 				return ret;
 
-			ret = coll_sched_copy(coll_op, (char *) data,
-					      (char *) *temp + (numranks - local_rank) * nbytes,
-					      local_rank * count, datatype, 1);
-			if (ret)
-				return ret;
-		}
+			ret = coll_sched_copy(coll_op, (char *) data,
+					      (char *) *temp + (numranks - local_rank) * nbytes,
+					      local_rank * count, datatype, 1);
+			if (ret)
+				return ret;
+		}
+	}
+
+	/* set up all receives */
+	mask = 0x1;
+	while (mask < numranks) {
+		if (relative_rank & mask) {
+			remote_rank = local_rank - mask;
+			if (remote_rank < 0)
+				remote_rank += numranks;
+
+			if (relative_rank % 2) {
+				/* leaf node, receive our data */
+				ret = coll_sched_recv(coll_op, remote_rank,
+						      result, count, datatype,
+						      1);
+				if (ret)
+					return ret;
+			} else {
+				/* branch node, receive data to forward */
+				ret = coll_sched_recv(coll_op, remote_rank,
+						      *temp, cur_cnt, datatype,
+						      1);
+				if (ret)
+					return ret;
+			}
+			break;
+		}
+		mask <<= 1;
+	}
+
+	/* set up all sends */
+	send_data = root == local_rank && root == 0 ? (void *) data : *temp;
+	mask >>= 1;
+	while (mask > 0) {
+		if (relative_rank + mask < numranks) {
+			/*
+			 * To this point, cur_cnt has represented the number of
+			 * values to expect to store in our data buf.  From here
+			 * on, cur_cnt is the number of values we have left to
+			 * forward from the data buf.
+			 */
+			send_cnt = cur_cnt - count * mask;
+
+			remote_rank = local_rank + mask;
+			if ((uint64_t) remote_rank >= numranks)
+				remote_rank -= numranks;
+
+			FI_DBG(coll_op->mc->av_set->av->prov, FI_LOG_CQ,
+			       "MASK: 0x%0lx CUR_CNT: %ld SENDING: %ld TO: %ld\n",
+			       mask, cur_cnt, send_cnt, remote_rank);
+
+			assert(send_cnt > 0);
+
+			ret = coll_sched_send(coll_op, remote_rank,
+					      (char *) send_data + nbytes * mask,
+					      send_cnt, datatype, 1);
+			if (ret)
+				return ret;
+
+			cur_cnt -= send_cnt;
+		}
+		mask >>= 1;
+	}
+
+	if (!(relative_rank % 2)) {
+		/*
+		 * for the root and all even nodes, we've got to copy
+		 * our local data to the result buffer
+		 */
+		ret = coll_sched_copy(coll_op, send_data, result,
+				      count, datatype, 1);
+		if (ret)
+			return ret;
+	}
+
+	return FI_SUCCESS;
+}
+
+/*
+ * Bruck alltoall: log2(numranks) steps, each forwarding the blocks whose
+ * index has the step bit set.  Blocks travel several hops, but small
+ * messages need far fewer sends than a pairwise exchange.
+ */
+static int coll_do_alltoall_bruck(struct util_coll_operation *coll_op,
+				  const void *send_buf, void *result,
+				  void **temp, size_t count,
+				  enum fi_datatype datatype)
+{
+	uint64_t local_rank, mask, i, blk_cnt, pack_cnt;
+	size_t nbytes, numranks, half;
+	char *tmp, *pack, *unpack;
+	int ret;
+
+	local_rank = coll_op->mc->local_rank;
+	numranks = coll_op->mc->av_set->fi_addr_count;
+	nbytes = count * ofi_datatype_size(datatype);
+	half = (numranks + 1) / 2;
+
+	*temp = malloc((numranks + 2 * half) * nbytes);
+	if (!*temp)
+		return -FI_ENOMEM;
+
+	tmp = *temp;
+	pack = tmp + numranks * nbytes;
+	unpack = pack + half * nbytes;
+
+	/* rotate so that the block for rank local_rank + i is at index i */
+	ret = coll_sched_copy(coll_op,
+			      (char *) send_buf + local_rank * nbytes, tmp,
+			      (numranks - local_rank) * count, datatype, 1);
+	if (ret)
+		return ret;
+
+	ret = coll_sched_copy(coll_op, (void *) send_buf,
+			      tmp + (numranks - local_rank) * nbytes,
+			      local_rank * count, datatype, 1);
+	if (ret)
+		return ret;
+
+	for (mask = 1; mask < numranks; mask <<= 1) {
+		/* blocks with the mask bit set come in runs of mask blocks */
+		pack_cnt = 0;
+		for (i = mask; i < numranks; i += 2 * mask) {
+			blk_cnt = MIN(mask, numranks - i);
+			ret = coll_sched_copy(coll_op, tmp + i * nbytes,
+					      pack + pack_cnt * nbytes,
+					      blk_cnt * count, datatype, 1);
+			if (ret)
+				return ret;
+			pack_cnt += blk_cnt;
+		}
+
+		ret = coll_sched_recv(coll_op,
+				      (numranks + local_rank - mask) % numranks,
+				      unpack, pack_cnt * count, datatype, 0);
+		if (ret)
+			return ret;
+
+		ret = coll_sched_send(coll_op, (local_rank + mask) % numranks,
+				      pack, pack_cnt * count, datatype, 1);
+		if (ret)
+			return ret;
+
+		pack_cnt = 0;
+		for (i = mask; i < numranks; i += 2 * mask) {
+			blk_cnt = MIN(mask, numranks - i);
+			ret = coll_sched_copy(coll_op, unpack + pack_cnt * nbytes,
+					      tmp + i * nbytes,
+					      blk_cnt * count, datatype, 1);
+			if (ret)
+				return ret;
+			pack_cnt += blk_cnt;
+		}
+	}
+
+	/* index i now holds the block from rank local_rank - i */
+	for (i = 0; i < numranks; i++) {
+		ret = coll_sched_copy(coll_op, tmp + i * nbytes,
+				      (char *) result +
+				      ((numranks + local_rank - i) % numranks) *
+				      nbytes, count, datatype, 1);
+		if (ret)
+			return ret;
+	}
+
+	return FI_SUCCESS;
+}
+
+/* pairwise exchange alltoall, sending each block straight to its owner */
+static int coll_do_alltoall_pairwise(struct util_coll_operation *coll_op,
+				     const void *send_buf, void *result,
+				     size_t count, enum fi_datatype datatype)
+{
+	uint64_t local_rank, i, src, dst;
+	size_t nbytes, numranks;
+	int pof2, ret;
+
+	local_rank = coll_op->mc->local_rank;
+	numranks = coll_op->mc->av_set->fi_addr_count;
+	nbytes = count * ofi_datatype_size(datatype);
+	pof2 = rounddown_power_of_two(numranks) == numranks;
+
+	ret = coll_sched_copy(coll_op,
+			      (char *) send_buf + local_rank * nbytes,
+			      (char *) result + local_rank * nbytes,
+			      count, datatype, 1);
+	if (ret)
+		return ret;
+
+	for (i = 1; i < numranks; i++) {
+		if (pof2) {
+			src = dst = local_rank ^ i;
+		} else {
+			src = (numranks + local_rank - i) % numranks;
+			dst = (local_rank + i) % numranks;
+		}
+
+		ret = coll_sched_recv(coll_op, src,
+				      (char *) result + src * nbytes,
+				      count, datatype, 0);
+		if (ret)
+			return ret;
+
+		ret = coll_sched_send(coll_op, dst,
+				      (char *) send_buf + dst * nbytes,
+				      count, datatype, 1);
+		if (ret)
+			return ret;
+	}
+
+	return FI_SUCCESS;
+}
+
+static int coll_do_alltoall(struct util_coll_operation *coll_op,
+			    const void *send_buf, void *result, void **temp,
+			    size_t count, enum fi_datatype datatype)
+{
+	size_t nbytes = count * ofi_datatype_size(datatype);
+
+	if (count == 0)
+		return FI_SUCCESS;
+
+	if (nbytes < coll_env.alltoall_threshold)
+		return coll_do_alltoall_bruck(coll_op, send_buf, result, temp,
+					      count, datatype);
+
+	return coll_do_alltoall_pairwise(coll_op, send_buf, result, count,
+					 datatype);
+}
+
+/* offset of the block owned by the member(s) behind new_id, in elements */
+static size_t coll_pof2_block_offset(size_t count, uint64_t new_id,
+				     uint64_t rem)
+{
+	return count * ((new_id < rem) ? new_id * 2 : new_id + rem);
+}
+
+/*
+ * Reduce-scatter by recursive halving.  As with allreduce, the first 2 * rem
+ * members fold in pairs; the odd member of a pair then works on behalf of
+ * both and hands the even member its block at the end.  temp holds the
+ * running total and a receive buffer, each count * numranks values.
+ */
+static int coll_do_recursive_halving(struct util_coll_operation *coll_op,
+				     const void *send_buf, void *result,
+				     void *temp, size_t count,
+				     enum fi_datatype datatype, enum fi_op op)
+{
+	uint64_t local, numranks, pof2, rem, my_new_id, new_remote, remote;
+	uint64_t mask, send_idx, recv_idx, last_idx;
+	size_t send_off, send_cnt, recv_off, recv_cnt, total;
+	size_t dsize = ofi_datatype_size(datatype);
+	char *accum, *tmp_buf;
+	int ret;
+
+	local = coll_op->mc->local_rank;
+	numranks = coll_op->mc->av_set->fi_addr_count;
+	pof2 = rounddown_power_of_two(numranks);
+	rem = numranks - pof2;
+	total = count * numranks;
+	accum = temp;
+	tmp_buf = accum + total * dsize;
+
+	memcpy(accum, send_buf, total * dsize);
+
+	if (local < 2 * rem) {
+		if (local % 2 == 0) {
+			ret = coll_sched_send(coll_op, local + 1, accum,
+					      total, datatype, 1);
+			if (ret)
+				return ret;
+
+			return coll_sched_recv(coll_op, local + 1, result,
+					       count, datatype, 1);
+		}
+
+		ret = coll_sched_recv(coll_op, local - 1, tmp_buf, total,
+				      datatype, 1);
+		if (ret)
+			return ret;
+
+		ret = coll_sched_reduce(coll_op, tmp_buf, accum, total,
+					datatype, op, 1);
+		if (ret)
+			return ret;
+
+		my_new_id = local / 2;
+	} else {
+		my_new_id = local - rem;
+	}
+
+	send_idx = recv_idx = 0;
+	last_idx = pof2;
+	for (mask = pof2 >> 1; mask > 0; mask >>= 1) {
+		new_remote = my_new_id ^ mask;
+		remote = coll_pof2_to_rank(new_remote, rem);
+
+		/* keep the half that holds our own block */
+		if (my_new_id < new_remote) {
+			send_idx = recv_idx + mask;
+			send_off = coll_pof2_block_offset(count, send_idx, rem);
+			send_cnt = coll_pof2_block_offset(count, last_idx,
+							  rem) - send_off;
+			recv_off = coll_pof2_block_offset(count, recv_idx, rem);
+			recv_cnt = send_off - recv_off;
+		} else {
+			recv_idx = send_idx + mask;
+			send_off = coll_pof2_block_offset(count, send_idx, rem);
+			recv_off = coll_pof2_block_offset(count, recv_idx, rem);
+			send_cnt = recv_off - send_off;
+			recv_cnt = coll_pof2_block_offset(count, last_idx,
+							  rem) - recv_off;
+		}
+
+		ret = coll_sched_recv(coll_op, remote,
+				      tmp_buf + recv_off * dsize,
+				      recv_cnt, datatype, 0);
+		if (ret)
+			return ret;
+
+		ret = coll_sched_send(coll_op, remote,
+				      accum + send_off * dsize,
+				      send_cnt, datatype, 1);
+		if (ret)
+			return ret;
+
+		ret = coll_sched_reduce(coll_op, tmp_buf + recv_off * dsize,
+					accum + recv_off * dsize,
+					recv_cnt, datatype, op, 1);
+		if (ret)
+			return ret;
+
+		send_idx = recv_idx;
+		last_idx = recv_idx + mask;
+	}
+
+	ret = coll_sched_copy(coll_op, accum + local * count * dsize, result,
+			      count, datatype, 1);
+	if (ret)
+		return ret;
+
+	if (local < 2 * rem)
+		return coll_sched_send(coll_op, local - 1,
+				       accum + (local - 1) * count * dsize,
+				       count, datatype, 1);
+
+	return FI_SUCCESS;
+}
+
+/* reduce count * numranks values, leaving block local_rank in result */
+static int coll_do_reduce_scatter(struct util_coll_operation *coll_op,
+				  const void *send_buf, void *result,
+				  void **temp, size_t count,
+				  enum fi_datatype datatype, enum fi_op op)
+{
+	uint64_t local_rank;
+	size_t numranks, total, dsize;
+	int ret;
+
+	local_rank = coll_op->mc->local_rank;
+	numranks = coll_op->mc->av_set->fi_addr_count;
+	dsize = ofi_datatype_size(datatype);
+	total = count * numranks;
+
+	if (count == 0)
+		return FI_SUCCESS;
+
+	*temp = malloc(2 * total * dsize);
+	if (!*temp)
+		return -FI_ENOMEM;
+
+	/*
+	 * Folding the extra members doubles their traffic, so large messages
+	 * on a member count that's not a power of two go around a ring.
+	 */
+	if (rounddown_power_of_two(numranks) == numranks ||
+	    total * dsize < coll_env.reduce_scatter_threshold)
+		return coll_do_recursive_halving(coll_op, send_buf, result,
+						 *temp, count, datatype, op);
+
+	memcpy(*temp, send_buf, total * dsize);
+	ret = coll_do_ring_reduce_scatter(coll_op, *temp,
+					  (char *) *temp + total * dsize,
+					  total, local_rank, datatype, op);
+	if (ret)
+		return ret;
+
+	return coll_sched_copy(coll_op,
+			       (char *) *temp + local_rank * count * dsize,
+			       result, count, datatype, 1);
+}
+
+/* Reduce implemented with binomial tree algorithm */
+static int coll_do_reduce_binomial(struct util_coll_operation *coll_op,
+				   void *accum, void *tmp_buf, size_t count,
+				   uint64_t root, enum fi_datatype datatype,
+				   enum fi_op op)
+{
+	uint64_t local_rank, relative_rank, child, mask;
+	size_t numranks;
+	int ret;
+
+	local_rank = coll_op->mc->local_rank;
+	numranks = coll_op->mc->av_set->fi_addr_count;
+	relative_rank = (numranks + local_rank - root) % numranks;
+
+	for (mask = 1; mask < numranks; mask <<= 1) {
+		if (relative_rank & mask) {
+			/* our subtree is complete, pass it up */
+			return coll_sched_send(coll_op,
+					       ((relative_rank & ~mask) + root) %
+					       numranks, accum, count,
+					       datatype, 1);
+		}
+
+		child = relative_rank | mask;
+		if (child >= numranks)
+			continue;
+
+		ret = coll_sched_recv(coll_op, (child + root) % numranks,
+				      tmp_buf, count, datatype, 1);
+		if (ret)
+			return ret;
+
+		ret = coll_sched_reduce(coll_op, tmp_buf, accum, count,
+					datatype, op, 1);
+		if (ret)
+			return ret;
+	}
+
+	return FI_SUCCESS;
+}
+
+/*
+ * Large reductions use a ring reduce-scatter, after which each member sends
+ * its block of the total to the root.  This keeps the root from receiving
+ * and reducing log2(numranks) full buffers.
+ */
+static int coll_do_reduce_ring(struct util_coll_operation *coll_op,
+			       void *accum, void *tmp_buf, size_t count,
+			       uint64_t root, enum fi_datatype datatype,
+			       enum fi_op op)
+{
+	uint64_t local_rank, i, last;
+	size_t numranks, off, dsize;
+	int ret;
+
+	local_rank = coll_op->mc->local_rank;
+	numranks = coll_op->mc->av_set->fi_addr_count;
+	dsize = ofi_datatype_size(datatype);
+
+	ret = coll_do_ring_reduce_scatter(coll_op, accum, tmp_buf, count,
+					  local_rank, datatype, op);
+	if (ret)
+		return ret;
+
+	off = coll_block_offset(count, numranks, local_rank);
+	if (local_rank != root)
+		return coll_sched_send(coll_op, root,
+				       (char *) accum + off * dsize,
+				       coll_block_offset(count, numranks,
+							 local_rank + 1) - off,
+				       datatype, 1);
+
+	/* fence the final receive so completion waits for all of them */
+	last = (root == numranks - 1) ? numranks - 2 : numranks - 1;
+	for (i = 0; i < numranks; i++) {
+		if (i == root)
+			continue;
+
+		off = coll_block_offset(count, numranks, i);
+		ret = coll_sched_recv(coll_op, i, (char *) accum + off * dsize,
+				      coll_block_offset(count, numranks, i + 1) -
+				      off, datatype, i == last);
+		if (ret)
+			return ret;
+	}
+
+	return FI_SUCCESS;
+}
+
+/* reduce the accum buffers of all members into accum at the root */
+static int coll_do_reduce_accum(struct util_coll_operation *coll_op,
+				void *accum, void *tmp_buf, size_t count,
+				uint64_t root, enum fi_datatype datatype,
+				enum fi_op op)
+{
+	size_t numranks;
+
+	numranks = coll_op->mc->av_set->fi_addr_count;
+	if (count * ofi_datatype_size(datatype) >= coll_env.reduce_threshold &&
+	    count >= numranks && numranks > 1)
+		return coll_do_reduce_ring(coll_op, accum, tmp_buf, count,
+					   root, datatype, op);
+
+	return coll_do_reduce_binomial(coll_op, accum, tmp_buf, count, root,
+				       datatype, op);
+}
+
+static int coll_do_reduce(struct util_coll_operation *coll_op,
+			  const void *send_buf, void *result, void **temp,
+			  size_t count, uint64_t root,
+			  enum fi_datatype datatype, enum fi_op op)
+{
+	size_t nbytes;
+	void *accum, *tmp_buf;
+
+	nbytes = count * ofi_datatype_size(datatype);
+
+	if (count == 0)
+		return FI_SUCCESS;
+
+	/* only the root has a result buffer to accumulate into */
+	*temp = malloc(2 * nbytes);
+	if (!*temp)
+		return -FI_ENOMEM;
+
+	if (coll_op->mc->local_rank == root) {
+		accum = result;
+		tmp_buf = *temp;
+	} else {
+		accum = *temp;
+		tmp_buf = (char *) *temp + nbytes;
+	}
+	memcpy(accum, send_buf, nbytes);
+
+	return coll_do_reduce_accum(coll_op, accum, tmp_buf, count, root,
+				    datatype, op);
+}
+
+/* Broadcast implemented with binomial tree algorithm */
+static int coll_do_bcast_binomial(struct util_coll_operation *coll_op,
+				  void *buf, size_t count, uint64_t root,
+				  enum fi_datatype datatype)
+{
+	uint64_t local_rank, relative_rank, child, mask;
+	size_t numranks;
+	int ret;
+
+	local_rank = coll_op->mc->local_rank;
+	numranks = coll_op->mc->av_set->fi_addr_count;
+	relative_rank = (numranks + local_rank - root) % numranks;
+
+	for (mask = 1; mask < numranks; mask <<= 1) {
+		if (relative_rank & mask) {
+			ret = coll_sched_recv(coll_op,
+					      ((relative_rank & ~mask) + root) %
+					      numranks, buf, count, datatype, 1);
+			if (ret)
+				return ret;
+			break;
+		}
+	}
+
+	/*
+	 * Pass the data down to our subtrees.  The send for mask 1 is always
+	 * the last, fence it so completion waits for all of them.
+	 */
+	for (mask >>= 1; mask; mask >>= 1) {
+		child = relative_rank | mask;
+		if (child >= numranks)
+			continue;
+
+		ret = coll_sched_send(coll_op, (child + root) % numranks,
+				      buf, count, datatype, mask == 1);
+		if (ret)
+			return ret;
+	}
+
+	return FI_SUCCESS;
+}
+
+/*
+ * Two level allreduce for groups whose members span several nodes: each
+ * node reduces into its leader, the leaders allreduce among themselves,
+ * and each leader broadcasts the total back to its node.  Only one member
+ * per node sends over the network.  The levels are scheduled on the node
+ * and leader sub-groups, so ranks and addresses are those of the sub-group.
+ *
+ * Sub-group ranks repeat between the levels, and receives are matched by
+ * tag alone, so the leader level is given its own collective id.
+ */
+static int coll_do_allreduce_hier(struct util_coll_operation *coll_op,
+				  const void *send_buf, void *result,
+				  void *tmp_buf, uint64_t count,
+				  enum fi_datatype datatype, enum fi_op op)
+{
+	struct util_coll_mc *coll_mc = coll_op->mc;
+	uint32_t cid = coll_op->cid;
+	uint32_t leader_cid;
+	int ret;
+
+	/* taken by every member, leader or not, to keep the ids in step */
+	leader_cid = coll_get_next_id(coll_mc);
+
+	if (result != send_buf)
+		memcpy(result, send_buf, count * ofi_datatype_size(datatype));
+
+	coll_op->mc = coll_mc->node_mc;
+	ret = coll_do_reduce_accum(coll_op, result, tmp_buf, count, 0,
+				   datatype, op);
+	if (ret)
+		goto out;
+
+	if (coll_mc->leader_mc) {
+		coll_op->mc = coll_mc->leader_mc;
+		coll_op->cid = leader_cid;
+		ret = coll_do_allreduce(coll_op, result, result, tmp_buf,
+					count, datatype, op);
+		if (ret)
+			goto out;
+		coll_op->mc = coll_mc->node_mc;
+		coll_op->cid = cid;
+	}
+
+	ret = coll_do_bcast_binomial(coll_op, result, count, 0, datatype);
+out:
+	coll_op->mc = coll_mc;
+	coll_op->cid = cid;
+	return ret;
+}
+
+/* Gather implemented with binomial tree algorithm */
+static int coll_do_gather_binomial(struct util_coll_operation *coll_op,
+				   const void *send_buf, void *result,
+				   void **temp, size_t count, uint64_t root,
+				   enum fi_datatype datatype)
+{
+	uint64_t local_rank, relative_rank, mask, child;
+	size_t nbytes, numranks, cur_cnt, recv_cnt;
+	char *buf;
+	int ret;
+
+	local_rank = coll_op->mc->local_rank;
+	numranks = coll_op->mc->av_set->fi_addr_count;
+	relative_rank = (numranks + local_rank - root) % numranks;
+	nbytes = count * ofi_datatype_size(datatype);
+
+	/* leaf nodes send their data straight up */
+	if (relative_rank % 2)
+		return coll_sched_send(coll_op,
+				       (numranks + local_rank - 1) % numranks,
+				       (void *) send_buf, count, datatype, 1);
+
+	/*
+	 * Branch nodes collect their subtree in relative rank order; the
+	 * root receives into the result buffer directly when it's rank 0.
+	 */
+	if (local_rank == root && root == 0) {
+		buf = result;
+	} else {
+		*temp = malloc((relative_rank ?
+				util_binomial_tree_values_to_recv(relative_rank,
+								  numranks) :
+				numranks) * nbytes);
+		if (!*temp)
+			return -FI_ENOMEM;
+		buf = *temp;
 	}
 
-	/* set up all receives */
-	mask = 0x1;
-	while (mask < numranks) {
-		if (relative_rank & mask) {
-			remote_rank = local_rank - mask;
-			if (remote_rank < 0)
-				remote_rank += numranks;
+	ret = coll_sched_copy(coll_op, (void *) send_buf, buf, count,
+			      datatype, 1);
+	if (ret)
+		return ret;
 
-			if (relative_rank % 2) {
-				/* leaf node, receive our data */
-				ret = coll_sched_recv(coll_op, remote_rank,
-						      result, count, datatype,
-						      1);
-				if (ret)
-					return ret;
-			} else {
-				/* branch node, receive data to forward */
-				ret = coll_sched_recv(coll_op, remote_rank,
-						      *temp, cur_cnt, datatype,
-						      1);
-				if (ret)
-					return ret;
-			}
-			break;
-		}
-		mask <<= 1;
+	cur_cnt = 1;
+	for (mask = 1; mask < numranks; mask <<= 1) {
+		if (relative_rank & mask)
+			return coll_sched_send(coll_op,
+					       (numranks + local_rank - mask) %
+					       numranks, buf, cur_cnt * count,
+					       datatype, 1);
+
+		child = relative_rank + mask;
+		if (child >= numranks)
+			continue;
+
+		recv_cnt = MIN(mask, numranks - child);
+		ret = coll_sched_recv(coll_op, (child + root) % numranks,
+				      buf + mask * nbytes, recv_cnt * count,
+				      datatype, 1);
+		if (ret)
+			return ret;
+		cur_cnt += recv_cnt;
 	}
 
-	/* set up all sends */
-	send_data = root == local_rank && root == 0 ? (void *) data : *temp;
-	mask >>= 1;
-	while (mask > 0) {
-		if (relative_rank + mask < numranks) {
-			/*
-			 * To this point, cur_cnt has represented the number of
-			 * values to expect to store in our data buf.  From here
-			 * on, cur_cnt is the number of values we have left to
-			 * forward from the data buf.
-			 */
-			send_cnt = cur_cnt - count * mask;
+	if (root == 0)
+		return FI_SUCCESS;
 
-			remote_rank = local_rank + mask;
-			if ((uint64_t) remote_rank >= numranks)
-				remote_rank -= numranks;
+	/* undo the rotation by root */
+	ret = coll_sched_copy(coll_op, buf, (char *) result + root * nbytes,
+			      (numranks - root) * count, datatype, 1);
+	if (ret)
+		return ret;
 
-			FI_DBG(coll_op->mc->av_set->av->prov, FI_LOG_CQ,
-			       "MASK: 0x%0lx CUR_CNT: %ld SENDING: %ld TO: %ld\n",
-			       mask, cur_cnt, send_cnt, remote_rank);
+	return coll_sched_copy(coll_op, buf + (numranks - root) * nbytes,
+			       result, root * count, datatype, 1);
+}
 
-			assert(send_cnt > 0);
+/*
+ * Large blocks are sent directly to the root, rather than being forwarded
+ * and copied up to log2(numranks) times through the tree.
+ */
+static int coll_do_gather_linear(struct util_coll_operation *coll_op,
+				 const void *send_buf, void *result,
+				 size_t count, uint64_t root,
+				 enum fi_datatype datatype)
+{
+	uint64_t local_rank, i, last;
+	size_t nbytes, numranks;
+	int ret;
 
-			ret = coll_sched_send(coll_op, remote_rank,
-					      (char *) send_data + nbytes * mask,
-					      send_cnt, datatype, 1);
-			if (ret)
-				return ret;
+	local_rank = coll_op->mc->local_rank;
+	numranks = coll_op->mc->av_set->fi_addr_count;
+	nbytes = count * ofi_datatype_size(datatype);
 
-			cur_cnt -= send_cnt;
-		}
-		mask >>= 1;
-	}
+	if (local_rank != root)
+		return coll_sched_send(coll_op, root, (void *) send_buf, count,
+				       datatype, 1);
 
-	if (!(relative_rank % 2)) {
-		/*
-		 * for the root and all even nodes, we've got to copy
-		 * our local data to the result buffer
-		 */
-		ret = coll_sched_copy(coll_op, send_data, result,
-				      count, datatype, 1);
+	ret = coll_sched_copy(coll_op, (void *) send_buf,
+			      (char *) result + root * nbytes, count,
+			      datatype, 1);
+	if (ret)
+		return ret;
+
+	/* fence the final receive so completion waits for all of them */
+	last = (root == numranks - 1) ? numranks - 2 : numranks - 1;
+	for (i = 0; i < numranks; i++) {
+		if (i == root)
+			continue;
+
+		ret = coll_sched_recv(coll_op, i, (char *) result + i * nbytes,
+				      count, datatype, i == last);
 		if (ret)
 			return ret;
 	}
@@ -645,12 +1620,41 @@ static int coll_do_scatter(struct util_coll_operation *coll_op,
 	return FI_SUCCESS;
 }
 
+static int coll_do_gather(struct util_coll_operation *coll_op,
+			  const void *send_buf, void *result, void **temp,
+			  size_t count, uint64_t root,
+			  enum fi_datatype datatype)
+{
+	if (count == 0)
+		return FI_SUCCESS;
+
+	if (count * ofi_datatype_size(datatype) >= coll_env.gather_threshold)
+		return coll_do_gather_linear(coll_op, send_buf, result, count,
+					     root, datatype);
+
+	return coll_do_gather_binomial(coll_op, send_buf, result, temp, count,
+				       root, datatype);
+}
+
+static void coll_close_sub_mc(struct util_coll_mc *sub_mc)
+{
+	struct util_av_set *av_set = sub_mc->av_set;
+
+	fi_close(&sub_mc->mc_fid.fid);
+	fi_close(&av_set->av_set_fid.fid);
+}
+
 static int coll_close(struct fid *fid)
 {
 	struct util_coll_mc *coll_mc;
 
 	coll_mc = container_of(fid, struct util_coll_mc, mc_fid.fid);
 
+	if (coll_mc->node_mc)
+		coll_close_sub_mc(coll_mc->node_mc);
+	if (coll_mc->leader_mc)
+		coll_close_sub_mc(coll_mc->leader_mc);
+
 	ofi_atomic_dec32(&coll_mc->av_set->ref);
 	free(coll_mc);
 
@@ -687,6 +1691,61 @@ static int coll_find_local_rank(struct fid_ep *ep,
 	return FI_SUCCESS;
 }
 
+/*
+ * Fill in the node and leader sub-groups from the node ids of all members.
+ * The leader of a node is its lowest ranked member.  Groups that are all
+ * on one node, or have one member per node, stay flat.
+ */
+static void coll_split_nodes(struct util_coll_mc *coll_mc,
+			     const uint64_t *node_ids)
+{
+	struct util_av_set *av_set = coll_mc->av_set;
+	struct util_av_set *node_set = coll_mc->node_mc->av_set;
+	struct util_av_set *leader_set = coll_mc->leader_mc->av_set;
+	uint64_t local_rank = coll_mc->local_rank;
+	size_t i, j;
+
+	for (i = 0; i < av_set->fi_addr_count; i++) {
+		for (j = 0; j < i; j++) {
+			if (node_ids[j] == node_ids[i])
+				break;
+		}
+
+		if (j == i) {
+			if (i == local_rank)
+				coll_mc->leader_mc->local_rank =
+					leader_set->fi_addr_count;
+			leader_set->fi_addr_array[leader_set->fi_addr_count++] =
+				av_set->fi_addr_array[i];
+		}
+
+		if (node_ids[i] == node_ids[local_rank]) {
+			if (i == local_rank)
+				coll_mc->node_mc->local_rank =
+					node_set->fi_addr_count;
+			node_set->fi_addr_array[node_set->fi_addr_count++] =
+				av_set->fi_addr_array[i];
+		}
+	}
+
+	FI_DBG(av_set->av->prov, FI_LOG_DOMAIN,
+	       "members: %zu nodes: %zu local node members: %zu\n",
+	       av_set->fi_addr_count, leader_set->fi_addr_count,
+	       node_set->fi_addr_count);
+
+	if (leader_set->fi_addr_count == 1 ||
+	    leader_set->fi_addr_count == av_set->fi_addr_count) {
+		coll_close_sub_mc(coll_mc->node_mc);
+		coll_mc->node_mc = NULL;
+	}
+
+	if (!coll_mc->node_mc || coll_mc->leader_mc->local_rank ==
+				 FI_ADDR_NOTAVAIL) {
+		coll_close_sub_mc(coll_mc->leader_mc);
+		coll_mc->leader_mc = NULL;
+	}
+}
+
 void coll_join_comp(struct util_coll_operation *coll_op)
 {
 	struct fi_eq_entry entry;
@@ -704,6 +1763,10 @@ void coll_join_comp(struct util_coll_operation *coll_op)
 	ofi_bitmask_unset(ep->util_ep.coll_cid_mask,
 			  coll_op->data.join.new_mc->group_id);
 
+	if (coll_op->data.join.node_ids)
+		coll_split_nodes(coll_op->data.join.new_mc,
+				 coll_op->data.join.node_ids);
+
 	/* write to the eq */
 	memset(&entry, 0, sizeof(entry));
 	entry.fid = &coll_op->mc->mc_fid.fid;
@@ -716,6 +1779,7 @@ void coll_join_comp(struct util_coll_operation *coll_op)
 
 	ofi_bitmask_free(&coll_op->data.join.data);
 	ofi_bitmask_free(&coll_op->data.join.tmp);
+	free(coll_op->data.join.node_ids);
 }
 
 void coll_collective_comp(struct util_coll_operation *coll_op)
@@ -745,6 +1809,22 @@ void coll_collective_comp(struct util_coll_operation *coll_op)
 		free(coll_op->data.broadcast.scatter);
 		break;
 
+	case UTIL_COLL_ALLTOALL_OP:
+		free(coll_op->data.alltoall);
+		break;
+
+	case UTIL_COLL_REDUCE_SCATTER_OP:
+		free(coll_op->data.reduce_scatter);
+		break;
+
+	case UTIL_COLL_REDUCE_OP:
+		free(coll_op->data.reduce);
+		break;
+
+	case UTIL_COLL_GATHER_OP:
+		free(coll_op->data.gather);
+		break;
+
 	case UTIL_COLL_JOIN_OP:
 	case UTIL_COLL_BARRIER_OP:
 	case UTIL_COLL_ALLGATHER_OP:
@@ -759,10 +1839,11 @@ static ssize_t coll_process_reduce_item(struct util_coll_reduce_item *reduce_ite
 	if (reduce_item->op < FI_MIN || reduce_item->op > FI_BXOR)
 		return -FI_ENOSYS;
 
-	ofi_atomic_write_handler(reduce_item->op, reduce_item->datatype,
-				 reduce_item->inout_buf,
-				 reduce_item->in_buf,
-				 reduce_item->count);
+	/* inout_buf is owned by the collective for the life of the op */
+	ofi_atomic_reduce_handler(reduce_item->op, reduce_item->datatype,
+				  reduce_item->inout_buf,
+				  reduce_item->in_buf,
+				  reduce_item->count);
 	return FI_SUCCESS;
 }
 
@@ -784,7 +1865,7 @@ static ssize_t coll_process_xfer_item(struct util_coll_xfer_item *item)
 	msg.context = item;
 	msg.data = 0;
 	msg.tag = item->tag;
-	msg.addr = coll_op->mc->av_set->fi_addr_array[item->remote_rank];
+	msg.addr = item->addr;
 
 	iov.iov_base = item->buf;
 	iov.iov_len = (item->count * ofi_datatype_size(item->datatype));
@@ -908,6 +1989,75 @@ static struct util_coll_mc *coll_create_mc(struct util_av_set *av_set,
 	return coll_mc;
 }
 
+/* an empty sub-group with room for every member of coll_mc */
+static struct util_coll_mc *coll_create_sub_mc(struct util_coll_mc *coll_mc)
+{
+	struct fi_av_set_attr attr = {
+		.count = coll_mc->av_set->fi_addr_count,
+		.start_addr = FI_ADDR_NOTAVAIL,
+		.end_addr = FI_ADDR_NOTAVAIL,
+	};
+	struct util_coll_mc *sub_mc;
+	struct fid_av_set *set;
+
+	if (coll_av_set(&coll_mc->av_set->av->av_fid, &attr, &set, NULL))
+		return NULL;
+
+	sub_mc = coll_create_mc(container_of(set, struct util_av_set,
+					     av_set_fid), NULL);
+	if (!sub_mc) {
+		fi_close(&set->fid);
+		return NULL;
+	}
+
+	sub_mc->local_rank = FI_ADDR_NOTAVAIL;
+	return sub_mc;
+}
+
+/*
+ * Exchange node ids among the members of the new group so the join can
+ * split it into node sub-groups.  The sub-groups are created up front so
+ * that the split can't fail, which would leave members disagreeing on the
+ * algorithms to run.  The exchange runs over the new group's ranks, so it
+ * gets its own collective id to keep its tags apart from the join's.
+ */
+static int coll_sched_node_ids(struct util_coll_operation *join_op)
+{
+	struct util_coll_mc *new_mc = join_op->data.join.new_mc;
+	struct util_coll_mc *coll_mc = join_op->mc;
+	size_t numranks = new_mc->av_set->fi_addr_count;
+	uint32_t cid = join_op->cid;
+	int ret;
+
+	/* at least 3 members are needed for both levels to be useful */
+	if (!coll_env.hierarchical || numranks < 3)
+		return FI_SUCCESS;
+
+	join_op->cid = coll_get_next_id(coll_mc);
+	if (new_mc->local_rank == FI_ADDR_NOTAVAIL) {
+		join_op->cid = cid;
+		return FI_SUCCESS;
+	}
+
+	join_op->data.join.node_ids = calloc(numranks,
+					     sizeof(*join_op->data.join.node_ids));
+	if (!join_op->data.join.node_ids)
+		return -FI_ENOMEM;
+
+	new_mc->node_mc = coll_create_sub_mc(new_mc);
+	new_mc->leader_mc = coll_create_sub_mc(new_mc);
+	if (!new_mc->node_mc || !new_mc->leader_mc)
+		return -FI_ENOMEM;
+
+	join_op->data.join.node_id = coll_env.node_id;
+	join_op->mc = new_mc;
+	ret = coll_do_allgather(join_op, &join_op->data.join.node_id,
+				join_op->data.join.node_ids, 1, FI_UINT64);
+	join_op->mc = coll_mc;
+	join_op->cid = cid;
+	return ret;
+}
+
 int coll_join_collective(struct fid_ep *ep, const void *addr,
 		         uint64_t flags, struct fid_mc **mc, void *context)
 {
@@ -973,6 +2123,10 @@ int coll_join_collective(struct fid_ep *ep, const void *addr,
 	if (ret)
 		goto err4;
 
+	ret = coll_sched_node_ids(join_op);
+	if (ret)
+		goto err4;
+
 	ret = coll_sched_comp(join_op);
 	if (ret)
 		goto err4;
@@ -983,6 +2137,7 @@ int coll_join_collective(struct fid_ep *ep, const void *addr,
 	return FI_SUCCESS;
 
 err4:
+	free(join_op->data.join.node_ids);
 	ofi_bitmask_free(&join_op->data.join.tmp);
 err3:
 	ofi_bitmask_free(&join_op->data.join.data);
@@ -1214,6 +2369,155 @@ err1:
 	return ret;
 }
 
+ssize_t coll_ep_alltoall(struct fid_ep *ep, const void *buf, size_t count,
+			 void *desc, void *result, void *result_desc,
+			 fi_addr_t coll_addr, enum fi_datatype datatype,
+			 uint64_t flags, void *context)
+{
+	struct util_coll_mc *coll_mc;
+	struct util_coll_operation *alltoall_op;
+	struct util_ep *util_ep;
+	int ret;
+
+	coll_mc = (struct util_coll_mc *) ((uintptr_t) coll_addr);
+	alltoall_op = coll_create_op(ep, coll_mc, UTIL_COLL_ALLTOALL_OP,
+				     flags, context,
+				     coll_collective_comp);
+	if (!alltoall_op)
+		return -FI_ENOMEM;
+
+	ret = coll_do_alltoall(alltoall_op, buf, result,
+			       &alltoall_op->data.alltoall, count, datatype);
+	if (ret)
+		goto err;
+
+	ret = coll_sched_comp(alltoall_op);
+	if (ret)
+		goto err;
+
+	util_ep = container_of(ep, struct util_ep, ep_fid);
+	coll_progress_work(util_ep, alltoall_op);
+
+	return FI_SUCCESS;
+err:
+	free(alltoall_op->data.alltoall);
+	free(alltoall_op);
+	return ret;
+}
+
+ssize_t coll_ep_reduce_scatter(struct fid_ep *ep, const void *buf,
+			       size_t count, void *desc, void *result,
+			       void *result_desc, fi_addr_t coll_addr,
+			       enum fi_datatype datatype, enum fi_op op,
+			       uint64_t flags, void *context)
+{
+	struct util_coll_mc *coll_mc;
+	struct util_coll_operation *reduce_scatter_op;
+	struct util_ep *util_ep;
+	int ret;
+
+	coll_mc = (struct util_coll_mc *) ((uintptr_t) coll_addr);
+	reduce_scatter_op = coll_create_op(ep, coll_mc,
+					   UTIL_COLL_REDUCE_SCATTER_OP,
+					   flags, context,
+					   coll_collective_comp);
+	if (!reduce_scatter_op)
+		return -FI_ENOMEM;
+
+	ret = coll_do_reduce_scatter(reduce_scatter_op, buf, result,
+				     &reduce_scatter_op->data.reduce_scatter,
+				     count, datatype, op);
+	if (ret)
+		goto err;
+
+	ret = coll_sched_comp(reduce_scatter_op);
+	if (ret)
+		goto err;
+
+	util_ep = container_of(ep, struct util_ep, ep_fid);
+	coll_progress_work(util_ep, reduce_scatter_op);
+
+	return FI_SUCCESS;
+err:
+	free(reduce_scatter_op->data.reduce_scatter);
+	free(reduce_scatter_op);
+	return ret;
+}
+
+ssize_t coll_ep_reduce(struct fid_ep *ep, const void *buf, size_t count,
+		       void *desc, void *result, void *result_desc,
+		       fi_addr_t coll_addr, fi_addr_t root_addr,
+		       enum fi_datatype datatype, enum fi_op op,
+		       uint64_t flags, void *context)
+{
+	struct util_coll_mc *coll_mc;
+	struct util_coll_operation *reduce_op;
+	struct util_ep *util_ep;
+	int ret;
+
+	coll_mc = (struct util_coll_mc *) ((uintptr_t) coll_addr);
+	reduce_op = coll_create_op(ep, coll_mc, UTIL_COLL_REDUCE_OP,
+				   flags, context,
+				   coll_collective_comp);
+	if (!reduce_op)
+		return -FI_ENOMEM;
+
+	ret = coll_do_reduce(reduce_op, buf, result, &reduce_op->data.reduce,
+			     count, root_addr, datatype, op);
+	if (ret)
+		goto err;
+
+	ret = coll_sched_comp(reduce_op);
+	if (ret)
+		goto err;
+
+	util_ep = container_of(ep, struct util_ep, ep_fid);
+	coll_progress_work(util_ep, reduce_op);
+
+	return FI_SUCCESS;
+err:
+	free(reduce_op->data.reduce);
+	free(reduce_op);
+	return ret;
+}
+
+ssize_t coll_ep_gather(struct fid_ep *ep, const void *buf, size_t count,
+		       void *desc, void *result, void *result_desc,
+		       fi_addr_t coll_addr, fi_addr_t root_addr,
+		       enum fi_datatype datatype, uint64_t flags,
+		       void *context)
+{
+	struct util_coll_mc *coll_mc;
+	struct util_coll_operation *gather_op;
+	struct util_ep *util_ep;
+	int ret;
+
+	coll_mc = (struct util_coll_mc *) ((uintptr_t) coll_addr);
+	gather_op = coll_create_op(ep, coll_mc, UTIL_COLL_GATHER_OP,
+				   flags, context,
+				   coll_collective_comp);
+	if (!gather_op)
+		return -FI_ENOMEM;
+
+	ret = coll_do_gather(gather_op, buf, result, &gather_op->data.gather,
+			     count, root_addr, datatype);
+	if (ret)
+		goto err;
+
+	ret = coll_sched_comp(gather_op);
+	if (ret)
+		goto err;
+
+	util_ep = container_of(ep, struct util_ep, ep_fid);
+	coll_progress_work(util_ep, gather_op);
+
+	return FI_SUCCESS;
+err:
+	free(gather_op->data.gather);
+	free(gather_op);
+	return ret;
+}
+
 ssize_t coll_peer_xfer_complete(struct fid_ep *ep,
 				struct fi_cq_tagged_entry *cqe,
 				fi_addr_t src_addr)
@@ -1280,9 +2584,13 @@ int coll_query_collective(struct fid_domain *dom_fid,
 	case FI_ALLGATHER:
 	case FI_SCATTER:
 	case FI_BROADCAST:
+	case FI_ALLTOALL:
+	case FI_GATHER:
 		ret = FI_SUCCESS;
 		break;
 	case FI_ALLREDUCE:
+	case FI_REDUCE_SCATTER:
+	case FI_REDUCE:
 		if (FI_MIN <= attr->op && FI_BXOR >= attr->op)
 			ret = fi_query_atomic(peer_domain, attr->datatype,
 					      attr->op, &attr->datatype_attr,
@@ -1290,10 +2598,6 @@ int coll_query_collective(struct fid_domain *dom_fid,
 		else
 			return -FI_ENOSYS;
 		break;
-	case FI_ALLTOALL:
-	case FI_REDUCE_SCATTER:
-	case FI_REDUCE:
-	case FI_GATHER:
 	default:
 		return -FI_ENOSYS;
 	}
@@ -32,6 +32,83 @@
 
 #include "coll.h"
 
+struct coll_env coll_env = {
+	.allreduce_algo		= COLL_ALLREDUCE_AUTO,
+	.allreduce_threshold	= 2048,
+	.alltoall_threshold	= 256,
+	.reduce_scatter_threshold = 2048,
+	.reduce_threshold	= 2048,
+	.gather_threshold	= 8192,
+	.hierarchical		= 1,
+};
+
+/* FNV-1a */
+static uint64_t coll_hash_name(const char *name)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL;
+
+	for (; *name; name++) {
+		hash ^= (uint8_t) *name;
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+static void coll_init_node_id(void)
+{
+	char hostname[HOST_NAME_MAX + 1] = {0};
+	char *node_name = NULL;
+
+	fi_param_get_str(&coll_prov, "node_name", &node_name);
+	if (node_name) {
+		coll_env.node_id = coll_hash_name(node_name);
+	} else if (!gethostname(hostname, sizeof(hostname) - 1)) {
+		coll_env.node_id = coll_hash_name(hostname);
+	} else {
+		/*
+		 * Still take part in the node id exchange, so the other
+		 * members don't wait for us, but as a node of our own.
+		 */
+		FI_WARN(&coll_prov, FI_LOG_CORE,
+			"unable to get hostname, running as a separate node\n");
+		coll_env.node_id = ~coll_hash_name("") ^ getpid();
+	}
+}
+
+static void coll_init_env(void)
+{
+	char *algo = NULL;
+
+	fi_param_get_bool(&coll_prov, "hierarchical", &coll_env.hierarchical);
+	if (coll_env.hierarchical)
+		coll_init_node_id();
+
+	fi_param_get_size_t(&coll_prov, "allreduce_threshold",
+			    &coll_env.allreduce_threshold);
+	fi_param_get_size_t(&coll_prov, "alltoall_threshold",
+			    &coll_env.alltoall_threshold);
+	fi_param_get_size_t(&coll_prov, "reduce_scatter_threshold",
+			    &coll_env.reduce_scatter_threshold);
+	fi_param_get_size_t(&coll_prov, "reduce_threshold",
+			    &coll_env.reduce_threshold);
+	fi_param_get_size_t(&coll_prov, "gather_threshold",
+			    &coll_env.gather_threshold);
+
+	fi_param_get_str(&coll_prov, "allreduce_algo", &algo);
+	if (!algo || !strcasecmp(algo, "auto"))
+		return;
+
+	if (!strcasecmp(algo, "recursive_doubling"))
+		coll_env.allreduce_algo = COLL_ALLREDUCE_RECURSIVE_DOUBLING;
+	else if (!strcasecmp(algo, "rabenseifner"))
+		coll_env.allreduce_algo = COLL_ALLREDUCE_RABENSEIFNER;
+	else if (!strcasecmp(algo, "ring"))
+		coll_env.allreduce_algo = COLL_ALLREDUCE_RING;
+	else
+		FI_WARN(&coll_prov, FI_LOG_CORE,
+			"unknown allreduce_algo '%s', using auto\n", algo);
+}
+
 static int coll_getinfo(uint32_t version, const char *node, const char *service,
 			uint64_t flags, const struct fi_info *hints,
 			struct fi_info **info)
@@ -60,5 +137,42 @@ struct fi_provider coll_prov = {
 
 COLL_INI
 {
+	fi_param_define(&coll_prov, "allreduce_algo", FI_PARAM_STRING,
+			"Allreduce algorithm: auto, recursive_doubling, "
+			"rabenseifner or ring.  Must be set identically on "
+			"all members (default: auto)");
+	fi_param_define(&coll_prov, "allreduce_threshold", FI_PARAM_SIZE_T,
+			"Message size in bytes at which auto selection switches "
+			"from recursive doubling to the bandwidth optimal "
+			"rabenseifner or ring algorithms (default: 2048)");
+	fi_param_define(&coll_prov, "alltoall_threshold", FI_PARAM_SIZE_T,
+			"Per member block size in bytes at which alltoall "
+			"switches from the Bruck algorithm to pairwise "
+			"exchange (default: 256)");
+	fi_param_define(&coll_prov, "reduce_scatter_threshold",
+			FI_PARAM_SIZE_T,
+			"Message size in bytes at which reduce_scatter "
+			"switches from recursive halving to a ring when the "
+			"member count is not a power of two (default: 2048)");
+	fi_param_define(&coll_prov, "reduce_threshold", FI_PARAM_SIZE_T,
+			"Message size in bytes at which reduce switches from "
+			"a binomial tree to a ring reduce-scatter followed by "
+			"a gather at the root (default: 2048)");
+	fi_param_define(&coll_prov, "gather_threshold", FI_PARAM_SIZE_T,
+			"Per member block size in bytes at which gather "
+			"switches from a binomial tree to sending directly to "
+			"the root (default: 8192)");
+	fi_param_define(&coll_prov, "hierarchical", FI_PARAM_BOOL,
+			"Run allreduce and barrier in two levels on groups "
+			"whose members span several nodes: within each node "
+			"to a leader, then among the node leaders.  Must be "
+			"set identically on all members (default: true)");
+	fi_param_define(&coll_prov, "node_name", FI_PARAM_STRING,
+			"Name of the node this process runs on, used to "
+			"group co-located members for hierarchical "
+			"collectives (default: hostname)");
+
+	coll_init_env();
+
 	return &coll_prov;
 }
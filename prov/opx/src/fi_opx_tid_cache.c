@@ -444,6 +444,7 @@ int opx_tid_cache_init(struct util_domain *domain,
 		return -FI_ENOSPC;
 
 	pthread_mutex_init(&cache->lock, NULL);
+	pthread_rwlock_init(&cache->tree_lock, NULL);
 	dlist_init(&cache->lru_list);
 	dlist_init(&cache->dead_region_list);
 	cache->cached_cnt = 0;
@@ -454,6 +455,7 @@ int opx_tid_cache_init(struct util_domain *domain,
 	cache->delete_cnt = 0;
 	cache->hit_cnt = 0;
 	cache->notify_cnt = 0;
+	cache->contended_cnt = 0;
 	cache->domain = domain;
 	ofi_atomic_inc32(&domain->ref);
 
@@ -481,6 +483,7 @@ del:
 destroy:
 	ofi_rbmap_cleanup(&cache->tree);
 	ofi_atomic_dec32(&cache->domain->ref);
+	pthread_rwlock_destroy(&cache->tree_lock);
 	pthread_mutex_destroy(&cache->lock);
 	cache->domain = NULL;
 	return ret;
@@ -227,6 +227,7 @@ int opx_hmem_cache_init(struct util_domain *domain,
 	}
 
 	pthread_mutex_init(&cache->lock, NULL);
+	pthread_rwlock_init(&cache->tree_lock, NULL);
 	dlist_init(&cache->lru_list);
 	dlist_init(&cache->dead_region_list);
 	cache->cached_cnt = 0;
@@ -239,6 +240,7 @@ int opx_hmem_cache_init(struct util_domain *domain,
 	cache->delete_cnt = 0;
 	cache->hit_cnt = 0;
 	cache->notify_cnt = 0;
+	cache->contended_cnt = 0;
 	cache->domain = domain;
 	cache->prov = &fi_opx_provider;
 	ofi_atomic_inc32(&domain->ref);
@@ -269,6 +271,7 @@ destroy:
 	OPX_TRACER_TRACE(OPX_TRACER_END_ERROR, "GDRCOPY-CACHE-INIT");
 	ofi_rbmap_cleanup(&cache->tree);
 	ofi_atomic_dec32(&cache->domain->ref);
+	pthread_rwlock_destroy(&cache->tree_lock);
 	pthread_mutex_destroy(&cache->lock);
 	cache->domain = NULL;
 	cache->prov = NULL;
@@ -45,6 +45,7 @@
 #include <rdma/fi_rma.h>
 #include <rdma/fi_tagged.h>
 #include <rdma/fi_trigger.h>
+#include <rdma/fi_ext.h>
 
 #include <ofi.h>
 #include <ofi_proto.h>
@@ -60,7 +61,7 @@
 #ifndef _RXD_H_
 #define _RXD_H_
 
-#define RXD_PROTOCOL_VERSION 	(2)
+#define RXD_PROTOCOL_VERSION 	(4)
 
 #define RXD_MAX_MTU_SIZE	4096
 
@@ -72,10 +73,21 @@
 #define RXD_RX_POOL_CHUNK_CNT	1024
 #define RXD_MAX_PENDING		128
 #define RXD_MAX_PKT_RETRY	50
+#define RXD_DUP_ACK_THRESH	3
+#define RXD_INIT_CWND		16
+#define RXD_MIN_CWND		2
+#define RXD_INIT_RTO		1000		/* usec */
+#define RXD_RTO_GRANULARITY	1000		/* usec */
+#define RXD_MAX_RTO		4000000		/* usec */
+#define RXD_MAX_SEG_CNT		64
+#define RXD_SEG_BUF_SIZE	(1 << 16)
 #define RXD_ADDR_INVALID	0
 
 #define RXD_PKT_IN_USE		(1 << 0)
 #define RXD_PKT_ACKED		(1 << 1)
+#define RXD_PKT_SACKED		(1 << 2)
+#define RXD_PKT_FAST_RETX	(1 << 3)
+#define RXD_PKT_RETX		(1 << 4)
 
 #define RXD_REMOTE_CQ_DATA	(1 << 0)
 #define RXD_NO_TX_COMP		(1 << 1)
@@ -84,6 +96,7 @@
 #define RXD_TAG_HDR		(1 << 4)
 #define RXD_INLINE		(1 << 5)
 #define RXD_MULTI_RECV		(1 << 6)
+#define RXD_ACK_REQ		(1 << 7)
 
 #define RXD_IDX_OFFSET(x)	(x + 1)	
 
@@ -92,6 +105,8 @@ struct rxd_env {
 	int retry;
 	int max_peers;
 	int max_unacked;
+	int seg_offload;
+	int cong_ctrl;
 };
 
 extern struct rxd_env rxd_env;
@@ -123,6 +138,7 @@ struct rxd_domain {
 
 struct rxd_peer {
 	struct dlist_entry entry;
+	fi_addr_t rxd_addr;
 	fi_addr_t peer_addr;
 	uint64_t tx_seq_no;
 	uint64_t rx_seq_no;
@@ -131,6 +147,22 @@ struct rxd_peer {
 	uint16_t rx_window;
 	uint16_t tx_window;
 	int retry_cnt;
+	uint16_t dup_ack_cnt;
+
+	/* RTT estimate and retransmit timeout (RFC 6298), in usec */
+	uint64_t srtt;
+	uint64_t rttvar;
+	uint64_t rto;
+
+	/* AIMD congestion window, in packets, capped by tx_window */
+	uint16_t cwnd;
+	uint16_t cwnd_cnt;
+	uint16_t ssthresh;
+	uint64_t recover;
+
+	uint64_t retx_cnt;
+	uint64_t fast_retx_cnt;
+	uint64_t timeout_cnt;
 
 	uint16_t unacked_cnt;
 	uint8_t active;
@@ -146,6 +178,11 @@ struct rxd_peer {
 	struct dlist_entry buf_pkts;
 };
 
+static inline uint16_t rxd_peer_window(struct rxd_peer *peer)
+{
+	return MIN(peer->tx_window, peer->cwnd);
+}
+
 struct rxd_addr {
 	fi_addr_t fi_addr;
 	fi_addr_t dg_addr;
@@ -182,6 +219,24 @@ struct rxd_buf_pool {
 	struct rxd_ep *rxd_ep;
 };
 
+/*
+ * Endpoint totals and per-peer copies of the transport state, refreshed on
+ * demand by rxd_ep_update_stats() for the fi_profile interface.
+ */
+struct rxd_stats {
+	uint64_t min_cwnd;
+	uint64_t max_srtt;
+	uint64_t max_rttvar;
+	uint64_t max_rto;
+	uint64_t retx_cnt;
+	uint64_t fast_retx_cnt;
+	uint64_t timeout_cnt;
+
+	struct fi_rxd_peer_stats *peers;
+	size_t peer_cnt;
+	size_t peer_size;
+};
+
 struct rxd_ep {
 	struct util_ep util_ep;
 	struct fid_ep *dg_ep;
@@ -193,7 +248,7 @@ struct rxd_ep {
 	size_t rx_prefix_size;
 	size_t min_multi_recv_size;
 	int do_local_mr;
-	int next_retry;
+	int next_retry;		/* msec until a retransmit is due, or -1 */
 	int dg_cq_fd;
 	uint32_t tx_flags;
 	uint32_t rx_flags;
@@ -207,6 +262,13 @@ struct rxd_ep {
 	struct rxd_buf_pool rx_pkt_pool;
 	struct slist rx_pkt_list;
 
+	/* Segmentation offload (GSO/GRO) provided by the core endpoint */
+	struct ofi_ops_dgram_seg *seg_ops;
+	size_t seg_max_cnt;
+	size_t seg_max_len;
+	struct ofi_bufpool *seg_buf_pool;
+	struct slist seg_buf_list;
+
 	struct rxd_buf_pool tx_entry_pool;
 	struct rxd_buf_pool rx_entry_pool;
 
@@ -219,6 +281,7 @@ struct rxd_ep {
 	struct dlist_entry ctrl_pkts;
 
 	struct index_map peers_idm;
+	struct rxd_stats stats;
 };
 /* ensure ep lock is held before this function is called */
 static inline struct rxd_peer *rxd_peer(struct rxd_ep *ep, fi_addr_t rxd_addr)
@@ -310,6 +373,14 @@ struct rxd_pkt_entry {
 	void *pkt;
 };
 
+/* Receive buffer for coalesced packets, split into rx pkt entries */
+struct rxd_seg_buf {
+	struct slist_entry s_entry;
+	struct fi_context context;
+	size_t seg_size;
+	uint8_t data[];
+};
+
 struct rxd_unexp_msg {
 	struct dlist_entry entry;
 	struct rxd_pkt_entry *pkt_entry;
@@ -474,8 +545,14 @@ struct rxd_x_entry *rxd_rx_entry_init(struct rxd_ep *ep,
 			uint32_t op, uint32_t flags);
 void rxd_tx_entry_free(struct rxd_ep *ep, struct rxd_x_entry *tx_entry);
 void rxd_rx_entry_free(struct rxd_ep *ep, struct rxd_x_entry *rx_entry);
-int rxd_get_timeout(int retry_cnt);
-uint64_t rxd_get_retry_time(uint64_t start, int retry_cnt);
+uint64_t rxd_get_timeout(struct rxd_peer *peer);
+uint64_t rxd_get_retry_time(struct rxd_peer *peer, uint64_t start);
+void rxd_update_rtt(struct rxd_peer *peer, uint64_t rtt);
+void rxd_cwnd_ack(struct rxd_peer *peer, uint16_t acked);
+void rxd_cwnd_loss(struct rxd_peer *peer, bool timeout);
+void rxd_ep_update_stats(struct rxd_ep *ep);
+int rxd_ep_ops_open(struct fid *fid, const char *name,
+		    uint64_t flags, void **ops, void *context);
 
 /* Generic message functions */
 ssize_t rxd_ep_generic_recvmsg(struct rxd_ep *rxd_ep, const struct iovec *iov,
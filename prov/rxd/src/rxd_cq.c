@@ -151,18 +151,34 @@ static void rxd_complete_tx(struct rxd_ep *ep, struct rxd_x_entry *tx_entry)
 	rxd_tx_entry_free(ep, tx_entry);
 }
 
-static int rxd_comp_pkt_seq_no(struct dlist_entry *item, const void *arg)
+/*
+ * Hold an out of order packet until the packets before it arrive.  buf_pkts
+ * is kept sorted by sequence number.  With retries enabled only packets that
+ * can be reported in a selective ack are held; anything further ahead is
+ * resent by the peer.  Returns false if the packet was not queued.
+ */
+static bool rxd_buf_pkt(struct rxd_peer *peer, struct rxd_pkt_entry *pkt_entry)
 {
-	struct rxd_base_hdr *list_hdr;
-	struct rxd_base_hdr *new_hdr;
-
-	list_hdr = rxd_get_base_hdr(container_of(item,
-				   struct rxd_pkt_entry, d_entry));
-
-	new_hdr = rxd_get_base_hdr(container_of((struct dlist_entry *) arg,
-				  struct rxd_pkt_entry, d_entry));
+	struct rxd_pkt_entry *entry;
+	struct dlist_entry *item;
+	uint64_t seq_no;
+
+	seq_no = rxd_get_base_hdr(pkt_entry)->seq_no;
+	if (ofi_after_eq(peer->rx_seq_no, seq_no) ||
+	    (rxd_env.retry && seq_no - peer->rx_seq_no > RXD_SACK_BITS))
+		return false;
+
+	for (item = peer->buf_pkts.prev; item != &peer->buf_pkts;
+	     item = item->prev) {
+		entry = container_of(item, struct rxd_pkt_entry, d_entry);
+		if (rxd_get_base_hdr(entry)->seq_no == seq_no)
+			return false;
+		if (ofi_before(rxd_get_base_hdr(entry)->seq_no, seq_no))
+			break;
+	}
 
-	return new_hdr->seq_no > list_hdr->seq_no;
+	dlist_insert_after(&pkt_entry->d_entry, item);
+	return true;
 }
 
 void rxd_ep_recv_data(struct rxd_ep *ep, struct rxd_x_entry *x_entry,
@@ -190,7 +206,8 @@ void rxd_ep_recv_data(struct rxd_ep *ep, struct rxd_x_entry *x_entry,
 	x_entry->next_seg_no++;
 
 	if (x_entry->next_seg_no < x_entry->num_segs) {
-		if (!(rxd_peer(ep, pkt->base_hdr.peer)->rx_seq_no %
+		if (pkt->base_hdr.flags & RXD_ACK_REQ ||
+		    !(rxd_peer(ep, pkt->base_hdr.peer)->rx_seq_no %
 		    rxd_peer(ep, pkt->base_hdr.peer)->rx_window))
 			rxd_ep_send_ack(ep, pkt->base_hdr.peer);
 		return;
@@ -242,7 +259,7 @@ int rxd_start_xfer(struct rxd_ep *ep, struct rxd_x_entry *tx_entry)
 	struct rxd_base_hdr *hdr = rxd_get_base_hdr(tx_entry->pkt);
 
 	if (rxd_peer(ep, tx_entry->peer)->unacked_cnt >=
-	    rxd_peer(ep, tx_entry->peer)->tx_window)
+	    rxd_peer_window(rxd_peer(ep, tx_entry->peer)))
 		return 0;
 
 	tx_entry->start_seq = rxd_set_pkt_seq(rxd_peer(ep, tx_entry->peer),
@@ -264,7 +281,7 @@ int rxd_start_xfer(struct rxd_ep *ep, struct rxd_x_entry *tx_entry)
 	}
 
 	return rxd_peer(ep, tx_entry->peer)->unacked_cnt <
-	       rxd_peer(ep,tx_entry->peer)->tx_window;
+	       rxd_peer_window(rxd_peer(ep, tx_entry->peer));
 }
 
 void rxd_progress_tx_list(struct rxd_ep *ep, struct rxd_peer *peer)
@@ -307,7 +324,7 @@ void rxd_progress_tx_list(struct rxd_ep *ep, struct rxd_peer *peer)
 
 		if (tx_entry->op == RXD_DATA_READ && !tx_entry->bytes_done) {
 			if (rxd_peer(ep, tx_entry->peer)->unacked_cnt >=
-		    	    rxd_peer(ep, tx_entry->peer)->tx_window) {
+		    	    rxd_peer_window(rxd_peer(ep, tx_entry->peer))) {
 				break;
 			}
 			tx_entry->start_seq = rxd_peer(ep,tx_entry->peer)->tx_seq_no;
@@ -897,6 +914,23 @@ static struct rxd_x_entry *rxd_get_data_x_entry(struct rxd_ep *ep,
 	return ofi_bufpool_get_ibuf(ep->tx_entry_pool.pool, data_pkt->ext_hdr.tx_id);
 }
 
+/* Queue data for an unexpected message until a matching receive is posted */
+static void rxd_buf_unexp_data(struct rxd_ep *ep,
+			       struct rxd_pkt_entry *pkt_entry)
+{
+	struct rxd_data_pkt *pkt = (struct rxd_data_pkt *) (pkt_entry->pkt);
+	struct rxd_unexp_msg *unexp_msg;
+
+	unexp_msg = rxd_peer(ep, pkt->base_hdr.peer)->curr_unexp;
+	dlist_insert_tail(&pkt_entry->d_entry, &unexp_msg->pkt_list);
+	if (pkt->ext_hdr.seg_no + 1 == unexp_msg->sar_hdr->num_segs - 1) {
+		rxd_peer(ep, pkt->base_hdr.peer)->curr_unexp = NULL;
+		rxd_ep_send_ack(ep, pkt->base_hdr.peer);
+	} else if (pkt->base_hdr.flags & RXD_ACK_REQ) {
+		rxd_ep_send_ack(ep, pkt->base_hdr.peer);
+	}
+}
+
 static void rxd_progress_buf_pkts(struct rxd_ep *ep, fi_addr_t peer)
 {
 	struct fi_cq_err_entry err_entry;
@@ -919,10 +953,24 @@ static void rxd_progress_buf_pkts(struct rxd_ep *ep, fi_addr_t peer)
 		pkt_entry = container_of(bufpkts->next, struct rxd_pkt_entry,
 					 d_entry);
 		base_hdr = rxd_get_base_hdr(pkt_entry);
+
+		/* A resent copy was already processed */
+		if (ofi_before(base_hdr->seq_no, rxd_peer(ep, peer)->rx_seq_no)) {
+			rxd_remove_free_pkt_entry(pkt_entry);
+			continue;
+		}
+
 		if (base_hdr->seq_no != rxd_peer(ep, peer)->rx_seq_no)
 			return;
 		if (base_hdr->type == RXD_DATA || base_hdr->type == RXD_DATA_READ) {
 			data_pkt = (struct rxd_data_pkt *) pkt_entry->pkt;
+			if (base_hdr->type == RXD_DATA &&
+			    rxd_peer(ep, peer)->curr_unexp) {
+				dlist_remove(&pkt_entry->d_entry);
+				rxd_peer(ep, peer)->rx_seq_no++;
+				rxd_buf_unexp_data(ep, pkt_entry);
+				continue;
+			}
 			rx_entry = rxd_get_data_x_entry(ep, data_pkt);
 			rxd_ep_recv_data(ep, rx_entry, data_pkt, pkt_entry->pkt_size);
 		} else {
@@ -943,9 +991,14 @@ static void rxd_progress_buf_pkts(struct rxd_ep *ep, fi_addr_t peer)
 				continue;
 			}
 			if (!rx_entry) {
-				if (base_hdr->type == RXD_MSG ||
-				    base_hdr->type == RXD_TAGGED) {
-					rxd_peer(ep, base_hdr->peer)->rx_seq_no++;
+				/* Unexpected messages take over the packet */
+				if ((base_hdr->type == RXD_MSG ||
+				     base_hdr->type == RXD_TAGGED) &&
+				    rxd_peer(ep, peer)->curr_unexp) {
+					dlist_remove(&pkt_entry->d_entry);
+					rxd_peer(ep, peer)->rx_seq_no++;
+					if (!sar_hdr)
+						rxd_peer(ep, peer)->curr_unexp = NULL;
 					continue;
 				}
 				break;
@@ -965,7 +1018,7 @@ static void rxd_handle_data(struct rxd_ep *ep, struct rxd_pkt_entry *pkt_entry)
 {
 	struct rxd_data_pkt *pkt = (struct rxd_data_pkt *) (pkt_entry->pkt);
 	struct rxd_x_entry *x_entry;
-	struct rxd_unexp_msg *unexp_msg;
+	bool queued;
 
 	if (pkt_entry->pkt_size < sizeof(*pkt) + ep->rx_prefix_size) {
 		FI_WARN(&rxd_prov, FI_LOG_CQ,
@@ -978,27 +1031,37 @@ static void rxd_handle_data(struct rxd_ep *ep, struct rxd_pkt_entry *pkt_entry)
 		rxd_peer(ep, pkt->base_hdr.peer)->rx_seq_no++;
 		if (pkt->base_hdr.type == RXD_DATA &&
 		    rxd_peer(ep, pkt->base_hdr.peer)->curr_unexp) {
-			unexp_msg = rxd_peer(ep, pkt->base_hdr.peer)->curr_unexp;
-			dlist_insert_tail(&pkt_entry->d_entry, &unexp_msg->pkt_list);
-			if (pkt->ext_hdr.seg_no + 1 == unexp_msg->sar_hdr->num_segs - 1) {
-				rxd_peer(ep, pkt->base_hdr.peer)->curr_unexp = NULL;
-				rxd_ep_send_ack(ep, pkt->base_hdr.peer);
+			rxd_buf_unexp_data(ep, pkt_entry);
+			if (!dlist_empty(&(rxd_peer(ep,
+					   pkt->base_hdr.peer)->buf_pkts))) {
+				rxd_progress_buf_pkts(ep, pkt->base_hdr.peer);
+				if (rxd_env.cong_ctrl)
+					rxd_ep_send_ack(ep, pkt->base_hdr.peer);
 			}
 			return;
 		}
 		x_entry = rxd_get_data_x_entry(ep, pkt);
 		rxd_ep_recv_data(ep, x_entry, pkt, pkt_entry->pkt_size);
+		/*
+		 * Ack a filled hole at once so a congestion limited sender
+		 * can reopen its window.
+		 */
 		if (!dlist_empty(&(rxd_peer(ep,
-				   pkt->base_hdr.peer)->buf_pkts)))
+				   pkt->base_hdr.peer)->buf_pkts))) {
 			rxd_progress_buf_pkts(ep, pkt->base_hdr.peer);
+			if (rxd_env.cong_ctrl)
+				rxd_ep_send_ack(ep, pkt->base_hdr.peer);
+		}
 	} else if (!rxd_env.retry) {
-		dlist_insert_order(&(rxd_peer(ep,
-				     pkt->base_hdr.peer)->buf_pkts),
-				   &rxd_comp_pkt_seq_no, &pkt_entry->d_entry);
-		return;
+		if (rxd_buf_pkt(rxd_peer(ep, pkt->base_hdr.peer), pkt_entry))
+			return;
 	} else if (rxd_peer(ep, pkt->base_hdr.peer)->peer_addr !=
 		   RXD_ADDR_INVALID) {
+		queued = rxd_buf_pkt(rxd_peer(ep, pkt->base_hdr.peer),
+				     pkt_entry);
 		rxd_ep_send_ack(ep, pkt->base_hdr.peer);
+		if (queued)
+			return;
 	}
 free:
 	ofi_buf_free(pkt_entry);
@@ -1015,17 +1078,23 @@ static void rxd_handle_op(struct rxd_ep *ep, struct rxd_pkt_entry *pkt_entry)
 	struct rxd_atom_hdr *atom_hdr;
 	void *msg;
 	size_t msg_size;
+	bool queued;
 	int ret;
 
 	if (base_hdr->seq_no != rxd_peer(ep, base_hdr->peer)->rx_seq_no) {
 		if (!rxd_env.retry) {
-			dlist_insert_order(&(rxd_peer(ep, base_hdr->peer)->buf_pkts),
-					   &rxd_comp_pkt_seq_no, &pkt_entry->d_entry);
-			return;
+			if (rxd_buf_pkt(rxd_peer(ep, base_hdr->peer), pkt_entry))
+				return;
+			goto release;
 		}
 
-		if (rxd_peer(ep, base_hdr->peer)->peer_addr != RXD_ADDR_INVALID)
-			goto ack;
+		if (rxd_peer(ep, base_hdr->peer)->peer_addr == RXD_ADDR_INVALID)
+			goto release;
+
+		queued = rxd_buf_pkt(rxd_peer(ep, base_hdr->peer), pkt_entry);
+		rxd_ep_send_ack(ep, base_hdr->peer);
+		if (queued)
+			return;
 		goto release;
 	}
 
@@ -1048,6 +1117,8 @@ static void rxd_handle_op(struct rxd_ep *ep, struct rxd_pkt_entry *pkt_entry)
 			if (!sar_hdr)
 				rxd_peer(ep, base_hdr->peer)->curr_unexp = NULL;
 
+			if (!dlist_empty(&(rxd_peer(ep, base_hdr->peer)->buf_pkts)))
+				rxd_progress_buf_pkts(ep, base_hdr->peer);
 			rxd_ep_send_ack(ep, base_hdr->peer);
 			return;
 		}
@@ -1082,19 +1153,96 @@ static void rxd_handle_cts(struct rxd_ep *ep, struct rxd_pkt_entry *pkt_entry)
 	rxd_update_peer(ep, cts->rts_addr, cts->cts_addr);
 }
 
+/*
+ * Mark the packets that the peer reports holding out of order.  Once
+ * RXD_DUP_ACK_THRESH duplicate acks have arrived, or one less than the
+ * number of outstanding packets if that is smaller, every packet before the
+ * highest selectively acked one that is still missing is presumed lost and
+ * resent right away, instead of waiting for the retransmit timer to resend
+ * everything after the first hole.  Each packet is fast retransmitted at
+ * most once, later losses are left to the timer.  The first fast retransmit
+ * in a window also halves the congestion window.
+ */
+static void rxd_handle_sack(struct rxd_ep *ep, struct rxd_peer *peer,
+			    struct rxd_ack_pkt *ack)
+{
+	struct rxd_pkt_entry *pkt_entry;
+	uint64_t seq_no, bit, high, sent = 0;
+	bool sacked = false, retx = false;
+
+	high = ack->base_hdr.seq_no;
+	dlist_foreach_container(&peer->unacked, struct rxd_pkt_entry,
+				pkt_entry, d_entry) {
+		seq_no = rxd_get_base_hdr(pkt_entry)->seq_no;
+		if (ofi_after_eq(ack->base_hdr.seq_no, seq_no))
+			continue;
+
+		bit = seq_no - ack->base_hdr.seq_no - 1;
+		if (bit >= RXD_SACK_BITS)
+			break;
+		if (ack->sack[bit / 64] & (1ULL << (bit % 64))) {
+			if (!(pkt_entry->flags & (RXD_PKT_SACKED | RXD_PKT_RETX |
+						  RXD_PKT_FAST_RETX)))
+				sent = pkt_entry->timestamp;
+			pkt_entry->flags |= RXD_PKT_SACKED;
+			high = seq_no;
+			sacked = true;
+		}
+	}
+
+	/* a newly sacked packet samples the RTT even while holes remain */
+	if (sent)
+		rxd_update_rtt(peer, ofi_gettime_us() - sent);
+
+	if (!sacked || peer->dup_ack_cnt < MIN(RXD_DUP_ACK_THRESH,
+					       MAX(peer->unacked_cnt - 1, 1)))
+		return;
+
+	dlist_foreach_container(&peer->unacked, struct rxd_pkt_entry,
+				pkt_entry, d_entry) {
+		seq_no = rxd_get_base_hdr(pkt_entry)->seq_no;
+		if (ofi_after_eq(seq_no, high))
+			break;
+		if (ofi_before(seq_no, ack->base_hdr.seq_no) ||
+		    pkt_entry->flags & (RXD_PKT_IN_USE | RXD_PKT_ACKED |
+					RXD_PKT_SACKED | RXD_PKT_FAST_RETX))
+			continue;
+
+		if (!retx) {
+			rxd_cwnd_loss(peer, false);
+			retx = true;
+		}
+		pkt_entry->flags |= RXD_PKT_FAST_RETX;
+		rxd_get_base_hdr(pkt_entry)->flags |= RXD_ACK_REQ;
+		if (rxd_ep_send_pkt(ep, pkt_entry))
+			break;
+		peer->fast_retx_cnt++;
+		ep->stats.fast_retx_cnt++;
+	}
+}
+
 static void rxd_handle_ack(struct rxd_ep *ep, struct rxd_pkt_entry *ack_entry)
 {
 	struct rxd_ack_pkt *ack = (struct rxd_ack_pkt *) (ack_entry->pkt);
 	struct rxd_pkt_entry *pkt_entry;
 	fi_addr_t peer = ack->base_hdr.peer;
 	struct rxd_base_hdr *hdr;
+	uint64_t sent = 0;
+	uint16_t acked = 0;
+	bool sample = true;
 
 	rxd_peer(ep, peer)->tx_window = (uint16_t) ack->ext_hdr.rx_id;
 
-	if (rxd_peer(ep, peer)->last_rx_ack == ack->base_hdr.seq_no)
+	if (rxd_peer(ep, peer)->last_rx_ack == ack->base_hdr.seq_no) {
+		if (!dlist_empty(&(rxd_peer(ep, peer)->unacked))) {
+			rxd_peer(ep, peer)->dup_ack_cnt++;
+			rxd_handle_sack(ep, rxd_peer(ep, peer), ack);
+		}
 		return;
+	}
 
 	rxd_peer(ep, peer)->last_rx_ack = ack->base_hdr.seq_no;
+	rxd_peer(ep, peer)->dup_ack_cnt = 0;
 
 	if (dlist_empty(&(rxd_peer(ep, peer)->unacked)))
 		return;
@@ -1109,6 +1257,19 @@ static void rxd_handle_ack(struct rxd_ep *ep, struct rxd_pkt_entry *ack_entry)
 		if (ofi_after_eq(hdr->seq_no, ack->base_hdr.seq_no))
 			break;
 
+		/*
+		 * Karn's rule: an ack that covers resent packets, or packets
+		 * the receiver held behind a hole, does not give a valid
+		 * sample.
+		 */
+		if (pkt_entry->flags & (RXD_PKT_RETX | RXD_PKT_FAST_RETX |
+					RXD_PKT_SACKED))
+			sample = false;
+		if (!(pkt_entry->flags & RXD_PKT_ACKED)) {
+			sent = pkt_entry->timestamp;
+			acked++;
+		}
+
 		if (pkt_entry->flags & RXD_PKT_IN_USE) {
 			pkt_entry->flags |= RXD_PKT_ACKED;
 			pkt_entry = container_of((&pkt_entry->d_entry)->next,
@@ -1123,6 +1284,12 @@ static void rxd_handle_ack(struct rxd_ep *ep, struct rxd_pkt_entry *ack_entry)
 					struct rxd_pkt_entry, d_entry);
 	}
 
+	if (sample && sent)
+		rxd_update_rtt(rxd_peer(ep, peer), ofi_gettime_us() - sent);
+	if (acked)
+		rxd_cwnd_ack(rxd_peer(ep, peer), acked);
+
+	rxd_handle_sack(ep, rxd_peer(ep, peer), ack);
 	rxd_progress_tx_list(ep, rxd_peer(ep, ack->base_hdr.peer));
 }
 
@@ -1153,19 +1320,14 @@ void rxd_handle_send_comp(struct rxd_ep *ep, struct fi_cq_msg_entry *comp)
 	}
 }
 
-void rxd_handle_recv_comp(struct rxd_ep *ep, struct fi_cq_msg_entry *comp)
+static void rxd_handle_rx_pkt(struct rxd_ep *ep,
+			      struct rxd_pkt_entry *pkt_entry, size_t len)
 {
-	struct rxd_pkt_entry *pkt_entry =
-		container_of(comp->op_context, struct rxd_pkt_entry, context);
-
 	FI_DBG(&rxd_prov, FI_LOG_EP_DATA,
 	       "got recv completion (type: %s)\n",
 	       rxd_pkt_type_str[(rxd_pkt_type(pkt_entry))]);
 
-	rxd_ep_post_buf(ep);
-	rxd_remove_rx_pkt(ep, pkt_entry);
-
-	pkt_entry->pkt_size = comp->len;
+	pkt_entry->pkt_size = len;
 	switch (rxd_pkt_type(pkt_entry)) {
 	case RXD_RTS:
 		rxd_handle_rts(ep, pkt_entry);
@@ -1192,6 +1354,62 @@ void rxd_handle_recv_comp(struct rxd_ep *ep, struct fi_cq_msg_entry *comp)
 	ofi_buf_free(pkt_entry);
 }
 
+static int rxd_match_seg_buf(struct slist_entry *item, const void *arg)
+{
+	return item == arg;
+}
+
+/*
+ * A GRO completion may hold several packets from the same peer.  Copy
+ * each into its own rx pkt entry so that the packet handlers can hold
+ * onto them independently.  Packets which cannot be buffered are dropped
+ * and recovered by the sender's retransmit.
+ */
+static void rxd_handle_seg_recv_comp(struct rxd_ep *ep,
+				     struct fi_cq_msg_entry *comp)
+{
+	struct rxd_seg_buf *seg_buf;
+	struct rxd_pkt_entry *pkt_entry;
+	size_t offset, len, seg_size;
+
+	seg_buf = container_of(comp->op_context, struct rxd_seg_buf, context);
+	rxd_ep_post_buf(ep);
+	slist_remove_first_match(&ep->seg_buf_list, rxd_match_seg_buf,
+				 &seg_buf->s_entry);
+
+	seg_size = seg_buf->seg_size ? seg_buf->seg_size : comp->len;
+	for (offset = 0; offset < comp->len; offset += len) {
+		len = MIN(seg_size, comp->len - offset);
+		if (len > (size_t) rxd_ep_domain(ep)->max_mtu_sz)
+			break;
+
+		pkt_entry = ofi_buf_alloc(ep->rx_pkt_pool.pool);
+		if (!pkt_entry)
+			break;
+
+		memcpy(rxd_pkt_start(pkt_entry), &seg_buf->data[offset], len);
+		rxd_handle_rx_pkt(ep, pkt_entry, len);
+	}
+
+	ofi_buf_free(seg_buf);
+}
+
+void rxd_handle_recv_comp(struct rxd_ep *ep, struct fi_cq_msg_entry *comp)
+{
+	struct rxd_pkt_entry *pkt_entry;
+
+	if (ep->seg_ops) {
+		rxd_handle_seg_recv_comp(ep, comp);
+		return;
+	}
+
+	pkt_entry = container_of(comp->op_context, struct rxd_pkt_entry,
+				 context);
+	rxd_ep_post_buf(ep);
+	rxd_remove_rx_pkt(ep, pkt_entry);
+	rxd_handle_rx_pkt(ep, pkt_entry, comp->len);
+}
+
 void rxd_handle_error(struct rxd_ep *ep)
 {
 	struct fi_cq_err_entry err = {0};
@@ -1270,7 +1488,7 @@ ssize_t rxd_cq_sreadfrom(struct fid_cq *cq_fid, void *buf, size_t count,
 		ofi_genlock_unlock(&cq->ep_list_lock);
 
 		ret = ofi_wait(&cq->wait->wait_fid, ep_retry == -1 ?
-			       timeout : rxd_get_timeout(ep_retry));
+			       timeout : ep_retry);
 
 		if (ep_retry != -1 && ret == -FI_ETIMEDOUT)
 			ret = 0;
@@ -223,11 +223,36 @@ struct rxd_x_entry *rxd_rx_entry_init(struct rxd_ep *ep,
 	return rx_entry;
 }
 
+static ssize_t rxd_ep_post_seg_buf(struct rxd_ep *ep)
+{
+	struct rxd_seg_buf *seg_buf;
+	ssize_t ret;
+
+	seg_buf = ofi_buf_alloc(ep->seg_buf_pool);
+	if (!seg_buf)
+		return -FI_ENOMEM;
+
+	ret = ep->seg_ops->recv(ep->dg_ep, seg_buf->data, RXD_SEG_BUF_SIZE,
+				&seg_buf->context, &seg_buf->seg_size);
+	if (ret) {
+		ofi_buf_free(seg_buf);
+		FI_WARN(&rxd_prov, FI_LOG_EP_CTRL, "failed to repost\n");
+		return ret;
+	}
+
+	slist_insert_tail(&seg_buf->s_entry, &ep->seg_buf_list);
+
+	return 0;
+}
+
 ssize_t rxd_ep_post_buf(struct rxd_ep *ep)
 {
 	struct rxd_pkt_entry *pkt_entry;
 	ssize_t ret;
 
+	if (ep->seg_ops)
+		return rxd_ep_post_seg_buf(ep);
+
 	pkt_entry = ofi_buf_alloc(ep->rx_pkt_pool.pool);
 	if (!pkt_entry)
 		return -FI_ENOMEM;
@@ -247,9 +272,48 @@ ssize_t rxd_ep_post_buf(struct rxd_ep *ep)
 	return 0;
 }
 
+static void rxd_ep_init_seg(struct rxd_ep *ep)
+{
+	struct ofi_ops_dgram_seg *seg_ops;
+	int ret;
+
+	ret = fi_open_ops(&ep->dg_ep->fid, OFI_OPS_DGRAM_SEG, 0,
+			  (void **) &seg_ops, NULL);
+	if (ret)
+		goto disable;
+
+	ret = seg_ops->query(ep->dg_ep, &ep->seg_max_cnt, &ep->seg_max_len);
+	if (ret)
+		goto disable;
+
+	ret = ofi_bufpool_create(&ep->seg_buf_pool,
+				 sizeof(struct rxd_seg_buf) + RXD_SEG_BUF_SIZE,
+				 RXD_BUF_POOL_ALIGNMENT, 0, 16, 0);
+	if (ret)
+		goto disable;
+
+	ep->seg_max_cnt = MIN(ep->seg_max_cnt, RXD_MAX_SEG_CNT);
+	ep->seg_ops = seg_ops;
+	return;
+
+disable:
+	FI_INFO(&rxd_prov, FI_LOG_EP_CTRL,
+		"segmentation offload not available: %s\n", fi_strerror(-ret));
+}
+
+/* A GRO buffer holds many packets, size the posted count to match rx_size */
+static size_t rxd_ep_rx_buf_cnt(struct rxd_ep *ep)
+{
+	if (!ep->seg_ops)
+		return ep->rx_size;
+
+	return MAX(ep->rx_size * rxd_ep_domain(ep)->max_mtu_sz /
+		   RXD_SEG_BUF_SIZE, 1);
+}
+
 static int rxd_ep_enable(struct rxd_ep *ep)
 {
-	size_t i;
+	size_t i, cnt;
 	int ret;
 
 	ret = fi_ep_bind(ep->dg_ep, &ep->dg_cq->fid, FI_TRANSMIT | FI_RECV);
@@ -263,8 +327,12 @@ static int rxd_ep_enable(struct rxd_ep *ep)
 	ep->tx_flags = rxd_tx_flags(ep->util_ep.tx_op_flags);
 	ep->rx_flags = rxd_rx_flags(ep->util_ep.rx_op_flags);
 
+	if (rxd_env.seg_offload)
+		rxd_ep_init_seg(ep);
+
 	ofi_genlock_lock(&ep->util_ep.lock);
-	for (i = 0; i < ep->rx_size; i++) {
+	cnt = rxd_ep_rx_buf_cnt(ep);
+	for (i = 0; i < cnt; i++) {
 		if (rxd_ep_post_buf(ep))
 			break;
 	}
@@ -273,16 +341,84 @@ static int rxd_ep_enable(struct rxd_ep *ep)
 }
 
 /*
- * Exponential back-off starting at 1ms, max 4s.
+ * Retransmit timeout derived from the peer's RTT estimate.  Each expiration
+ * doubles it, up to 4s, until an ack provides a new valid sample.
  */
-int rxd_get_timeout(int retry_cnt)
+uint64_t rxd_get_timeout(struct rxd_peer *peer)
 {
-	return MIN(1 << retry_cnt, 4000);
+	return peer->rto;
 }
 
-uint64_t rxd_get_retry_time(uint64_t start, int retry_cnt)
+uint64_t rxd_get_retry_time(struct rxd_peer *peer, uint64_t start)
 {
-	return start + rxd_get_timeout(retry_cnt);
+	return start + rxd_get_timeout(peer);
+}
+
+/*
+ * Jacobson/Karels estimator as specified by RFC 6298, with the variance term
+ * bounded below by the 1ms resolution at which retransmits are checked while
+ * blocked.  Callers only pass samples that Karn's rule allows.
+ */
+void rxd_update_rtt(struct rxd_peer *peer, uint64_t rtt)
+{
+	uint64_t delta;
+
+	if (!peer->srtt) {
+		peer->srtt = MAX(rtt, 1);
+		peer->rttvar = rtt / 2;
+	} else {
+		delta = peer->srtt > rtt ? peer->srtt - rtt : rtt - peer->srtt;
+		peer->rttvar = (3 * peer->rttvar + delta) / 4;
+		peer->srtt = MAX((7 * peer->srtt + rtt) / 8, 1);
+	}
+
+	peer->rto = MIN(peer->srtt + MAX(4 * peer->rttvar,
+					 (uint64_t) RXD_RTO_GRANULARITY),
+			(uint64_t) RXD_MAX_RTO);
+}
+
+/*
+ * Additive increase: grow by one packet per acked packet during slow start
+ * and by one packet per window afterwards, but not while still recovering
+ * from a loss.  The window never exceeds what a receiver may advertise.
+ */
+void rxd_cwnd_ack(struct rxd_peer *peer, uint16_t acked)
+{
+	uint16_t max_cwnd = (uint16_t) rxd_env.max_unacked;
+
+	if (!rxd_env.cong_ctrl ||
+	    ofi_before(peer->last_rx_ack, peer->recover))
+		return;
+
+	if (peer->cwnd < peer->ssthresh) {
+		peer->cwnd = MIN(peer->cwnd + acked, max_cwnd);
+		return;
+	}
+
+	peer->cwnd_cnt += acked;
+	if (peer->cwnd_cnt >= peer->cwnd) {
+		peer->cwnd_cnt -= peer->cwnd;
+		peer->cwnd = MIN(peer->cwnd + 1, max_cwnd);
+	}
+}
+
+/*
+ * Multiplicative decrease: a fast retransmit halves the window at most once
+ * per window of data, a timeout restarts slow start.
+ */
+void rxd_cwnd_loss(struct rxd_peer *peer, bool timeout)
+{
+	if (!rxd_env.cong_ctrl ||
+	    (!timeout && ofi_before(peer->last_rx_ack, peer->recover)))
+		return;
+
+	/* repeated timeouts of the same data do not shrink ssthresh further */
+	if (!timeout || !peer->retry_cnt)
+		peer->ssthresh = MAX(peer->cwnd / 2, RXD_MIN_CWND);
+	peer->cwnd = timeout ? RXD_MIN_CWND : peer->ssthresh;
+	peer->cwnd_cnt = 0;
+	if (!timeout)
+		peer->recover = peer->tx_seq_no;
 }
 
 void rxd_init_data_pkt(struct rxd_ep *ep, struct rxd_x_entry *tx_entry,
@@ -379,19 +515,75 @@ void rxd_insert_unacked(struct rxd_ep *ep, fi_addr_t peer,
 	rxd_peer(ep, peer)->unacked_cnt++;
 }
 
+/*
+ * Send a run of data packets to the same peer with a single segmented
+ * send.  All packets but the last have the same size.  On failure the
+ * packets stay unacked and are retried by the retransmit timer.
+ */
+static void rxd_ep_send_pkts(struct rxd_ep *ep, struct rxd_pkt_entry **pkts,
+			     size_t cnt)
+{
+	struct iovec iov[RXD_MAX_SEG_CNT];
+	void *context[RXD_MAX_SEG_CNT];
+	fi_addr_t dg_addr;
+	uint64_t now;
+	size_t i;
+	ssize_t ret;
+
+	if (cnt == 1) {
+		rxd_ep_send_pkt(ep, pkts[0]);
+		return;
+	}
+
+	now = ofi_gettime_us();
+	for (i = 0; i < cnt; i++) {
+		pkts[i]->timestamp = now;
+		iov[i].iov_base = rxd_pkt_start(pkts[i]);
+		iov[i].iov_len = pkts[i]->pkt_size;
+		context[i] = &pkts[i]->context;
+	}
+
+	dg_addr = (intptr_t) ofi_idx_lookup(&(rxd_ep_av(ep)->rxdaddr_dg_idx),
+					    (int) pkts[0]->peer);
+	ret = ep->seg_ops->sendv(ep->dg_ep, iov, context, cnt, dg_addr);
+	if (ret) {
+		FI_WARN(&rxd_prov, FI_LOG_EP_CTRL,
+			"error sending packets: %d (%s)\n",
+			(int) ret, fi_strerror((int) -ret));
+		return;
+	}
+
+	for (i = 0; i < cnt; i++)
+		pkts[i]->flags |= RXD_PKT_IN_USE;
+}
+
+static bool rxd_seg_fits(struct rxd_ep *ep, struct rxd_pkt_entry **pkts,
+			 size_t cnt, size_t len, struct rxd_pkt_entry *pkt_entry)
+{
+	return cnt < ep->seg_max_cnt &&
+	       len + pkt_entry->pkt_size <= ep->seg_max_len &&
+	       pkts[cnt - 1]->pkt_size == pkts[0]->pkt_size &&
+	       pkt_entry->pkt_size <= pkts[0]->pkt_size;
+}
+
 ssize_t rxd_ep_post_data_pkts(struct rxd_ep *ep, struct rxd_x_entry *tx_entry)
 {
+	struct rxd_peer *peer = rxd_peer(ep, tx_entry->peer);
+	struct rxd_pkt_entry *pkts[RXD_MAX_SEG_CNT];
 	struct rxd_pkt_entry *pkt_entry;
 	struct rxd_data_pkt *data;
+	size_t cnt = 0, len = 0;
+	ssize_t ret = 0;
 
 	while (tx_entry->bytes_done != tx_entry->cq_entry.len) {
-		if (rxd_peer(ep, tx_entry->peer)->unacked_cnt >=
-		    rxd_peer(ep, tx_entry->peer)->tx_window)
-			return 0;
+		if (peer->unacked_cnt >= rxd_peer_window(peer))
+			break;
 
 		pkt_entry = rxd_get_tx_pkt(ep);
-		if (!pkt_entry)
-			return -FI_ENOMEM;
+		if (!pkt_entry) {
+			ret = -FI_ENOMEM;
+			break;
+		}
 
 		rxd_init_data_pkt(ep, tx_entry, pkt_entry);
 
@@ -401,19 +593,45 @@ ssize_t rxd_ep_post_data_pkts(struct rxd_ep *ep, struct rxd_x_entry *tx_entry)
 		if (data->base_hdr.type != RXD_DATA_READ)
 			data->base_hdr.seq_no++;
 
-		rxd_ep_send_pkt(ep, pkt_entry);
 		rxd_insert_unacked(ep, tx_entry->peer, pkt_entry);
+
+		/*
+		 * The receiver only acks every rx_window segments on its own,
+		 * which may be more than the congestion window allows in
+		 * flight.  Ask for an ack half way and when the window fills.
+		 */
+		if (rxd_env.cong_ctrl &&
+		    (peer->unacked_cnt >= rxd_peer_window(peer) ||
+		     peer->unacked_cnt == rxd_peer_window(peer) / 2))
+			data->base_hdr.flags |= RXD_ACK_REQ;
+
+		if (!ep->seg_ops) {
+			rxd_ep_send_pkt(ep, pkt_entry);
+			continue;
+		}
+
+		if (cnt && !rxd_seg_fits(ep, pkts, cnt, len, pkt_entry)) {
+			rxd_ep_send_pkts(ep, pkts, cnt);
+			cnt = len = 0;
+		}
+		pkts[cnt++] = pkt_entry;
+		len += pkt_entry->pkt_size;
 	}
 
-	return rxd_peer(ep, tx_entry->peer)->unacked_cnt >=
-	       rxd_peer(ep, tx_entry->peer)->tx_window;
+	if (cnt)
+		rxd_ep_send_pkts(ep, pkts, cnt);
+
+	if (ret)
+		return ret;
+
+	return peer->unacked_cnt >= rxd_peer_window(peer);
 }
 
 ssize_t rxd_ep_send_pkt(struct rxd_ep *ep, struct rxd_pkt_entry *pkt_entry)
 {
 	ssize_t ret;
 	fi_addr_t dg_addr;
-	pkt_entry->timestamp = ofi_gettime_ms();
+	pkt_entry->timestamp = ofi_gettime_us();
 
 	dg_addr = (intptr_t) ofi_idx_lookup(&(rxd_ep_av(ep)->rxdaddr_dg_idx),
 					    (int)pkt_entry->peer);
@@ -557,6 +775,26 @@ size_t rxd_init_msg(void **ptr, const struct iovec *iov, size_t iov_count,
 	return done;
 }
 
+/* Report the out of order packets held on buf_pkts, see rxd_buf_pkt() */
+static void rxd_set_sack(struct rxd_peer *peer, struct rxd_ack_pkt *ack)
+{
+	struct rxd_pkt_entry *pkt_entry;
+	uint64_t seq_no, bit;
+
+	memset(ack->sack, 0, sizeof(ack->sack));
+	dlist_foreach_container(&peer->buf_pkts, struct rxd_pkt_entry,
+				pkt_entry, d_entry) {
+		seq_no = rxd_get_base_hdr(pkt_entry)->seq_no;
+		if (ofi_after_eq(peer->rx_seq_no, seq_no))
+			continue;
+
+		bit = seq_no - peer->rx_seq_no - 1;
+		if (bit >= RXD_SACK_BITS)
+			break;
+		ack->sack[bit / 64] |= 1ULL << (bit % 64);
+	}
+}
+
 void rxd_ep_send_ack(struct rxd_ep *rxd_ep, fi_addr_t peer)
 {
 	struct rxd_pkt_entry *pkt_entry;
@@ -578,6 +816,7 @@ void rxd_ep_send_ack(struct rxd_ep *rxd_ep, fi_addr_t peer)
 	ack->base_hdr.seq_no = rxd_peer(rxd_ep, peer)->rx_seq_no;
 	ack->ext_hdr.rx_id = rxd_peer(rxd_ep, peer)->rx_window;
 	rxd_peer(rxd_ep, peer)->last_tx_ack = ack->base_hdr.seq_no;
+	rxd_set_sack(rxd_peer(rxd_ep, peer), ack);
 
 	dlist_insert_tail(&pkt_entry->d_entry, &rxd_ep->ctrl_pkts);
 	if (rxd_ep_send_pkt(rxd_ep, pkt_entry))
@@ -597,6 +836,9 @@ static void rxd_ep_free_res(struct rxd_ep *ep)
 
 	if (ep->rx_entry_pool.pool)
 		ofi_bufpool_destroy(ep->rx_entry_pool.pool);
+
+	if (ep->seg_buf_pool)
+		ofi_bufpool_destroy(ep->seg_buf_pool);
 }
 
 static void rxd_close_peer(struct rxd_ep *ep, struct rxd_peer *peer)
@@ -604,6 +846,12 @@ static void rxd_close_peer(struct rxd_ep *ep, struct rxd_peer *peer)
 	struct rxd_pkt_entry *pkt_entry;
 	struct rxd_x_entry *x_entry;
 
+	FI_INFO(&rxd_prov, FI_LOG_EP_CTRL, "peer %" PRIu64 ": cwnd %u "
+		"srtt %" PRIu64 "us rttvar %" PRIu64 "us retransmits %" PRIu64
+		" fast retransmits %" PRIu64 " timeouts %" PRIu64 "\n",
+		peer->peer_addr, peer->cwnd, peer->srtt, peer->rttvar,
+		peer->retx_cnt, peer->fast_retx_cnt, peer->timeout_cnt);
+
 	while (!dlist_empty(&peer->unacked)) {
 		dlist_pop_front(&peer->unacked, struct rxd_pkt_entry,
 				pkt_entry, d_entry);
@@ -629,6 +877,12 @@ static void rxd_close_peer(struct rxd_ep *ep, struct rxd_peer *peer)
 		rxd_tx_entry_free(ep, x_entry);
 	}
 
+	while (!dlist_empty(&peer->buf_pkts)) {
+		dlist_pop_front(&peer->buf_pkts, struct rxd_pkt_entry,
+				pkt_entry, d_entry);
+		ofi_buf_free(pkt_entry);
+	}
+
 	dlist_remove(&peer->entry);
 	peer->active = 0;
 }
@@ -688,6 +942,11 @@ static int rxd_ep_close(struct fid *fid)
 		ofi_buf_free(pkt_entry);
 	}
 
+	while (!slist_empty(&ep->seg_buf_list)) {
+		entry = slist_remove_head(&ep->seg_buf_list);
+		ofi_buf_free(container_of(entry, struct rxd_seg_buf, s_entry));
+	}
+
 	rxd_cleanup_unexp_msg_list(&ep->unexp_list);
 	rxd_cleanup_unexp_msg_list(&ep->unexp_tag_list);
 
@@ -699,6 +958,7 @@ static int rxd_ep_close(struct fid *fid)
 
 	rxd_ep_free_res(ep);
 	ofi_endpoint_close(&ep->util_ep);
+	free(ep->stats.peers);
 	free(ep);
 	return 0;
 }
@@ -852,7 +1112,7 @@ static struct fi_ops rxd_ep_fi_ops = {
 	.close = rxd_ep_close,
 	.bind = rxd_ep_bind,
 	.control = rxd_ep_control,
-	.ops_open = fi_no_ops_open,
+	.ops_open = rxd_ep_ops_open,
 };
 
 static int rxd_ep_cm_setname(fid_t fid, void *addr, size_t addrlen)
@@ -914,14 +1174,35 @@ static void rxd_peer_timeout(struct rxd_ep *rxd_ep, struct rxd_peer *peer)
 	dlist_remove(&peer->entry);
 }
 
+static ssize_t rxd_retransmit_pkt(struct rxd_ep *ep, struct rxd_peer *peer,
+				  struct rxd_pkt_entry *pkt_entry, int *retry)
+{
+	ssize_t ret;
+
+	if (!*retry) {
+		rxd_cwnd_loss(peer, true);
+		peer->timeout_cnt++;
+		ep->stats.timeout_cnt++;
+	}
+	*retry = 1;
+	pkt_entry->flags |= RXD_PKT_RETX;
+	rxd_get_base_hdr(pkt_entry)->flags |= RXD_ACK_REQ;
+	ret = rxd_ep_send_pkt(ep, pkt_entry);
+	if (ret)
+		return ret;
+
+	peer->retx_cnt++;
+	ep->stats.retx_cnt++;
+	return 0;
+}
+
 static void rxd_progress_pkt_list(struct rxd_ep *ep, struct rxd_peer *peer)
 {
-	struct rxd_pkt_entry *pkt_entry;
+	struct rxd_pkt_entry *pkt_entry, *probe = NULL;
 	uint64_t current;
-	ssize_t ret;
-	int retry = 0;
+	int retry = 0, timeout;
 
-	current = ofi_gettime_ms();
+	current = ofi_gettime_us();
 	if (peer->retry_cnt > RXD_MAX_PKT_RETRY) {
 		rxd_peer_timeout(ep, peer);
 		return;
@@ -929,21 +1210,107 @@ static void rxd_progress_pkt_list(struct rxd_ep *ep, struct rxd_peer *peer)
 
 	dlist_foreach_container(&peer->unacked, struct rxd_pkt_entry,
 				pkt_entry, d_entry) {
+		/* Held by the receiver, only the holes need resending */
+		if (pkt_entry->flags & RXD_PKT_SACKED) {
+			if (!probe && !(pkt_entry->flags & RXD_PKT_IN_USE) &&
+			    current >= rxd_get_retry_time(peer,
+							  pkt_entry->timestamp))
+				probe = pkt_entry;
+			continue;
+		}
 		if (pkt_entry->flags & (RXD_PKT_IN_USE | RXD_PKT_ACKED) ||
-		    current < rxd_get_retry_time(pkt_entry->timestamp,
-						 (uint8_t) peer->retry_cnt))
+		    current < rxd_get_retry_time(peer, pkt_entry->timestamp))
 			break;
-		retry = 1;
-		ret = rxd_ep_send_pkt(ep, pkt_entry);
-		if (ret)
+		if (rxd_retransmit_pkt(ep, peer, pkt_entry, &retry))
 			break;
 	}
-	if (retry)
+
+	/*
+	 * No holes are left but the ack covering the held packets was lost.
+	 * Resend one of them to have the receiver repeat its ack.
+	 */
+	if (!retry && probe)
+		(void) rxd_retransmit_pkt(ep, peer, probe, &retry);
+
+	if (retry) {
 		peer->retry_cnt++;
+		peer->rto = MIN(peer->rto << 1, (uint64_t) RXD_MAX_RTO);
+	}
+
+	if (!dlist_empty(&peer->unacked)) {
+		timeout = (int) ((rxd_get_timeout(peer) + 999) / 1000);
+		ep->next_retry = ep->next_retry == -1 ? timeout :
+				 MIN(ep->next_retry, timeout);
+	}
+}
 
-	if (!dlist_empty(&peer->unacked))
-		ep->next_retry = ep->next_retry == -1 ? peer->retry_cnt :
-				 MIN(ep->next_retry, peer->retry_cnt);
+static fi_addr_t rxd_peer_fi_addr(struct rxd_ep *ep, struct rxd_peer *peer)
+{
+	int util_addr;
+
+	if (!ep->util_ep.av)
+		return FI_ADDR_NOTAVAIL;
+
+	util_addr = (int) (intptr_t) ofi_idm_lookup(
+			&rxd_ep_av(ep)->rxdaddr_fi_idm, (int) peer->rxd_addr);
+	return util_addr ? (fi_addr_t) (util_addr - 1) : FI_ADDR_NOTAVAIL;
+}
+
+static void rxd_ep_update_peer_stats(struct rxd_ep *ep)
+{
+	struct fi_rxd_peer_stats *peers, *stats;
+	struct rxd_peer *peer;
+	size_t cnt = 0;
+
+	dlist_foreach_container(&ep->active_peers, struct rxd_peer,
+				peer, entry)
+		cnt++;
+
+	if (cnt > ep->stats.peer_size) {
+		peers = realloc(ep->stats.peers, cnt * sizeof(*peers));
+		if (!peers) {
+			ep->stats.peer_cnt = 0;
+			return;
+		}
+		ep->stats.peers = peers;
+		ep->stats.peer_size = cnt;
+	}
+
+	stats = ep->stats.peers;
+	dlist_foreach_container(&ep->active_peers, struct rxd_peer,
+				peer, entry) {
+		stats->addr = rxd_peer_fi_addr(ep, peer);
+		stats->cwnd = peer->cwnd;
+		stats->srtt = peer->srtt;
+		stats->rttvar = peer->rttvar;
+		stats->rto = peer->rto;
+		stats->retx_cnt = peer->retx_cnt;
+		stats->fast_retx_cnt = peer->fast_retx_cnt;
+		stats->timeout_cnt = peer->timeout_cnt;
+		stats++;
+	}
+	ep->stats.peer_cnt = cnt;
+}
+
+/* ensure ep lock is held before this function is called */
+void rxd_ep_update_stats(struct rxd_ep *ep)
+{
+	struct rxd_peer *peer;
+
+	ep->stats.min_cwnd = 0;
+	ep->stats.max_srtt = 0;
+	ep->stats.max_rttvar = 0;
+	ep->stats.max_rto = 0;
+
+	dlist_foreach_container(&ep->active_peers, struct rxd_peer,
+				peer, entry) {
+		if (!ep->stats.min_cwnd || peer->cwnd < ep->stats.min_cwnd)
+			ep->stats.min_cwnd = peer->cwnd;
+		ep->stats.max_srtt = MAX(ep->stats.max_srtt, peer->srtt);
+		ep->stats.max_rttvar = MAX(ep->stats.max_rttvar, peer->rttvar);
+		ep->stats.max_rto = MAX(ep->stats.max_rto, peer->rto);
+	}
+	rxd_ep_update_peer_stats(ep);
 }
 
 void rxd_ep_progress(struct util_ep *util_ep)
@@ -1138,6 +1505,7 @@ int rxd_ep_init_res(struct rxd_ep *ep, struct fi_info *fi_info)
 	dlist_init(&ep->unexp_tag_list);
 	dlist_init(&ep->ctrl_pkts);
 	slist_init(&ep->rx_pkt_list);
+	slist_init(&ep->seg_buf_list);
 
 	return 0;
 err:
@@ -1155,6 +1523,7 @@ int rxd_create_peer(struct rxd_ep *ep, uint64_t rxd_addr)
 	if (!peer)
 		return -FI_ENOMEM;
 
+	peer->rxd_addr = rxd_addr;
 	peer->peer_addr = RXD_ADDR_INVALID;
 	peer->tx_seq_no = 0;
 	peer->rx_seq_no = 0;
@@ -1164,6 +1533,11 @@ int rxd_create_peer(struct rxd_ep *ep, uint64_t rxd_addr)
 	peer->tx_window = (uint16_t) rxd_env.max_unacked;
 	peer->unacked_cnt = 0;
 	peer->retry_cnt = 0;
+	peer->dup_ack_cnt = 0;
+	peer->rto = RXD_INIT_RTO;
+	peer->cwnd = rxd_env.cong_ctrl ? MIN(RXD_INIT_CWND, peer->tx_window) :
+		     peer->tx_window;
+	peer->ssthresh = peer->tx_window;
 	peer->active = 0;
 	dlist_init(&(peer->unacked));
 	dlist_init(&(peer->tx_list));
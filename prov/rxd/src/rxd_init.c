@@ -43,6 +43,8 @@ struct rxd_env rxd_env = {
 	.retry		= 1,
 	.max_peers	= 1024,
 	.max_unacked	= 128,
+	.seg_offload	= 0,
+	.cong_ctrl	= 0,
 };
 
 char *rxd_pkt_type_str[] = {
@@ -55,6 +57,8 @@ static void rxd_init_env(void)
 	fi_param_get_bool(&rxd_prov, "retry", &rxd_env.retry);
 	fi_param_get_int(&rxd_prov, "max_peers", &rxd_env.max_peers);
 	fi_param_get_int(&rxd_prov, "max_unacked", &rxd_env.max_unacked);
+	fi_param_get_bool(&rxd_prov, "seg_offload", &rxd_env.seg_offload);
+	fi_param_get_bool(&rxd_prov, "cong_ctrl", &rxd_env.cong_ctrl);
 }
 
 void rxd_info_to_core_mr_modes(uint32_t version, const struct fi_info *hints,
@@ -147,6 +151,14 @@ RXD_INI
 			"Maximum number of peers to track (default: 1024)");
 	fi_param_define(&rxd_prov, "max_unacked", FI_PARAM_INT,
 			"Maximum number of packets to send at once (default: 128)");
+	fi_param_define(&rxd_prov, "seg_offload", FI_PARAM_BOOL,
+			"Send and receive data packets using segmentation "
+			"offload (UDP GSO/GRO) when supported by the core "
+			"provider (default: no)");
+	fi_param_define(&rxd_prov, "cong_ctrl", FI_PARAM_BOOL,
+			"Limit the packets in flight to each peer with an "
+			"AIMD congestion window.  Useful on shared or lossy "
+			"networks, at some cost in bandwidth (default: no)");
 
 	rxd_init_env();
 
@@ -0,0 +1,337 @@
+/*
+ * Copyright (c) 2026 Intel Corporation. All rights reserved.
+ *
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *	   Redistribution and use in source and binary forms, with or
+ *	   without modification, are permitted provided that the following
+ *	   conditions are met:
+ *
+ *		- Redistributions of source code must retain the above
+ *		  copyright notice, this list of conditions and the following
+ *		  disclaimer.
+ *
+ *		- Redistributions in binary form must reproduce the above
+ *		  copyright notice, this list of conditions and the following
+ *		  disclaimer in the documentation and/or other materials
+ *		  provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <rdma/fi_errno.h>
+#include <rdma/fabric.h>
+
+#include <ofi_prov.h>
+#include "rxd.h"
+
+#ifdef HAVE_FABRIC_PROFILE
+#include <ofi_profile.h>
+
+/*
+ * Provider-specific variables.  Window and RTT values are taken across the
+ * endpoint's active peers when read, counters are endpoint totals.
+ * RXD_VAR_PEER_STATS reads an array of struct fi_rxd_peer_stats, one
+ * entry per active peer.
+ */
+enum {
+	RXD_VAR_MIN_CWND = (1 << 16),
+	RXD_VAR_MAX_SRTT,
+	RXD_VAR_MAX_RTTVAR,
+	RXD_VAR_MAX_RTO,
+	RXD_VAR_RETX_CNT,
+	RXD_VAR_FAST_RETX_CNT,
+	RXD_VAR_TIMEOUT_CNT,
+	RXD_VAR_PEER_STATS,
+};
+
+#define RXD_PROF_U64_VAR(var_id, var_name, var_desc)	\
+	{						\
+	 .id = var_id,					\
+	 .datatype_sel = fi_primitive_type,		\
+	 .datatype.primitive = FI_UINT64,		\
+	 .flags = 0,					\
+	 .size = sizeof(uint64_t),			\
+	 .name = var_name,				\
+	 .desc = var_desc				\
+	}
+
+static struct fi_profile_desc rxd_prof_vars[] = {
+	RXD_PROF_U64_VAR(RXD_VAR_MIN_CWND, "rxd_min_cwnd",
+			 "Smallest congestion window of any peer (packets)"),
+	RXD_PROF_U64_VAR(RXD_VAR_MAX_SRTT, "rxd_max_srtt",
+			 "Largest smoothed round trip time of any peer (usec)"),
+	RXD_PROF_U64_VAR(RXD_VAR_MAX_RTTVAR, "rxd_max_rttvar",
+			 "Largest round trip time variation of any peer (usec)"),
+	RXD_PROF_U64_VAR(RXD_VAR_MAX_RTO, "rxd_max_rto",
+			 "Largest retransmit timeout of any peer (usec)"),
+	RXD_PROF_U64_VAR(RXD_VAR_RETX_CNT, "rxd_retx_cnt",
+			 "Number of packets resent on timeout"),
+	RXD_PROF_U64_VAR(RXD_VAR_FAST_RETX_CNT, "rxd_fast_retx_cnt",
+			 "Number of packets resent on duplicate acks"),
+	RXD_PROF_U64_VAR(RXD_VAR_TIMEOUT_CNT, "rxd_timeout_cnt",
+			 "Number of retransmit timer expirations"),
+	{
+	 .id = RXD_VAR_PEER_STATS,
+	 .datatype_sel = fi_primitive_type,
+	 .datatype.primitive = FI_VOID,
+	 .flags = 0,
+	 .size = sizeof(struct fi_rxd_peer_stats),
+	 .name = "rxd_peer_stats",
+	 .desc = "Window, RTT and retransmits of each peer "
+		 "(struct fi_rxd_peer_stats array)"
+	},
+};
+
+static struct rxd_ep *rxd_prof_ep(struct util_profile *prof)
+{
+	return container_of(prof->fid, struct rxd_ep, util_ep.ep_fid.fid);
+}
+
+/* Point the cached data at the per-peer array, ep lock held */
+static void rxd_prof_set_peers(struct util_profile *prof, int idx)
+{
+	struct rxd_stats *stats = prof->vars[idx];
+
+	prof->data[idx].value.pt = stats->peers;
+	prof->data[idx].size = stats->peer_cnt * sizeof(*stats->peers);
+}
+
+static void rxd_prof_update(struct util_profile *prof)
+{
+	struct rxd_ep *ep = rxd_prof_ep(prof);
+
+	ofi_genlock_lock(&ep->util_ep.lock);
+	rxd_ep_update_stats(ep);
+	rxd_prof_set_peers(prof, ofi_prof_id2_idx(RXD_VAR_PEER_STATS,
+						  ofi_common_var_count));
+	ofi_genlock_unlock(&ep->util_ep.lock);
+}
+
+static int
+rxd_prof_init(struct fid *fid, uint64_t flags, void *context,
+	      struct fi_profile_ops *ops, struct rxd_ep *ep,
+	      struct util_profile **rxd_prof)
+{
+	struct util_profile *prof;
+	void *vars[] = {
+		&ep->stats.min_cwnd,
+		&ep->stats.max_srtt,
+		&ep->stats.max_rttvar,
+		&ep->stats.max_rto,
+		&ep->stats.retx_cnt,
+		&ep->stats.fast_retx_cnt,
+		&ep->stats.timeout_cnt,
+		&ep->stats,
+	};
+	size_t i;
+	int ret;
+
+	prof = calloc(1, sizeof(*prof));
+	if (!prof) {
+		FI_WARN(&rxd_prov, FI_LOG_EP_CTRL,
+			"cannot allocate memory.\n");
+		return -FI_ENOMEM;
+	}
+
+	prof->prov = &rxd_prov;
+	ret = ofi_prof_init(prof, fid, flags, context, ops,
+			    ARRAY_SIZE(rxd_prof_vars), 0);
+	if (ret) {
+		free(prof);
+		return ret;
+	}
+
+	ofi_prof_add_common_vars(prof);
+	for (i = 0; i < ARRAY_SIZE(rxd_prof_vars); i++)
+		(void) ofi_prof_add_var(prof, rxd_prof_vars[i].id,
+					&rxd_prof_vars[i], vars[i]);
+	ofi_prof_add_common_events(prof);
+
+	FI_TRACE(&rxd_prov, FI_LOG_EP_CTRL,
+		 "rxd_prof_init: flags 0x%lx, total: vars %zu, events %zu\n",
+		 flags, prof->var_count, prof->event_count);
+
+	*rxd_prof = prof;
+	return 0;
+}
+
+static void
+rxd_prof_reset(struct fid_profile *prof_fid, uint64_t flags)
+{
+	struct util_profile *util_prof =
+		container_of(prof_fid, struct util_profile, prof_fid);
+
+	ofi_prof_reset(util_prof, flags);
+}
+
+static ssize_t
+rxd_prof_query_vars(struct fid_profile *prof_fid,
+		    struct fi_profile_desc *varlist, size_t *count)
+{
+	struct util_profile *util_prof =
+		container_of(prof_fid, struct util_profile, prof_fid);
+
+	return ofi_prof_query_vars(util_prof, varlist, count);
+}
+
+static ssize_t
+rxd_prof_query_events(struct fid_profile *prof_fid,
+		      struct fi_profile_desc *eventlist, size_t *count)
+{
+	struct util_profile *util_prof =
+		container_of(prof_fid, struct util_profile, prof_fid);
+
+	return ofi_prof_query_events(util_prof, eventlist, count);
+}
+
+static int
+rxd_prof_reg_cb(struct fid_profile *prof_fid, uint32_t event,
+		ofi_prof_callback_t cb, void *context)
+{
+	struct util_profile *util_prof =
+		container_of(prof_fid, struct util_profile, prof_fid);
+
+	return ofi_prof_reg_callback(util_prof, event, cb, context);
+}
+
+static ssize_t
+rxd_prof_read_peers(struct util_profile *prof, int idx, void *data,
+		    size_t *size)
+{
+	struct rxd_ep *ep = rxd_prof_ep(prof);
+	ssize_t ret;
+
+	ofi_genlock_lock(&ep->util_ep.lock);
+	rxd_ep_update_stats(ep);
+	rxd_prof_set_peers(prof, idx);
+	if (*size < prof->data[idx].size) {
+		*size = prof->data[idx].size;
+		ret = -FI_ETOOSMALL;
+	} else {
+		ret = ofi_prof_read_cached_data(prof, idx, data, size);
+	}
+	ofi_genlock_unlock(&ep->util_ep.lock);
+	return ret;
+}
+
+static ssize_t
+rxd_prof_read_var(struct fid_profile *prof_fid, uint32_t var_id,
+		  void *data, size_t *size)
+{
+	struct util_profile *util_prof =
+		container_of(prof_fid, struct util_profile, prof_fid);
+	int idx = ofi_prof_id2_idx(var_id, ofi_common_var_count);
+
+	if ((idx >= util_prof->varlist_size) ||
+	    (!OFI_VAR_ENABLED(&util_prof->varlist[idx])))
+		return -FI_EINVAL;
+
+	if (!util_prof->vars[idx])
+		return -FI_ENODATA;
+
+	if (OFI_VAR_DATATYPE_U64(&(util_prof->varlist[idx]))) {
+		if (!OFI_PROF_DATA_CACHED(util_prof))
+			rxd_prof_update(util_prof);
+		return ofi_prof_read_u64(util_prof, idx, data, size);
+	}
+
+	if (OFI_PROF_DATA_CACHED(util_prof))
+		return ofi_prof_read_cached_data(util_prof, idx, data, size);
+
+	if (var_id == RXD_VAR_PEER_STATS)
+		return rxd_prof_read_peers(util_prof, idx, data, size);
+
+	return 0;
+}
+
+static void
+rxd_prof_start_reads(struct fid_profile *prof_fid, uint64_t flags)
+{
+	int i;
+	uint64_t size_u64 = sizeof(uint64_t);
+	struct util_profile *util_prof =
+		container_of(prof_fid, struct util_profile, prof_fid);
+
+	OFI_PROF_END_READS(util_prof);
+	rxd_prof_update(util_prof);
+	for (i = 0; i < util_prof->var_count; i++) {
+		/* common vars that rxd does not track are left unbound */
+		if (util_prof->vars[i] &&
+		    OFI_VAR_DATATYPE_U64(&(util_prof->varlist[i]))) {
+			util_prof->data[i].size =
+			       ofi_prof_read_u64(util_prof, i,
+						 &(util_prof->data[i].value.u64),
+						 &size_u64);
+		}
+	}
+	OFI_PROF_START_READS(util_prof);
+}
+
+static void
+rxd_prof_end_reads(struct fid_profile *prof_fid, uint64_t flags)
+{
+	struct util_profile *util_prof =
+		container_of(prof_fid, struct util_profile, prof_fid);
+
+	OFI_PROF_END_READS(util_prof);
+}
+
+static struct fi_profile_ops rxd_prof_ep_ops = {
+	.size = sizeof(struct fi_profile_ops),
+	.reset = rxd_prof_reset,
+	.query_vars = rxd_prof_query_vars,
+	.query_events = rxd_prof_query_events,
+	.read_var = rxd_prof_read_var,
+	.reg_callback = rxd_prof_reg_cb,
+	.start_reads = rxd_prof_start_reads,
+	.end_reads = rxd_prof_end_reads,
+};
+
+int rxd_ep_ops_open(struct fid *fid, const char *name,
+		    uint64_t flags, void **ops, void *context)
+{
+	struct util_profile *prof;
+	struct rxd_ep *ep;
+	int ret;
+
+	if (!strcmp(name, "fi_profile_ops") && fid->fclass == FI_CLASS_EP) {
+		ep = container_of(fid, struct rxd_ep, util_ep.ep_fid.fid);
+		ret = rxd_prof_init(fid, flags, context, &rxd_prof_ep_ops,
+				    ep, &prof);
+		if (ret)
+			return ret;
+
+		*ops = &prof->prof_fid.ops;
+		return 0;
+	}
+	FI_WARN(&rxd_prov, FI_LOG_EP_CTRL, "unsupported ep ops <%s>\n", name);
+
+	return -FI_ENOSYS;
+}
+
+#else
+
+int rxd_ep_ops_open(struct fid *fid, const char *name,
+		    uint64_t flags, void **ops, void *context)
+{
+	OFI_UNUSED(fid);
+	OFI_UNUSED(name);
+	OFI_UNUSED(flags);
+	OFI_UNUSED(ops);
+	OFI_UNUSED(context);
+	return -FI_ENOSYS;
+}
+
+#endif
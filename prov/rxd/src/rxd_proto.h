@@ -120,11 +120,17 @@ struct rxd_cts_pkt {
 
 /*
  * ACK: to signal received packets and send tx/rx id info
+ * 	- base_hdr.seq_no: next sequence number expected from the peer
+ * 	- ext_hdr.rx_id: receive window
+ * 	- sack: selective ack, bit i is set if packet seq_no + 1 + i has
+ * 	  been received out of order and is held by the receiver
  */
+#define RXD_SACK_BITS		128
+
 struct rxd_ack_pkt {
 	struct rxd_base_hdr	base_hdr;
 	struct rxd_ext_hdr	ext_hdr;
-	//TODO fill in more fields? Selective ack?
+	uint64_t		sack[RXD_SACK_BITS / 64];
 };
 
 /*
@@ -271,7 +271,6 @@ struct rxm_domain {
 	bool passthru;
 	struct ofi_ops_flow_ctrl *flow_ctrl_ops;
 	struct ofi_bufpool *amo_bufpool;
-	ofi_mutex_t amo_bufpool_lock;
 	struct fid_domain *util_coll_domain;
 	struct fid_domain *offload_coll_domain;
 	uint64_t offload_coll_mask;
@@ -449,6 +448,8 @@ struct rxm_recv_match_attr {
 
 struct rxm_unexp_msg {
 	struct dlist_entry entry;
+	/* Links the message on its source's list with FI_DIRECTED_RECV */
+	struct dlist_entry src_entry;
 	fi_addr_t addr;
 	uint64_t tag;
 };
@@ -617,6 +618,7 @@ struct rxm_recv_entry {
 	uint64_t comp_flags;
 	size_t total_len;
 	struct rxm_recv_queue *recv_queue;
+	uint64_t seq_no;
 
 	/* Used for SAR protocol */
 	struct {
@@ -639,12 +641,29 @@ enum rxm_recv_queue_type {
 	RXM_RECV_QUEUE_TAGGED,
 };
 
+/* With FI_DIRECTED_RECV, posted receives for a specific source are kept on
+ * a per-source list, indexed by fi_addr, and only receives from
+ * FI_ADDR_UNSPEC are kept on recv_list.  Receives are stamped with a
+ * sequence number so that an arrival can pick the oldest match between its
+ * source list and the wildcard list.  Unexpected messages are kept on both
+ * unexp_msg_list, in arrival order, and on their source's list, so that a
+ * directed receive only walks messages from that peer.  Messages from a
+ * peer that was not in the AV when they arrived are resolved to an address
+ * only when matched, so they go on unexp_anon_list instead and force
+ * directed receives back to the full unexp_msg_list while any are queued.
+ */
 struct rxm_recv_queue {
 	struct rxm_ep		*rxm_ep;
 	enum rxm_recv_queue_type type;
 	struct rxm_recv_fs	*fs;
 	struct dlist_entry	recv_list;
 	struct dlist_entry	unexp_msg_list;
+	struct dlist_entry	unexp_anon_list;
+	struct ofi_dyn_arr	src_recv_lists;
+	struct ofi_dyn_arr	src_unexp_lists;
+	uint64_t		seq_no;
+	bool			dir_recv;
+	bool			src_unexp;
 	dlist_func_t		*match_recv;
 	dlist_func_t		*match_unexp;
 };
@@ -964,6 +983,20 @@ rxm_recv_entry_get(struct rxm_ep *rxm_ep, const struct iovec *iov,
 struct rxm_rx_buf *
 rxm_get_unexp_msg(struct rxm_recv_queue *recv_queue, fi_addr_t addr,
 		  uint64_t tag, uint64_t ignore);
+void rxm_recv_queue_insert(struct rxm_recv_queue *recv_queue,
+			   struct rxm_recv_entry *recv_entry);
+struct rxm_recv_entry *
+rxm_recv_queue_match(struct rxm_recv_queue *recv_queue,
+		     struct rxm_recv_match_attr *match_attr);
+void rxm_unexp_msg_insert(struct rxm_recv_queue *recv_queue,
+			  struct rxm_rx_buf *rx_buf);
+
+static inline void rxm_unexp_msg_remove(struct rxm_rx_buf *rx_buf)
+{
+	dlist_remove(&rx_buf->unexp_msg.entry);
+	dlist_remove_init(&rx_buf->unexp_msg.src_entry);
+}
+
 ssize_t rxm_handle_unexp_sar(struct rxm_recv_queue *recv_queue,
 			     struct rxm_recv_entry *recv_entry,
 			     struct rxm_rx_buf *rx_buf);
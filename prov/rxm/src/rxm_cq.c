@@ -191,6 +191,28 @@ rxm_cq_write_tx_comp(struct rxm_ep *rxm_ep, uint64_t comp_flags,
 	}
 }
 
+/*
+ * Sends posted by the collective provider with FI_PEER_TRANSFER complete
+ * back to it rather than to the application's CQ.
+ */
+static void
+rxm_cq_write_send_comp(struct rxm_ep *rxm_ep, uint64_t tag,
+		       uint64_t comp_flags, void *app_context, uint64_t flags)
+{
+	if (rxm_ep->util_coll_ep && (tag & RXM_PEER_XFER_TAG_FLAG)) {
+		struct fi_cq_tagged_entry cqe = {
+			.tag = tag,
+			.op_context = app_context,
+		};
+		rxm_ep->util_coll_peer_xfer_ops->
+			complete(rxm_ep->util_coll_ep, &cqe, 0);
+		return;
+	}
+
+	rxm_cq_write_tx_comp(rxm_ep, comp_flags, app_context, flags);
+	ofi_ep_cntr_inc(&rxm_ep->util_ep, CNTR_TX);
+}
+
 static void rxm_finish_rma(struct rxm_ep *rxm_ep, struct rxm_tx_buf *rma_buf,
 			  uint64_t comp_flags)
 {
@@ -249,17 +271,17 @@ static void rxm_handle_sar_comp(struct rxm_ep *rxm_ep,
 				struct rxm_tx_buf *tx_buf)
 {
 	void *app_context;
-	uint64_t comp_flags, tx_flags;
+	uint64_t comp_flags, tx_flags, tag;
 
 	app_context = tx_buf->app_context;
 	comp_flags = ofi_tx_cq_flags(tx_buf->pkt.hdr.op);
 	tx_flags = tx_buf->flags;
+	tag = tx_buf->pkt.hdr.tag;
 
 	if (!rxm_complete_sar(rxm_ep, tx_buf))
 		return;
 
-	rxm_cq_write_tx_comp(rxm_ep, comp_flags, app_context, tx_flags);
-	ofi_ep_cntr_inc(&rxm_ep->util_ep, CNTR_TX);
+	rxm_cq_write_send_comp(rxm_ep, tag, comp_flags, app_context, tx_flags);
 }
 
 static void rxm_rndv_rx_finish(struct rxm_rx_buf *rx_buf)
@@ -287,15 +309,15 @@ static void rxm_rndv_tx_finish(struct rxm_ep *rxm_ep,
 	if (!rxm_ep->rdm_mr_local)
 		rxm_msg_mr_closev(tx_buf->rma.mr, tx_buf->rma.count);
 
-	rxm_cq_write_tx_comp(rxm_ep, ofi_tx_cq_flags(tx_buf->pkt.hdr.op),
-			     tx_buf->app_context, tx_buf->flags);
+	rxm_cq_write_send_comp(rxm_ep, tx_buf->pkt.hdr.tag,
+			       ofi_tx_cq_flags(tx_buf->pkt.hdr.op),
+			       tx_buf->app_context, tx_buf->flags);
 
 	if (rxm_ep->rndv_ops == &rxm_rndv_ops_write &&
 	    tx_buf->write_rndv.done_buf) {
 		ofi_buf_free(tx_buf->write_rndv.done_buf);
 		tx_buf->write_rndv.done_buf = NULL;
 	}
-	ofi_ep_cntr_inc(&rxm_ep->util_ep, CNTR_TX);
 	rxm_free_tx_buf(rxm_ep, tx_buf);
 }
 
@@ -715,6 +737,8 @@ static void rxm_adjust_multi_recv(struct rxm_rx_buf *rx_buf)
 
 	rx_buf->recv_entry->flags &= ~FI_MULTI_RECV;
 
+	/* The remainder keeps the original's place in the receive order */
+	recv_entry->seq_no = rx_buf->recv_entry->seq_no;
 	dlist_insert_head(&recv_entry->entry, &rx_buf->ep->recv_queue.recv_list);
 }
 
@@ -723,12 +747,8 @@ rxm_match_rx_buf(struct rxm_rx_buf *rx_buf,
 		 struct rxm_recv_queue *recv_queue,
 		 struct rxm_recv_match_attr *match_attr)
 {
-	struct dlist_entry *entry;
-
-	entry = dlist_remove_first_match(&recv_queue->recv_list,
-					 recv_queue->match_recv, match_attr);
-	if (entry) {
-		rx_buf->recv_entry = container_of(entry, struct rxm_recv_entry, entry);
+	rx_buf->recv_entry = rxm_recv_queue_match(recv_queue, match_attr);
+	if (rx_buf->recv_entry) {
 
 		if (rx_buf->recv_entry->flags & FI_MULTI_RECV)
 			rxm_adjust_multi_recv(rx_buf);
@@ -742,8 +762,7 @@ rxm_match_rx_buf(struct rxm_rx_buf *rx_buf,
 	rx_buf->unexp_msg.addr = match_attr->addr;
 	rx_buf->unexp_msg.tag = match_attr->tag;
 
-	dlist_insert_tail(&rx_buf->unexp_msg.entry,
-			  &recv_queue->unexp_msg_list);
+	rxm_unexp_msg_insert(recv_queue, rx_buf);
 	rxm_replace_rx_buf(rx_buf);
 	return 0;
 }
@@ -1105,10 +1124,7 @@ static int rxm_do_device_mem_atomic(struct rxm_mr *dev_mr, uint8_t op,
 		.iov_len = amo_op_size,
 	};
 
-	ofi_mutex_lock(&dom->amo_bufpool_lock);
 	tx_buf = ofi_buf_alloc(dom->amo_bufpool);
-	ofi_mutex_unlock(&dom->amo_bufpool_lock);
-
 	if (!tx_buf)
 		return -FI_ENOMEM;
 
@@ -1126,9 +1142,7 @@ static int rxm_do_device_mem_atomic(struct rxm_mr *dev_mr, uint8_t op,
 
 	ofi_mutex_unlock(&dev_mr->amo_lock);
 
-	ofi_mutex_lock(&dom->amo_bufpool_lock);
 	ofi_buf_free(tx_buf);
-	ofi_mutex_unlock(&dom->amo_bufpool_lock);
 
 	return FI_SUCCESS;
 }
@@ -1332,17 +1346,11 @@ static ssize_t rxm_handle_credit(struct rxm_ep *rxm_ep, struct rxm_rx_buf *rx_bu
 void rxm_finish_coll_eager_send(struct rxm_ep *rxm_ep,
 			        struct rxm_tx_buf *tx_eager_buf)
 {
-	if (rxm_ep->util_coll_ep &&
-	    (tx_eager_buf->pkt.hdr.tag & RXM_PEER_XFER_TAG_FLAG)) {
-		struct fi_cq_tagged_entry cqe = {
-			.tag = tx_eager_buf->pkt.hdr.tag,
-			.op_context = tx_eager_buf->app_context,
-		};
-		rxm_ep->util_coll_peer_xfer_ops->
-			complete(rxm_ep->util_coll_ep, &cqe, 0);
-	} else {
-		rxm_finish_eager_send(rxm_ep, tx_eager_buf);
-	}
+	assert(ofi_tx_cq_flags(tx_eager_buf->pkt.hdr.op) & FI_SEND);
+
+	rxm_cq_write_send_comp(rxm_ep, tx_eager_buf->pkt.hdr.tag,
+			       ofi_tx_cq_flags(tx_eager_buf->pkt.hdr.op),
+			       tx_eager_buf->app_context, tx_eager_buf->flags);
 }
 
 ssize_t rxm_handle_comp(struct rxm_ep *rxm_ep, struct fi_cq_data_entry *comp)
@@ -401,7 +401,6 @@ static int rxm_domain_close(fid_t fid)
 
 	rxm_domain = container_of(fid, struct rxm_domain, util_domain.domain_fid.fid);
 
-	ofi_mutex_destroy(&rxm_domain->amo_bufpool_lock);
 	ofi_bufpool_destroy(rxm_domain->amo_bufpool);
 
 	ret = fi_close(&rxm_domain->msg_domain->fid);
@@ -943,13 +942,13 @@ int rxm_domain_open(struct fid_fabric *fabric, struct fi_info *info,
 	(*domain)->fid.ops = &rxm_domain_fi_ops;
 	(*domain)->ops = &rxm_domain_ops;
 
+	/* shared by endpoints that are progressed without a common lock */
 	ret = ofi_bufpool_create(&rxm_domain->amo_bufpool,
-				 rxm_domain->max_atomic_size, 64, 0, 0, 0);
+				 rxm_domain->max_atomic_size, 64, 0, 0,
+				 OFI_BUFPOOL_MT);
 	if (ret)
 		goto err5;
 
-	ofi_mutex_init(&rxm_domain->amo_bufpool_lock);
-
 	rxm_domain->passthru = rxm_passthru_info(info);
 	if (rxm_domain->passthru)
 		(*domain)->mr = &rxm_domain_mr_thru_ops;
@@ -964,7 +963,6 @@ int rxm_domain_open(struct fid_fabric *fabric, struct fi_info *info,
 	return 0;
 
 err6:
-	ofi_mutex_destroy(&rxm_domain->amo_bufpool_lock);
 	ofi_bufpool_destroy(rxm_domain->amo_bufpool);
 err5:
 	if (rxm_domain->offload_coll_domain)
@@ -206,6 +206,11 @@ static void rxm_recv_entry_init(struct rxm_recv_entry *entry, void *arg)
 		entry->comp_flags |= FI_TAGGED;
 }
 
+static void rxm_init_src_list(struct ofi_dyn_arr *arr, void *item)
+{
+	dlist_init(item);
+}
+
 static int rxm_recv_queue_init(struct rxm_ep *rxm_ep,  struct rxm_recv_queue *recv_queue,
 			       size_t size, enum rxm_recv_queue_type type)
 {
@@ -218,6 +223,14 @@ static int rxm_recv_queue_init(struct rxm_ep *rxm_ep,  struct rxm_recv_queue *re
 
 	dlist_init(&recv_queue->recv_list);
 	dlist_init(&recv_queue->unexp_msg_list);
+	dlist_init(&recv_queue->unexp_anon_list);
+	ofi_array_init(&recv_queue->src_recv_lists, sizeof(struct dlist_entry),
+		       rxm_init_src_list);
+	ofi_array_init(&recv_queue->src_unexp_lists, sizeof(struct dlist_entry),
+		       rxm_init_src_list);
+	recv_queue->seq_no = 0;
+	recv_queue->dir_recv = !!(rxm_ep->rxm_info->caps & FI_DIRECTED_RECV);
+	recv_queue->src_unexp = recv_queue->dir_recv;
 	if (type == RXM_RECV_QUEUE_MSG) {
 		if (rxm_ep->rxm_info->caps & FI_DIRECTED_RECV) {
 			recv_queue->match_recv = rxm_match_recv_entry;
@@ -245,6 +258,8 @@ static void rxm_recv_queue_close(struct rxm_recv_queue *recv_queue)
 	if (recv_queue->fs) {
 		rxm_recv_fs_free(recv_queue->fs);
 		recv_queue->fs = NULL;
+		ofi_array_destroy(&recv_queue->src_recv_lists);
+		ofi_array_destroy(&recv_queue->src_unexp_lists);
 	}
 	// TODO cleanup recv_list and unexp msg list
 }
@@ -420,11 +435,29 @@ static struct rxm_eager_ops coll_eager_ops = {
 	.handle_rx = rxm_handle_coll_eager,
 };
 
+struct rxm_cancel_attr {
+	void *context;
+	struct dlist_entry *entry;
+};
+
+static int rxm_cancel_src(struct ofi_dyn_arr *arr, void *list, void *arg)
+{
+	struct rxm_cancel_attr *attr = arg;
+
+	attr->entry = dlist_remove_first_match(list,
+					       rxm_match_recv_entry_context,
+					       attr->context);
+	return attr->entry != NULL;
+}
+
 static bool rxm_ep_cancel_recv(struct rxm_ep *rxm_ep,
 			       struct rxm_recv_queue *recv_queue, void *context)
 {
 	struct fi_cq_err_entry err_entry;
 	struct rxm_recv_entry *recv_entry;
+	struct rxm_cancel_attr attr = {
+		.context = context,
+	};
 	struct dlist_entry *entry;
 	int ret;
 
@@ -432,6 +465,11 @@ static bool rxm_ep_cancel_recv(struct rxm_ep *rxm_ep,
 	entry = dlist_remove_first_match(&recv_queue->recv_list,
 					 rxm_match_recv_entry_context,
 					 context);
+	if (!entry && recv_queue->dir_recv) {
+		(void) ofi_array_iter(&recv_queue->src_recv_lists, &attr,
+				      rxm_cancel_src);
+		entry = attr.entry;
+	}
 	if (!entry)
 		goto unlock;
 
@@ -565,13 +603,103 @@ static struct fi_ops_ep rxm_ops_ep = {
 };
 
 
+static struct dlist_entry *
+rxm_src_list(struct ofi_dyn_arr *lists, fi_addr_t addr)
+{
+	if (addr > OFI_IDX_MAX_INDEX)
+		return NULL;
+
+	return ofi_array_at(lists, (int) addr);
+}
+
+void rxm_recv_queue_insert(struct rxm_recv_queue *recv_queue,
+			   struct rxm_recv_entry *recv_entry)
+{
+	struct dlist_entry *list = NULL;
+
+	recv_entry->seq_no = recv_queue->seq_no++;
+	if (recv_queue->dir_recv)
+		list = rxm_src_list(&recv_queue->src_recv_lists,
+				    recv_entry->addr);
+
+	/* match_recv still checks the source, so a directed receive is safe
+	 * on the wildcard list if its source list could not be allocated */
+	dlist_insert_tail(&recv_entry->entry,
+			  list ? list : &recv_queue->recv_list);
+}
+
+/* Removes and returns the oldest posted receive matching an arrival, or NULL.
+ * Only the arrival's source list and the wildcard list need to be searched.
+ */
+struct rxm_recv_entry *
+rxm_recv_queue_match(struct rxm_recv_queue *recv_queue,
+		     struct rxm_recv_match_attr *match_attr)
+{
+	struct rxm_recv_entry *recv_entry = NULL, *any_entry;
+	struct dlist_entry *list, *entry;
+
+	if (recv_queue->dir_recv) {
+		list = rxm_src_list(&recv_queue->src_recv_lists,
+				    match_attr->addr);
+		entry = list ? dlist_find_first_match(list,
+				recv_queue->match_recv, match_attr) : NULL;
+		if (entry)
+			recv_entry = container_of(entry, struct rxm_recv_entry,
+						  entry);
+	}
+
+	dlist_foreach_container(&recv_queue->recv_list, struct rxm_recv_entry,
+				any_entry, entry) {
+		if (recv_entry && any_entry->seq_no > recv_entry->seq_no)
+			break;
+
+		if (recv_queue->match_recv(&any_entry->entry, match_attr)) {
+			recv_entry = any_entry;
+			break;
+		}
+	}
+
+	if (recv_entry)
+		dlist_remove(&recv_entry->entry);
+	return recv_entry;
+}
+
+void rxm_unexp_msg_insert(struct rxm_recv_queue *recv_queue,
+			  struct rxm_rx_buf *rx_buf)
+{
+	struct dlist_entry *list = NULL;
+
+	dlist_insert_tail(&rx_buf->unexp_msg.entry,
+			  &recv_queue->unexp_msg_list);
+
+	if (recv_queue->dir_recv && rx_buf->unexp_msg.addr == FI_ADDR_UNSPEC) {
+		list = &recv_queue->unexp_anon_list;
+	} else if (recv_queue->dir_recv) {
+		list = rxm_src_list(&recv_queue->src_unexp_lists,
+				    rx_buf->unexp_msg.addr);
+		if (!list && recv_queue->src_unexp &&
+		    rx_buf->unexp_msg.addr <= OFI_IDX_MAX_INDEX) {
+			FI_WARN(&rxm_prov, FI_LOG_EP_DATA, "unable to allocate "
+				"per source unexpected list, falling back to "
+				"a single list\n");
+			recv_queue->src_unexp = false;
+		}
+	}
+
+	if (list)
+		dlist_insert_tail(&rx_buf->unexp_msg.src_entry, list);
+	else
+		dlist_init(&rx_buf->unexp_msg.src_entry);
+}
+
 /* Caller must hold recv_queue->lock -- TODO which lock? */
 struct rxm_rx_buf *
 rxm_get_unexp_msg(struct rxm_recv_queue *recv_queue, fi_addr_t addr,
 		  uint64_t tag, uint64_t ignore)
 {
 	struct rxm_recv_match_attr match_attr;
-	struct dlist_entry *entry;
+	struct dlist_entry *entry, *list;
+	struct rxm_rx_buf *rx_buf;
 
 	if (dlist_empty(&recv_queue->unexp_msg_list))
 		return NULL;
@@ -580,15 +708,30 @@ rxm_get_unexp_msg(struct rxm_recv_queue *recv_queue, fi_addr_t addr,
 	match_attr.tag = tag;
 	match_attr.ignore = ignore;
 
+	list = recv_queue->src_unexp &&
+	       dlist_empty(&recv_queue->unexp_anon_list) ?
+	       rxm_src_list(&recv_queue->src_unexp_lists, addr) : NULL;
+	if (list) {
+		dlist_foreach_container(list, struct rxm_rx_buf, rx_buf,
+					unexp_msg.src_entry) {
+			if (recv_queue->match_unexp(&rx_buf->unexp_msg.entry,
+						    &match_attr))
+				goto found;
+		}
+		return NULL;
+	}
+
 	entry = dlist_find_first_match(&recv_queue->unexp_msg_list,
 				       recv_queue->match_unexp, &match_attr);
 	if (!entry)
 		return NULL;
 
+	rx_buf = container_of(entry, struct rxm_rx_buf, unexp_msg.entry);
+found:
 	RXM_DBG_ADDR_TAG(FI_LOG_EP_DATA, "Match for posted recv found in unexp"
 			 " msg list\n", match_attr.addr, match_attr.tag);
 
-	return container_of(entry, struct rxm_rx_buf, unexp_msg.entry);
+	return rx_buf;
 }
 
 static void rxm_recv_entry_init_common(struct rxm_recv_entry *recv_entry,
@@ -1126,18 +1269,129 @@ ssize_t rxm_ep_broadcast(struct fid_ep *ep, void *buf, size_t count,
 	return ret;
 }
 
+ssize_t rxm_ep_alltoall(struct fid_ep *ep, const void *buf, size_t count,
+			void *desc, void *result, void *result_desc,
+			fi_addr_t coll_addr, enum fi_datatype datatype,
+			uint64_t flags, void *context)
+{
+	struct rxm_ep *rxm_ep;
+	struct fid_ep *coll_ep;
+	struct rxm_coll_buf *req;
+	ssize_t ret;
+
+        rxm_ep = container_of(ep, struct rxm_ep, util_ep.ep_fid.fid);
+
+	ret = rxm_ep_init_coll_req(rxm_ep, FI_ALLTOALL, flags, context,
+				   &req, &coll_ep);
+	if (ret)
+		return ret;
+
+	flags &= ~FI_PEER_TRANSFER;
+
+	ret = fi_alltoall(coll_ep, buf, count, desc, result, result_desc,
+			  coll_addr, datatype, flags, req);
+	if (ret)
+		rxm_ep_free_coll_req(rxm_ep, req);
+
+	return ret;
+}
+
+ssize_t rxm_ep_reduce_scatter(struct fid_ep *ep, const void *buf,
+			      size_t count, void *desc, void *result,
+			      void *result_desc, fi_addr_t coll_addr,
+			      enum fi_datatype datatype, enum fi_op op,
+			      uint64_t flags, void *context)
+{
+	struct rxm_ep *rxm_ep;
+	struct fid_ep *coll_ep;
+	struct rxm_coll_buf *req;
+	ssize_t ret;
+
+        rxm_ep = container_of(ep, struct rxm_ep, util_ep.ep_fid.fid);
+
+	ret = rxm_ep_init_coll_req(rxm_ep, FI_REDUCE_SCATTER, flags, context,
+				   &req, &coll_ep);
+	if (ret)
+		return ret;
+
+	flags &= ~FI_PEER_TRANSFER;
+
+	ret = fi_reduce_scatter(coll_ep, buf, count, desc, result, result_desc,
+				coll_addr, datatype, op, flags, req);
+	if (ret)
+		rxm_ep_free_coll_req(rxm_ep, req);
+
+	return ret;
+}
+
+ssize_t rxm_ep_reduce(struct fid_ep *ep, const void *buf, size_t count,
+		      void *desc, void *result, void *result_desc,
+		      fi_addr_t coll_addr, fi_addr_t root_addr,
+		      enum fi_datatype datatype, enum fi_op op,
+		      uint64_t flags, void *context)
+{
+	struct rxm_ep *rxm_ep;
+	struct fid_ep *coll_ep;
+	struct rxm_coll_buf *req;
+	ssize_t ret;
+
+        rxm_ep = container_of(ep, struct rxm_ep, util_ep.ep_fid.fid);
+
+	ret = rxm_ep_init_coll_req(rxm_ep, FI_REDUCE, flags, context,
+				   &req, &coll_ep);
+	if (ret)
+		return ret;
+
+	flags &= ~FI_PEER_TRANSFER;
+
+	ret = fi_reduce(coll_ep, buf, count, desc, result, result_desc,
+			coll_addr, root_addr, datatype, op, flags, req);
+	if (ret)
+		rxm_ep_free_coll_req(rxm_ep, req);
+
+	return ret;
+}
+
+ssize_t rxm_ep_gather(struct fid_ep *ep, const void *buf, size_t count,
+		      void *desc, void *result, void *result_desc,
+		      fi_addr_t coll_addr, fi_addr_t root_addr,
+		      enum fi_datatype datatype, uint64_t flags,
+		      void *context)
+{
+	struct rxm_ep *rxm_ep;
+	struct fid_ep *coll_ep;
+	struct rxm_coll_buf *req;
+	ssize_t ret;
+
+        rxm_ep = container_of(ep, struct rxm_ep, util_ep.ep_fid.fid);
+
+	ret = rxm_ep_init_coll_req(rxm_ep, FI_GATHER, flags, context,
+				   &req, &coll_ep);
+	if (ret)
+		return ret;
+
+	flags &= ~FI_PEER_TRANSFER;
+
+	ret = fi_gather(coll_ep, buf, count, desc, result, result_desc,
+			coll_addr, root_addr, datatype, flags, req);
+	if (ret)
+		rxm_ep_free_coll_req(rxm_ep, req);
+
+	return ret;
+}
+
 static struct fi_ops_collective rxm_ops_collective = {
 	.size = sizeof(struct fi_ops_collective),
 	.barrier = rxm_ep_barrier,
 	.barrier2 = rxm_ep_barrier2,
 	.broadcast = rxm_ep_broadcast,
-	.alltoall = fi_coll_no_alltoall,
+	.alltoall = rxm_ep_alltoall,
 	.allreduce = rxm_ep_allreduce,
 	.allgather = rxm_ep_allgather,
-	.reduce_scatter = fi_coll_no_reduce_scatter,
-	.reduce = fi_coll_no_reduce,
+	.reduce_scatter = rxm_ep_reduce_scatter,
+	.reduce = rxm_ep_reduce,
 	.scatter = rxm_ep_scatter,
-	.gather = fi_coll_no_gather,
+	.gather = rxm_ep_gather,
 	.msg = fi_coll_no_msg,
 };
 
@@ -77,7 +77,7 @@ ssize_t rxm_handle_unexp_sar(struct rxm_recv_queue *recv_queue,
 		if (recv_entry->sar.conn != rx_buf->conn)
 			continue;
 		rx_buf->recv_entry = recv_entry;
-		dlist_remove(&rx_buf->unexp_msg.entry);
+		rxm_unexp_msg_remove(rx_buf);
 		last = rxm_sar_get_seg_type(&rx_buf->pkt.ctrl_hdr) ==
 		       RXM_SAR_SEG_LAST;
 		ret = rxm_handle_rx_buf(rx_buf);
@@ -116,12 +116,11 @@ rxm_post_mrecv(struct rxm_ep *ep, const struct iovec *iov,
 
 		rx_buf = rxm_get_unexp_msg(&ep->recv_queue, recv_entry->addr, 0,  0);
 		if (!rx_buf) {
-			dlist_insert_tail(&recv_entry->entry,
-					  &ep->recv_queue.recv_list);
+			rxm_recv_queue_insert(&ep->recv_queue, recv_entry);
 			return 0;
 		}
 
-		dlist_remove(&rx_buf->unexp_msg.entry);
+		rxm_unexp_msg_remove(rx_buf);
 		rx_buf->recv_entry = recv_entry;
 		recv_entry->flags &= ~FI_MULTI_RECV;
 		recv_entry->total_len = MIN(cur_iov.iov_len, rx_buf->pkt.hdr.size);
@@ -175,13 +174,12 @@ rxm_recv_common(struct rxm_ep *rxm_ep, const struct iovec *iov,
 
 	rx_buf = rxm_get_unexp_msg(&rxm_ep->recv_queue, recv_entry->addr, 0, 0);
 	if (!rx_buf) {
-		dlist_insert_tail(&recv_entry->entry,
-				  &rxm_ep->recv_queue.recv_list);
+		rxm_recv_queue_insert(&rxm_ep->recv_queue, recv_entry);
 		ret = FI_SUCCESS;
 		goto release;
 	}
 
-	dlist_remove(&rx_buf->unexp_msg.entry);
+	rxm_unexp_msg_remove(rx_buf);
 	rx_buf->recv_entry = recv_entry;
 
 	ret = (rx_buf->pkt.ctrl_hdr.type != rxm_ctrl_seg) ?
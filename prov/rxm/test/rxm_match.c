@@ -0,0 +1,375 @@
+/*
+ * Copyright (c) 2026 Intel Corporation.  All rights reserved.
+ *
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+ * Receive matching test for rxm with FI_DIRECTED_RECV, run over tcp on the
+ * loopback interface.  Directed receives and unexpected messages are kept
+ * per source, which must not change the order in which receives and
+ * messages are matched: a message takes the oldest posted receive that
+ * accepts it, and a receive takes the oldest queued message it accepts.
+ * Exits 77 (skipped) if tcp;ofi_rxm is not available.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <rdma/fabric.h>
+#include <rdma/fi_domain.h>
+#include <rdma/fi_endpoint.h>
+#include <rdma/fi_tagged.h>
+#include <rdma/fi_cm.h>
+#include <rdma/fi_errno.h>
+
+enum {
+	TEST_EP_CNT	= 3,
+	TEST_MSG_SIZE	= 64,
+	TEST_SLOTS	= 3,
+	TEST_POLL_CNT	= 10000000,
+	TEST_DRAIN_CNT	= 10000,
+};
+
+static struct fid_fabric *fabric;
+static struct fid_domain *domain;
+static struct fid_av *av;
+static struct fid_cq *cq;
+static struct fid_ep *ep[TEST_EP_CNT];
+static fi_addr_t addr[TEST_EP_CNT];
+static char rx_buf[TEST_SLOTS][TEST_MSG_SIZE];
+static int sends_pending;
+static int errors;
+
+#define test_error(fmt, ...)						\
+	do {								\
+		fprintf(stderr, "%s:%d: " fmt "\n", __func__, __LINE__, \
+			##__VA_ARGS__);					\
+		errors++;						\
+	} while (0)
+
+static int test_setup(void)
+{
+	struct fi_info *hints, *info;
+	struct fi_av_attr av_attr = { .type = FI_AV_TABLE };
+	struct fi_cq_attr cq_attr = { .format = FI_CQ_FORMAT_TAGGED };
+	char name[FI_NAME_MAX];
+	size_t len;
+	int i, ret;
+
+	hints = fi_allocinfo();
+	if (!hints)
+		return -FI_ENOMEM;
+
+	hints->ep_attr->type = FI_EP_RDM;
+	hints->caps = FI_MSG | FI_TAGGED | FI_DIRECTED_RECV;
+	hints->fabric_attr->prov_name = strdup("tcp;ofi_rxm");
+
+	ret = fi_getinfo(FI_VERSION(1, 18), "127.0.0.1", "0", FI_SOURCE,
+			 hints, &info);
+	fi_freeinfo(hints);
+	if (ret)
+		return ret;
+
+	ret = fi_fabric(info->fabric_attr, &fabric, NULL);
+	if (ret)
+		goto out;
+	ret = fi_domain(fabric, info, &domain, NULL);
+	if (ret)
+		goto out;
+	ret = fi_av_open(domain, &av_attr, &av, NULL);
+	if (ret)
+		goto out;
+	ret = fi_cq_open(domain, &cq_attr, &cq, NULL);
+	if (ret)
+		goto out;
+
+	for (i = 0; i < TEST_EP_CNT; i++) {
+		ret = fi_endpoint(domain, info, &ep[i], NULL);
+		if (ret)
+			goto out;
+		ret = fi_ep_bind(ep[i], &av->fid, 0);
+		if (ret)
+			goto out;
+		ret = fi_ep_bind(ep[i], &cq->fid, FI_TRANSMIT | FI_RECV);
+		if (ret)
+			goto out;
+		ret = fi_enable(ep[i]);
+		if (ret)
+			goto out;
+
+		len = sizeof(name);
+		ret = fi_getname(&ep[i]->fid, name, &len);
+		if (ret)
+			goto out;
+		if (fi_av_insert(av, name, 1, &addr[i], 0, NULL) != 1) {
+			ret = -FI_EINVAL;
+			goto out;
+		}
+	}
+out:
+	fi_freeinfo(info);
+	return ret;
+}
+
+static void test_cleanup(void)
+{
+	int i;
+
+	for (i = 0; i < TEST_EP_CNT; i++) {
+		if (ep[i])
+			fi_close(&ep[i]->fid);
+	}
+	if (cq)
+		fi_close(&cq->fid);
+	if (av)
+		fi_close(&av->fid);
+	if (domain)
+		fi_close(&domain->fid);
+	if (fabric)
+		fi_close(&fabric->fid);
+}
+
+/* Read one completion, returns 1 for a receive, 0 otherwise */
+static int test_poll(struct fi_cq_tagged_entry *comp)
+{
+	struct fi_cq_err_entry err_entry = { 0 };
+	ssize_t ret;
+
+	ret = fi_cq_read(cq, comp, 1);
+	if (ret == 1) {
+		if (comp->flags & FI_RECV)
+			return 1;
+		sends_pending--;
+		return 0;
+	}
+	if (ret == -FI_EAVAIL) {
+		fi_cq_readerr(cq, &err_entry, 0);
+		test_error("completion error %d", err_entry.err);
+	} else if (ret != -FI_EAGAIN) {
+		test_error("fi_cq_read: %zd", ret);
+	}
+	return ret == -FI_EAGAIN ? 0 : (int) ret;
+}
+
+static int test_wait_recv(struct fi_cq_tagged_entry *comp)
+{
+	int i, ret;
+
+	for (i = 0; i < TEST_POLL_CNT && !errors; i++) {
+		ret = test_poll(comp);
+		if (ret == 1)
+			return 0;
+		if (ret < 0)
+			return ret;
+	}
+	test_error("timed out");
+	return -FI_ETIMEDOUT;
+}
+
+/*
+ * Wait for the sends to complete, then keep progressing so that the
+ * receiver queues the messages as unexpected.  Nothing is posted, so no
+ * receive may complete.
+ */
+static void test_drain(void)
+{
+	struct fi_cq_tagged_entry comp;
+	int i;
+
+	for (i = 0; i < TEST_POLL_CNT && sends_pending > 0 && !errors; i++) {
+		if (test_poll(&comp) == 1)
+			test_error("unexpected receive completion");
+	}
+	for (i = 0; i < TEST_DRAIN_CNT && !errors; i++) {
+		if (test_poll(&comp) == 1)
+			test_error("unexpected receive completion");
+	}
+}
+
+static void test_send(int src, uint64_t tag, char fill, bool tagged)
+{
+	struct fi_cq_tagged_entry comp;
+	char buf[TEST_MSG_SIZE];
+	ssize_t ret;
+
+	memset(buf, fill, sizeof(buf));
+	do {
+		if (tagged)
+			ret = fi_tsend(ep[src], buf, sizeof(buf), NULL,
+				       addr[0], tag, NULL);
+		else
+			ret = fi_send(ep[src], buf, sizeof(buf), NULL,
+				      addr[0], NULL);
+		if (ret == -FI_EAGAIN && test_poll(&comp) == 1)
+			test_error("unexpected receive completion");
+	} while (ret == -FI_EAGAIN && !errors);
+
+	if (ret)
+		test_error("send: %zd", ret);
+	else
+		sends_pending++;
+}
+
+static void test_post(int slot, fi_addr_t src, uint64_t tag, bool tagged)
+{
+	ssize_t ret;
+
+	memset(rx_buf[slot], 0, sizeof(rx_buf[slot]));
+	if (tagged)
+		ret = fi_trecv(ep[0], rx_buf[slot], TEST_MSG_SIZE, NULL, src,
+			       tag, 0, &rx_buf[slot]);
+	else
+		ret = fi_recv(ep[0], rx_buf[slot], TEST_MSG_SIZE, NULL, src,
+			      &rx_buf[slot]);
+	if (ret)
+		test_error("post: %zd", ret);
+}
+
+/* The next receive must complete into slot with data filled by fill */
+static void test_expect(int slot, char fill)
+{
+	struct fi_cq_tagged_entry comp;
+
+	if (test_wait_recv(&comp))
+		return;
+
+	if (comp.op_context != &rx_buf[slot]) {
+		test_error("message %c matched the wrong receive", fill);
+		return;
+	}
+	if (rx_buf[slot][0] != fill || rx_buf[slot][TEST_MSG_SIZE - 1] != fill)
+		test_error("slot %d holds %c, expected %c", slot,
+			   rx_buf[slot][0], fill);
+}
+
+/* Receives posted ahead of the messages, on the wildcard and source lists */
+static void test_posted_order(bool tagged)
+{
+	/* wildcard then directed */
+	test_post(0, FI_ADDR_UNSPEC, 1, tagged);
+	test_post(1, addr[1], 1, tagged);
+	test_send(1, 1, 'a', tagged);
+	test_send(1, 1, 'b', tagged);
+	test_expect(0, 'a');
+	test_expect(1, 'b');
+
+	/* directed then wildcard */
+	test_post(0, addr[1], 1, tagged);
+	test_post(1, FI_ADDR_UNSPEC, 1, tagged);
+	test_send(1, 1, 'c', tagged);
+	test_send(1, 1, 'd', tagged);
+	test_expect(0, 'c');
+	test_expect(1, 'd');
+
+	/* a receive directed at another source is passed over */
+	test_post(0, addr[1], 1, tagged);
+	test_post(1, FI_ADDR_UNSPEC, 1, tagged);
+	test_send(2, 1, 'e', tagged);
+	test_expect(1, 'e');
+	test_send(1, 1, 'f', tagged);
+	test_expect(0, 'f');
+	test_drain();
+}
+
+/*
+ * Messages queued as unexpected from two sources.  Messages from one
+ * source arrive in order, so the expected matches hold however far the
+ * receiver got before the receives were posted.
+ */
+static void test_unexp_order(bool tagged)
+{
+	/* a directed receive skips the older message from another source */
+	test_send(1, 2, 'g', tagged);
+	test_drain();
+	test_send(2, 2, 'h', tagged);
+	test_drain();
+	test_send(1, 2, 'i', tagged);
+	test_drain();
+	test_post(0, addr[2], 2, tagged);
+	test_expect(0, 'h');
+	test_post(1, FI_ADDR_UNSPEC, 2, tagged);
+	test_expect(1, 'g');
+	test_post(2, addr[1], 2, tagged);
+	test_expect(2, 'i');
+
+	/* a wildcard receive takes the oldest message of all sources */
+	test_send(2, 3, 'j', tagged);
+	test_drain();
+	test_send(1, 3, 'k', tagged);
+	test_drain();
+	test_post(0, FI_ADDR_UNSPEC, 3, tagged);
+	test_expect(0, 'j');
+	test_post(1, addr[1], 3, tagged);
+	test_expect(1, 'k');
+}
+
+/* A directed receive must not take a message with another tag */
+static void test_unexp_tag(void)
+{
+	test_send(1, 4, 'l', true);
+	test_drain();
+	test_send(1, 5, 'm', true);
+	test_drain();
+	test_post(0, addr[1], 5, true);
+	test_expect(0, 'm');
+	test_post(1, addr[1], 4, true);
+	test_expect(1, 'l');
+}
+
+int main(void)
+{
+	int ret;
+
+	ret = test_setup();
+	if (ret) {
+		test_cleanup();
+		if (ret == -FI_ENODATA) {
+			printf("SKIPPED: tcp;ofi_rxm not available\n");
+			return 77;
+		}
+		fprintf(stderr, "setup: %s\n", fi_strerror(-ret));
+		return EXIT_FAILURE;
+	}
+
+	test_posted_order(true);
+	test_posted_order(false);
+	test_unexp_order(true);
+	test_unexp_order(false);
+	test_unexp_tag();
+
+	test_cleanup();
+	printf("%s: %d errors\n", errors ? "FAILED" : "PASSED", errors);
+
+	return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
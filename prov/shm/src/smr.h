@@ -76,8 +76,14 @@ struct smr_env {
 	size_t sar_threshold;
 	int disable_cma;
 	int use_dsa_sar;
+	size_t sw_copy_threads;
 	size_t max_gdrcopy_size;
 	int use_xpmem;
+	int direct_landing;
+	int numa_policy;
+	int use_hugepages;
+	char *hugepage_dir;
+	int prefault;
 };
 
 extern struct smr_env smr_env;
@@ -112,8 +118,6 @@ int smr_av_open(struct fid_domain *domain, struct fi_av_attr *attr,
 int smr_query_atomic(struct fid_domain *domain, enum fi_datatype datatype,
 		enum fi_op op, struct fi_atomic_attr *attr, uint64_t flags);
 
-#define SMR_IOV_LIMIT		4
-
 struct smr_tx_entry {
 	struct smr_cmd	cmd;
 	int64_t		peer_id;
@@ -205,9 +209,25 @@ struct smr_sock_info {
 	pthread_t		listener_thread;
 	int			*my_fds;
 	int			nfds;
-	struct smr_cmap_entry	peers[SMR_MAX_PEERS];
+	/* chunks of SMR_PEER_CHUNK_SIZE, allocated on first fd exchange */
+	struct smr_cmap_entry	*peers[SMR_MAX_PEER_CHUNKS];
 };
 
+static inline struct smr_cmap_entry *
+smr_sock_peer(struct smr_sock_info *sock_info, int64_t id)
+{
+	struct smr_cmap_entry **chunk;
+
+	assert(id >= 0 && id < SMR_MAX_PEERS);
+	chunk = &sock_info->peers[id >> SMR_PEER_CHUNK_BITS];
+	if (!*chunk) {
+		*chunk = calloc(SMR_PEER_CHUNK_SIZE, sizeof(**chunk));
+		if (!*chunk)
+			return NULL;
+	}
+	return &(*chunk)[id & (SMR_PEER_CHUNK_SIZE - 1)];
+}
+
 struct smr_unexp_buf {
 	struct slist_entry entry;
 	char buf[SMR_SAR_SIZE];
@@ -233,7 +253,16 @@ struct smr_ep {
 	enum ofi_shm_p2p_type	p2p_type;
 	struct smr_sock_info	*sock_info;
 	void			*dsa_context;
+	void			*sw_copy_context;
 	void 			(*smr_progress_ipc_list)(struct smr_ep *ep);
+
+	/* direct landing, see struct smr_landing */
+	bool			direct_landing;
+	int64_t			landing_id;
+	uint32_t		landing_op;
+	struct fi_peer_rx_entry	*landing_rx;
+	int64_t			last_rx_id;
+	uint32_t		last_rx_op;
 };
 
 static inline struct fid_peer_srx *smr_get_peer_srx(struct smr_ep *ep)
@@ -322,12 +351,19 @@ static inline bool smr_vma_enabled(struct smr_ep *ep,
 static inline void smr_set_ipc_valid(struct smr_region *region, uint64_t id)
 {
 	if (ofi_hmem_is_initialized(FI_HMEM_ZE) &&
-	    region->map->peers[id].pid_fd == -1)
+	    smr_map_peer(region->map, id)->pid_fd == -1)
 		smr_peer_data(region)[id].ipc_valid = 0;
         else
         	smr_peer_data(region)[id].ipc_valid = 1;
 }
 
+/* Share the SAR pool evenly, but let every peer make progress */
+static inline void smr_set_sar_bufs(struct smr_region *region, int num_peers)
+{
+	region->max_sar_buf_per_peer = num_peers > 0 ?
+		MAX(SMR_SAR_BUF_CNT / num_peers, 1) : SMR_BUF_BATCH_MAX;
+}
+
 static inline bool smr_ipc_valid(struct smr_ep *ep, struct smr_region *peer_smr,
 				 int64_t id, int64_t peer_id)
 {
@@ -367,6 +403,25 @@ smr_release_txbuf(struct smr_region *smr,
 
 int smr_unexp_start(struct fi_peer_rx_entry *rx_entry);
 
+void smr_landing_publish(struct smr_ep *ep);
+bool smr_landing_revoke(struct smr_ep *ep);
+
+/* Messages to a peer that publishes receives are counted, which gates
+ * claiming its published receive, see smr_do_direct
+ */
+static inline bool smr_direct_peer(struct smr_region *peer_smr, uint32_t op)
+{
+	return (peer_smr->flags & SMR_FLAG_DIRECT_LANDING) &&
+	       (op == ofi_op_msg || op == ofi_op_tagged);
+}
+
+static inline bool smr_use_direct(struct smr_region *peer_smr, int proto,
+				  uint32_t op)
+{
+	return (proto == smr_src_inline || proto == smr_src_inject) &&
+	       smr_direct_peer(peer_smr, op);
+}
+
 void smr_progress_ipc_list(struct smr_ep *ep);
 static inline void smr_progress_ipc_list_noop(struct smr_ep *ep)
 {
@@ -32,32 +32,22 @@
 
 #include "smr.h"
 
-static void smr_peer_addr_init(struct smr_addr *peer)
-{
-	memset(peer->name, 0, SMR_NAME_MAX);
-	peer->id = -1;
-}
-
 static int smr_name_compare(struct ofi_rbmap *map, void *key, void *data)
 {
 	struct smr_map *smr_map;
 
 	smr_map = container_of(map, struct smr_map, rbmap);
 
-	return strncmp(smr_map->peers[(uintptr_t) data].peer.name,
+	return strncmp(smr_map_peer(smr_map, (uintptr_t) data)->peer.name,
 		       (char *) key, SMR_NAME_MAX);
 }
 
 static int smr_map_init(const struct fi_provider *prov, struct smr_map *map,
-		 int peer_count, uint16_t flags)
+			size_t count, uint16_t flags)
 {
-	int i;
-
-	for (i = 0; i < peer_count; i++) {
-		smr_peer_addr_init(&map->peers[i].peer);
-		map->peers[i].fiaddr = FI_ADDR_NOTAVAIL;
-	}
 	map->flags = flags;
+	count = MIN(MAX(count, SMR_DEF_PEERS), SMR_MAX_PEERS);
+	map->max_chunks = (int) ofi_div_ceil(count, SMR_PEER_CHUNK_SIZE);
 
 	ofi_rbmap_init(&map->rbmap, smr_name_compare);
 	ofi_spin_init(&map->lock);
@@ -69,8 +59,13 @@ static void smr_map_cleanup(struct smr_map *map)
 {
 	int64_t i;
 
-	for (i = 0; i < SMR_MAX_PEERS; i++)
-		smr_map_del(map, i);
+	for (i = 0; i < smr_map_size(map); i++) {
+		if (smr_map_peer(map, i)->peer.id >= 0)
+			smr_map_del(map, i);
+	}
+
+	for (i = 0; i < map->num_chunks; i++)
+		free(map->peers[i]);
 
 	ofi_rbmap_cleanup(&map->rbmap);
 }
@@ -98,7 +93,8 @@ static fi_addr_t smr_get_addr(struct fi_peer_rx_entry *rx_entry)
 {
 	struct smr_cmd_ctx *cmd_ctx = rx_entry->peer_context;
 
-	return cmd_ctx->ep->region->map->peers[cmd_ctx->cmd.msg.hdr.id].fiaddr;
+	return smr_map_peer(cmd_ctx->ep->region->map,
+			    cmd_ctx->cmd.msg.hdr.id)->fiaddr;
 }
 
 
@@ -127,7 +123,7 @@ static int smr_av_insert(struct fid_av *av_fid, const void *addr, size_t count,
 		FI_INFO(&smr_prov, FI_LOG_AV, "%s\n", (const char *) addr);
 
 		util_addr = FI_ADDR_NOTAVAIL;
-		if (smr_av->used < SMR_MAX_PEERS) {
+		if (smr_av->used < smr_map_max_peers(&smr_av->smr_map)) {
 			ret = smr_map_add(&smr_prov, &smr_av->smr_map,
 					  addr, &shm_id);
 			if (!ret) {
@@ -153,12 +149,15 @@ static int smr_av_insert(struct fid_av *av_fid, const void *addr, size_t count,
 			continue;
 		}
 
-		assert(shm_id >= 0 && shm_id < SMR_MAX_PEERS);
+		assert(shm_id >= 0 &&
+		       shm_id < (int64_t) smr_map_max_peers(&smr_av->smr_map));
 		if (flags & FI_AV_USER_ID) {
 			assert(fi_addr);
-			smr_av->smr_map.peers[shm_id].fiaddr = fi_addr[i];
+			smr_map_peer(&smr_av->smr_map, shm_id)->fiaddr =
+				fi_addr[i];
 		} else {
-			smr_av->smr_map.peers[shm_id].fiaddr = util_addr;
+			smr_map_peer(&smr_av->smr_map, shm_id)->fiaddr =
+				util_addr;
 		}
 		succ_count++;
 		smr_av->used++;
@@ -171,8 +170,8 @@ static int smr_av_insert(struct fid_av *av_fid, const void *addr, size_t count,
         		util_ep = container_of(av_entry, struct util_ep,
 					       av_entry);
         		smr_ep = container_of(util_ep, struct smr_ep, util_ep);
-			smr_ep->region->max_sar_buf_per_peer =
-				SMR_MAX_PEERS / smr_av->smr_map.num_peers;
+			smr_set_sar_bufs(smr_ep->region,
+					 smr_av->smr_map.num_peers);
 			srx = smr_get_peer_srx(smr_ep);
 			srx->owner_ops->foreach_unspec_addr(srx, &smr_get_addr);
 		}
@@ -212,13 +211,8 @@ static int smr_av_remove(struct fid_av *av_fid, fi_addr_t *fi_addr, size_t count
 			util_ep = container_of(av_entry, struct util_ep, av_entry);
 			smr_ep = container_of(util_ep, struct smr_ep, util_ep);
 			smr_unmap_from_endpoint(smr_ep->region, id);
-			if (smr_av->smr_map.num_peers > 0)
-				smr_ep->region->max_sar_buf_per_peer =
-					SMR_MAX_PEERS /
-					smr_av->smr_map.num_peers;
-			else
-				smr_ep->region->max_sar_buf_per_peer =
-					SMR_BUF_BATCH_MAX;
+			smr_set_sar_bufs(smr_ep->region,
+					 smr_av->smr_map.num_peers);
 		}
 		smr_av->used--;
 	}
@@ -239,7 +233,7 @@ static int smr_av_lookup(struct fid_av *av, fi_addr_t fi_addr, void *addr,
 	smr_av = container_of(util_av, struct smr_av, util_av);
 
 	id = smr_addr_lookup(util_av, fi_addr);
-	name = smr_av->smr_map.peers[id].peer.name;
+	name = smr_map_peer(&smr_av->smr_map, id)->peer.name;
 
 	strncpy((char *) addr, name, *addrlen);
 
@@ -323,7 +317,8 @@ int smr_av_open(struct fid_domain *domain, struct fi_av_attr *attr,
 	(*av)->fid.ops = &smr_av_fi_ops;
 	(*av)->ops = &smr_av_ops;
 
-	ret = smr_map_init(&smr_prov, &smr_av->smr_map, SMR_MAX_PEERS,
+	ret = smr_map_init(&smr_prov, &smr_av->smr_map,
+			   attr->count ? attr->count : ofi_universe_size,
 			   util_domain->info_domain_caps & FI_HMEM ?
 			   SMR_FLAG_HMEM_ENABLED : 0);
 	if (ret)
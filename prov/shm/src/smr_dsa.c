@@ -953,6 +953,7 @@ void smr_dsa_context_init(struct smr_ep *ep)
 
 wq_get_error:
 	free(dsa_context);
+	ep->dsa_context = NULL;
 alloc_error:
 	smr_env.use_dsa_sar = 0;
 }
@@ -42,6 +42,7 @@
 #include "smr_signal.h"
 #include "smr.h"
 #include "smr_dsa.h"
+#include "smr_sw_copy.h"
 #include "ofi_xpmem.h"
 
 extern struct fi_ops_msg smr_msg_ops, smr_no_recv_msg_ops;
@@ -159,6 +160,12 @@ static ssize_t smr_ep_cancel(fid_t ep_fid, void *context)
 	struct smr_ep *ep;
 
 	ep = container_of(ep_fid, struct smr_ep, util_ep.ep_fid);
+
+	/* a receive published for direct landing is not in the srx queues */
+	ofi_genlock_lock(&ep->util_ep.lock);
+	(void) smr_landing_revoke(ep);
+	ofi_genlock_unlock(&ep->util_ep.lock);
+
 	return ep->srx->ops->cancel(&ep->srx->fid, context);
 }
 
@@ -219,10 +226,10 @@ int64_t smr_verify_peer(struct smr_ep *ep, fi_addr_t fi_addr)
 	if (id < 0)
 		return -1;
 
-	if (smr_peer_data(ep->region)[id].addr.id >= 0)
+	if (smr_peer_id(ep->region, id) >= 0)
 		return id;
 
-	if (!ep->region->map->peers[id].region) {
+	if (!smr_peer_region(ep->region, id)) {
 		ret = smr_map_to_region(&smr_prov, ep->region->map, id);
 		if (ret)
 			return -1;
@@ -523,18 +530,24 @@ static int smr_format_sar(struct smr_ep *ep, struct smr_cmd *cmd,
 			ret = smr_dsa_copy_to_sar(ep, smr_sar_pool(peer_smr),
 					resp, cmd, iov,	count,
 					&pending->bytes_done, pending);
-			if (ret != FI_SUCCESS) {
-				for (i = cmd->msg.data.buf_batch_size - 1;
-				     i >= 0; i--) {
-					smr_freestack_push_by_index(
-					    smr_sar_pool(peer_smr),
-					    cmd->msg.data.sar[i]);
-				}
-				return -FI_EAGAIN;
-			}
+		} else if (ep->sw_copy_context && ofi_mr_all_host(mr, count)) {
+			ret = smr_sw_copy_to_sar(ep, smr_sar_pool(peer_smr),
+					resp, cmd, iov, count,
+					&pending->bytes_done, pending);
 		} else {
 			smr_copy_to_sar(smr_sar_pool(peer_smr), resp, cmd,
 					mr, iov, count, &pending->bytes_done);
+			ret = FI_SUCCESS;
+		}
+
+		if (ret != FI_SUCCESS) {
+			pthread_spin_lock(&peer_smr->lock);
+			for (i = cmd->msg.data.buf_batch_size - 1; i >= 0; i--)
+				smr_freestack_push_by_index(
+					smr_sar_pool(peer_smr),
+					cmd->msg.data.sar[i]);
+			pthread_spin_unlock(&peer_smr->lock);
+			return -FI_EAGAIN;
 		}
 	}
 out:
@@ -635,6 +648,66 @@ static ssize_t smr_do_inject(struct smr_ep *ep, struct smr_region *peer_smr, int
 	return FI_SUCCESS;
 }
 
+/* Claim the receive that the peer published for our next message and write
+ * the data straight into it.  Returns -FI_EAGAIN if there is no such receive
+ * or the message does not fit it.
+ */
+static ssize_t smr_do_direct(struct smr_ep *ep, struct smr_region *peer_smr, int64_t id,
+			     int64_t peer_id, uint32_t op, uint64_t tag, uint64_t data,
+			     uint64_t op_flags, struct ofi_mr **desc,
+			     const struct iovec *iov, size_t iov_count, size_t total_len,
+			     void *context, struct smr_cmd *cmd)
+{
+	struct smr_landing *landing;
+	struct iovec dst_iov[SMR_IOV_LIMIT];
+	size_t dst_count;
+	int64_t state;
+	int ret;
+
+	if (!smr_vma_enabled(ep, peer_smr) ||
+	    (desc && !ofi_mr_all_host(desc, iov_count)))
+		return -FI_EAGAIN;
+
+	landing = &smr_peer_data(peer_smr)[peer_id].landing;
+	state = ofi_atomic_load_explicit64(&landing->state,
+					   memory_order_acquire);
+	if ((state & SMR_LANDING_STATE_MASK) != SMR_LANDING_POSTED)
+		return -FI_EAGAIN;
+
+	/* The fields read here are only known to be current if the claim
+	 * below succeeds. */
+	dst_count = landing->iov_count;
+	if (landing->op != op || dst_count > SMR_IOV_LIMIT ||
+	    landing->seq != smr_peer_data(ep->region)[id].tx_msg_cnt ||
+	    (op == ofi_op_tagged &&
+	     !ofi_match_tag(landing->tag, landing->ignore, tag)))
+		return -FI_EAGAIN;
+
+	memcpy(dst_iov, landing->iov, sizeof(*dst_iov) * dst_count);
+	if (ofi_total_iov_len(dst_iov, dst_count) < total_len)
+		return -FI_EAGAIN;
+
+	if (!ofi_atomic_cas_bool64(&landing->state, state,
+				   (state & ~SMR_LANDING_STATE_MASK) |
+				   SMR_LANDING_CLAIMED))
+		return -FI_EAGAIN;
+
+	ret = ofi_shm_p2p_copy(ep->p2p_type, (struct iovec *) iov, iov_count,
+			       dst_iov, dst_count, total_len, peer_smr->pid,
+			       true, &smr_peer_data(ep->region)[id].xpmem);
+	if (ret)
+		FI_WARN(&smr_prov, FI_LOG_EP_DATA,
+			"direct landing copy failed: %s\n", fi_strerror(-ret));
+
+	/* The receive is ours now, so an error is reported through it */
+	smr_generic_format(cmd, peer_id, op, tag, data, op_flags);
+	cmd->msg.hdr.op_src = smr_src_direct;
+	cmd->msg.hdr.src_data = -ret;
+	cmd->msg.hdr.size = total_len;
+
+	return FI_SUCCESS;
+}
+
 static ssize_t smr_do_iov(struct smr_ep *ep, struct smr_region *peer_smr, int64_t id,
 			  int64_t peer_id, uint32_t op, uint64_t tag, uint64_t data,
 			  uint64_t op_flags, struct ofi_mr **desc,
@@ -764,6 +837,7 @@ smr_proto_func smr_proto_ops[smr_src_max] = {
 	[smr_src_mmap] = &smr_do_mmap,
 	[smr_src_sar] = &smr_do_sar,
 	[smr_src_ipc] = &smr_do_ipc,
+	[smr_src_direct] = &smr_do_direct,
 };
 
 static void smr_cleanup_epoll(struct smr_sock_info *sock_info)
@@ -774,14 +848,21 @@ static void smr_cleanup_epoll(struct smr_sock_info *sock_info)
 
 static void smr_free_sock_info(struct smr_ep *ep)
 {
-	int i, j;
+	struct smr_cmap_entry *peers;
+	int i, j, k;
 
-	for (i = 0; i < SMR_MAX_PEERS; i++) {
-		if (!ep->sock_info->peers[i].device_fds)
+	for (i = 0; i < SMR_MAX_PEER_CHUNKS; i++) {
+		peers = ep->sock_info->peers[i];
+		if (!peers)
 			continue;
-		for (j = 0; j < ep->sock_info->nfds; j++)
-			close(ep->sock_info->peers[i].device_fds[j]);
-		free(ep->sock_info->peers[i].device_fds);
+		for (j = 0; j < SMR_PEER_CHUNK_SIZE; j++) {
+			if (!peers[j].device_fds)
+				continue;
+			for (k = 0; k < ep->sock_info->nfds; k++)
+				close(peers[j].device_fds[k]);
+			free(peers[j].device_fds);
+		}
+		free(peers);
 	}
 	free(ep->sock_info);
 	ep->sock_info = NULL;
@@ -795,6 +876,7 @@ static int smr_ep_close(struct fid *fid)
 
 	if (smr_env.use_dsa_sar)
 		smr_dsa_context_cleanup(ep);
+	smr_sw_copy_context_cleanup(ep);
 
 	if (ep->sock_info) {
 		fd_signal_set(&ep->sock_info->signal);
@@ -805,6 +887,11 @@ static int smr_ep_close(struct fid *fid)
 		smr_free_sock_info(ep);
 	}
 
+	ofi_genlock_lock(&ep->util_ep.lock);
+	if (ep->landing_rx && !smr_landing_revoke(ep))
+		smr_get_peer_srx(ep)->owner_ops->free_entry(ep->landing_rx);
+	ofi_genlock_unlock(&ep->util_ep.lock);
+
 	if (ep->srx) {
 		/* shm is an owner provider */
 		if (ep->util_ep.ep_fid.msg != &smr_no_recv_msg_ops)
@@ -815,8 +902,10 @@ static int smr_ep_close(struct fid *fid)
 
 	ofi_endpoint_close(&ep->util_ep);
 
-	if (ep->region)
+	if (ep->region) {
+		smr_region_report(&smr_prov, ep->region);
 		smr_free(ep->region);
+	}
 
 	if (ep->cmd_ctx_pool)
 		ofi_bufpool_destroy(ep->cmd_ctx_pool);
@@ -970,9 +1059,14 @@ void smr_ep_exchange_fds(struct smr_ep *ep, int64_t id)
 {
 	struct smr_region *peer_smr = smr_peer_region(ep->region, id);
 	struct sockaddr_un server_sockaddr = {0}, client_sockaddr = {0};
+	struct smr_cmap_entry *peer;
 	int ret = -1, sock = -1;
 	int64_t peer_id;
 
+	peer = smr_sock_peer(ep->sock_info, id);
+	if (!peer)
+		return;
+
 	if (peer_smr->pid == ep->region->pid ||
 	    !(peer_smr->flags & SMR_FLAG_IPC_SOCK))
 		goto out;
@@ -988,7 +1082,7 @@ void smr_ep_exchange_fds(struct smr_ep *ep, int64_t id)
 	if (ret == -1) {
 		if (errno != EADDRINUSE) {
 			FI_WARN(&smr_prov, FI_LOG_EP_CTRL, "bind error\n");
-			ep->sock_info->peers[id].state = SMR_CMAP_FAILED;
+			peer->state = SMR_CMAP_FAILED;
 		}
 		close(sock);
 		return;
@@ -1004,20 +1098,19 @@ void smr_ep_exchange_fds(struct smr_ep *ep, int64_t id)
 	FI_DBG(&smr_prov, FI_LOG_EP_CTRL, "EP connected to UNIX socket %s\n",
 	       server_sockaddr.sun_path);
 
-	peer_id = smr_peer_data(ep->region)[id].addr.id;
+	peer_id = smr_peer_id(ep->region, id);
 	ret = smr_sendmsg_fd(sock, id, peer_id, ep->sock_info->my_fds,
 			     ep->sock_info->nfds);
 	if (ret)
 		goto cleanup;
 
-	if (!ep->sock_info->peers[id].device_fds) {
-		ep->sock_info->peers[id].device_fds =
-			calloc(ep->sock_info->nfds,
-			       sizeof(*ep->sock_info->peers[id].device_fds));
-		if (!ep->sock_info->peers[id].device_fds)
+	if (!peer->device_fds) {
+		peer->device_fds = calloc(ep->sock_info->nfds,
+					  sizeof(*peer->device_fds));
+		if (!peer->device_fds)
 			goto cleanup;
 	}
-	ret = smr_recvmsg_fd(sock, &id, ep->sock_info->peers[id].device_fds,
+	ret = smr_recvmsg_fd(sock, &peer_id, peer->device_fds,
 			     ep->sock_info->nfds);
 	if (ret)
 		goto cleanup;
@@ -1026,8 +1119,7 @@ cleanup:
 	close(sock);
 	unlink(client_sockaddr.sun_path);
 out:
-	ep->sock_info->peers[id].state = ret ?
-		SMR_CMAP_FAILED : SMR_CMAP_SUCCESS;
+	peer->state = ret ? SMR_CMAP_FAILED : SMR_CMAP_SUCCESS;
 }
 
 static int smr_discard(struct fi_peer_rx_entry *rx_entry)
@@ -1190,6 +1282,8 @@ static int smr_ep_ctrl(struct fid *fid, int command, void *arg)
 
 		if (smr_env.use_dsa_sar)
 			smr_dsa_context_init(ep);
+		if (!ep->dsa_context && smr_env.sw_copy_threads)
+			smr_sw_copy_context_init(ep);
 
 		/* if XPMEM is on after exchanging peer info, then set the
 		 * endpoint p2p to XPMEM so it can be used on the fast
@@ -1198,6 +1292,18 @@ static int smr_ep_ctrl(struct fid *fid, int command, void *arg)
 		if (ep->region->xpmem_cap_self == SMR_VMA_CAP_ON)
 			ep->p2p_type = FI_SHM_P2P_XPMEM;
 
+		/* With CMA, the system call to place a small message costs
+		 * more than the copy it saves, so direct landing defaults to
+		 * XPMEM only.  It needs our own srx to publish receives.
+		 */
+		ep->direct_landing =
+			ep->util_ep.ep_fid.msg != &smr_no_recv_msg_ops &&
+			(smr_env.direct_landing > 0 ||
+			 (smr_env.direct_landing < 0 &&
+			  ep->p2p_type == FI_SHM_P2P_XPMEM));
+		if (ep->direct_landing)
+			ep->region->flags |= SMR_FLAG_DIRECT_LANDING;
+
 		break;
 	default:
 		return -FI_ENOSYS;
@@ -1256,11 +1362,15 @@ out:
 
 static int smr_create_pools(struct smr_ep *ep, struct fi_info *info)
 {
+	int flags = OFI_BUFPOOL_NO_TRACK;
 	int ret;
 
+	/* receive side pools follow the shm region's placement */
+	if (smr_env.numa_policy != OFI_NUMA_NONE)
+		flags |= OFI_BUFPOOL_NUMA_LOCAL;
+
 	ret = ofi_bufpool_create(&ep->cmd_ctx_pool, sizeof(struct smr_cmd_ctx),
-				 16, 0, info->rx_attr->size,
-				 OFI_BUFPOOL_NO_TRACK);
+				 16, 0, info->rx_attr->size, flags);
 	if (ret)
 		goto err;
 
@@ -1270,7 +1380,7 @@ static int smr_create_pools(struct smr_ep *ep, struct fi_info *info)
 
 	ret = ofi_bufpool_create(&ep->unexp_buf_pool,
 				 sizeof(struct smr_unexp_buf),
-				 16, 0, 4, OFI_BUFPOOL_NO_TRACK);
+				 16, 0, 4, flags);
 	if (ret)
 		goto free2;
 
@@ -1340,6 +1450,8 @@ int smr_endpoint(struct fid_domain *domain, struct fi_info *info,
 
 	/* default to CMA for p2p */
 	ep->p2p_type = FI_SHM_P2P_CMA;
+	ep->landing_id = -1;
+	ep->last_rx_id = -1;
 	return 0;
 ep:
 	ofi_endpoint_close(&ep->util_ep);
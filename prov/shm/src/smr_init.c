@@ -36,6 +36,7 @@
 #include "smr.h"
 #include "smr_signal.h"
 #include "smr_dsa.h"
+#include "smr_sw_copy.h"
 #include <ofi_hmem.h>
 
 struct sigaction *old_action = NULL;
@@ -46,8 +47,32 @@ struct smr_env smr_env = {
 	.use_dsa_sar = false,
 	.max_gdrcopy_size = 3072,
 	.use_xpmem = false,
+	.direct_landing = -1,
+	.numa_policy = OFI_NUMA_LOCAL,
+	.use_hugepages = false,
+	.hugepage_dir = "/dev/hugepages",
+	.prefault = false,
 };
 
+static void smr_init_numa_policy(void)
+{
+	char *policy = NULL;
+
+	if (fi_param_get_str(&smr_prov, "numa_policy", &policy) || !policy)
+		return;
+
+	if (!strcasecmp(policy, "none")) {
+		smr_env.numa_policy = OFI_NUMA_NONE;
+	} else if (!strcasecmp(policy, "local")) {
+		smr_env.numa_policy = OFI_NUMA_LOCAL;
+	} else if (!strcasecmp(policy, "interleave")) {
+		smr_env.numa_policy = OFI_NUMA_INTERLEAVE;
+	} else {
+		FI_WARN(&smr_prov, FI_LOG_CORE,
+			"unknown numa_policy %s, using local\n", policy);
+	}
+}
+
 static void smr_init_env(void)
 {
 	fi_param_get_size_t(&smr_prov, "sar_threshold", &smr_env.sar_threshold);
@@ -55,7 +80,14 @@ static void smr_init_env(void)
 	fi_param_get_size_t(&smr_prov, "rx_size", &smr_info.rx_attr->size);
 	fi_param_get_bool(&smr_prov, "disable_cma", &smr_env.disable_cma);
 	fi_param_get_bool(&smr_prov, "use_dsa_sar", &smr_env.use_dsa_sar);
+	fi_param_get_size_t(&smr_prov, "sw_copy_threads",
+			    &smr_env.sw_copy_threads);
 	fi_param_get_bool(&smr_prov, "use_xpmem", &smr_env.use_xpmem);
+	fi_param_get_bool(&smr_prov, "direct_landing", &smr_env.direct_landing);
+	smr_init_numa_policy();
+	fi_param_get_bool(&smr_prov, "use_hugepages", &smr_env.use_hugepages);
+	fi_param_get_str(&smr_prov, "hugepage_dir", &smr_env.hugepage_dir);
+	fi_param_get_bool(&smr_prov, "prefault", &smr_env.prefault);
 }
 
 static void smr_resolve_addr(const char *node, const char *service,
@@ -107,6 +139,7 @@ static int smr_shm_space_check(size_t tx_count, size_t rx_count)
 	}
 	shm_size_needed = num_of_core *
 			  smr_calculate_size_offsets(tx_count, rx_count,
+						     ofi_universe_size,
 						     NULL, NULL, NULL,
 						     NULL, NULL, NULL,
 						     NULL);
@@ -181,6 +214,7 @@ static void smr_fini(void)
 	ofi_hmem_cleanup();
 #endif
 	smr_dsa_cleanup();
+	smr_sw_copy_cleanup();
 	smr_cleanup();
 	free(old_action);
 }
@@ -204,6 +238,7 @@ SHM_INI
 {
 #if HAVE_SHM_DL
 	ofi_hmem_init();
+	ofi_atomic_init();
 #endif
 	fi_param_define(&smr_prov, "sar_threshold", FI_PARAM_SIZE_T,
 			"Max size to use for alternate SAR protocol if CMA \
@@ -219,9 +254,33 @@ SHM_INI
 			"Manually disables CMA. Default: false");
 	fi_param_define(&smr_prov, "use_dsa_sar", FI_PARAM_BOOL,
 			"Enable use of DSA in SAR protocol. Default: false");
+	fi_param_define(&smr_prov, "sw_copy_threads", FI_PARAM_SIZE_T,
+			"Number of helper threads used to copy SAR data in "
+			"the background when DSA is not in use. Default: 0 "
+			"(copy inline)");
 	fi_param_define(&smr_prov, "use_xpmem", FI_PARAM_BOOL,
 			"Enable XPMEM over CMA when possible "
 			"(default: false)");
+	fi_param_define(&smr_prov, "direct_landing", FI_PARAM_BOOL,
+			"Let senders write small messages directly into the "
+			"next posted receive instead of staging them in the "
+			"shared region (default: enabled when using XPMEM)");
+	fi_param_define(&smr_prov, "numa_policy", FI_PARAM_STRING,
+			"NUMA placement of the shared region and receive side "
+			"pools: none, local (bind to the node of the thread "
+			"opening the endpoint) or interleave (local, with the "
+			"SAR pool interleaved across nodes). Default: local");
+	fi_param_define(&smr_prov, "use_hugepages", FI_PARAM_BOOL,
+			"Back shm regions with huge pages from the hugetlbfs "
+			"mount at hugepage_dir, falling back to /dev/shm with "
+			"transparent huge pages. Default: false");
+	fi_param_define(&smr_prov, "hugepage_dir", FI_PARAM_STRING,
+			"hugetlbfs mount used for shm regions when "
+			"use_hugepages is set. Default: /dev/hugepages");
+	fi_param_define(&smr_prov, "prefault", FI_PARAM_BOOL,
+			"Fault in the queues and pools of an endpoint's shm "
+			"region when it is created, rather than on first use. "
+			"Default: false");
 
 	smr_init_env();
 
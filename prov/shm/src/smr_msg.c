@@ -96,7 +96,7 @@ static ssize_t smr_generic_sendmsg(struct smr_ep *ep, const struct iovec *iov,
 	if (id < 0)
 		return -FI_EAGAIN;
 
-	peer_id = smr_peer_data(ep->region)[id].addr.id;
+	peer_id = smr_peer_id(ep->region, id);
 	peer_smr = smr_peer_region(ep->region, id);
 
 	if (smr_peer_data(ep->region)[id].sar_status)
@@ -115,16 +115,31 @@ static ssize_t smr_generic_sendmsg(struct smr_ep *ep, const struct iovec *iov,
 	                         smr_ipc_valid(ep, peer_smr, id, peer_id), op,
 				 total_len, op_flags);
 
-	ret = smr_proto_ops[proto](ep, peer_smr, id, peer_id, op, tag, data, op_flags,
-				   (struct ofi_mr **)desc, iov, iov_count, total_len,
-				   context, &ce->cmd);
-	if (ret) {
-		smr_cmd_queue_discard(ce, pos);
-		goto unlock;
+	if (smr_use_direct(peer_smr, proto, op) &&
+	    !smr_proto_ops[smr_src_direct](ep, peer_smr, id, peer_id, op, tag,
+				data, op_flags, (struct ofi_mr **)desc, iov,
+				iov_count, total_len, context, &ce->cmd)) {
+		proto = smr_src_direct;
+	} else {
+		ret = smr_proto_ops[proto](ep, peer_smr, id, peer_id, op, tag,
+				data, op_flags, (struct ofi_mr **)desc, iov,
+				iov_count, total_len, context, &ce->cmd);
+		if (ret) {
+			smr_cmd_queue_discard(ce, pos);
+			goto unlock;
+		}
 	}
 	smr_cmd_queue_commit(ce, pos);
 
-	if (proto != smr_src_inline && proto != smr_src_inject)
+	if (smr_direct_peer(peer_smr, op))
+		smr_peer_data(ep->region)[id].tx_msg_cnt++;
+
+	/* the receive for the reply is usually posted just before this */
+	if (ep->direct_landing)
+		smr_landing_publish(ep);
+
+	if (proto != smr_src_inline && proto != smr_src_inject &&
+	    proto != smr_src_direct)
 		goto unlock;
 
 	ret = smr_complete_tx(ep, context, op, op_flags);
@@ -189,6 +204,7 @@ static ssize_t smr_generic_inject(struct fid_ep *ep_fid, const void *buf,
 	int proto;
 	struct smr_cmd_entry *ce;
 	int64_t pos;
+	bool direct;
 
 	assert(len <= SMR_INJECT_SIZE);
 
@@ -201,7 +217,7 @@ static ssize_t smr_generic_inject(struct fid_ep *ep_fid, const void *buf,
 	if (id < 0)
 		return -FI_EAGAIN;
 
-	peer_id = smr_peer_data(ep->region)[id].addr.id;
+	peer_id = smr_peer_id(ep->region, id);
 	peer_smr = smr_peer_region(ep->region, id);
 
 	if (smr_peer_data(ep->region)[id].sar_status)
@@ -211,14 +227,32 @@ static ssize_t smr_generic_inject(struct fid_ep *ep_fid, const void *buf,
 	if (ret == -FI_ENOENT)
 		return -FI_EAGAIN;
 
+	/* message counts toward a published receive must follow the order
+	 * that commands are committed in */
+	direct = smr_direct_peer(peer_smr, op);
+	if (direct) {
+		ofi_genlock_lock(&ep->util_ep.lock);
+		if (!smr_proto_ops[smr_src_direct](ep, peer_smr, id, peer_id, op,
+				tag, data, op_flags, NULL, &msg_iov, 1, len,
+				NULL, &ce->cmd))
+			goto commit;
+	}
+
 	proto = len <= SMR_MSG_DATA_LEN ? smr_src_inline : smr_src_inject;
 	ret = smr_proto_ops[proto](ep, peer_smr, id, peer_id, op, tag, data,
 			op_flags, NULL, &msg_iov, 1, len, NULL, &ce->cmd);
 	if (ret) {
 		smr_cmd_queue_discard(ce, pos);
+		if (direct)
+			ofi_genlock_unlock(&ep->util_ep.lock);
 		return -FI_EAGAIN;
 	}
+commit:
 	smr_cmd_queue_commit(ce, pos);
+	if (direct) {
+		smr_peer_data(ep->region)[id].tx_msg_cnt++;
+		ofi_genlock_unlock(&ep->util_ep.lock);
+	}
 	ofi_ep_peer_tx_cntr_inc(&ep->util_ep, op);
 
 	return FI_SUCCESS;
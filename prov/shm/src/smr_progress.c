@@ -42,6 +42,7 @@
 #include "ofi_shm_p2p.h"
 #include "smr.h"
 #include "smr_dsa.h"
+#include "smr_sw_copy.h"
 
 static inline void
 smr_try_progress_to_sar(struct smr_ep *ep, struct smr_region *smr,
@@ -55,6 +56,10 @@ smr_try_progress_to_sar(struct smr_ep *ep, struct smr_region *smr,
 			(void) smr_dsa_copy_to_sar(ep, sar_pool, resp, cmd, iov,
 					    iov_count, bytes_done, entry_ptr);
 			return;
+		} else if (ep->sw_copy_context &&
+			   ofi_mr_all_host(mr, iov_count)) {
+			(void) smr_sw_copy_to_sar(ep, sar_pool, resp, cmd, iov,
+					    iov_count, bytes_done, entry_ptr);
 		} else {
 			smr_copy_to_sar(sar_pool, resp, cmd, mr, iov, iov_count,
 					bytes_done);
@@ -74,6 +79,10 @@ smr_try_progress_from_sar(struct smr_ep *ep, struct smr_region *smr,
 			(void) smr_dsa_copy_from_sar(ep, sar_pool, resp, cmd,
 					iov, iov_count, bytes_done, entry_ptr);
 			return;
+		} else if (ep->sw_copy_context &&
+			   ofi_mr_all_host(mr, iov_count)) {
+			(void) smr_sw_copy_from_sar(ep, sar_pool, resp, cmd,
+					iov, iov_count, bytes_done, entry_ptr);
 		} else {
 			smr_copy_from_sar(sar_pool, resp, cmd, mr,
 					  iov, iov_count, bytes_done);
@@ -341,7 +350,8 @@ static int smr_mmap_peer_copy(struct smr_ep *ep, struct smr_cmd *cmd,
 	ssize_t hmem_copy_ret;
 
 	num = smr_mmap_name(shm_name,
-			ep->region->map->peers[cmd->msg.hdr.id].peer.name,
+			smr_map_peer(ep->region->map,
+				     cmd->msg.hdr.id)->peer.name,
 			cmd->msg.hdr.msg_id);
 	if (num < 0) {
 		FI_WARN(&smr_prov, FI_LOG_AV, "generating shm file name failed\n");
@@ -542,7 +552,8 @@ static struct smr_pend_entry *smr_progress_ipc(struct smr_cmd *cmd,
 
 	if (cmd->msg.data.ipc_info.iface == FI_HMEM_ZE)
 		ze_set_pid_fd((void **) &cmd->msg.data.ipc_info.ipc_handle,
-			      ep->region->map->peers[cmd->msg.hdr.id].pid_fd);
+			      smr_map_peer(ep->region->map,
+					   cmd->msg.hdr.id)->pid_fd);
 
 	//TODO disable IPC if more than 1 interface is initialized
 	ret = ofi_ipc_cache_search(domain->ipc_cache, cmd->msg.hdr.id,
@@ -623,7 +634,13 @@ static void smr_do_atomic(void *src, struct ofi_mr *dst_mr, void *dst,
 		ofi_atomic_readwrite_handler(op, datatype, cpy_dst, src,
 					     tmp_result, cnt);
 	} else if (ofi_atomic_iswrite_op(op)) {
-		ofi_atomic_write_handler(op, datatype, cpy_dst, src, cnt);
+		/* the host bounce buffer is private, registered memory is not */
+		if (cpy_dst != dst)
+			ofi_atomic_reduce_handler(op, datatype, cpy_dst, src,
+						  cnt);
+		else
+			ofi_atomic_write_handler(op, datatype, cpy_dst, src,
+						 cnt);
 	} else {
 		FI_WARN(&smr_prov, FI_LOG_EP_DATA,
 			"invalid atomic operation\n");
@@ -754,6 +771,10 @@ static int smr_start_common(struct smr_ep *ep, struct smr_cmd *cmd,
 				rx_entry->iov, rx_entry->count,
 				&total_len, ep, &err);
 		break;
+	case smr_src_direct:
+		err = -(int) cmd->msg.hdr.src_data;
+		total_len = cmd->msg.hdr.size;
+		break;
 	default:
 		FI_WARN(&smr_prov, FI_LOG_EP_CTRL,
 			"unidentified operation type\n");
@@ -902,14 +923,20 @@ static void smr_progress_connreq(struct smr_ep *ep, struct smr_cmd *cmd)
 		peer_smr = smr_peer_region(ep->region, idx);
 	}
 
+	/* The peer's messages follow this request, and we may not have
+	 * mapped it to the endpoint yet, see smr_map_to_endpoint
+	 */
+	smr_peer_data(ep->region)[idx].rx_msg_cnt = 0;
+	ofi_atomic_initialize64(&smr_peer_data(ep->region)[idx].landing.state,
+				SMR_LANDING_EMPTY);
+
 	smr_set_ipc_valid(ep->region, idx);
-	smr_peer_data(peer_smr)[cmd->msg.hdr.id].addr.id = idx;
-	smr_peer_data(ep->region)[idx].addr.id = cmd->msg.hdr.id;
+	smr_set_peer_id(peer_smr, cmd->msg.hdr.id, idx);
+	smr_set_peer_id(ep->region, idx, cmd->msg.hdr.id);
 
 	smr_release_txbuf(ep->region, tx_buf);
 	assert(ep->region->map->num_peers > 0);
-	ep->region->max_sar_buf_per_peer = SMR_MAX_PEERS /
-		ep->region->map->num_peers;
+	smr_set_sar_bufs(ep->region, ep->region->map->num_peers);
 }
 
 static int smr_alloc_cmd_ctx(struct smr_ep *ep,
@@ -981,6 +1008,111 @@ static int smr_alloc_cmd_ctx(struct smr_ep *ep,
 	return FI_SUCCESS;
 }
 
+/*
+ * Offer the receive that the next message from the last sender will match to
+ * that sender, see struct smr_landing.  Called with the srx lock held.
+ */
+void smr_landing_publish(struct smr_ep *ep)
+{
+	struct fi_peer_rx_entry *rx_entry;
+	struct smr_landing *landing;
+	uint64_t ignore, state;
+	bool tagged;
+
+	assert(ep->direct_landing);
+	if (ep->landing_rx || ep->last_rx_id < 0)
+		return;
+
+	tagged = ep->last_rx_op == ofi_op_tagged;
+	rx_entry = util_srx_claim_recv(smr_get_peer_srx(ep),
+			smr_map_peer(ep->region->map, ep->last_rx_id)->fiaddr,
+			tagged, &ignore);
+	if (!rx_entry)
+		return;
+
+	if (rx_entry->count > SMR_IOV_LIMIT || (rx_entry->desc &&
+	    !ofi_mr_all_host((struct ofi_mr **) rx_entry->desc,
+			     rx_entry->count))) {
+		util_srx_unclaim_recv(rx_entry, tagged);
+		return;
+	}
+
+	landing = &smr_peer_data(ep->region)[ep->last_rx_id].landing;
+	landing->op = ep->last_rx_op;
+	landing->seq = smr_peer_data(ep->region)[ep->last_rx_id].rx_msg_cnt;
+	landing->tag = rx_entry->tag;
+	landing->ignore = ignore;
+	landing->iov_count = rx_entry->count;
+	memcpy(landing->iov, rx_entry->iov,
+	       sizeof(*rx_entry->iov) * rx_entry->count);
+
+	state = ofi_atomic_load_explicit64(&landing->state,
+					   memory_order_relaxed);
+	ofi_atomic_store_explicit64(&landing->state,
+			((state & ~SMR_LANDING_STATE_MASK) + SMR_LANDING_GEN_INC) |
+			SMR_LANDING_POSTED, memory_order_release);
+
+	ep->landing_rx = rx_entry;
+	ep->landing_id = ep->last_rx_id;
+	ep->landing_op = ep->last_rx_op;
+}
+
+/*
+ * Take the published receive back so a message can be matched against it.
+ * Returns false if the sender already claimed it, in which case its message
+ * is on the way and the receive stays with the landing.
+ */
+bool smr_landing_revoke(struct smr_ep *ep)
+{
+	struct smr_landing *landing;
+	int64_t state;
+
+	if (!ep->landing_rx)
+		return true;
+
+	landing = &smr_peer_data(ep->region)[ep->landing_id].landing;
+	do {
+		state = ofi_atomic_load_explicit64(&landing->state,
+						   memory_order_acquire);
+		if ((state & SMR_LANDING_STATE_MASK) == SMR_LANDING_CLAIMED)
+			return false;
+	} while ((state & SMR_LANDING_STATE_MASK) == SMR_LANDING_POSTED &&
+		 !ofi_atomic_cas_bool64(&landing->state, state,
+					state & ~SMR_LANDING_STATE_MASK));
+
+	util_srx_unclaim_recv(ep->landing_rx,
+			      ep->landing_op == ofi_op_tagged);
+	ep->landing_rx = NULL;
+	return true;
+}
+
+static int smr_progress_landing(struct smr_ep *ep, struct smr_cmd *cmd)
+{
+	struct smr_landing *landing;
+	struct fi_peer_rx_entry *rx_entry;
+	int64_t state;
+
+	assert(ep->landing_rx && ep->landing_id == cmd->msg.hdr.id);
+	landing = &smr_peer_data(ep->region)[cmd->msg.hdr.id].landing;
+	state = ofi_atomic_load_explicit64(&landing->state,
+					   memory_order_relaxed);
+	ofi_atomic_store_explicit64(&landing->state,
+				    state & ~SMR_LANDING_STATE_MASK,
+				    memory_order_relaxed);
+
+	rx_entry = util_srx_claimed_entry(ep->landing_rx,
+			smr_map_peer(ep->region->map, cmd->msg.hdr.id)->fiaddr,
+			cmd->msg.hdr.size, ep->landing_op == ofi_op_tagged);
+	ep->landing_rx = NULL;
+	if (!rx_entry) {
+		FI_WARN(&smr_prov, FI_LOG_EP_CTRL,
+			"cannot allocate multi receive buffer\n");
+		return -FI_ENOMEM;
+	}
+
+	return smr_start_common(ep, cmd, rx_entry);
+}
+
 static int smr_progress_cmd_msg(struct smr_ep *ep, struct smr_cmd *cmd)
 {
 	struct fid_peer_srx *peer_srx = smr_get_peer_srx(ep);
@@ -988,7 +1120,16 @@ static int smr_progress_cmd_msg(struct smr_ep *ep, struct smr_cmd *cmd)
 	struct fi_peer_rx_entry *rx_entry;
 	int ret;
 
-	attr.addr = ep->region->map->peers[cmd->msg.hdr.id].fiaddr;
+	smr_peer_data(ep->region)[cmd->msg.hdr.id].rx_msg_cnt++;
+	if (ep->direct_landing) {
+		ep->last_rx_id = cmd->msg.hdr.id;
+		ep->last_rx_op = cmd->msg.hdr.op;
+		if (cmd->msg.hdr.op_src == smr_src_direct)
+			return smr_progress_landing(ep, cmd);
+		(void) smr_landing_revoke(ep);
+	}
+
+	attr.addr = smr_map_peer(ep->region->map, cmd->msg.hdr.id)->fiaddr;
 	attr.msg_size = cmd->msg.hdr.size;
 	attr.tag = cmd->msg.hdr.tag;
 	if (cmd->msg.hdr.op == ofi_op_tagged) {
@@ -1273,6 +1414,8 @@ static void smr_progress_cmd(struct smr_ep *ep)
 			break;
 		}
 	}
+	if (ep->direct_landing)
+		smr_landing_publish(ep);
 	ofi_genlock_unlock(&ep->util_ep.lock);
 }
 
@@ -1461,6 +1604,8 @@ void smr_ep_progress(struct util_ep *util_ep)
 
 	if (smr_env.use_dsa_sar)
 		smr_dsa_progress(ep);
+	if (ep->sw_copy_context)
+		smr_sw_copy_progress(ep);
 	smr_progress_resp(ep);
 	smr_progress_sar_list(ep);
 	smr_progress_cmd(ep);
@@ -49,7 +49,10 @@ static void smr_handle_signal(int signum, siginfo_t *info, void *ucontext)
 	pthread_mutex_lock(&ep_list_lock);
 	dlist_foreach_container(&ep_name_list, struct smr_ep_name,
 				ep_name, entry) {
-		shm_unlink(ep_name->name);
+		if (ep_name->huge_path)
+			unlink(ep_name->huge_path);
+		else
+			shm_unlink(ep_name->name);
 	}
 	pthread_mutex_unlock(&ep_list_lock);
 
@@ -0,0 +1,582 @@
+/*
+ * Copyright (c) 2026 Intel Corporation. All rights reserved
+ *
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <dirent.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "ofi_atom.h"
+#include "ofi_list.h"
+#include "ofi_mb.h"
+#include "smr_util.h"
+#include "smr_sw_copy.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define CMD_CONTEXT_COUNT 32
+
+/* Same bound as DSA: enough descriptors to fill every SAR buffer */
+#define MAX_CMD_BATCH_SIZE (SMR_BUF_BATCH_MAX + SMR_IOV_LIMIT)
+
+/*
+ * Messages at least this large are streamed into the receive buffer with
+ * non-temporal stores.  They would evict most of the cache on the way in
+ * and are rarely read back right away.  Copies into SAR buffers always
+ * go through the cache since the peer reads them immediately.
+ */
+#define SMR_SW_COPY_NT_THRESHOLD (1024 * 1024)
+
+struct smr_sw_copy_cmd;
+
+struct smr_sw_copy_desc {
+	struct dlist_entry entry;
+	struct smr_sw_copy_cmd *cmd;
+	const void *src;
+	void *dst;
+	size_t len;
+	bool nt;
+};
+
+struct smr_sw_copy_cmd {
+	ofi_atomic32_t pending;
+	size_t bytes_in_progress;
+	int batch_size;
+	int dir;
+	uint32_t op;
+	void *entry_ptr;
+};
+
+struct smr_sw_copy_context {
+	struct smr_sw_copy_desc desc[MAX_CMD_BATCH_SIZE * CMD_CONTEXT_COUNT];
+	struct smr_sw_copy_cmd cmd[CMD_CONTEXT_COUNT];
+
+	/* bitmap of busy cmds, protected by the ep lock */
+	uint32_t busy;
+	ofi_atomic32_t busy_cnt;
+
+	unsigned long copy_type_stats[2];
+};
+
+/* Helper threads are shared by all endpoints in the process */
+struct smr_sw_copy_engine {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	struct dlist_entry queue;
+	int idle;
+	bool stop;
+
+	pthread_t *threads;
+	size_t thread_cnt;
+	int ref;
+	char cpulist[256];
+};
+
+static pthread_mutex_t smr_sw_copy_init_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct smr_sw_copy_engine smr_sw_copy_engine = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.cond = PTHREAD_COND_INITIALIZER,
+};
+
+#if defined(__SSE2__)
+static void smr_sw_copy_nt(void *dst, const void *src, size_t len)
+{
+	__m128i r0, r1, r2, r3;
+	const char *s = src;
+	char *d = dst;
+	size_t head;
+
+	head = MIN(len, (16 - ((uintptr_t) d & 15)) & 15);
+	memcpy(d, s, head);
+	d += head;
+	s += head;
+	len -= head;
+
+	for (; len >= 64; len -= 64, d += 64, s += 64) {
+		r0 = _mm_loadu_si128((const __m128i *) s);
+		r1 = _mm_loadu_si128((const __m128i *) (s + 16));
+		r2 = _mm_loadu_si128((const __m128i *) (s + 32));
+		r3 = _mm_loadu_si128((const __m128i *) (s + 48));
+		_mm_stream_si128((__m128i *) d, r0);
+		_mm_stream_si128((__m128i *) (d + 16), r1);
+		_mm_stream_si128((__m128i *) (d + 32), r2);
+		_mm_stream_si128((__m128i *) (d + 48), r3);
+	}
+	for (; len >= 16; len -= 16, d += 16, s += 16) {
+		r0 = _mm_loadu_si128((const __m128i *) s);
+		_mm_stream_si128((__m128i *) d, r0);
+	}
+	memcpy(d, s, len);
+
+	/* streaming stores are weakly ordered */
+	_mm_sfence();
+}
+#else
+static void smr_sw_copy_nt(void *dst, const void *src, size_t len)
+{
+	memcpy(dst, src, len);
+}
+#endif
+
+static void *smr_sw_copy_thread(void *arg)
+{
+	struct smr_sw_copy_engine *engine = arg;
+	struct smr_sw_copy_desc *desc;
+	struct smr_sw_copy_cmd *cmd;
+	int ret;
+
+	if (engine->cpulist[0]) {
+		ret = ofi_set_thread_affinity(engine->cpulist);
+		if (ret)
+			FI_INFO(&smr_prov, FI_LOG_EP_CTRL,
+				"unable to bind copy thread to cpus %s: %s\n",
+				engine->cpulist, fi_strerror(-ret));
+	}
+
+	pthread_mutex_lock(&engine->lock);
+	while (!engine->stop) {
+		if (dlist_empty(&engine->queue)) {
+			engine->idle++;
+			pthread_cond_wait(&engine->cond, &engine->lock);
+			engine->idle--;
+			continue;
+		}
+
+		dlist_pop_front(&engine->queue, struct smr_sw_copy_desc,
+				desc, entry);
+		pthread_mutex_unlock(&engine->lock);
+
+		if (desc->nt)
+			smr_sw_copy_nt(desc->dst, desc->src, desc->len);
+		else
+			memcpy(desc->dst, desc->src, desc->len);
+
+		/* desc belongs to the ep again once pending drops */
+		cmd = desc->cmd;
+		ofi_wmb();
+		ofi_atomic_dec32(&cmd->pending);
+
+		pthread_mutex_lock(&engine->lock);
+	}
+	pthread_mutex_unlock(&engine->lock);
+
+	return NULL;
+}
+
+/*
+ * Keep the helpers on the NUMA node of the thread that opened the first
+ * endpoint, which is where the SAR buffers and most user buffers live.
+ * The node is read from sysfs so no libnuma dependency is needed.
+ */
+static void smr_sw_copy_get_cpulist(char *buf, size_t size)
+{
+	struct dirent *entry;
+	char path[64];
+	int cpu, node = -1;
+	DIR *dir;
+	int len;
+
+	buf[0] = '\0';
+	cpu = sched_getcpu();
+	if (cpu < 0)
+		return;
+
+	snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+	dir = opendir(path);
+	if (!dir)
+		return;
+
+	while ((entry = readdir(dir))) {
+		if (sscanf(entry->d_name, "node%d", &node) == 1)
+			break;
+	}
+	closedir(dir);
+	if (node < 0)
+		return;
+
+	snprintf(path, sizeof(path), "/sys/devices/system/node/node%d", node);
+	len = fi_read_file(path, "cpulist", buf, size - 1);
+	buf[len > 0 ? len : 0] = '\0';
+}
+
+static void smr_sw_copy_stop(struct smr_sw_copy_engine *engine)
+{
+	size_t i;
+
+	pthread_mutex_lock(&engine->lock);
+	engine->stop = true;
+	pthread_cond_broadcast(&engine->cond);
+	pthread_mutex_unlock(&engine->lock);
+
+	for (i = 0; i < engine->thread_cnt; i++)
+		pthread_join(engine->threads[i], NULL);
+
+	free(engine->threads);
+	engine->threads = NULL;
+	engine->thread_cnt = 0;
+}
+
+static int smr_sw_copy_start(struct smr_sw_copy_engine *engine,
+			     size_t thread_cnt)
+{
+	int ret;
+
+	engine->threads = calloc(thread_cnt, sizeof(*engine->threads));
+	if (!engine->threads)
+		return -FI_ENOMEM;
+
+	dlist_init(&engine->queue);
+	engine->stop = false;
+	engine->idle = 0;
+	smr_sw_copy_get_cpulist(engine->cpulist, sizeof(engine->cpulist));
+
+	for (; engine->thread_cnt < thread_cnt; engine->thread_cnt++) {
+		ret = pthread_create(&engine->threads[engine->thread_cnt],
+				     NULL, smr_sw_copy_thread, engine);
+		if (ret) {
+			FI_WARN(&smr_prov, FI_LOG_EP_CTRL,
+				"unable to create copy thread: %s\n",
+				strerror(ret));
+			smr_sw_copy_stop(engine);
+			return -FI_EOTHER;
+		}
+	}
+
+	FI_INFO(&smr_prov, FI_LOG_EP_CTRL,
+		"started %zu copy threads on cpus %s\n", thread_cnt,
+		engine->cpulist[0] ? engine->cpulist : "(any)");
+	return FI_SUCCESS;
+}
+
+void smr_sw_copy_cleanup(void)
+{
+	pthread_mutex_lock(&smr_sw_copy_init_lock);
+	if (smr_sw_copy_engine.thread_cnt)
+		smr_sw_copy_stop(&smr_sw_copy_engine);
+	smr_sw_copy_engine.ref = 0;
+	pthread_mutex_unlock(&smr_sw_copy_init_lock);
+}
+
+void smr_sw_copy_context_init(struct smr_ep *ep)
+{
+	struct smr_sw_copy_context *context;
+	int i;
+
+	context = calloc(1, sizeof(*context));
+	if (!context)
+		goto err;
+
+	for (i = 0; i < CMD_CONTEXT_COUNT; i++)
+		ofi_atomic_initialize32(&context->cmd[i].pending, 0);
+	ofi_atomic_initialize32(&context->busy_cnt, 0);
+
+	pthread_mutex_lock(&smr_sw_copy_init_lock);
+	if (!smr_sw_copy_engine.ref &&
+	    smr_sw_copy_start(&smr_sw_copy_engine, smr_env.sw_copy_threads)) {
+		pthread_mutex_unlock(&smr_sw_copy_init_lock);
+		free(context);
+		goto err;
+	}
+	smr_sw_copy_engine.ref++;
+	pthread_mutex_unlock(&smr_sw_copy_init_lock);
+
+	ep->sw_copy_context = context;
+	return;
+
+err:
+	FI_WARN(&smr_prov, FI_LOG_EP_CTRL,
+		"software copy engine unavailable, copying inline\n");
+}
+
+void smr_sw_copy_context_cleanup(struct smr_ep *ep)
+{
+	struct smr_sw_copy_context *context = ep->sw_copy_context;
+	int i;
+
+	if (!context)
+		return;
+
+	FI_INFO(&smr_prov, FI_LOG_EP_CTRL,
+		"copy cmds: user to sar %lu sar to user %lu\n",
+		context->copy_type_stats[OFI_COPY_IOV_TO_BUF],
+		context->copy_type_stats[OFI_COPY_BUF_TO_IOV]);
+
+	/* helpers may still be writing into descriptors we own */
+	for (i = 0; i < CMD_CONTEXT_COUNT; i++) {
+		while (ofi_atomic_get32(&context->cmd[i].pending))
+			sched_yield();
+	}
+
+	pthread_mutex_lock(&smr_sw_copy_init_lock);
+	if (smr_sw_copy_engine.ref && !--smr_sw_copy_engine.ref)
+		smr_sw_copy_stop(&smr_sw_copy_engine);
+	pthread_mutex_unlock(&smr_sw_copy_init_lock);
+
+	free(context);
+	ep->sw_copy_context = NULL;
+}
+
+static struct smr_sw_copy_cmd *
+smr_sw_copy_alloc_cmd(struct smr_sw_copy_context *context, int *index)
+{
+	int i;
+
+	for (i = 0; i < CMD_CONTEXT_COUNT; i++) {
+		if (!(context->busy & (1U << i)))
+			break;
+	}
+	if (i == CMD_CONTEXT_COUNT)
+		return NULL;
+
+	context->busy |= 1U << i;
+	ofi_atomic_inc32(&context->busy_cnt);
+	*index = i;
+	return &context->cmd[i];
+}
+
+static void smr_sw_copy_free_cmd(struct smr_sw_copy_context *context, int i)
+{
+	context->busy &= ~(1U << i);
+	ofi_atomic_dec32(&context->busy_cnt);
+}
+
+static void smr_sw_copy_sar(struct smr_freestack *sar_pool,
+			    struct smr_sw_copy_context *context, int index,
+			    struct smr_resp *resp, struct smr_cmd *cmd,
+			    const struct iovec *iov, size_t count,
+			    size_t *bytes_done)
+{
+	struct smr_sw_copy_cmd *copy_cmd = &context->cmd[index];
+	struct smr_sw_copy_engine *engine = &smr_sw_copy_engine;
+	struct smr_sw_copy_desc *desc;
+	struct smr_sar_buf *smr_sar_buf;
+	struct dlist_entry desc_list;
+	size_t remaining_sar_size, remaining_iov_size;
+	size_t iov_index, iov_offset = *bytes_done;
+	size_t sar_offset = 0, cmd_size;
+	size_t bytes_pending = 0;
+	int sar_index = 0;
+	char *iov_buf, *sar_buf;
+	bool nt;
+
+	nt = copy_cmd->dir == OFI_COPY_BUF_TO_IOV &&
+	     cmd->msg.hdr.size >= SMR_SW_COPY_NT_THRESHOLD;
+
+	for (iov_index = 0; iov_index < count; iov_index++) {
+		if (iov_offset < iov[iov_index].iov_len)
+			break;
+		iov_offset -= iov[iov_index].iov_len;
+	}
+
+	dlist_init(&desc_list);
+	copy_cmd->batch_size = 0;
+	while (iov_index < count &&
+	       sar_index < cmd->msg.data.buf_batch_size &&
+	       copy_cmd->batch_size < MAX_CMD_BATCH_SIZE) {
+		smr_sar_buf = smr_freestack_get_entry_from_index(
+				sar_pool, cmd->msg.data.sar[sar_index]);
+		iov_buf = (char *) iov[iov_index].iov_base + iov_offset;
+		sar_buf = (char *) smr_sar_buf->buf + sar_offset;
+
+		remaining_sar_size = SMR_SAR_SIZE - sar_offset;
+		remaining_iov_size = iov[iov_index].iov_len - iov_offset;
+		cmd_size = MIN(remaining_iov_size, remaining_sar_size);
+		assert(cmd_size > 0);
+
+		desc = &context->desc[index * MAX_CMD_BATCH_SIZE +
+				      copy_cmd->batch_size++];
+		desc->cmd = copy_cmd;
+		desc->len = cmd_size;
+		desc->nt = nt;
+		if (copy_cmd->dir == OFI_COPY_BUF_TO_IOV) {
+			desc->src = sar_buf;
+			desc->dst = iov_buf;
+		} else {
+			desc->src = iov_buf;
+			desc->dst = sar_buf;
+		}
+		dlist_insert_tail(&desc->entry, &desc_list);
+		bytes_pending += cmd_size;
+
+		if (remaining_sar_size > remaining_iov_size) {
+			iov_index++;
+			iov_offset = 0;
+			sar_offset += cmd_size;
+		} else if (remaining_sar_size < remaining_iov_size) {
+			sar_index++;
+			sar_offset = 0;
+			iov_offset += cmd_size;
+		} else {
+			iov_index++;
+			iov_offset = 0;
+			sar_index++;
+			sar_offset = 0;
+		}
+	}
+	assert(bytes_pending > 0);
+
+	resp->status = SMR_STATUS_BUSY;
+	copy_cmd->bytes_in_progress = bytes_pending;
+	copy_cmd->op = cmd->msg.hdr.op;
+	context->copy_type_stats[copy_cmd->dir]++;
+	ofi_atomic_set32(&copy_cmd->pending, copy_cmd->batch_size);
+
+	pthread_mutex_lock(&engine->lock);
+	dlist_splice_tail(&engine->queue, &desc_list);
+	if (engine->idle) {
+		if (copy_cmd->batch_size > 1)
+			pthread_cond_broadcast(&engine->cond);
+		else
+			pthread_cond_signal(&engine->cond);
+	}
+	pthread_mutex_unlock(&engine->lock);
+}
+
+static void smr_sw_copy_update_tx_entry(struct smr_region *smr,
+					struct smr_sw_copy_cmd *copy_cmd)
+{
+	struct smr_tx_entry *tx_entry = copy_cmd->entry_ptr;
+	struct smr_resp *resp;
+
+	tx_entry->bytes_done += copy_cmd->bytes_in_progress;
+	resp = smr_get_ptr(smr, tx_entry->cmd.msg.hdr.src_data);
+
+	assert(resp->status == SMR_STATUS_BUSY);
+	resp->status = (copy_cmd->dir == OFI_COPY_IOV_TO_BUF ?
+			SMR_STATUS_SAR_FULL : SMR_STATUS_SAR_EMPTY);
+}
+
+static void smr_sw_copy_update_sar_entry(struct smr_region *smr,
+					 struct smr_sw_copy_cmd *copy_cmd)
+{
+	struct smr_pend_entry *sar_entry = copy_cmd->entry_ptr;
+	struct smr_region *peer_smr;
+	struct smr_resp *resp;
+
+	sar_entry->bytes_done += copy_cmd->bytes_in_progress;
+	peer_smr = smr_peer_region(smr, sar_entry->cmd.msg.hdr.id);
+	resp = smr_get_ptr(peer_smr, sar_entry->cmd.msg.hdr.src_data);
+
+	assert(resp->status == SMR_STATUS_BUSY);
+	resp->status = (copy_cmd->dir == OFI_COPY_IOV_TO_BUF ?
+			SMR_STATUS_SAR_FULL : SMR_STATUS_SAR_EMPTY);
+}
+
+void smr_sw_copy_progress(struct smr_ep *ep)
+{
+	struct smr_sw_copy_context *context = ep->sw_copy_context;
+	struct smr_sw_copy_cmd *copy_cmd;
+	bool tx_side;
+	int i;
+
+	if (!ofi_atomic_get32(&context->busy_cnt))
+		return;
+
+	ofi_genlock_lock(&ep->util_ep.lock);
+	for (i = 0; i < CMD_CONTEXT_COUNT; i++) {
+		if (!(context->busy & (1U << i)))
+			continue;
+
+		/* pairs with the helper's barrier before it drops pending */
+		copy_cmd = &context->cmd[i];
+		if (ofi_atomic_load_explicit32(&copy_cmd->pending,
+					       memory_order_acquire))
+			continue;
+
+		if (copy_cmd->op == ofi_op_read_req)
+			tx_side = copy_cmd->dir == OFI_COPY_BUF_TO_IOV;
+		else
+			tx_side = copy_cmd->dir == OFI_COPY_IOV_TO_BUF;
+
+		/* the peer may read the SAR buffers as soon as status flips */
+		ofi_wmb();
+		if (tx_side)
+			smr_sw_copy_update_tx_entry(ep->region, copy_cmd);
+		else
+			smr_sw_copy_update_sar_entry(ep->region, copy_cmd);
+
+		smr_sw_copy_free_cmd(context, i);
+	}
+	ofi_genlock_unlock(&ep->util_ep.lock);
+}
+
+static int smr_sw_copy_submit(struct smr_ep *ep, struct smr_freestack *sar_pool,
+		struct smr_resp *resp, struct smr_cmd *cmd,
+		const struct iovec *iov, size_t count, size_t *bytes_done,
+		void *entry_ptr, int dir)
+{
+	struct smr_sw_copy_cmd *copy_cmd;
+	int index;
+
+	copy_cmd = smr_sw_copy_alloc_cmd(ep->sw_copy_context, &index);
+	if (!copy_cmd)
+		return -FI_ENOMEM;
+
+	copy_cmd->dir = dir;
+	copy_cmd->entry_ptr = entry_ptr;
+	smr_sw_copy_sar(sar_pool, ep->sw_copy_context, index, resp, cmd,
+			iov, count, bytes_done);
+
+	return FI_SUCCESS;
+}
+
+int smr_sw_copy_to_sar(struct smr_ep *ep, struct smr_freestack *sar_pool,
+		struct smr_resp *resp, struct smr_cmd *cmd,
+		const struct iovec *iov, size_t count, size_t *bytes_done,
+		void *entry_ptr)
+{
+	assert(ep->sw_copy_context);
+
+	if (resp->status != SMR_STATUS_SAR_EMPTY)
+		return -FI_EAGAIN;
+
+	return smr_sw_copy_submit(ep, sar_pool, resp, cmd, iov, count,
+				  bytes_done, entry_ptr, OFI_COPY_IOV_TO_BUF);
+}
+
+int smr_sw_copy_from_sar(struct smr_ep *ep, struct smr_freestack *sar_pool,
+		struct smr_resp *resp, struct smr_cmd *cmd,
+		const struct iovec *iov, size_t count, size_t *bytes_done,
+		void *entry_ptr)
+{
+	assert(ep->sw_copy_context);
+
+	if (resp->status != SMR_STATUS_SAR_FULL)
+		return -FI_EAGAIN;
+
+	return smr_sw_copy_submit(ep, sar_pool, resp, cmd, iov, count,
+				  bytes_done, entry_ptr, OFI_COPY_BUF_TO_IOV);
+}
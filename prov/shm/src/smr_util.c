@@ -56,8 +56,10 @@ void smr_cleanup(void)
 
 	pthread_mutex_lock(&ep_list_lock);
 	dlist_foreach_container_safe(&ep_name_list, struct smr_ep_name,
-				     ep_name, entry, tmp)
+				     ep_name, entry, tmp) {
+		free(ep_name->huge_path);
 		free(ep_name);
+	}
 	pthread_mutex_unlock(&ep_list_lock);
 }
 
@@ -90,6 +92,7 @@ void smr_cma_check(struct smr_region *smr, struct smr_region *peer_smr)
 }
 
 size_t smr_calculate_size_offsets(size_t tx_count, size_t rx_count,
+				  size_t peer_count,
 				  size_t *cmd_offset, size_t *resp_offset,
 				  size_t *inject_offset, size_t *sar_offset,
 				  size_t *peer_offset, size_t *name_offset,
@@ -111,9 +114,9 @@ size_t smr_calculate_size_offsets(size_t tx_count, size_t rx_count,
 	sar_pool_offset = inject_pool_offset +
 		freestack_size(sizeof(struct smr_inject_buf), rx_size);
 	peer_data_offset = sar_pool_offset +
-		freestack_size(sizeof(struct smr_sar_buf), SMR_MAX_PEERS);
+		freestack_size(sizeof(struct smr_sar_buf), SMR_SAR_BUF_CNT);
 	ep_name_offset = peer_data_offset + sizeof(struct smr_peer_data) *
-		SMR_MAX_PEERS;
+		peer_count;
 
 	sock_name_offset = ep_name_offset + SMR_NAME_MAX;
 
@@ -143,11 +146,20 @@ size_t smr_calculate_size_offsets(size_t tx_count, size_t rx_count,
 	return total_size;
 }
 
-static int smr_retry_map(const char *name, int *fd)
+static bool smr_pid_exited(int pid)
 {
 	char tmp[NAME_MAX];
-	struct smr_region *old_shm;
 	struct stat sts;
+
+	memset(tmp, 0, sizeof(tmp));
+	snprintf(tmp, sizeof(tmp), "/proc/%d", pid);
+
+	return stat(tmp, &sts) == -1 && errno == ENOENT;
+}
+
+static int smr_retry_map(const char *name, int *fd)
+{
+	struct smr_region *old_shm;
 	int shm_pid;
 
 	*fd = shm_open(name, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
@@ -167,13 +179,7 @@ static int smr_retry_map(const char *name, int *fd)
 	shm_pid = old_shm->pid;
 	munmap(old_shm, sizeof(*old_shm));
 
-	if (!shm_pid)
-		return FI_SUCCESS;
-
-	memset(tmp, 0, sizeof(tmp));
-	snprintf(tmp, sizeof(tmp), "/proc/%d", shm_pid);
-
-	if (stat(tmp, &sts) == -1 && errno == ENOENT)
+	if (!shm_pid || smr_pid_exited(shm_pid))
 		return FI_SUCCESS;
 
 err:
@@ -182,54 +188,217 @@ err:
 	return -FI_EBUSY;
 }
 
-static void smr_lock_init(pthread_spinlock_t *lock)
+/*
+ * Place the region on the NUMA node of the thread creating it, which is
+ * the thread that will poll its queues.  Peers write into the queues and
+ * pools, so the range is bound rather than left to whichever process
+ * touches a page first.  Large SAR pools can optionally be spread over all
+ * nodes.
+ */
+static void smr_region_place(const struct fi_provider *prov, char *addr,
+			     size_t page_size, size_t total_size,
+			     size_t sar_pool_offset, size_t peer_data_offset)
 {
-	pthread_spin_init(lock, PTHREAD_PROCESS_SHARED);
+	size_t start, end;
+	int node, ret;
+
+	if (smr_env.numa_policy == OFI_NUMA_NONE)
+		return;
+
+	node = ofi_numa_node();
+	ret = ofi_numa_bind(addr, total_size, OFI_NUMA_LOCAL, node);
+	if (ret) {
+		FI_INFO(prov, FI_LOG_EP_CTRL,
+			"unable to bind shm region to node %d: %s\n",
+			node, fi_strerror(-ret));
+		return;
+	}
+
+	if (smr_env.numa_policy == OFI_NUMA_INTERLEAVE) {
+		start = ofi_get_aligned_size(sar_pool_offset, page_size);
+		end = peer_data_offset & ~(page_size - 1);
+		if (end > start) {
+			ret = ofi_numa_bind(addr + start, end - start,
+					    OFI_NUMA_INTERLEAVE, node);
+			if (ret)
+				FI_INFO(prov, FI_LOG_EP_CTRL,
+					"unable to interleave sar pool: %s\n",
+					fi_strerror(-ret));
+		}
+	}
 }
 
-/* TODO: Determine if aligning SMR data helps performance */
-int smr_create(const struct fi_provider *prov, struct smr_map *map,
-	       const struct smr_attr *attr, struct smr_region *volatile *smr)
+/*
+ * Fault in the queues and pools of a new region up front, so that the
+ * first messages exchanged with a peer do not take page faults.  Peers
+ * mapping the region find the pages already present.  The peer data area
+ * is left unbacked.  Only MADV_POPULATE_WRITE is used: unlike touching
+ * each page, it fails cleanly instead of raising SIGBUS when the backing
+ * file system is full, and the pages are then faulted in on first use.
+ */
+static void smr_prefault(const struct fi_provider *prov, char *addr,
+			 size_t len)
 {
-	struct smr_ep_name *ep_name;
-	size_t total_size, cmd_queue_offset, peer_data_offset;
-	size_t resp_queue_offset, inject_pool_offset, name_offset;
-	size_t sar_pool_offset, sock_name_offset;
-	int fd, ret, i;
-	void *mapped_addr;
-	size_t tx_size, rx_size;
+	if (!smr_env.prefault)
+		return;
 
-	tx_size = roundup_power_of_two(attr->tx_count);
-	rx_size = roundup_power_of_two(attr->rx_count);
-	total_size = smr_calculate_size_offsets(tx_size, rx_size, &cmd_queue_offset,
-					&resp_queue_offset, &inject_pool_offset,
-					&sar_pool_offset, &peer_data_offset,
-					&name_offset, &sock_name_offset);
+#ifdef MADV_POPULATE_WRITE
+	if (!madvise(addr, len, MADV_POPULATE_WRITE))
+		return;
+#endif
+	FI_INFO(prov, FI_LOG_EP_CTRL, "unable to prefault shm region\n");
+}
 
-	fd = shm_open(attr->name, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+static int smr_huge_path(char *path, size_t size, const char *name)
+{
+	int len;
+
+	len = snprintf(path, size, "%s/%s", smr_env.hugepage_dir, name);
+	return len < 0 || (size_t) len >= size ? -FI_EINVAL : 0;
+}
+
+/*
+ * Back a region with a file in a hugetlbfs mount, which cuts the TLB
+ * entries needed to reach many peers' regions.  Returns NULL if hugetlbfs
+ * is not mounted at FI_SHM_HUGEPAGE_DIR or no huge pages are available,
+ * and the region is created in /dev/shm instead.  Peers look in the
+ * hugetlbfs mount first, see smr_open_region().
+ */
+static void *smr_map_hugepages(const struct fi_provider *prov,
+			       struct smr_ep_name *ep_name, size_t *size,
+			       size_t *page_size)
+{
+	char path[PATH_MAX];
+	ssize_t huge_size;
+	void *addr;
+	size_t len;
+	int fd;
+
+	huge_size = ofi_get_hugepage_size();
+	if (huge_size <= 0 || smr_huge_path(path, sizeof(path), ep_name->name))
+		goto err;
+
+	fd = open(path, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC,
+		  S_IRUSR | S_IWUSR);
+	if (fd < 0)
+		goto err;
+
+	/* hugetlbfs mappings must be a multiple of the huge page size */
+	len = ofi_get_aligned_size(*size, huge_size);
+	if (ftruncate(fd, len))
+		goto unlink;
+
+	/* shared hugetlbfs mappings reserve their pages here */
+	addr = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (addr == MAP_FAILED)
+		goto unlink;
+
+	ep_name->huge_path = strdup(path);
+	if (!ep_name->huge_path) {
+		munmap(addr, len);
+		goto unlink;
+	}
+
+	close(fd);
+	*size = len;
+	*page_size = huge_size;
+	return addr;
+
+unlink:
+	close(fd);
+	unlink(path);
+err:
+	FI_INFO(prov, FI_LOG_EP_CTRL,
+		"unable to back %s with huge pages in %s, using %s\n",
+		ep_name->name, smr_env.hugepage_dir, SMR_DIR);
+	return NULL;
+}
+
+static int smr_map_shm(const struct fi_provider *prov, const char *name,
+		       size_t size, void **addr)
+{
+	int fd, ret;
+
+	fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
 	if (fd < 0) {
 		if (errno != EEXIST) {
 			FI_WARN(prov, FI_LOG_EP_CTRL,
 				"shm_open error (%s): %s\n",
-				attr->name, strerror(errno));
+				name, strerror(errno));
 			return -errno;
 		}
 
-		ret = smr_retry_map(attr->name, &fd);
+		ret = smr_retry_map(name, &fd);
 		if (ret) {
 			FI_WARN(prov, FI_LOG_EP_CTRL, "shm file in use (%s)\n",
-				attr->name);
+				name);
 			return ret;
 		}
 		FI_WARN(prov, FI_LOG_EP_CTRL,
-			"Overwriting shm from dead process (%s)\n", attr->name);
+			"Overwriting shm from dead process (%s)\n", name);
 	}
 
+	/* Drop any pages left by a dead process, so that the peer data
+	 * area starts out zeroed and unbacked.
+	 */
+	ret = ftruncate(fd, 0);
+	if (!ret)
+		ret = ftruncate(fd, size);
+	if (ret < 0) {
+		FI_WARN(prov, FI_LOG_EP_CTRL, "ftruncate error\n");
+		ret = -errno;
+		goto err;
+	}
+
+	*addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (*addr == MAP_FAILED) {
+		FI_WARN(prov, FI_LOG_EP_CTRL, "mmap error\n");
+		ret = -errno;
+		goto err;
+	}
+	close(fd);
+
+	/* transparent huge pages, if shmem_enabled allows it */
+	if (smr_env.use_hugepages)
+		(void) madvise(*addr, size, MADV_HUGEPAGE);
+	return 0;
+
+err:
+	close(fd);
+	shm_unlink(name);
+	return ret;
+}
+
+static void smr_lock_init(pthread_spinlock_t *lock)
+{
+	pthread_spin_init(lock, PTHREAD_PROCESS_SHARED);
+}
+
+/* TODO: Determine if aligning SMR data helps performance */
+int smr_create(const struct fi_provider *prov, struct smr_map *map,
+	       const struct smr_attr *attr, struct smr_region *volatile *smr)
+{
+	struct smr_ep_name *ep_name;
+	size_t total_size, cmd_queue_offset, peer_data_offset;
+	size_t resp_queue_offset, inject_pool_offset, name_offset;
+	size_t sar_pool_offset, sock_name_offset, page_size;
+	void *mapped_addr = NULL;
+	size_t tx_size, rx_size;
+	int ret;
+
+	tx_size = roundup_power_of_two(attr->tx_count);
+	rx_size = roundup_power_of_two(attr->rx_count);
+	total_size = smr_calculate_size_offsets(tx_size, rx_size,
+					smr_map_max_peers(map),
+					&cmd_queue_offset, &resp_queue_offset,
+					&inject_pool_offset,
+					&sar_pool_offset, &peer_data_offset,
+					&name_offset, &sock_name_offset);
+
 	ep_name = calloc(1, sizeof(*ep_name));
 	if (!ep_name) {
 		FI_WARN(prov, FI_LOG_EP_CTRL, "calloc error\n");
-		ret = -FI_ENOMEM;
-		goto close;
+		return -FI_ENOMEM;
 	}
 	strncpy(ep_name->name, (char *)attr->name, SMR_NAME_MAX - 1);
 	ep_name->name[SMR_NAME_MAX - 1] = '\0';
@@ -237,22 +406,19 @@ int smr_create(const struct fi_provider *prov, struct smr_map *map,
 	pthread_mutex_lock(&ep_list_lock);
 	dlist_insert_tail(&ep_name->entry, &ep_name_list);
 
-	ret = ftruncate(fd, total_size);
-	if (ret < 0) {
-		FI_WARN(prov, FI_LOG_EP_CTRL, "ftruncate error\n");
-		ret = -errno;
-		goto remove;
-	}
-
-	mapped_addr = mmap(NULL, total_size, PROT_READ | PROT_WRITE,
-			   MAP_SHARED, fd, 0);
-	if (mapped_addr == MAP_FAILED) {
-		FI_WARN(prov, FI_LOG_EP_CTRL, "mmap error\n");
-		ret = -errno;
-		goto remove;
+	if (smr_env.use_hugepages)
+		mapped_addr = smr_map_hugepages(prov, ep_name, &total_size,
+						&page_size);
+	if (!mapped_addr) {
+		ret = smr_map_shm(prov, attr->name, total_size, &mapped_addr);
+		if (ret)
+			goto remove;
+		page_size = ofi_get_page_size();
 	}
 
-	close(fd);
+	smr_region_place(prov, mapped_addr, page_size, total_size,
+			 sar_pool_offset, peer_data_offset);
+	smr_prefault(prov, mapped_addr, peer_data_offset);
 
 	if (attr->flags & SMR_FLAG_HMEM_ENABLED) {
 		ret = ofi_hmem_host_register(mapped_addr, total_size);
@@ -271,6 +437,8 @@ int smr_create(const struct fi_provider *prov, struct smr_map *map,
 	(*smr)->version = SMR_VERSION;
 
 	(*smr)->flags = attr->flags;
+	if (ep_name->huge_path)
+		(*smr)->flags |= SMR_FLAG_HUGEPAGES;
 #ifdef HAVE_ATOMICS
 	(*smr)->flags |= SMR_FLAG_ATOMIC;
 #endif
@@ -303,14 +471,8 @@ int smr_create(const struct fi_provider *prov, struct smr_map *map,
 	smr_resp_queue_init(smr_resp_queue(*smr), tx_size);
 	smr_freestack_init(smr_inject_pool(*smr), rx_size,
 			sizeof(struct smr_inject_buf));
-	smr_freestack_init(smr_sar_pool(*smr), SMR_MAX_PEERS,
+	smr_freestack_init(smr_sar_pool(*smr), SMR_SAR_BUF_CNT,
 			sizeof(struct smr_sar_buf));
-	for (i = 0; i < SMR_MAX_PEERS; i++) {
-		smr_peer_data(*smr)[i].addr.id = -1;
-		smr_peer_data(*smr)[i].sar_status = 0;
-		smr_peer_data(*smr)[i].name_sent = 0;
-		smr_peer_data(*smr)[i].xpmem.cap = SMR_VMA_CAP_OFF;
-	}
 
 	strncpy((char *) smr_name(*smr), attr->name, total_size - name_offset);
 
@@ -322,17 +484,94 @@ remove:
 	dlist_remove(&ep_name->entry);
 	pthread_mutex_unlock(&ep_list_lock);
 	free(ep_name);
-close:
-	close(fd);
-	shm_unlink(attr->name);
 	return ret;
 }
 
+/* Nodes backing the resident pages of [offset, end), -1 if none */
+static void smr_region_nodes(struct smr_region *smr, size_t offset,
+			     size_t end, int *min_node, int *max_node)
+{
+	size_t page_size = ofi_get_page_size();
+	int node;
+
+	*min_node = *max_node = -1;
+	for (offset = ofi_get_aligned_size(offset, page_size); offset < end;
+	     offset += page_size) {
+		node = ofi_numa_addr_node((char *) smr + offset);
+		if (node < 0)
+			continue;
+		if (*min_node < 0 || node < *min_node)
+			*min_node = node;
+		if (node > *max_node)
+			*max_node = node;
+	}
+}
+
+static void smr_region_report_numa(const struct fi_provider *prov,
+				   struct smr_region *smr)
+{
+	static const char *policy_str[] = {
+		[OFI_NUMA_NONE] = "none",
+		[OFI_NUMA_LOCAL] = "local",
+		[OFI_NUMA_INTERLEAVE] = "interleave",
+	};
+	int queue_min, queue_max, sar_min, sar_max;
+
+	smr_region_nodes(smr, 0, smr->sar_pool_offset, &queue_min, &queue_max);
+	smr_region_nodes(smr, smr->sar_pool_offset, smr->peer_data_offset,
+			 &sar_min, &sar_max);
+	if (queue_min < 0 && sar_min < 0)
+		return;
+
+	FI_INFO(prov, FI_LOG_EP_CTRL,
+		"region %s: numa policy %s, queues and inject pool on "
+		"node(s) %d-%d, sar pool on node(s) %d-%d\n",
+		smr_name(smr), policy_str[smr_env.numa_policy],
+		queue_min, queue_max, sar_min, sar_max);
+}
+
+void smr_region_report(const struct fi_provider *prov, struct smr_region *smr)
+{
+	unsigned char *vec;
+	size_t page_size, pages, resident = 0, i;
+
+	if (!fi_log_enabled(prov, FI_LOG_INFO, FI_LOG_EP_CTRL))
+		return;
+
+	page_size = ofi_get_page_size();
+	pages = ofi_div_ceil(smr->total_size, page_size);
+	vec = malloc(pages);
+	if (vec && !mincore(smr, smr->total_size, vec)) {
+		for (i = 0; i < pages; i++)
+			resident += (vec[i] & 1) * page_size;
+	}
+	free(vec);
+
+	FI_INFO(prov, FI_LOG_EP_CTRL,
+		"region %s: total %zu bytes, resident %zu bytes, "
+		"cmd queue %zu, resp queue %zu, inject pool %zu, "
+		"sar pool %zu, peer data %zu (%d peers)\n",
+		smr_name(smr), smr->total_size, resident,
+		smr->resp_queue_offset - smr->cmd_queue_offset,
+		smr->inject_pool_offset - smr->resp_queue_offset,
+		smr->sar_pool_offset - smr->inject_pool_offset,
+		smr->peer_data_offset - smr->sar_pool_offset,
+		smr->name_offset - smr->peer_data_offset,
+		smr->map ? smr->map->num_peers : 0);
+
+	smr_region_report_numa(prov, smr);
+}
+
 void smr_free(struct smr_region *smr)
 {
+	char path[PATH_MAX];
+
 	if (smr->flags & SMR_FLAG_HMEM_ENABLED)
 		(void) ofi_hmem_host_unregister(smr);
-	shm_unlink(smr_name(smr));
+	if (!(smr->flags & SMR_FLAG_HUGEPAGES))
+		shm_unlink(smr_name(smr));
+	else if (!smr_huge_path(path, sizeof(path), smr_name(smr)))
+		unlink(path);
 	munmap(smr, smr->total_size);
 }
 
@@ -342,20 +581,55 @@ static int smr_match_name(struct dlist_entry *item, const void *args)
 		       (char *) args);
 }
 
+/*
+ * Open a peer's region and read its header.  A region is created either in
+ * the hugetlbfs mount or in /dev/shm, and a file left in /dev/shm by a
+ * process that died must not shadow a live hugetlbfs region, so the
+ * hugetlbfs mount is tried first.  It is only used if the header says the
+ * region is backed by it and its owner is still running, otherwise a stale
+ * hugetlbfs file would shadow a live /dev/shm region the same way.  Header
+ * reads avoid mapping the file, hugetlbfs mappings can only be unmapped in
+ * whole huge pages.
+ */
+static int smr_open_region(const char *name, struct smr_region *hdr)
+{
+	char path[PATH_MAX];
+	int fd;
+
+	if (!smr_huge_path(path, sizeof(path), name)) {
+		fd = open(path, O_RDWR | O_CLOEXEC);
+		if (fd >= 0) {
+			if (pread(fd, hdr, sizeof(*hdr), 0) == sizeof(*hdr) &&
+			    hdr->pid && (hdr->flags & SMR_FLAG_HUGEPAGES) &&
+			    !smr_pid_exited(hdr->pid))
+				return fd;
+			close(fd);
+		}
+	}
+
+	fd = shm_open(name, O_RDWR, S_IRUSR | S_IWUSR);
+	if (fd < 0)
+		return -errno;
+
+	if (pread(fd, hdr, sizeof(*hdr), 0) != sizeof(*hdr)) {
+		close(fd);
+		return -FI_ENOENT;
+	}
+	return fd;
+}
+
 int smr_map_to_region(const struct fi_provider *prov, struct smr_map *map,
 		      int64_t id)
 {
-	struct smr_peer *peer_buf = &map->peers[id];
-	struct smr_region *peer;
+	struct smr_peer *peer_buf = smr_map_peer(map, id);
+	struct smr_region *peer, hdr;
 	struct util_ep *util_ep;
 	struct smr_ep *smr_ep;
 	struct smr_av *av;
 	size_t size;
 	int fd, ret = 0;
-	struct stat sts;
 	struct dlist_entry *entry;
 	const char *name = smr_no_prefix(peer_buf->peer.name);
-	char tmp[SMR_PATH_MAX];
 
 	pthread_mutex_lock(&ep_list_lock);
 	entry = dlist_find_first_match(&ep_name_list, smr_match_name, name);
@@ -371,45 +645,27 @@ int smr_map_to_region(const struct fi_provider *prov, struct smr_map *map,
 	if (peer_buf->region)
 		goto unlock;
 
-	fd = shm_open(name, O_RDWR, S_IRUSR | S_IWUSR);
+	fd = smr_open_region(name, &hdr);
 	if (fd < 0) {
-		ret = -errno;
+		ret = fd;
 		FI_WARN_ONCE(prov, FI_LOG_AV,
-			     "shm_open error: name %s errno %d\n", name, errno);
+			     "shm_open error: name %s errno %d\n", name, -fd);
 		goto unlock;
 	}
 
-	memset(tmp, 0, sizeof(tmp));
-	snprintf(tmp, sizeof(tmp), "%s%s", SMR_DIR, name);
-	if (stat(tmp, &sts) == -1) {
-		ret = -errno;
-		goto out;
-	}
-
-	if (sts.st_size < sizeof(*peer)) {
+	if (!hdr.pid) {
+		FI_WARN(prov, FI_LOG_AV, "peer not initialized\n");
 		ret = -FI_ENOENT;
 		goto out;
 	}
 
-	peer = mmap(NULL, sizeof(*peer), PROT_READ | PROT_WRITE,
-		    MAP_SHARED, fd, 0);
+	size = hdr.total_size;
+	peer = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
 	if (peer == MAP_FAILED) {
 		FI_WARN(prov, FI_LOG_AV, "mmap error\n");
 		ret = -errno;
 		goto out;
 	}
-
-	if (!peer->pid) {
-		FI_WARN(prov, FI_LOG_AV, "peer not initialized\n");
-		munmap(peer, sizeof(*peer));
-		ret = -FI_ENOENT;
-		goto out;
-	}
-
-	size = peer->total_size;
-	munmap(peer, sizeof(*peer));
-
-	peer = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
 	peer_buf->region = peer;
 
 	if (map->flags & SMR_FLAG_HMEM_ENABLED) {
@@ -449,10 +705,14 @@ void smr_map_to_endpoint(struct smr_region *region, int64_t id)
 	struct smr_peer_data *local_peers;
 
 	peer_smr = smr_peer_region(region, id);
-	if (region->map->peers[id].peer.id < 0 || !peer_smr)
+	if (smr_map_peer(region->map, id)->peer.id < 0 || !peer_smr)
 	    return;
 
 	local_peers = smr_peer_data(region);
+	local_peers[id].tx_msg_cnt = 0;
+	local_peers[id].rx_msg_cnt = 0;
+	ofi_atomic_initialize64(&local_peers[id].landing.state,
+				SMR_LANDING_EMPTY);
 
 	if ((region != peer_smr && region->cma_cap_peer == SMR_VMA_CAP_NA) ||
 	    (region == peer_smr && region->cma_cap_self == SMR_VMA_CAP_NA))
@@ -486,15 +746,15 @@ void smr_unmap_from_endpoint(struct smr_region *region, int64_t id)
 	int64_t peer_id;
 
 	local_peers = smr_peer_data(region);
-	if (region->map->peers[id].peer.id < 0)
+	if (smr_map_peer(region->map, id)->peer.id < 0)
 		return;
 
 	peer_smr = smr_peer_region(region, id);
-	peer_id = smr_peer_data(region)[id].addr.id;
+	peer_id = smr_peer_id(region, id);
 
 	peer_peers = smr_peer_data(peer_smr);
 
-	peer_peers[peer_id].addr.id = -1;
+	smr_set_peer_id(peer_smr, peer_id, -1);
 	peer_peers[peer_id].name_sent = 0;
 
 	ofi_xpmem_release(&local_peers[peer_id].xpmem);
@@ -503,15 +763,38 @@ void smr_unmap_from_endpoint(struct smr_region *region, int64_t id)
 void smr_exchange_all_peers(struct smr_region *region)
 {
 	int64_t i;
-	for (i = 0; i < SMR_MAX_PEERS; i++)
+	for (i = 0; i < smr_map_size(region->map); i++)
 		smr_map_to_endpoint(region, i);
 }
 
+static int smr_map_grow(struct smr_map *map)
+{
+	struct smr_peer *chunk;
+	int i;
+
+	if (map->num_chunks == map->max_chunks)
+		return -FI_ENOMEM;
+
+	chunk = calloc(SMR_PEER_CHUNK_SIZE, sizeof(*chunk));
+	if (!chunk)
+		return -FI_ENOMEM;
+
+	for (i = 0; i < SMR_PEER_CHUNK_SIZE; i++) {
+		chunk[i].peer.id = -1;
+		chunk[i].fiaddr = FI_ADDR_NOTAVAIL;
+	}
+
+	map->cur_id = smr_map_size(map);
+	map->peers[map->num_chunks++] = chunk;
+	return 0;
+}
+
 int smr_map_add(const struct fi_provider *prov, struct smr_map *map,
 		const char *name, int64_t *id)
 {
 	struct ofi_rbnode *node;
-	int tries = 0, ret = 0;
+	struct smr_peer *peer;
+	int ret;
 
 	ofi_spin_lock(&map->lock);
 	ret = ofi_rbmap_insert(&map->rbmap, (void *) name,
@@ -519,62 +802,71 @@ int smr_map_add(const struct fi_provider *prov, struct smr_map *map,
 	if (ret) {
 		assert(ret == -FI_EALREADY);
 		*id = (intptr_t) node->data;
+		ret = FI_SUCCESS;
 		goto out;
 	}
 
-	while (map->peers[map->cur_id].peer.id != -1 && tries < SMR_MAX_PEERS) {
-		if (++map->cur_id == SMR_MAX_PEERS)
+	if (map->num_peers == smr_map_size(map)) {
+		ret = smr_map_grow(map);
+		if (ret) {
+			FI_WARN(prov, FI_LOG_AV,
+				"peer map full (%d peers)\n", map->num_peers);
+			ofi_rbmap_delete(&map->rbmap, node);
+			*id = -1;
+			goto out;
+		}
+	}
+
+	while (smr_map_peer(map, map->cur_id)->peer.id != -1) {
+		if (++map->cur_id == smr_map_size(map))
 			map->cur_id = 0;
-		tries++;
 	}
 
-	assert(map->cur_id < SMR_MAX_PEERS && tries < SMR_MAX_PEERS);
 	*id = map->cur_id;
-	if (++map->cur_id == SMR_MAX_PEERS)
+	if (++map->cur_id == smr_map_size(map))
 		map->cur_id = 0;
 	node->data = (void *) (intptr_t) *id;
-	strncpy(map->peers[*id].peer.name, name, SMR_NAME_MAX);
-	map->peers[*id].peer.name[SMR_NAME_MAX - 1] = '\0';
-	map->peers[*id].region = NULL;
+	peer = smr_map_peer(map, *id);
+	strncpy(peer->peer.name, name, SMR_NAME_MAX);
+	peer->peer.name[SMR_NAME_MAX - 1] = '\0';
+	peer->region = NULL;
 	map->num_peers++;
-	map->peers[*id].peer.id = *id;
+	peer->peer.id = *id;
 
 out:
 	ofi_spin_unlock(&map->lock);
-	return FI_SUCCESS;
+	return ret;
 }
 
 void smr_map_del(struct smr_map *map, int64_t id)
 {
+	struct smr_peer *peer = smr_map_peer(map, id);
 	struct dlist_entry *entry;
 
-	assert(id >= 0 && id < SMR_MAX_PEERS);
-
 	pthread_mutex_lock(&ep_list_lock);
 	entry = dlist_find_first_match(&ep_name_list, smr_match_name,
-				       smr_no_prefix(map->peers[id].peer.name));
+				       smr_no_prefix(peer->peer.name));
 	pthread_mutex_unlock(&ep_list_lock);
 
 	ofi_spin_lock(&map->lock);
-	(void) ofi_rbmap_find_delete(&map->rbmap,
-				     (void *) map->peers[id].peer.name);
+	(void) ofi_rbmap_find_delete(&map->rbmap, (void *) peer->peer.name);
 
-	map->peers[id].fiaddr = FI_ADDR_NOTAVAIL;
-	map->peers[id].peer.id = -1;
+	peer->fiaddr = FI_ADDR_NOTAVAIL;
+	peer->peer.id = -1;
 	map->num_peers--;
 
-	if (!map->peers[id].region)
+	if (!peer->region)
 		goto unlock;
 
 	if (!entry) {
 		if (map->flags & SMR_FLAG_HMEM_ENABLED) {
-			if (map->peers[id].pid_fd != -1)
-				close(map->peers[id].pid_fd);
+			if (peer->pid_fd != -1)
+				close(peer->pid_fd);
 
-			(void) ofi_hmem_host_unregister(map->peers[id].region);
+			(void) ofi_hmem_host_unregister(peer->region);
 		}
-		munmap(map->peers[id].region, map->peers[id].region->total_size);
-		map->peers[id].region = NULL;
+		munmap(peer->region, peer->region->total_size);
+		peer->region = NULL;
 	}
 unlock:
 	ofi_spin_unlock(&map->lock);
@@ -582,8 +874,8 @@ unlock:
 
 struct smr_region *smr_map_get(struct smr_map *map, int64_t id)
 {
-	if (id < 0 || id >= SMR_MAX_PEERS)
+	if (id < 0 || id >= smr_map_size(map))
 		return NULL;
 
-	return map->peers[id].region;
+	return smr_map_peer(map, id)->region;
 }
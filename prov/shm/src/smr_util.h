@@ -54,14 +54,17 @@
 extern "C" {
 #endif
 
-#define SMR_VERSION	8
+#define SMR_VERSION	10
 
 #define SMR_FLAG_ATOMIC	(1 << 0)
 #define SMR_FLAG_DEBUG	(1 << 1)
 #define SMR_FLAG_IPC_SOCK (1 << 2)
 #define SMR_FLAG_HMEM_ENABLED (1 << 3)
+#define SMR_FLAG_DIRECT_LANDING (1 << 4)
+#define SMR_FLAG_HUGEPAGES (1 << 5)
 
 #define SMR_CMD_SIZE		256	/* align with 64-byte cache line */
+#define SMR_IOV_LIMIT		4
 
 /* SMR op_src: Specifies data source location */
 enum {
@@ -71,6 +74,7 @@ enum {
 	smr_src_mmap,	/* mmap-based fallback protocol */
 	smr_src_sar,	/* segmentation fallback protocol */
 	smr_src_ipc,	/* device IPC handle protocol */
+	smr_src_direct,	/* written to a published receive, see smr_landing */
 	smr_src_max,
 };
 
@@ -98,7 +102,8 @@ enum {
  * 	op - type of op (ex. ofi_op_msg, defined in ofi_proto.h)
  * 	op_src - msg src (ex. smr_src_inline, defined above)
  * 	op_flags - operation flags (ex. SMR_REMOTE_CQ_DATA, defined above)
- * 	src_data - src of additional op data (inject offset / resp offset)
+ * 	src_data - src of additional op data (inject offset / resp offset,
+ * 		   or the negated copy status for smr_src_direct)
  * 	data - remote CQ data
  */
 struct smr_msg_hdr {
@@ -170,19 +175,57 @@ struct smr_cmd {
 #define SMR_SOCK_NAME_MAX sizeof(((struct sockaddr_un *)0)->sun_path)
 
 /* On next version update remove this struct to make id a bool in the smr_peer
- * remove name from smr_peer_data because it is unused.
  */
 struct smr_addr {
 	char		name[SMR_NAME_MAX];
 	int64_t		id;
 };
 
+/*
+ * Direct landing: the region owner may publish the buffer of a posted receive
+ * for the next message from one peer.  The peer claims it by moving state
+ * from POSTED to CLAIMED, writes a small message straight into the buffer
+ * with CMA or XPMEM and sends an smr_src_direct command, which saves the copy
+ * through the command or inject buffer.  The bits of state above the
+ * SMR_LANDING_STATE_MASK count publications, so a claim based on a stale
+ * read fails.  seq is the number of messages the owner had taken from the
+ * peer when publishing.  The peer only claims the receive if it has sent
+ * exactly that many, so a direct message never overtakes a queued one.
+ */
+enum {
+	SMR_LANDING_EMPTY,
+	SMR_LANDING_POSTED,
+	SMR_LANDING_CLAIMED,
+};
+
+#define SMR_LANDING_STATE_MASK	0x3
+#define SMR_LANDING_GEN_INC	(SMR_LANDING_STATE_MASK + 1)
+
+struct smr_landing {
+	ofi_atomic64_t		state;
+	uint32_t		op;
+	uint32_t		iov_count;
+	uint64_t		seq;
+	uint64_t		tag;
+	uint64_t		ignore;
+	struct iovec		iov[SMR_IOV_LIMIT];
+};
+
+/*
+ * Per-peer state in a region, indexed by the region owner's id for the peer.
+ * All fields are valid when zeroed, so pages of the peer data area are only
+ * backed once a peer with an id in that range is used.  The peer's id for
+ * the region owner is stored biased by one (see smr_peer_id).
+ */
 struct smr_peer_data {
-	struct smr_addr		addr;
+	int64_t			id;
 	uint32_t		sar_status;
 	uint16_t		name_sent;
 	uint16_t		ipc_valid;
 	struct ofi_xpmem_client xpmem;
+	uint64_t		tx_msg_cnt;
+	uint64_t		rx_msg_cnt;
+	struct smr_landing	landing;
 };
 
 extern struct dlist_entry ep_name_list;
@@ -194,6 +237,7 @@ struct smr_region;
 
 struct smr_ep_name {
 	char name[SMR_NAME_MAX];
+	char *huge_path;	/* backing file if not in SMR_DIR */
 	struct smr_region *region;
 	struct dlist_entry entry;
 };
@@ -212,17 +256,48 @@ struct smr_peer {
 	int			pid_fd;
 };
 
-#define SMR_MAX_PEERS	256
+/*
+ * The peer map grows on insert in chunks of SMR_PEER_CHUNK_SIZE entries.
+ * Chunks are never moved or freed until the map is destroyed, so lookups
+ * do not need the map lock.  The map is limited to max_chunks, derived
+ * from the AV count, which also sizes the peer data area of the regions
+ * using the map.  At least SMR_DEF_PEERS are always supported.
+ */
+#define SMR_PEER_CHUNK_BITS	8
+#define SMR_PEER_CHUNK_SIZE	(1 << SMR_PEER_CHUNK_BITS)
+#define SMR_MAX_PEER_CHUNKS	256
+#define SMR_MAX_PEERS		(SMR_MAX_PEER_CHUNKS * SMR_PEER_CHUNK_SIZE)
+#define SMR_DEF_PEERS		SMR_PEER_CHUNK_SIZE
+#define SMR_SAR_BUF_CNT		256
 
 struct smr_map {
 	ofi_spin_t		lock;
 	int64_t			cur_id;
 	int 			num_peers;
+	int			num_chunks;
+	int			max_chunks;
 	uint16_t		flags;
 	struct ofi_rbmap	rbmap;
-	struct smr_peer		peers[SMR_MAX_PEERS];
+	struct smr_peer		*peers[SMR_MAX_PEER_CHUNKS];
 };
 
+static inline struct smr_peer *smr_map_peer(struct smr_map *map, int64_t id)
+{
+	assert(id >= 0 && (id >> SMR_PEER_CHUNK_BITS) < map->num_chunks);
+	return &map->peers[id >> SMR_PEER_CHUNK_BITS]
+			  [id & (SMR_PEER_CHUNK_SIZE - 1)];
+}
+
+static inline int64_t smr_map_size(struct smr_map *map)
+{
+	return (int64_t) map->num_chunks * SMR_PEER_CHUNK_SIZE;
+}
+
+static inline size_t smr_map_max_peers(struct smr_map *map)
+{
+	return (size_t) map->max_chunks * SMR_PEER_CHUNK_SIZE;
+}
+
 struct smr_region {
 	uint8_t		version;
 	uint8_t		resv;
@@ -302,7 +377,7 @@ OFI_DECLARE_ATOMIC_Q(struct smr_cmd_entry, smr_cmd_queue);
 
 static inline struct smr_region *smr_peer_region(struct smr_region *smr, int i)
 {
-	return smr->map->peers[i].region;
+	return smr_map_peer(smr->map, i)->region;
 }
 static inline struct smr_cmd_queue *smr_cmd_queue(struct smr_region *smr)
 {
@@ -320,6 +395,15 @@ static inline struct smr_peer_data *smr_peer_data(struct smr_region *smr)
 {
 	return (struct smr_peer_data *) ((char *) smr + smr->peer_data_offset);
 }
+static inline int64_t smr_peer_id(struct smr_region *smr, int64_t id)
+{
+	return smr_peer_data(smr)[id].id - 1;
+}
+static inline void smr_set_peer_id(struct smr_region *smr, int64_t id,
+				   int64_t peer_id)
+{
+	smr_peer_data(smr)[id].id = peer_id + 1;
+}
 static inline struct smr_freestack *smr_sar_pool(struct smr_region *smr)
 {
 	return (struct smr_freestack *) ((char *) smr + smr->sar_pool_offset);
@@ -347,12 +431,15 @@ struct smr_attr {
 };
 
 size_t smr_calculate_size_offsets(size_t tx_count, size_t rx_count,
+				  size_t peer_count,
 				  size_t *cmd_offset, size_t *resp_offset,
 				  size_t *inject_offset, size_t *sar_offset,
 				  size_t *peer_offset, size_t *name_offset,
 				  size_t *sock_offset);
 void	smr_cma_check(struct smr_region *region, struct smr_region *peer_region);
 void	smr_cleanup(void);
+void	smr_region_report(const struct fi_provider *prov,
+			  struct smr_region *smr);
 int	smr_map_to_region(const struct fi_provider *prov, struct smr_map *map,
 			  int64_t id);
 void	smr_map_to_endpoint(struct smr_region *region, int64_t id);
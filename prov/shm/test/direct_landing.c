@@ -0,0 +1,589 @@
+/*
+ * Copyright (c) 2026 Intel Corporation.  All rights reserved.
+ *
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+ * Test for the shm direct landing protocol, forced on with
+ * FI_SHM_DIRECT_LANDING.  The receiver publishes the receive that the next
+ * message from its last sender will match, and that sender writes small
+ * messages straight into it.  Messages must still land in the receive that
+ * plain matching would give them: in posting order, across sources, with
+ * tags that do not fit the published receive, behind unexpected messages,
+ * and in multi-receive buffers.  Senders are separate processes, since shm
+ * only uses CMA between processes, and send when the receiver tells them
+ * to.  Exits 77 (skipped) if shm is not available.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+#include <rdma/fabric.h>
+#include <rdma/fi_domain.h>
+#include <rdma/fi_endpoint.h>
+#include <rdma/fi_tagged.h>
+#include <rdma/fi_cm.h>
+#include <rdma/fi_errno.h>
+
+enum {
+	TEST_EP_CNT	= 3,
+	TEST_SLOTS	= 8,
+	TEST_INLINE	= 64,	/* smr_src_inline */
+	TEST_INJECT	= 300,	/* smr_src_inject */
+	TEST_MULTI_SIZE	= 1024,
+	TEST_MIN_MULTI	= 256,
+	TEST_POLL_CNT	= 1000000,
+	TEST_DRAIN_CNT	= 1000,
+};
+
+/* Sent to a sender process, which replies with one byte once it is sent */
+struct test_cmd {
+	uint64_t	tag;
+	uint32_t	size;
+	char		fill;
+	bool		tagged;
+	bool		quit;
+};
+
+static struct fid_fabric *fabric;
+static struct fid_domain *domain;
+static struct fid_av *av;
+static struct fid_cq *cq;
+static struct fid_ep *ep;
+static fi_addr_t addr[TEST_EP_CNT];
+static int cmd_fd[TEST_EP_CNT], ack_fd[TEST_EP_CNT];
+static pid_t pid[TEST_EP_CNT];
+static char rx_buf[TEST_SLOTS][TEST_MULTI_SIZE];
+static int errors;
+
+#define test_error(fmt, ...)						\
+	do {								\
+		fprintf(stderr, "%s:%d: " fmt "\n", __func__, __LINE__, \
+			##__VA_ARGS__);					\
+		errors++;						\
+	} while (0)
+
+static int test_setup(void)
+{
+	struct fi_info *hints, *info;
+	struct fi_av_attr av_attr = { .type = FI_AV_TABLE };
+	struct fi_cq_attr cq_attr = { .format = FI_CQ_FORMAT_TAGGED };
+	int ret;
+
+	hints = fi_allocinfo();
+	if (!hints)
+		return -FI_ENOMEM;
+
+	hints->ep_attr->type = FI_EP_RDM;
+	hints->caps = FI_MSG | FI_TAGGED | FI_DIRECTED_RECV | FI_MULTI_RECV;
+	hints->fabric_attr->prov_name = strdup("shm");
+
+	ret = fi_getinfo(FI_VERSION(1, 18), NULL, NULL, 0, hints, &info);
+	fi_freeinfo(hints);
+	if (ret)
+		return ret;
+
+	ret = fi_fabric(info->fabric_attr, &fabric, NULL);
+	if (ret)
+		goto out;
+	ret = fi_domain(fabric, info, &domain, NULL);
+	if (ret)
+		goto out;
+	ret = fi_av_open(domain, &av_attr, &av, NULL);
+	if (ret)
+		goto out;
+	ret = fi_cq_open(domain, &cq_attr, &cq, NULL);
+	if (ret)
+		goto out;
+	ret = fi_endpoint(domain, info, &ep, NULL);
+	if (ret)
+		goto out;
+	ret = fi_ep_bind(ep, &av->fid, 0);
+	if (ret)
+		goto out;
+	ret = fi_ep_bind(ep, &cq->fid, FI_TRANSMIT | FI_RECV);
+	if (ret)
+		goto out;
+	ret = fi_enable(ep);
+out:
+	fi_freeinfo(info);
+	return ret;
+}
+
+static void test_cleanup(void)
+{
+	if (ep)
+		fi_close(&ep->fid);
+	if (cq)
+		fi_close(&cq->fid);
+	if (av)
+		fi_close(&av->fid);
+	if (domain)
+		fi_close(&domain->fid);
+	if (fabric)
+		fi_close(&fabric->fid);
+}
+
+/* An empty name reports a failed setup */
+static int test_put_name(int fd, int ret)
+{
+	char name[FI_NAME_MAX];
+	size_t len = sizeof(name);
+
+	if (ret || fi_getname(&ep->fid, name, &len))
+		len = 0;
+	if (write(fd, &len, sizeof(len)) != sizeof(len) ||
+	    write(fd, name, len) != (ssize_t) len)
+		return -FI_EIO;
+	return len ? 0 : -FI_EOTHER;
+}
+
+static int test_get_name(int fd, fi_addr_t *fi_addr)
+{
+	char name[FI_NAME_MAX];
+	size_t len;
+
+	if (read(fd, &len, sizeof(len)) != sizeof(len) || !len ||
+	    len > sizeof(name) || read(fd, name, len) != (ssize_t) len)
+		return -FI_EOTHER;
+	return fi_av_insert(av, name, 1, fi_addr, 0, NULL) == 1 ?
+	       0 : -FI_EINVAL;
+}
+
+/* Run a sender process, returns its exit status */
+static int test_sender(int cmd, int ack)
+{
+	struct fi_cq_tagged_entry comp;
+	char buf[TEST_MULTI_SIZE];
+	struct test_cmd tcmd;
+	ssize_t ret;
+	int status = EXIT_FAILURE;
+
+	ret = test_setup();
+	if (test_put_name(ack, ret) || test_get_name(cmd, &addr[0]))
+		goto out;
+
+	while (read(cmd, &tcmd, sizeof(tcmd)) == sizeof(tcmd) && !tcmd.quit) {
+		memset(buf, tcmd.fill, tcmd.size);
+		do {
+			if (tcmd.tagged)
+				ret = fi_tsend(ep, buf, tcmd.size, NULL,
+					       addr[0], tcmd.tag, NULL);
+			else
+				ret = fi_send(ep, buf, tcmd.size, NULL,
+					      addr[0], NULL);
+			if (ret == -FI_EAGAIN)
+				(void) fi_cq_read(cq, NULL, 0);
+		} while (ret == -FI_EAGAIN);
+		if (ret)
+			goto out;
+
+		do {
+			ret = fi_cq_read(cq, &comp, 1);
+		} while (ret == -FI_EAGAIN);
+		if (ret != 1 || write(ack, "", 1) != 1)
+			goto out;
+	}
+	status = EXIT_SUCCESS;
+out:
+	test_cleanup();
+	return status;
+}
+
+/* Read one completion, returns 1 for a receive, 0 otherwise */
+static int test_poll(struct fi_cq_tagged_entry *comp)
+{
+	struct fi_cq_err_entry err_entry = { 0 };
+	ssize_t ret;
+
+	ret = fi_cq_read(cq, comp, 1);
+	if (ret == 1)
+		return comp->flags & (FI_RECV | FI_MULTI_RECV) ? 1 : 0;
+	if (ret == -FI_EAVAIL) {
+		fi_cq_readerr(cq, &err_entry, 0);
+		test_error("completion error %d", err_entry.err);
+		return -FI_EIO;
+	}
+	if (ret != -FI_EAGAIN) {
+		test_error("fi_cq_read: %zd", ret);
+		return (int) ret;
+	}
+	return 0;
+}
+
+static int test_wait_recv(struct fi_cq_tagged_entry *comp)
+{
+	int i, ret;
+
+	for (i = 0; i < TEST_POLL_CNT; i++) {
+		ret = test_poll(comp);
+		if (ret)
+			return ret == 1 ? 0 : ret;
+	}
+	test_error("timed out");
+	return -FI_ETIMEDOUT;
+}
+
+/* Progress with no matching receive posted, nothing may complete */
+static void test_drain(void)
+{
+	struct fi_cq_tagged_entry comp;
+	int i;
+
+	for (i = 0; i < TEST_DRAIN_CNT; i++) {
+		if (test_poll(&comp) == 1)
+			test_error("unexpected receive completion");
+	}
+}
+
+/*
+ * Have sender src send a message and wait until it is sent.  The receiver
+ * progresses meanwhile, without reading completions, so that the sender
+ * can connect.
+ */
+static void test_send(int src, uint64_t tag, char fill, size_t size,
+		      bool tagged)
+{
+	struct test_cmd tcmd = {
+		.tag = tag,
+		.size = size,
+		.fill = fill,
+		.tagged = tagged,
+	};
+	struct pollfd pfd = {
+		.fd = ack_fd[src],
+		.events = POLLIN,
+	};
+	char ack;
+
+	if (write(cmd_fd[src], &tcmd, sizeof(tcmd)) != sizeof(tcmd)) {
+		test_error("sender %d is gone", src);
+		return;
+	}
+	while (!poll(&pfd, 1, 0))
+		(void) fi_cq_read(cq, NULL, 0);
+	if (read(ack_fd[src], &ack, 1) != 1)
+		test_error("sender %d failed to send", src);
+}
+
+static void test_post(int slot, fi_addr_t src, uint64_t tag, bool tagged)
+{
+	ssize_t ret;
+
+	memset(rx_buf[slot], 0, sizeof(rx_buf[slot]));
+	if (tagged)
+		ret = fi_trecv(ep, rx_buf[slot], TEST_INJECT, NULL, src,
+			       tag, 0, &rx_buf[slot]);
+	else
+		ret = fi_recv(ep, rx_buf[slot], TEST_INJECT, NULL, src,
+			      &rx_buf[slot]);
+	if (ret)
+		test_error("post: %zd", ret);
+}
+
+/* The next receive must complete into slot with size bytes of fill */
+static void test_expect(int slot, char fill, size_t size)
+{
+	struct fi_cq_tagged_entry comp;
+
+	if (test_wait_recv(&comp))
+		return;
+
+	if (comp.op_context != &rx_buf[slot]) {
+		test_error("message %c matched the wrong receive", fill);
+		return;
+	}
+	if (comp.len != size)
+		test_error("message %c completed with len %zu, expected %zu",
+			   fill, comp.len, size);
+	if (rx_buf[slot][0] != fill || rx_buf[slot][size - 1] != fill ||
+	    rx_buf[slot][size])
+		test_error("slot %d holds %c, expected %c", slot,
+			   rx_buf[slot][0], fill);
+}
+
+/*
+ * Messages from one source fill wildcard receives in order, both when each
+ * one is received before the next is sent, which lets the receiver publish
+ * the next receive, and when they are sent back to back.
+ */
+static void test_stream(bool tagged, size_t size)
+{
+	int i;
+
+	for (i = 0; i < TEST_SLOTS; i++)
+		test_post(i, FI_ADDR_UNSPEC, 1, tagged);
+	for (i = 0; i < TEST_SLOTS; i++) {
+		test_send(1, 1, 'a' + i, size, tagged);
+		test_expect(i, 'a' + i, size);
+	}
+
+	for (i = 0; i < TEST_SLOTS; i++)
+		test_post(i, FI_ADDR_UNSPEC, 1, tagged);
+	for (i = 0; i < TEST_SLOTS; i++)
+		test_send(1, 1, 'a' + i, size, tagged);
+	for (i = 0; i < TEST_SLOTS; i++)
+		test_expect(i, 'a' + i, size);
+}
+
+/*
+ * A message from another source takes back the receive published for the
+ * last sender, and must still match the oldest receive that accepts it.
+ */
+static void test_sources(bool tagged)
+{
+	static const int src[TEST_SLOTS] = { 1, 2, 1, 1, 2, 2, 1, 2 };
+	int i;
+
+	for (i = 0; i < TEST_SLOTS; i++)
+		test_post(i, FI_ADDR_UNSPEC, 1, tagged);
+	for (i = 0; i < TEST_SLOTS; i++) {
+		test_send(src[i], 1, 'a' + i, TEST_INLINE, tagged);
+		test_expect(i, 'a' + i, TEST_INLINE);
+	}
+
+	/* the receive published for source 1 is the oldest one for 2 */
+	test_post(0, addr[1], 1, tagged);
+	test_post(1, FI_ADDR_UNSPEC, 1, tagged);
+	test_post(2, addr[1], 1, tagged);
+	test_send(1, 1, 'i', TEST_INLINE, tagged);
+	test_expect(0, 'i', TEST_INLINE);
+	test_send(2, 1, 'j', TEST_INLINE, tagged);
+	test_expect(1, 'j', TEST_INLINE);
+	test_send(1, 1, 'k', TEST_INLINE, tagged);
+	test_expect(2, 'k', TEST_INLINE);
+}
+
+/*
+ * A message whose tag does not fit the published receive goes through the
+ * unexpected path, and the receive stays available for the next message.
+ */
+static void test_tag_mismatch(void)
+{
+	test_post(0, FI_ADDR_UNSPEC, 1, true);
+	test_post(1, FI_ADDR_UNSPEC, 2, true);
+	test_send(1, 1, 'a', TEST_INLINE, true);
+	test_expect(0, 'a', TEST_INLINE);
+	test_send(1, 3, 'b', TEST_INLINE, true);
+	test_drain();
+	test_send(1, 2, 'c', TEST_INLINE, true);
+	test_expect(1, 'c', TEST_INLINE);
+	test_post(2, FI_ADDR_UNSPEC, 3, true);
+	test_expect(2, 'b', TEST_INLINE);
+}
+
+/* Unexpected messages are matched ahead of later, directly placed ones */
+static void test_unexp(bool tagged)
+{
+	test_send(1, 1, 'a', TEST_INLINE, tagged);
+	test_send(1, 1, 'b', TEST_INJECT, tagged);
+	test_drain();
+	test_post(0, FI_ADDR_UNSPEC, 1, tagged);
+	test_post(1, FI_ADDR_UNSPEC, 1, tagged);
+	test_post(2, FI_ADDR_UNSPEC, 1, tagged);
+	test_expect(0, 'a', TEST_INLINE);
+	test_expect(1, 'b', TEST_INJECT);
+	test_send(1, 1, 'c', TEST_INLINE, tagged);
+	test_expect(2, 'c', TEST_INLINE);
+
+	test_send(1, 1, 'd', TEST_INLINE, tagged);
+	test_drain();
+	test_post(0, FI_ADDR_UNSPEC, 1, tagged);
+	test_post(1, FI_ADDR_UNSPEC, 1, tagged);
+	test_expect(0, 'd', TEST_INLINE);
+	test_send(1, 1, 'e', TEST_INLINE, tagged);
+	test_expect(1, 'e', TEST_INLINE);
+}
+
+/*
+ * Messages placed directly in a multi-receive buffer land back to back,
+ * and the buffer is released once less than FI_OPT_MIN_MULTI_RECV is left.
+ */
+static void test_multi_recv(void)
+{
+	struct fi_cq_tagged_entry comp;
+	struct iovec iov = {
+		.iov_base = rx_buf[0],
+		.iov_len = TEST_MULTI_SIZE,
+	};
+	struct fi_msg msg = {
+		.msg_iov = &iov,
+		.iov_count = 1,
+		.addr = FI_ADDR_UNSPEC,
+		.context = &rx_buf[0],
+	};
+	size_t offset = 0;
+	bool released = false;
+	int cnt;
+
+	memset(rx_buf[0], 0, sizeof(rx_buf[0]));
+	if (fi_recvmsg(ep, &msg, FI_MULTI_RECV)) {
+		test_error("fi_recvmsg failed");
+		return;
+	}
+
+	for (cnt = 0; cnt < TEST_MULTI_SIZE / TEST_INJECT; cnt++) {
+		if (released) {
+			test_error("buffer released after %d messages", cnt);
+			return;
+		}
+
+		test_send(1, 0, 'a' + cnt, TEST_INJECT, false);
+		if (test_wait_recv(&comp))
+			return;
+		if (comp.op_context != &rx_buf[0] || !(comp.flags & FI_RECV)) {
+			test_error("message %d not received in the buffer", cnt);
+			return;
+		}
+
+		if (comp.buf != rx_buf[0] + offset || comp.len != TEST_INJECT)
+			test_error("message %d at offset %td len %zu", cnt,
+				   (char *) comp.buf - rx_buf[0], comp.len);
+		else if (rx_buf[0][offset] != 'a' + cnt ||
+			 rx_buf[0][offset + TEST_INJECT - 1] != 'a' + cnt)
+			test_error("message %d holds %c", cnt,
+				   rx_buf[0][offset]);
+		offset += TEST_INJECT;
+		released = comp.flags & FI_MULTI_RECV;
+	}
+
+	if (!released && (test_wait_recv(&comp) ||
+			  comp.op_context != &rx_buf[0] ||
+			  !(comp.flags & FI_MULTI_RECV)))
+		test_error("buffer not released with %zu bytes left",
+			   TEST_MULTI_SIZE - offset);
+
+	/* later messages go to the next receive */
+	test_post(1, FI_ADDR_UNSPEC, 0, false);
+	test_send(1, 0, 'z', TEST_INLINE, false);
+	test_expect(1, 'z', TEST_INLINE);
+}
+
+/* Fork the senders, they are gone again when this returns */
+static int test_run(void)
+{
+	size_t min_multi = TEST_MIN_MULTI;
+	int cmd[2], ack[2];
+	int i, ret;
+
+	for (i = 1; i < TEST_EP_CNT; i++) {
+		if (pipe(cmd) || pipe(ack))
+			return -FI_EOTHER;
+
+		pid[i] = fork();
+		if (pid[i] < 0)
+			return -FI_EOTHER;
+		if (!pid[i]) {
+			close(cmd[1]);
+			close(ack[0]);
+			exit(test_sender(cmd[0], ack[1]));
+		}
+		close(cmd[0]);
+		close(ack[1]);
+		cmd_fd[i] = cmd[1];
+		ack_fd[i] = ack[0];
+	}
+
+	ret = test_setup();
+	if (ret)
+		return ret;
+
+	for (i = 1; i < TEST_EP_CNT; i++) {
+		ret = test_get_name(ack_fd[i], &addr[i]);
+		if (ret)
+			return ret;
+		ret = test_put_name(cmd_fd[i], 0);
+		if (ret)
+			return ret;
+	}
+
+	/* shm sets up its receive context, and this option, on enable */
+	ret = fi_setopt(&ep->fid, FI_OPT_ENDPOINT, FI_OPT_MIN_MULTI_RECV,
+			&min_multi, sizeof(min_multi));
+	if (ret)
+		return ret;
+
+	test_stream(true, TEST_INLINE);
+	test_stream(false, TEST_INLINE);
+	test_stream(true, TEST_INJECT);
+	test_stream(false, TEST_INJECT);
+	test_sources(true);
+	test_sources(false);
+	test_tag_mismatch();
+	test_unexp(true);
+	test_unexp(false);
+	test_multi_recv();
+	return 0;
+}
+
+int main(void)
+{
+	struct test_cmd quit = { .quit = true };
+	int i, ret, status;
+
+	setenv("FI_SHM_DIRECT_LANDING", "1", 1);
+	signal(SIGPIPE, SIG_IGN);
+
+	ret = test_run();
+
+	for (i = 1; i < TEST_EP_CNT; i++) {
+		if (pid[i] <= 0)
+			continue;
+		if (write(cmd_fd[i], &quit, sizeof(quit)) != sizeof(quit))
+			close(cmd_fd[i]);
+		if (waitpid(pid[i], &status, 0) != pid[i] ||
+		    !WIFEXITED(status) || WEXITSTATUS(status)) {
+			if (!ret)
+				test_error("sender %d failed", i);
+		}
+	}
+	test_cleanup();
+
+	if (ret == -FI_ENODATA) {
+		printf("SKIPPED: shm provider not available\n");
+		return 77;
+	}
+	if (ret) {
+		fprintf(stderr, "setup: %s\n", fi_strerror(-ret));
+		return EXIT_FAILURE;
+	}
+
+	printf("%s: %d errors\n", errors ? "FAILED" : "PASSED", errors);
+
+	return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -115,6 +115,13 @@ extern size_t xnet_zerocopy_size;
 extern int xnet_trace_msg;
 extern int xnet_disable_autoprog;
 extern int xnet_io_uring;
+extern int xnet_uring_rbuf_cnt;
+extern int xnet_uring_ep_rbuf_cnt;
+extern int xnet_uring_fixed_cnt;
+extern size_t xnet_tx_coalesce_size;
+extern int xnet_tx_coalesce_usec;
+extern int xnet_busy_poll;
+extern size_t xnet_uring_rbuf_size;
 extern int xnet_max_saved;
 extern size_t xnet_max_saved_size;
 extern size_t xnet_max_inject;
@@ -243,6 +250,9 @@ struct xnet_ep {
 	OFI_DBG_VAR(uint8_t, rx_id)
 
 	struct dlist_entry	unexp_entry;
+	struct dlist_entry	rbuf_wait_entry;
+	/* stops the multishot receive at progress::rbuf_ep_max */
+	struct ofi_sockctx	rbuf_cancel_sockctx;
 	struct slist		rx_queue;
 	struct slist		tx_queue;
 	struct slist		priority_queue;
@@ -265,6 +275,11 @@ struct xnet_ep {
 
 	short			pollflags;
 
+	/* small sends held in bsock.sq, see xnet_tx_coalesce() */
+	bool			tx_more;
+	uint64_t		tx_hold_end;
+	struct dlist_entry	tx_hold_entry;
+
 	xnet_profile_t *profile;
 };
 
@@ -363,6 +378,14 @@ struct xnet_progress {
 	struct xnet_uring	rx_uring;
 	ofi_io_uring_cqe_t	**cqes;
 
+	/* provided receive buffers, used if bufring.cnt != 0 */
+	struct ofi_bufring	bufring;
+	struct dlist_entry	rbuf_wait_list;
+	unsigned int		rbuf_ep_max;
+
+	/* endpoints holding FI_MORE sends for coalescing */
+	struct dlist_entry	tx_hold_list;
+
 	struct ofi_sockapi	sockapi;
 
 	struct ofi_dynpoll	epoll_fd;
@@ -398,6 +421,9 @@ int xnet_uring_cancel(struct xnet_progress *progress,
 int xnet_uring_pollin_add(struct xnet_progress *progress,
 			  int fd, bool multishot,
 			  struct ofi_sockctx *pollin_ctx);
+int xnet_uring_rx_arm(struct xnet_ep *ep);
+void xnet_uring_register_ep(struct xnet_ep *ep);
+void xnet_uring_unregister_ep(struct xnet_ep *ep);
 
 static inline int xnet_progress_locked(struct xnet_progress *progress)
 {
@@ -428,6 +454,7 @@ static inline void xnet_signal_progress(struct xnet_progress *progress)
 #define XNET_COPY_RECV		BIT(9)
 #define XNET_CLAIM_RECV		BIT(10)
 #define XNET_NEED_CTS		BIT(11)
+#define XNET_MORE		BIT(12)
 #define XNET_MULTI_RECV		FI_MULTI_RECV /* BIT(16) */
 
 struct xnet_mrecv {
@@ -630,6 +657,13 @@ xnet_set_ack_flags(struct xnet_xfer_entry *xfer, uint64_t flags)
 	}
 }
 
+static inline void
+xnet_set_more_flag(struct xnet_xfer_entry *xfer, uint64_t flags)
+{
+	if (flags & FI_MORE)
+		xfer->ctrl_flags |= XNET_MORE;
+}
+
 static inline void
 xnet_set_commit_flags(struct xnet_xfer_entry *xfer, uint64_t flags)
 {
@@ -66,13 +66,53 @@ xnet_cq_readerr(struct fid_cq *cq_fid, struct fi_cq_err_entry *buf,
 	return ret;
 }
 
+/* In busy poll mode, drive progress from the reading thread for a bounded
+ * time before falling back to the fd based wait.
+ */
+static ssize_t
+xnet_cq_sreadfrom(struct fid_cq *cq_fid, void *buf, size_t count,
+		  fi_addr_t *src_addr, const void *cond, int timeout)
+{
+	uint64_t start, end, now;
+	ssize_t ret;
+
+	if (xnet_busy_poll && timeout) {
+		start = ofi_gettime_us();
+		end = start + xnet_busy_poll;
+		if (timeout > 0)
+			end = MIN(end, start + (uint64_t) timeout * 1000);
+
+		do {
+			ret = fi_cq_readfrom(cq_fid, buf, count, src_addr);
+			if (ret != -FI_EAGAIN)
+				return ret;
+			now = ofi_gettime_us();
+		} while (now < end);
+
+		if (timeout > 0) {
+			timeout -= (int) ((now - start) / 1000);
+			if (timeout <= 0)
+				return -FI_EAGAIN;
+		}
+	}
+
+	return ofi_cq_sreadfrom(cq_fid, buf, count, src_addr, cond, timeout);
+}
+
+static ssize_t
+xnet_cq_sread(struct fid_cq *cq_fid, void *buf, size_t count,
+	      const void *cond, int timeout)
+{
+	return xnet_cq_sreadfrom(cq_fid, buf, count, NULL, cond, timeout);
+}
+
 static struct fi_ops_cq xnet_cq_ops = {
 	.size = sizeof(struct fi_ops_cq),
 	.read = ofi_cq_read,
 	.readfrom = xnet_cq_readfrom,
 	.readerr = xnet_cq_readerr,
-	.sread = ofi_cq_sread,
-	.sreadfrom = ofi_cq_sreadfrom,
+	.sread = xnet_cq_sread,
+	.sreadfrom = xnet_cq_sreadfrom,
 	.signal = ofi_cq_signal,
 	.strerror = ofi_cq_strerror,
 };
@@ -171,7 +211,7 @@ void xnet_report_success(struct xnet_xfer_entry *xfer_entry)
 		tag = 0;
 	}
 
-	if (cq->src) {
+	if (cq->domain->info_domain_caps & FI_SOURCE) {
 		ofi_cq_write_src(cq, xfer_entry->context, flags, len,
 				 xfer_entry->user_buf, data, tag,
 				 xfer_entry->src_addr);
@@ -283,14 +323,13 @@ int xnet_cq_open(struct fid_domain *domain, struct fi_cq_attr *attr,
 	if (!attr->size)
 		attr->size = XNET_DEF_CQ_SIZE;
 
-	if (attr->wait_obj == FI_WAIT_UNSPEC) {
-		cq_attr = *attr;
+	cq_attr = *attr;
+	if (cq_attr.wait_obj == FI_WAIT_UNSPEC)
 		cq_attr.wait_obj = FI_WAIT_FD;
-		attr = &cq_attr;
-	}
 
-	ret = ofi_cq_init(&xnet_prov, domain, attr, &cq->util_cq,
-			  &xnet_cq_progress, context);
+	/* Completions are written by the progress thread and app threads */
+	ret = ofi_cq_init2(&xnet_prov, domain, &cq_attr, &cq->util_cq,
+			   &xnet_cq_progress, OFI_CQ_ATOMIC_QUEUE, context);
 	if (ret)
 		goto free_cq;
 
@@ -156,6 +156,32 @@ static void xnet_set_no_port(SOCKET sock)
 #define xnet_set_no_port(sock)
 #endif
 
+#ifdef SO_BUSY_POLL
+static void xnet_set_busy_poll(SOCKET sock)
+{
+	int val = xnet_busy_poll;
+
+	if (!xnet_busy_poll)
+		return;
+
+	/* Raising SO_BUSY_POLL above net.core.busy_read needs CAP_NET_ADMIN */
+	if (setsockopt(sock, SOL_SOCKET, SO_BUSY_POLL, &val, sizeof(val))) {
+		FI_INFO(&xnet_prov, FI_LOG_EP_CTRL,
+			"unable to set SO_BUSY_POLL: %s\n",
+			strerror(ofi_sockerr()));
+		return;
+	}
+
+#ifdef SO_PREFER_BUSY_POLL
+	val = 1;
+	(void) setsockopt(sock, SOL_SOCKET, SO_PREFER_BUSY_POLL,
+			  &val, sizeof(val));
+#endif
+}
+#else
+#define xnet_set_busy_poll(sock)
+#endif
+
 int xnet_setup_socket(SOCKET sock, struct fi_info *info)
 {
 	int ret, optval = 1;
@@ -190,6 +216,7 @@ int xnet_setup_socket(SOCKET sock, struct fi_info *info)
 		return ret;
 	}
 
+	xnet_set_busy_poll(sock);
 	return 0;
 }
 
@@ -197,8 +224,8 @@ static int xnet_monitor_ep(struct xnet_progress *progress, struct xnet_ep *ep)
 {
 	if (xnet_io_uring) {
 		assert(!(ep->pollflags & POLLOUT));
-		return xnet_uring_pollin_add(progress, ep->bsock.sock,
-					     false, &ep->bsock.pollin_sockctx);
+		xnet_uring_register_ep(ep);
+		return xnet_uring_rx_arm(ep);
 	}
 
 	return xnet_monitor_sock(progress, ep->bsock.sock, ep->pollflags,
@@ -390,6 +417,14 @@ static void xnet_ep_flush_all_queues(struct xnet_ep *ep)
 	if (ret)
 		FI_WARN(&xnet_prov, FI_LOG_EP_DATA, "Failed to cancel POLLIN uring\n");
 
+	ret = xnet_uring_cancel(progress, &progress->rx_uring,
+				&ep->rbuf_cancel_sockctx,
+				&ep->util_ep.ep_fid);
+	if (ret)
+		FI_WARN(&xnet_prov, FI_LOG_EP_DATA, "Failed to cancel RX stop uring\n");
+
+	xnet_uring_unregister_ep(ep);
+
 	if (ep->cur_tx.entry) {
 		ep->hdr_bswap(ep, &ep->cur_tx.entry->hdr.base_hdr);
 		if (ep->cur_tx.entry->ctrl_flags & XNET_NEED_CTS) {
@@ -419,6 +454,9 @@ static void xnet_ep_flush_all_queues(struct xnet_ep *ep)
 	xnet_reset_rx(ep);
 	xnet_flush_xfer_queue(progress, &ep->rx_queue, NULL);
 	ep->rx_avail = 0;
+	dlist_remove_init(&ep->rbuf_wait_entry);
+	dlist_remove_init(&ep->tx_hold_entry);
+	ep->tx_more = false;
 	ofi_bsock_discard(&ep->bsock);
 }
 
@@ -807,6 +845,9 @@ int xnet_endpoint(struct fid_domain *domain, struct fi_info *info,
 	}
 
 	dlist_init(&ep->unexp_entry);
+	dlist_init(&ep->rbuf_wait_entry);
+	ofi_sockctx_init(&ep->rbuf_cancel_sockctx, &ep->util_ep.ep_fid);
+	dlist_init(&ep->tx_hold_entry);
 	slist_init(&ep->rx_queue);
 	slist_init(&ep->tx_queue);
 	slist_init(&ep->priority_queue);
@@ -67,6 +67,13 @@ size_t xnet_zerocopy_size = SIZE_MAX;
 int xnet_trace_msg;
 int xnet_disable_autoprog;
 int xnet_io_uring;
+int xnet_uring_rbuf_cnt;
+int xnet_uring_ep_rbuf_cnt;
+int xnet_uring_fixed_cnt = 1024;
+size_t xnet_tx_coalesce_size = 512;
+int xnet_tx_coalesce_usec = 10;
+int xnet_busy_poll;
+size_t xnet_uring_rbuf_size = 16384;
 int xnet_max_saved = 64;
 size_t xnet_max_inject = XNET_DEF_INJECT;
 size_t xnet_buf_size = XNET_DEF_BUF_SIZE;
@@ -174,6 +181,31 @@ static void xnet_init_env(void)
 			 &xnet_prefetch_rbuf_size);
 	fi_param_get_size_t(&xnet_prov, "zerocopy_size", &xnet_zerocopy_size);
 
+	fi_param_define(&xnet_prov, "tx_coalesce_size", FI_PARAM_SIZE_T,
+			"Messages up to this size, including the header, are "
+			"copied into the staging buffer and sent together "
+			"with following messages that are already queued or "
+			"announced with FI_MORE, 0 to disable (default: %zu)",
+			xnet_tx_coalesce_size);
+	fi_param_get_size_t(&xnet_prov, "tx_coalesce_size",
+			    &xnet_tx_coalesce_size);
+	fi_param_define(&xnet_prov, "tx_coalesce_usec", FI_PARAM_INT,
+			"Maximum time in microseconds that messages sent with "
+			"FI_MORE are held waiting for more data "
+			"(default: %d)", xnet_tx_coalesce_usec);
+	fi_param_get_int(&xnet_prov, "tx_coalesce_usec",
+			 &xnet_tx_coalesce_usec);
+
+	fi_param_define(&xnet_prov, "busy_poll", FI_PARAM_INT,
+			"Low latency mode.  Time in microseconds to busy poll "
+			"for socket events and completions before blocking.  "
+			"Also enables kernel busy polling on data sockets and "
+			"the progress epoll set where supported, 0 to disable "
+			"(default: %d)", xnet_busy_poll);
+	fi_param_get_int(&xnet_prov, "busy_poll", &xnet_busy_poll);
+	if (xnet_busy_poll < 0)
+		xnet_busy_poll = 0;
+
 	fi_param_define(&xnet_prov, "trace_msg", FI_PARAM_BOOL,
 			"Capture and display transport message information "
 			"when FI_LOG_LEVEL=TRACE is specified");
@@ -186,6 +218,31 @@ static void xnet_init_env(void)
 			"Enable io_uring support if available (default: %d)", xnet_io_uring);
 	fi_param_get_bool(&xnet_prov, "io_uring",
 			 &xnet_io_uring);
+	fi_param_define(&xnet_prov, "io_uring_rbufs", FI_PARAM_INT,
+			"Number of receive buffers shared by all endpoints "
+			"of a progress engine when using io_uring.  If set, "
+			"endpoints receive with multishot receives from a "
+			"provided buffer ring.  Must be a power of 2, "
+			"0 to disable (default: %d)", xnet_uring_rbuf_cnt);
+	fi_param_get_int(&xnet_prov, "io_uring_rbufs", &xnet_uring_rbuf_cnt);
+	fi_param_define(&xnet_prov, "io_uring_ep_rbufs", FI_PARAM_INT,
+			"Maximum number of provided receive buffers that a "
+			"single endpoint may hold before its multishot receive "
+			"is stopped, 0 to use 1/8 of io_uring_rbufs "
+			"(default: %d)", xnet_uring_ep_rbuf_cnt);
+	fi_param_get_int(&xnet_prov, "io_uring_ep_rbufs",
+			 &xnet_uring_ep_rbuf_cnt);
+	fi_param_define(&xnet_prov, "io_uring_rbuf_size", FI_PARAM_SIZE_T,
+			"Size of each io_uring provided receive buffer "
+			"(default: %zu)", xnet_uring_rbuf_size);
+	fi_param_get_size_t(&xnet_prov, "io_uring_rbuf_size",
+			    &xnet_uring_rbuf_size);
+	fi_param_define(&xnet_prov, "io_uring_fixed_files", FI_PARAM_INT,
+			"Number of endpoints per progress engine whose socket "
+			"and staging buffer are registered with the io_uring, "
+			"0 to disable (default: %d)", xnet_uring_fixed_cnt);
+	fi_param_get_int(&xnet_prov, "io_uring_fixed_files",
+			 &xnet_uring_fixed_cnt);
 }
 
 static void xnet_fini(void)
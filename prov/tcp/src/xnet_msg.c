@@ -343,6 +343,7 @@ xnet_sendmsg(struct fid_ep *ep_fid, const struct fi_msg *msg, uint64_t flags)
 	tx_entry->cq_flags = xnet_tx_completion_get_msgflags(ep, flags) |
 			     FI_MSG | FI_SEND;
 	xnet_set_ack_flags(tx_entry, flags);
+	xnet_set_more_flag(tx_entry, flags);
 	tx_entry->context = msg->context;
 
 	xnet_tx_queue_insert(ep, tx_entry);
@@ -548,6 +549,7 @@ xnet_tsendmsg(struct fid_ep *fid_ep, const struct fi_msg_tagged *msg,
 	tx_entry->cq_flags = xnet_tx_completion_get_msgflags(ep, flags) |
 			     FI_TAGGED | FI_SEND;
 	xnet_set_ack_flags(tx_entry, flags);
+	xnet_set_more_flag(tx_entry, flags);
 	tx_entry->context = msg->context;
 
 	ret = xnet_rts_check(ep, tx_entry);
@@ -39,9 +39,61 @@
 #ifdef HAVE_FABRIC_PROFILE
 #include <ofi_profile.h>
 
+/* provider-specific variables, shared by all endpoints of a progress engine */
+enum {
+	XNET_VAR_URING_SEND_CNT = (1 << 16),
+	XNET_VAR_URING_SEND_FIXED_FILE_CNT,
+	XNET_VAR_URING_SEND_FIXED_BUF_CNT,
+	XNET_VAR_URING_SEND_ZC_CNT,
+};
+
+#define XNET_PROF_U64_VAR(var_id, var_name, var_desc)	\
+	{						\
+	 .id = var_id,					\
+	 .datatype_sel = fi_primitive_type,		\
+	 .datatype.primitive = FI_UINT64,		\
+	 .flags = 0,					\
+	 .size = sizeof(uint64_t),			\
+	 .name = var_name,				\
+	 .desc = var_desc				\
+	}
+
+static struct fi_profile_desc xnet_prof_vars[] = {
+	XNET_PROF_U64_VAR(XNET_VAR_URING_SEND_CNT, "tcp_uring_send_cnt",
+			  "Number of io_uring send requests"),
+	XNET_PROF_U64_VAR(XNET_VAR_URING_SEND_FIXED_FILE_CNT,
+			  "tcp_uring_send_fixed_file_cnt",
+			  "Number of io_uring sends using a registered file"),
+	XNET_PROF_U64_VAR(XNET_VAR_URING_SEND_FIXED_BUF_CNT,
+			  "tcp_uring_send_fixed_buf_cnt",
+			  "Number of io_uring sends from a registered buffer"),
+	XNET_PROF_U64_VAR(XNET_VAR_URING_SEND_ZC_CNT,
+			  "tcp_uring_send_zc_cnt",
+			  "Number of io_uring zero-copy sends"),
+};
+
+static void
+xnet_prof_add_uring_vars(struct util_profile *prof,
+			 struct xnet_progress *progress)
+{
+	struct ofi_sockapi_uring *uring = &progress->sockapi.tx_uring;
+	uint64_t *vars[] = {
+		&uring->send_cnt,
+		&uring->send_fixed_file_cnt,
+		&uring->send_fixed_buf_cnt,
+		&uring->send_zc_cnt,
+	};
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(xnet_prof_vars); i++)
+		(void) ofi_prof_add_var(prof, xnet_prof_vars[i].id,
+					&xnet_prof_vars[i], vars[i]);
+}
+
 static int
 xnet_prof_init(struct fid *fid, uint64_t flags, void *context,
-	       struct fi_profile_ops *ops, struct xnet_profile **xnet_prof)
+	       struct fi_profile_ops *ops, struct xnet_progress *progress,
+	       struct xnet_profile **xnet_prof)
 {
 	int ret = 0;
 	struct util_profile *prof;
@@ -64,6 +116,7 @@ xnet_prof_init(struct fid *fid, uint64_t flags, void *context,
 	ofi_prof_add_common_vars(prof);
 	ret = ofi_prof_add_var(prof, FI_VAR_UNEXP_MSG_CNT, NULL,
 			       &((*xnet_prof)->unexp_msg_cnt));
+	xnet_prof_add_uring_vars(prof, progress);
 
 	ofi_prof_add_common_events(prof);
 
@@ -199,13 +252,14 @@ int xnet_ep_ops_open(struct fid *fid, const char *name,
 
 	if (!strcmp(name, "fi_profile_ops")) {
 		if (fid->fclass == FI_CLASS_EP) {
+			ep = container_of(fid, struct xnet_ep,
+					  util_ep.ep_fid.fid);
 			ret = xnet_prof_init(fid, flags, context, 
-					     &xnet_prof_ep_ops, &xnet_prof);
+					     &xnet_prof_ep_ops,
+					     xnet_ep2_progress(ep), &xnet_prof);
 			if (ret)
 				return ret;
 
-			ep = container_of(fid, struct xnet_ep,
-					  util_ep.ep_fid.fid);
 			ep->profile = xnet_prof;
 			*ops = &(xnet_prof->util_prof.prof_fid.ops);
 			return ret;
@@ -225,14 +279,15 @@ int xnet_rdm_ops_open(struct fid *fid, const char *name,
 
 	if (!strncmp(name, "fi_profile_ops", 11)) {
 		if (fid->fclass == FI_CLASS_EP) {
+			rdm = container_of(fid, struct xnet_rdm,
+					   util_ep.ep_fid.fid);
 			ret = xnet_prof_init(fid, flags, context,
 					     &xnet_prof_ep_ops,
+					     xnet_rdm2_progress(rdm),
 					     &xnet_prof);
 			if (ret)
 				return ret;
 
-			rdm = container_of(fid, struct xnet_rdm,
-					   util_ep.ep_fid.fid);
 			rdm->profile = xnet_prof;
 			if (rdm->srx)
 				rdm->srx->profile = xnet_prof;
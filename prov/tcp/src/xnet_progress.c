@@ -377,6 +377,92 @@ int xnet_uring_pollin_add(struct xnet_progress *progress, int fd,
 	return 0;
 }
 
+/* With a provided buffer ring, the endpoint receives through a multishot
+ * receive instead of polling the socket.  The receive stays armed until the
+ * ring runs out of buffers, at which point the endpoint waits for buffers
+ * to be returned before being rearmed.  An endpoint that stopped consuming
+ * its data (e.g. no posted receives) is limited to rbuf_ep_max buffers, and
+ * is only rearmed once it has drained half of them, so that it cannot take
+ * the ring away from the other endpoints.
+ */
+int xnet_uring_rx_arm(struct xnet_ep *ep)
+{
+	struct xnet_progress *progress;
+	int ret;
+
+	progress = xnet_ep2_progress(ep);
+	assert(xnet_progress_locked(progress));
+	if (!progress->bufring.cnt)
+		return xnet_uring_pollin_add(progress, ep->bsock.sock, false,
+					     &ep->bsock.pollin_sockctx);
+
+	ep->bsock.bufring = &progress->bufring;
+	if (ep->bsock.pollin_sockctx.uring_sqe_inuse ||
+	    ep->bsock.rbufs_cnt > progress->rbuf_ep_max / 2)
+		return 0;
+
+	if (!progress->bufring.avail) {
+		if (dlist_empty(&ep->rbuf_wait_entry))
+			dlist_insert_tail(&ep->rbuf_wait_entry,
+					  &progress->rbuf_wait_list);
+		return 0;
+	}
+
+	ret = ofi_sockctx_uring_recv_multishot(progress->rx_uring.sockapi,
+					       ep->bsock.sock,
+					       &progress->bufring,
+					       &ep->bsock.pollin_sockctx);
+	return ret == -OFI_EINPROGRESS_URING ? 0 : ret;
+}
+
+/* Register the socket and staging buffer used for sends, which saves a file
+ * lookup and page pinning per request.  Sends proceed unregistered if no
+ * slot is available.
+ */
+void xnet_uring_register_ep(struct xnet_ep *ep)
+{
+	struct xnet_progress *progress;
+	int ret;
+
+	progress = xnet_ep2_progress(ep);
+	assert(xnet_progress_locked(progress));
+	if (!progress->sockapi.tx_uring.fixed_free)
+		return;
+
+	ret = ofi_sockctx_uring_register(&progress->sockapi.tx_uring,
+					 &ep->bsock.tx_sockctx, ep->bsock.sock,
+					 ep->bsock.sq.data,
+					 sizeof(ep->bsock.sq.data));
+	if (ret) {
+		FI_DBG(&xnet_prov, FI_LOG_EP_CTRL,
+		       "unable to register socket with io_uring (%d)\n", ret);
+	}
+}
+
+void xnet_uring_unregister_ep(struct xnet_ep *ep)
+{
+	struct xnet_progress *progress;
+
+	progress = xnet_ep2_progress(ep);
+	assert(xnet_progress_locked(progress));
+	ofi_sockctx_uring_unregister(&progress->sockapi.tx_uring,
+				     &ep->bsock.tx_sockctx);
+}
+
+static void xnet_uring_rx_rearm(struct xnet_progress *progress)
+{
+	struct xnet_ep *ep;
+
+	while (progress->bufring.avail &&
+	       !dlist_empty(&progress->rbuf_wait_list)) {
+		dlist_pop_front(&progress->rbuf_wait_list, struct xnet_ep,
+				ep, rbuf_wait_entry);
+		dlist_init(&ep->rbuf_wait_entry);
+		if (xnet_uring_rx_arm(ep))
+			xnet_ep_disable(ep, 0, NULL, 0);
+	}
+}
+
 static int xnet_update_pollflag(struct xnet_ep *ep, short pollflag, bool set)
 {
 	struct xnet_progress *progress;
@@ -417,8 +503,7 @@ static int xnet_update_pollflag(struct xnet_ep *ep, short pollflag, bool set)
 			return 0;
 		}
 
-		ret = xnet_uring_pollin_add(progress, ep->bsock.sock,
-					    false, &ep->bsock.pollin_sockctx);
+		ret = xnet_uring_rx_arm(ep);
 	} else {
 		ret = ofi_dynpoll_mod(&progress->epoll_fd, ep->bsock.sock,
 				      ep->pollflags, &ep->util_ep.ep_fid.fid);
@@ -427,6 +512,44 @@ static int xnet_update_pollflag(struct xnet_ep *ep, short pollflag, bool set)
 	return ret;
 }
 
+/* A small message is copied into the staging buffer instead of being sent
+ * if more messages are queued behind it, or if the application indicated
+ * that more are coming (FI_MORE).  The buffered data goes out with the next
+ * message that is sent, so that a burst of small messages results in a
+ * single send call.  Data held for FI_MORE is flushed once the hold time
+ * expires.
+ */
+static bool xnet_tx_coalesce(struct xnet_ep *ep,
+			     struct xnet_xfer_entry *tx_entry)
+{
+	ep->tx_more = false;
+	if (xnet_io_uring || ep->cur_tx.data_left > xnet_tx_coalesce_size ||
+	    ep->cur_tx.data_left >= ofi_byteq_writeable(&ep->bsock.sq))
+		return false;
+
+	if (!slist_empty(&ep->priority_queue) || !slist_empty(&ep->tx_queue))
+		return true;
+
+	ep->tx_more = (tx_entry->ctrl_flags & XNET_MORE) != 0;
+	return ep->tx_more;
+}
+
+static bool xnet_tx_hold(struct xnet_ep *ep)
+{
+	uint64_t now;
+
+	if (!ep->tx_more)
+		return false;
+
+	now = ofi_gettime_us();
+	if (dlist_empty(&ep->tx_hold_entry)) {
+		ep->tx_hold_end = now + xnet_tx_coalesce_usec;
+		dlist_insert_tail(&ep->tx_hold_entry,
+				  &xnet_ep2_progress(ep)->tx_hold_list);
+	}
+	return now < ep->tx_hold_end;
+}
+
 static int xnet_send_msg(struct xnet_ep *ep)
 {
 	struct xnet_xfer_entry *tx_entry;
@@ -436,6 +559,13 @@ static int xnet_send_msg(struct xnet_ep *ep)
 	assert(xnet_progress_locked(xnet_ep2_progress(ep)));
 	assert(ep->cur_tx.entry);
 	tx_entry = ep->cur_tx.entry;
+	if (xnet_tx_coalesce(ep, tx_entry)) {
+		ofi_byteq_writev(&ep->bsock.sq, tx_entry->iov,
+				 tx_entry->iov_cnt);
+		ep->cur_tx.data_left = 0;
+		return FI_SUCCESS;
+	}
+
 	ret = ofi_bsock_sendv(&ep->bsock, tx_entry->iov, tx_entry->iov_cnt,
 			      &len);
 	if (ret < 0 && ret != -OFI_EINPROGRESS_ASYNC)
@@ -587,6 +717,10 @@ static void xnet_progress_tx(struct xnet_ep *ep)
 		xnet_complete_tx(ep, ret);
 	}
 
+	if (xnet_tx_hold(ep))
+		return;
+	dlist_remove_init(&ep->tx_hold_entry);
+
 	/* Buffered data is sent first by xnet_send_msg, but if we don't
 	 * have other data to send, we need to try flushing any buffered data.
 	 */
@@ -602,6 +736,26 @@ disable_ep:
 	xnet_ep_disable(ep, 0, NULL, 0);
 }
 
+static void xnet_progress_tx_hold(struct xnet_progress *progress)
+{
+	struct dlist_entry *tmp;
+	struct xnet_ep *ep;
+	uint64_t now;
+
+	if (dlist_empty(&progress->tx_hold_list))
+		return;
+
+	now = ofi_gettime_us();
+	dlist_foreach_container_safe(&progress->tx_hold_list, struct xnet_ep,
+				     ep, tx_hold_entry, tmp) {
+		if (now < ep->tx_hold_end)
+			continue;
+
+		ep->tx_more = false;
+		xnet_progress_tx(ep);
+	}
+}
+
 static void xnet_pmem_commit(struct xnet_ep *ep, struct xnet_xfer_entry *rx_entry)
 {
 	struct ofi_rma_iov *rma_iov;
@@ -1151,6 +1305,10 @@ void xnet_progress_rx(struct xnet_ep *ep)
 		else if (!ret || OFI_SOCK_TRY_SND_RCV_AGAIN(-ret))
 			ret = xnet_update_pollflag(ep, POLLIN, true);
 
+		/* Resume a multishot receive stopped at the buffer limit */
+		if (!ret && ep->bsock.bufring && ep->state == XNET_CONNECTED)
+			ret = xnet_uring_rx_arm(ep);
+
 		if (ret)
 			xnet_ep_disable(ep, 0, NULL, 0);
 	}
@@ -1243,6 +1401,48 @@ disable_ep:
 	xnet_ep_disable(ep, 0, NULL, 0);
 }
 
+/* Data that arrives before the cancel takes effect is still queued.  The
+ * final completion of the receive does not rearm it while the endpoint is
+ * above its limit, see xnet_uring_rx_arm.
+ */
+static void xnet_uring_rx_stop(struct xnet_ep *ep)
+{
+	struct xnet_progress *progress;
+	int ret;
+
+	progress = xnet_ep2_progress(ep);
+	ret = ofi_sockctx_uring_cancel(progress->rx_uring.sockapi,
+				       &ep->bsock.pollin_sockctx,
+				       &ep->rbuf_cancel_sockctx);
+	if (ret && ret != -OFI_EINPROGRESS_URING) {
+		FI_DBG(&xnet_prov, FI_LOG_EP_DATA,
+		       "unable to stop multishot receive (%d)\n", ret);
+	}
+}
+
+static void xnet_uring_rbuf_done(struct xnet_ep *ep, int res,
+				 uint32_t cqe_flags)
+{
+	/* On -ENOBUFS, data stays queued in the socket until the receive
+	 * is rearmed, which waits for buffers to be returned to the ring.
+	 */
+	if (res > 0) {
+		ofi_bsock_rbuf_done(&ep->bsock, cqe_flags, res);
+		if ((cqe_flags & IORING_CQE_F_MORE) &&
+		    ep->bsock.rbufs_cnt >= xnet_ep2_progress(ep)->rbuf_ep_max)
+			xnet_uring_rx_stop(ep);
+	} else if (res != -ENOBUFS && res != -ECANCELED) {
+		xnet_ep_disable(ep, 0, NULL, 0);
+		return;
+	}
+
+	if (!(cqe_flags & IORING_CQE_F_MORE) && xnet_uring_rx_arm(ep)) {
+		xnet_ep_disable(ep, 0, NULL, 0);
+		return;
+	}
+	xnet_progress_rx(ep);
+}
+
 static void xnet_uring_connect_done(struct xnet_ep *ep, int res)
 {
 	struct xnet_progress *progress;
@@ -1277,8 +1477,21 @@ disable:
 }
 
 static void xnet_uring_run_ep(struct xnet_ep *ep, struct ofi_sockctx *sockctx,
-			      int res)
+			      int res, uint32_t cqe_flags)
 {
+	if (cqe_flags & IORING_CQE_F_BUFFER) {
+		assert(sockctx == &ep->bsock.pollin_sockctx);
+		if (ep->state == XNET_CONNECTED) {
+			xnet_uring_rbuf_done(ep, res, cqe_flags);
+		} else {
+			/* Data received after the endpoint was disabled */
+			ofi_bufring_put(ep->bsock.bufring,
+					ofi_bufring_get(ep->bsock.bufring,
+							cqe_flags, res));
+		}
+		return;
+	}
+
 	switch (ep->state) {
 	case XNET_CONNECTED:
 		if (sockctx == &ep->bsock.tx_sockctx) {
@@ -1286,7 +1499,9 @@ static void xnet_uring_run_ep(struct xnet_ep *ep, struct ofi_sockctx *sockctx,
 		} else if (sockctx == &ep->bsock.rx_sockctx) {
 			xnet_uring_rx_done(ep, res);
 		} else if (sockctx == &ep->bsock.pollin_sockctx) {
-			if (res < 0) {
+			if (ep->bsock.bufring) {
+				xnet_uring_rbuf_done(ep, res, cqe_flags);
+			} else if (res < 0) {
 				xnet_ep_disable(ep, -res, NULL, 0);
 			} else {
 				assert(res & POLLIN);
@@ -1328,20 +1543,37 @@ static void xnet_progress_cqe(struct xnet_progress *progress,
 	struct xnet_ep *ep;
 	struct xnet_conn_handle *conn;
 	struct xnet_pep *pep;
+	int res;
 
 	assert(xnet_io_uring);
 	sockctx = (struct ofi_sockctx *) cqe->user_data;
 	assert(sockctx);
 	assert(sockctx->uring_sqe_inuse);
-	if (!(cqe ->flags & IORING_CQE_F_MORE))
+	/* A multishot request holds its credit until its last completion */
+	if (!(cqe->flags & IORING_CQE_F_MORE)) {
 		sockctx->uring_sqe_inuse = false;
-	uring->sockapi->credits++;
+		uring->sockapi->credits++;
+	}
+
+	/* A zero-copy send reports its result, then notifies us once the
+	 * kernel no longer references the buffer.  Complete on the latter.
+	 */
+	res = cqe->res;
+	if (sockctx->uring_zc) {
+		if (cqe->flags & IORING_CQE_F_MORE) {
+			sockctx->uring_zc_res = res;
+			return;
+		}
+		if (cqe->flags & IORING_CQE_F_NOTIF)
+			res = sockctx->uring_zc_res;
+		sockctx->uring_zc = false;
+	}
 
 	fid = sockctx->context;
 	switch (fid->fclass) {
 	case FI_CLASS_EP:
 		ep = container_of(fid, struct xnet_ep, util_ep.ep_fid.fid);
-		xnet_uring_run_ep(ep, sockctx, cqe->res);
+		xnet_uring_run_ep(ep, sockctx, res, cqe->flags);
 		break;
 	case FI_CLASS_CONNREQ:
 		conn = container_of(fid, struct xnet_conn_handle, fid);
@@ -1553,6 +1785,7 @@ void xnet_run_progress(struct xnet_progress *progress, bool clear_signal)
 	if (xnet_io_uring) {
 		xnet_progress_uring(progress, &progress->tx_uring);
 		xnet_progress_uring(progress, &progress->rx_uring);
+		xnet_uring_rx_rearm(progress);
 		xnet_handle_event_list(progress);
 		xnet_submit_uring(&progress->tx_uring);
 		xnet_submit_uring(&progress->rx_uring);
@@ -1561,6 +1794,7 @@ void xnet_run_progress(struct xnet_progress *progress, bool clear_signal)
 					ARRAY_SIZE(progress->events), 0);
 		xnet_handle_events(progress, &progress->events[0], nfds, clear_signal);
 	}
+	xnet_progress_tx_hold(progress);
 }
 
 void xnet_progress(struct xnet_progress *progress, bool clear_signal)
@@ -1626,7 +1860,7 @@ int xnet_trywait(struct fid_fabric *fabric_fid, struct fid **fid, int count)
 			cq = container_of(fid[i], struct xnet_cq,
 					  util_cq.cq_fid.fid);
 			ofi_genlock_lock(xnet_cq2_progress(cq)->active_lock);
-			if (ofi_cirque_isempty(cq->util_cq.cirq))
+			if (ofi_cq_isempty(&cq->util_cq))
 				xnet_reset_wait(cq->util_cq.wait);
 			else
 				ret = -FI_EAGAIN;
@@ -1668,6 +1902,55 @@ int xnet_trywait(struct fid_fabric *fabric_fid, struct fid **fid, int count)
 	return ret;
 }
 
+/* Poll for events without sleeping for up to spin_usec.  With SO_BUSY_POLL
+ * set on the sockets, each poll also lets the kernel poll the device
+ * queues, so data is picked up without waiting for an interrupt.
+ */
+static int xnet_progress_spin(struct xnet_progress *progress,
+			      struct ofi_epollfds_event *event,
+			      uint64_t spin_usec, int *timeout)
+{
+	uint64_t start, end, now;
+	int nfds;
+
+	start = ofi_gettime_us();
+	end = start + spin_usec;
+	if (*timeout >= 0)
+		end = MIN(end, start + (uint64_t) *timeout * 1000);
+
+	do {
+		nfds = ofi_dynpoll_wait(&progress->epoll_fd, event, 1, 0);
+		if (nfds)
+			return nfds;
+		now = ofi_gettime_us();
+	} while (now < end);
+
+	if (*timeout > 0)
+		*timeout = MAX(*timeout - (int) ((now - start) / 1000), 0);
+	return 0;
+}
+
+/* Time in usec until the oldest held send must be flushed, or -1 if no
+ * sends are held.  Holds are queued in the order they started, and all
+ * last the same time, so the first one expires first.
+ */
+static int64_t xnet_tx_hold_left(struct xnet_progress *progress)
+{
+	struct xnet_ep *ep;
+	uint64_t now;
+	int64_t left = -1;
+
+	ofi_genlock_lock(progress->active_lock);
+	if (!dlist_empty(&progress->tx_hold_list)) {
+		ep = container_of(progress->tx_hold_list.next, struct xnet_ep,
+				  tx_hold_entry);
+		now = ofi_gettime_us();
+		left = now < ep->tx_hold_end ? ep->tx_hold_end - now : 0;
+	}
+	ofi_genlock_unlock(progress->active_lock);
+	return left;
+}
+
 /* We can't hold the progress lock around waiting, or we
  * can hang another thread trying to obtain the lock.  But
  * the poll fds may change while we're waiting for an event.
@@ -1679,6 +1962,8 @@ int xnet_trywait(struct fid_fabric *fabric_fid, struct fid **fid, int count)
 int xnet_progress_wait(struct xnet_progress *progress, int timeout)
 {
 	struct ofi_epollfds_event event;
+	int64_t hold_left;
+	int nfds;
 
 	/* We cannot enter blocking if io_uring has entries
 	 * that need submission. */
@@ -1686,6 +1971,26 @@ int xnet_progress_wait(struct xnet_progress *progress, int timeout)
 		assert(ofi_uring_sq_ready(&progress->tx_uring.ring) == 0);
 		assert(ofi_uring_sq_ready(&progress->rx_uring.ring) == 0);
 	}
+
+	/* Held sends must be flushed when their coalescing window closes,
+	 * which is well below the poll timeout resolution.  Poll without
+	 * sleeping until then, and return so the caller runs progress.
+	 */
+	hold_left = xnet_tx_hold_left(progress);
+	if (hold_left >= 0) {
+		if (!hold_left || !timeout)
+			return ofi_dynpoll_wait(&progress->epoll_fd, &event,
+						1, 0);
+		return xnet_progress_spin(progress, &event, hold_left,
+					  &timeout);
+	}
+
+	if (xnet_busy_poll && timeout) {
+		nfds = xnet_progress_spin(progress, &event, xnet_busy_poll,
+					  &timeout);
+		if (nfds || !timeout)
+			return nfds;
+	}
 	return ofi_dynpoll_wait(&progress->epoll_fd, &event, 1, timeout);
 }
 
@@ -1824,6 +2129,7 @@ static int xnet_init_uring(struct xnet_uring *uring, size_t entries,
 	uring->sockapi = sockapi;
 	uring->sockapi->io_uring = &uring->ring;
 	uring->sockapi->credits = ofi_uring_sq_space_left(&uring->ring);
+	uring->sockapi->zc_size = SIZE_MAX;
 
 	ret = ofi_dynpoll_add(dynpoll,
 			      ofi_uring_get_fd(&uring->ring),
@@ -1858,6 +2164,7 @@ int xnet_init_progress(struct xnet_progress *progress, struct fi_info *info)
 	dlist_init(&progress->unexp_msg_list);
 	dlist_init(&progress->unexp_tag_list);
 	dlist_init(&progress->saved_tag_list);
+	dlist_init(&progress->tx_hold_list);
 	slist_init(&progress->event_list);
 
 	ret = fd_signal_init(&progress->signal);
@@ -1874,6 +2181,12 @@ int xnet_init_progress(struct xnet_progress *progress, struct fi_info *info)
 	if (ret)
 		goto err2;
 
+	if (xnet_busy_poll &&
+	    ofi_dynpoll_busy_poll(&progress->epoll_fd, xnet_busy_poll)) {
+		FI_INFO(&xnet_prov, FI_LOG_DOMAIN,
+			"epoll busy poll parameters not supported\n");
+	}
+
 	ret = ofi_bufpool_create(&progress->xfer_pool,
 			sizeof(struct xnet_xfer_entry) + xnet_buf_size,
 			16, 0, 1024, 0);
@@ -1900,6 +2213,19 @@ int xnet_init_progress(struct xnet_progress *progress, struct fi_info *info)
 		if (ret)
 			goto err6;
 
+		/* Zero-copy sends do not need SO_ZEROCOPY with io_uring */
+		progress->sockapi.tx_uring.zc_size = xnet_zerocopy_size;
+		if (xnet_uring_fixed_cnt > 0) {
+			ret = ofi_uring_init_fixed(&progress->sockapi.tx_uring,
+						   xnet_uring_fixed_cnt);
+			if (ret) {
+				FI_INFO(&xnet_prov, FI_LOG_EP_CTRL,
+					"unable to register io_uring files "
+					"(%d), using unregistered sends\n",
+					ret);
+			}
+		}
+
 		ret = xnet_init_uring(&progress->rx_uring,
 				      info ? info->rx_attr->size :
 					     xnet_default_rx_size,
@@ -1907,12 +2233,31 @@ int xnet_init_progress(struct xnet_progress *progress, struct fi_info *info)
 				      &progress->epoll_fd);
 		if (ret)
 			goto err7;
+
+		progress->bufring.cnt = 0;
+		dlist_init(&progress->rbuf_wait_list);
+		if (xnet_uring_rbuf_cnt) {
+			ret = ofi_bufring_init(&progress->bufring,
+					       &progress->rx_uring.ring,
+					       xnet_uring_rbuf_cnt,
+					       xnet_uring_rbuf_size, 0);
+			if (ret) {
+				FI_WARN(&xnet_prov, FI_LOG_EP_CTRL,
+					"unable to create io_uring buffer ring "
+					"(%d), using socket receives\n", ret);
+				progress->bufring.cnt = 0;
+			}
+			progress->rbuf_ep_max = xnet_uring_ep_rbuf_cnt > 0 ?
+				(unsigned int) xnet_uring_ep_rbuf_cnt :
+				MAX(progress->bufring.cnt / 8, 2U);
+		}
 	} else {
 		progress->sockapi = xnet_sockapi_socket;
 	}
 
 	return 0;
 err7:
+	ofi_uring_cleanup_fixed(&progress->sockapi.tx_uring);
 	xnet_destroy_uring(&progress->tx_uring, &progress->epoll_fd);
 err6:
 	ofi_dynpoll_del(&progress->epoll_fd, progress->signal.fd[FI_READ_FD]);
@@ -1935,11 +2280,16 @@ void xnet_close_progress(struct xnet_progress *progress)
 	assert(dlist_empty(&progress->unexp_msg_list));
 	assert(dlist_empty(&progress->unexp_tag_list));
 	assert(dlist_empty(&progress->saved_tag_list));
+	assert(dlist_empty(&progress->tx_hold_list));
 	assert(slist_empty(&progress->event_list));
 	xnet_stop_progress(progress);
 	if (xnet_io_uring) {
 		free(progress->cqes);
+		assert(dlist_empty(&progress->rbuf_wait_list));
+		if (progress->bufring.cnt)
+			ofi_bufring_cleanup(&progress->bufring);
 		xnet_destroy_uring(&progress->rx_uring, &progress->epoll_fd);
+		ofi_uring_cleanup_fixed(&progress->sockapi.tx_uring);
 		xnet_destroy_uring(&progress->tx_uring, &progress->epoll_fd);
 	}
 	ofi_dynpoll_close(&progress->epoll_fd);
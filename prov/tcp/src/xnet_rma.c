@@ -266,6 +266,7 @@ xnet_rma_writemsg(struct fid_ep *ep_fid, const struct fi_msg_rma *msg,
 			       FI_RMA | FI_WRITE;
 	send_entry->cntr = ep->util_ep.cntrs[CNTR_WR];
 	xnet_set_commit_flags(send_entry, flags);
+	xnet_set_more_flag(send_entry, flags);
 	send_entry->context = msg->context;
 
 	xnet_tx_queue_insert(ep, send_entry);
@@ -41,6 +41,7 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <netinet/ip.h>
+#include <netinet/udp.h>
 
 #include <rdma/fabric.h>
 #include <rdma/fi_atomic.h>
@@ -78,7 +79,22 @@ int udpx_eq_open(struct fid_fabric *fabric, struct fi_eq_attr *attr,
 
 
 #define UDPX_FLAG_MULTI_RECV	1
+#define UDPX_FLAG_SEG		2
 #define UDPX_IOV_LIMIT		4
+#define UDPX_MAX_BATCH		64
+
+#define HAVE_UDPX_SEG		(HAVE_DECL_UDP_SEGMENT && HAVE_DECL_UDP_GRO)
+#define UDPX_MAX_SEG_CNT	64
+#define UDPX_MAX_SEG_LEN	(UINT16_MAX - sizeof(struct iphdr) - \
+				 sizeof(struct udphdr))
+
+struct udpx_env {
+	size_t	rx_batch;
+	size_t	tx_batch;
+	int	tx_loss;
+};
+
+extern struct udpx_env udpx_env;
 
 struct udpx_ep_entry {
 	void			*context;
@@ -86,6 +102,7 @@ struct udpx_ep_entry {
 	uint8_t			iov_count;
 	uint8_t			flags;
 	uint8_t			resv[sizeof(size_t) - 2];
+	size_t			*seg_size;
 };
 
 OFI_DECLARE_CIRQUE(struct udpx_ep_entry, udpx_rx_cirq);
@@ -95,13 +112,39 @@ typedef void (*udpx_rx_comp_func)(struct udpx_ep *ep, void *context,
 		uint64_t flags, size_t len, void *buf, void *addr);
 typedef void (*udpx_tx_comp_func)(struct udpx_ep *ep, void *context);
 
+#if HAVE_RECVMMSG
+struct udpx_rx_batch {
+	struct mmsghdr		msg[UDPX_MAX_BATCH];
+	struct sockaddr_in6	addr[UDPX_MAX_BATCH];
+};
+#endif
+
+#if HAVE_SENDMMSG
+/* Sends posted with FI_MORE, flushed with a single sendmmsg() */
+struct udpx_tx_batch {
+	size_t			cnt;
+	void			*context[UDPX_MAX_BATCH];
+	bool			lost[UDPX_MAX_BATCH]; /* loss injection */
+	struct iovec		iov[UDPX_MAX_BATCH][UDPX_IOV_LIMIT];
+	struct mmsghdr		msg[UDPX_MAX_BATCH];
+};
+#endif
+
 struct udpx_ep {
 	struct util_ep		util_ep;
 	udpx_rx_comp_func	rx_comp;
 	udpx_tx_comp_func	tx_comp;
 	struct udpx_rx_cirq	*rxq;    /* protected by rx_cq lock */
+#if HAVE_RECVMMSG
+	struct udpx_rx_batch	*rx_batch; /* protected by rx_cq lock */
+#endif
+#if HAVE_SENDMMSG
+	struct udpx_tx_batch	*tx_batch; /* protected by tx_cq lock */
+#endif
 	SOCKET			sock;
 	int			is_bound;
+	int			gro;	 /* UDP_GRO enabled on sock */
+	uint32_t		loss_seed; /* protected by tx_cq lock */
 	ofi_atomic32_t		ref;
 };
 
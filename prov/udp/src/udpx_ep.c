@@ -228,6 +228,13 @@ static void udpx_tx_comp(struct udpx_ep *ep, void *context)
 	ofi_cirque_commit(ep->util_ep.tx_cq->cirq);
 }
 
+/* Loss injection: report the send as complete without sending it */
+static bool udpx_tx_lost(struct udpx_ep *ep)
+{
+	return udpx_env.tx_loss &&
+	       !(ofi_xorshift_random_r(&ep->loss_seed) % udpx_env.tx_loss);
+}
+
 static void udpx_tx_comp_signal(struct udpx_ep *ep, void *context)
 {
 	udpx_tx_comp(ep, context);
@@ -270,15 +277,101 @@ static void udpx_rx_src_comp_signal(struct udpx_ep *ep, void *context,
 	ep->util_ep.rx_cq->wait->signal(ep->util_ep.rx_cq->wait);
 }
 
-static void udpx_ep_progress(struct util_ep *util_ep)
+static const void *
+udpx_dest_addr(struct udpx_ep *ep, fi_addr_t addr, uint64_t flags)
+{
+	return (flags & FI_MULTICAST) ?
+	       (const void *) (uintptr_t) addr :
+	       ofi_ip_av_get_addr(ep->util_ep.av, (int)addr);
+}
+
+static size_t
+udpx_dest_addrlen(struct udpx_ep *ep, fi_addr_t addr, uint64_t flags)
+{
+	return (flags & FI_MULTICAST) ?
+		ofi_sizeofaddr((const void *) (uintptr_t) addr) :
+		ep->util_ep.av->addrlen;
+}
+
+/* Receive completions must not take the slots reserved by queued sends */
+static size_t udpx_rx_comp_space(struct udpx_ep *ep)
+{
+	size_t space = ofi_cirque_freecnt(ep->util_ep.rx_cq->cirq);
+
+#if HAVE_SENDMMSG
+	if (ep->tx_batch && ep->util_ep.tx_cq == ep->util_ep.rx_cq)
+		space -= MIN(space, ep->tx_batch->cnt);
+#endif
+	return space;
+}
+
+#if HAVE_RECVMMSG
+static void udpx_progress_rx_batch(struct udpx_ep *ep)
+{
+	struct udpx_rx_batch *batch = ep->rx_batch;
+	struct udpx_ep_entry *entry;
+	struct msghdr *hdr;
+	size_t i, cnt;
+	int ret;
+
+	cnt = MIN(ofi_cirque_usedcnt(ep->rxq), udpx_env.rx_batch);
+	cnt = MIN(cnt, udpx_rx_comp_space(ep));
+	for (i = 0; i < cnt; i++) {
+		entry = &ep->rxq->buf[(ep->rxq->rcnt + i) & ep->rxq->size_mask];
+		hdr = &batch->msg[i].msg_hdr;
+		hdr->msg_name = &batch->addr[i];
+		hdr->msg_namelen = sizeof(batch->addr[i]);
+		hdr->msg_iov = entry->iov;
+		hdr->msg_iovlen = entry->iov_count;
+	}
+
+	ret = cnt ? recvmmsg(ep->sock, batch->msg, (unsigned int) cnt, 0,
+			     NULL) : 0;
+	if (ret <= 0)
+		return;
+
+	for (i = 0; i < (size_t) ret; i++) {
+		entry = ofi_cirque_head(ep->rxq);
+		if (ep->util_ep.domain->info_domain_caps & FI_SOURCE)
+			udpx_rx_src_comp(ep, entry->context, 0,
+					 batch->msg[i].msg_len, NULL,
+					 &batch->addr[i]);
+		else
+			udpx_rx_comp(ep, entry->context, 0,
+				     batch->msg[i].msg_len, NULL,
+				     &batch->addr[i]);
+		ofi_cirque_discard(ep->rxq);
+	}
+
+	if (ep->util_ep.rx_cq->wait)
+		ep->util_ep.rx_cq->wait->signal(ep->util_ep.rx_cq->wait);
+}
+#endif
+
+#if HAVE_UDPX_SEG
+static size_t udpx_gro_size(struct msghdr *hdr, size_t len)
+{
+	struct cmsghdr *cmsg;
+
+	for (cmsg = CMSG_FIRSTHDR(hdr); cmsg; cmsg = CMSG_NXTHDR(hdr, cmsg)) {
+		if (cmsg->cmsg_level == IPPROTO_UDP &&
+		    cmsg->cmsg_type == UDP_GRO)
+			return *(int *) CMSG_DATA(cmsg);
+	}
+	return len;
+}
+#endif
+
+static void udpx_progress_rx(struct udpx_ep *ep)
 {
-	struct udpx_ep *ep;
 	struct udpx_ep_entry *entry;
 	struct msghdr hdr;
 	struct sockaddr_in6 addr;
+#if HAVE_UDPX_SEG
+	char ctrl[CMSG_SPACE(sizeof(int))];
+#endif
 	ssize_t ret;
 
-	ep = container_of(util_ep, struct udpx_ep, util_ep);
 	hdr.msg_name = &addr;
 	hdr.msg_namelen = sizeof(addr);
 	hdr.msg_control = NULL;
@@ -286,15 +379,32 @@ static void udpx_ep_progress(struct util_ep *util_ep)
 	hdr.msg_flags = 0;
 
 	ofi_genlock_lock(&ep->util_ep.rx_cq->cq_lock);
-	if (ofi_cirque_isempty(ep->rxq))
+	if (ofi_cirque_isempty(ep->rxq) || !udpx_rx_comp_space(ep))
 		goto out;
 
+#if HAVE_RECVMMSG
+	if (ep->rx_batch && !ep->gro && ofi_cirque_usedcnt(ep->rxq) > 1) {
+		udpx_progress_rx_batch(ep);
+		goto out;
+	}
+#endif
+
 	entry = ofi_cirque_head(ep->rxq);
 	hdr.msg_iov = entry->iov;
 	hdr.msg_iovlen = entry->iov_count;
+#if HAVE_UDPX_SEG
+	if (entry->flags & UDPX_FLAG_SEG) {
+		hdr.msg_control = ctrl;
+		hdr.msg_controllen = sizeof(ctrl);
+	}
+#endif
 
 	ret = ofi_recvmsg_udp(ep->sock, &hdr, 0);
 	if (ret >= 0) {
+#if HAVE_UDPX_SEG
+		if (entry->flags & UDPX_FLAG_SEG)
+			*entry->seg_size = udpx_gro_size(&hdr, ret);
+#endif
 		ep->rx_comp(ep, entry->context, 0, ret, NULL, &addr);
 		ofi_cirque_discard(ep->rxq);
 	}
@@ -302,6 +412,159 @@ out:
 	ofi_genlock_unlock(&ep->util_ep.rx_cq->cq_lock);
 }
 
+#if HAVE_SENDMMSG
+static void udpx_flush_tx(struct udpx_ep *ep)
+{
+	struct udpx_tx_batch *batch = ep->tx_batch;
+	struct fi_cq_err_entry err_entry;
+	size_t i, end, done = 0;
+	int ret;
+
+	assert(ofi_genlock_held(&ep->util_ep.tx_cq->cq_lock));
+	while (done < batch->cnt) {
+		if (batch->lost[done]) {
+			udpx_tx_comp(ep, batch->context[done++]);
+			continue;
+		}
+
+		for (end = done + 1; end < batch->cnt && !batch->lost[end];
+		     end++)
+			;
+		ret = sendmmsg(ep->sock, &batch->msg[done],
+			       (unsigned int) (end - done), 0);
+		if (ret < 0) {
+			ret = ofi_sockerr();
+			if (OFI_SOCK_TRY_SND_RCV_AGAIN(ret))
+				break;
+
+			FI_WARN(&udpx_prov, FI_LOG_EP_DATA,
+				"sendmmsg failed %d (%s)\n", ret, strerror(ret));
+			memset(&err_entry, 0, sizeof(err_entry));
+			err_entry.op_context = batch->context[done];
+			err_entry.flags = FI_SEND;
+			err_entry.err = ret;
+			err_entry.prov_errno = -ret;
+			(void) ofi_cq_insert_error(ep->util_ep.tx_cq, &err_entry);
+			done++;
+			continue;
+		}
+
+		for (i = 0; i < (size_t) ret; i++)
+			udpx_tx_comp(ep, batch->context[done + i]);
+		done += ret;
+	}
+
+	if (!done)
+		return;
+
+	batch->cnt -= done;
+	if (batch->cnt) {
+		memmove(batch->context, &batch->context[done],
+			sizeof(*batch->context) * batch->cnt);
+		memmove(batch->lost, &batch->lost[done],
+			sizeof(*batch->lost) * batch->cnt);
+		memmove(batch->iov, &batch->iov[done],
+			sizeof(*batch->iov) * batch->cnt);
+		memmove(batch->msg, &batch->msg[done],
+			sizeof(*batch->msg) * batch->cnt);
+		for (i = 0; i < batch->cnt; i++)
+			batch->msg[i].msg_hdr.msg_iov = batch->iov[i];
+	}
+
+	if (ep->util_ep.tx_cq->wait)
+		ep->util_ep.tx_cq->wait->signal(ep->util_ep.tx_cq->wait);
+}
+
+static ssize_t udpx_queue_tx(struct udpx_ep *ep, const struct fi_msg *msg,
+			     uint64_t flags)
+{
+	struct udpx_tx_batch *batch = ep->tx_batch;
+	struct msghdr *hdr;
+
+	assert(ofi_genlock_held(&ep->util_ep.tx_cq->cq_lock));
+	if (msg->iov_count > UDPX_IOV_LIMIT)
+		return -FI_EINVAL;
+
+	if (batch->cnt == udpx_env.tx_batch) {
+		udpx_flush_tx(ep);
+		if (batch->cnt == udpx_env.tx_batch)
+			return -FI_EAGAIN;
+	}
+
+	/* Reserve a CQ slot for every queued send */
+	if (ofi_cirque_freecnt(ep->util_ep.tx_cq->cirq) <= batch->cnt)
+		return -FI_EAGAIN;
+
+	/* Lost sends are completed in order with the queued sends */
+	batch->lost[batch->cnt] = udpx_tx_lost(ep);
+	if (batch->lost[batch->cnt]) {
+		batch->context[batch->cnt++] = msg->context;
+		goto flush;
+	}
+
+	memcpy(batch->iov[batch->cnt], msg->msg_iov,
+	       sizeof(*msg->msg_iov) * msg->iov_count);
+	hdr = &batch->msg[batch->cnt].msg_hdr;
+	hdr->msg_name = (void *) udpx_dest_addr(ep, msg->addr, flags);
+	hdr->msg_namelen = (socklen_t) udpx_dest_addrlen(ep, msg->addr, flags);
+	hdr->msg_iov = batch->iov[batch->cnt];
+	hdr->msg_iovlen = msg->iov_count;
+	hdr->msg_control = NULL;
+	hdr->msg_controllen = 0;
+	hdr->msg_flags = 0;
+	batch->context[batch->cnt++] = msg->context;
+
+flush:
+	if (!(flags & FI_MORE) || batch->cnt == udpx_env.tx_batch)
+		udpx_flush_tx(ep);
+	return 0;
+}
+
+static void udpx_progress_tx(struct udpx_ep *ep)
+{
+	ofi_genlock_lock(&ep->util_ep.tx_cq->cq_lock);
+	if (ep->tx_batch->cnt)
+		udpx_flush_tx(ep);
+	ofi_genlock_unlock(&ep->util_ep.tx_cq->cq_lock);
+}
+
+/* Sends still queued when the endpoint closes are sent or canceled */
+static void udpx_drain_tx(struct udpx_ep *ep)
+{
+	struct udpx_tx_batch *batch = ep->tx_batch;
+	struct fi_cq_err_entry err_entry;
+	size_t i;
+
+	ofi_genlock_lock(&ep->util_ep.tx_cq->cq_lock);
+	if (batch->cnt)
+		udpx_flush_tx(ep);
+
+	for (i = 0; i < batch->cnt; i++) {
+		memset(&err_entry, 0, sizeof(err_entry));
+		err_entry.op_context = batch->context[i];
+		err_entry.flags = FI_SEND;
+		err_entry.err = FI_ECANCELED;
+		(void) ofi_cq_insert_error(ep->util_ep.tx_cq, &err_entry);
+	}
+	batch->cnt = 0;
+	ofi_genlock_unlock(&ep->util_ep.tx_cq->cq_lock);
+}
+#endif
+
+static void udpx_ep_progress(struct util_ep *util_ep)
+{
+	struct udpx_ep *ep;
+
+	ep = container_of(util_ep, struct udpx_ep, util_ep);
+	if (ep->util_ep.rx_cq)
+		udpx_progress_rx(ep);
+
+#if HAVE_SENDMMSG
+	if (ep->tx_batch && ep->util_ep.tx_cq)
+		udpx_progress_tx(ep);
+#endif
+}
+
 static ssize_t udpx_recvmsg(struct fid_ep *ep_fid, const struct fi_msg *msg,
 			    uint64_t flags)
 {
@@ -371,22 +634,6 @@ out:
 	return ret;
 }
 
-static const void *
-udpx_dest_addr(struct udpx_ep *ep, fi_addr_t addr, uint64_t flags)
-{
-	return (flags & FI_MULTICAST) ?
-	       (const void *) (uintptr_t) addr :
-	       ofi_ip_av_get_addr(ep->util_ep.av, (int)addr);
-}
-
-static size_t
-udpx_dest_addrlen(struct udpx_ep *ep, fi_addr_t addr, uint64_t flags)
-{
-	return (flags & FI_MULTICAST) ?
-		ofi_sizeofaddr((const void *) (uintptr_t) addr) :
-		ep->util_ep.av->addrlen;
-}
-
 static ssize_t udpx_sendto(struct udpx_ep *ep, const void *buf, size_t len,
 			   const void *addr, size_t addrlen, void *context)
 {
@@ -398,7 +645,18 @@ static ssize_t udpx_sendto(struct udpx_ep *ep, const void *buf, size_t len,
 		goto out;
 	}
 
-	ret = ofi_sendto_socket(ep->sock, buf, len, 0,
+#if HAVE_SENDMMSG
+	if (ep->tx_batch && ep->tx_batch->cnt) {
+		udpx_flush_tx(ep);
+		if (ep->tx_batch->cnt) {
+			ret = -FI_EAGAIN;
+			goto out;
+		}
+	}
+#endif
+
+	ret = udpx_tx_lost(ep) ? (ssize_t) len :
+	      ofi_sendto_socket(ep->sock, buf, len, 0,
 				addr, (socklen_t)addrlen);
 	if (ret == (ssize_t)len) {
 		ep->tx_comp(ep, context);
@@ -454,7 +712,14 @@ static ssize_t udpx_sendmsg(struct fid_ep *ep_fid, const struct fi_msg *msg,
 		goto out;
 	}
 
-	ret = ofi_sendmsg_udp(ep->sock, &hdr, 0);
+#if HAVE_SENDMMSG
+	if (ep->tx_batch && ((flags & FI_MORE) || ep->tx_batch->cnt)) {
+		ret = udpx_queue_tx(ep, msg, flags);
+		goto out;
+	}
+#endif
+
+	ret = udpx_tx_lost(ep) ? 0 : ofi_sendmsg_udp(ep->sock, &hdr, 0);
 	if (ret >= 0) {
 		ep->tx_comp(ep, msg->context);
 		ret = 0;
@@ -494,30 +759,53 @@ static ssize_t udpx_sendv_mc(struct fid_ep *ep_fid, const struct iovec *iov,
 	return udpx_sendmsg(ep_fid, &msg, FI_MULTICAST);
 }
 
+static ssize_t udpx_inject_to(struct udpx_ep *ep, const void *buf,
+			      size_t len, const void *addr, socklen_t addrlen)
+{
+	ssize_t ret;
+
+#if HAVE_SENDMMSG
+	/* Sends queued with FI_MORE must go out ahead of the inject */
+	if (ep->tx_batch && ep->util_ep.tx_cq) {
+		ofi_genlock_lock(&ep->util_ep.tx_cq->cq_lock);
+		if (ep->tx_batch->cnt)
+			udpx_flush_tx(ep);
+
+		if (ep->tx_batch->cnt) {
+			ret = -FI_EAGAIN;
+		} else {
+			ret = ofi_sendto_socket(ep->sock, buf, len, 0,
+						addr, addrlen);
+			ret = ret == (ssize_t) len ? 0 : -errno;
+		}
+		ofi_genlock_unlock(&ep->util_ep.tx_cq->cq_lock);
+		return ret;
+	}
+#endif
+
+	ret = ofi_sendto_socket(ep->sock, buf, len, 0, addr, addrlen);
+	return ret == (ssize_t)len ? 0 : -errno;
+}
+
 static ssize_t udpx_inject(struct fid_ep *ep_fid, const void *buf, size_t len,
 			   fi_addr_t dest_addr)
 {
 	struct udpx_ep *ep;
-	ssize_t ret;
 
 	ep = container_of(ep_fid, struct udpx_ep, util_ep.ep_fid.fid);
-	ret = ofi_sendto_socket(ep->sock, buf, len, 0,
-				ofi_ip_av_get_addr(ep->util_ep.av, (int)dest_addr),
-				(socklen_t)ep->util_ep.av->addrlen);
-	return ret == (ssize_t)len ? 0 : -errno;
+	return udpx_inject_to(ep, buf, len,
+			      ofi_ip_av_get_addr(ep->util_ep.av, (int)dest_addr),
+			      (socklen_t)ep->util_ep.av->addrlen);
 }
 
 static ssize_t udpx_inject_mc(struct fid_ep *ep_fid, const void *buf,
 			      size_t len, fi_addr_t dest_addr)
 {
 	struct udpx_ep *ep;
-	ssize_t ret;
 
 	ep = container_of(ep_fid, struct udpx_ep, util_ep.ep_fid.fid);
-	ret = ofi_sendto_socket(ep->sock, buf, len, 0,
-				(const void *)(uintptr_t)dest_addr,
-				(socklen_t)ofi_sizeofaddr((const void *)(uintptr_t)dest_addr));
-	return ret == (ssize_t)len ? 0 : -errno;
+	return udpx_inject_to(ep, buf, len, (const void *)(uintptr_t)dest_addr,
+			      (socklen_t)ofi_sizeofaddr((const void *)(uintptr_t)dest_addr));
 }
 
 static struct fi_ops_msg udpx_msg_ops = {
@@ -568,6 +856,22 @@ static int udpx_ep_close(struct fid *fid)
 				&ep->util_ep.ep_fid.fid);
 	}
 
+	if (ep->util_ep.tx_cq) {
+#if HAVE_SENDMMSG
+		if (ep->tx_batch)
+			udpx_drain_tx(ep);
+#endif
+		fid_list_remove2(&ep->util_ep.tx_cq->ep_list,
+				 &ep->util_ep.tx_cq->ep_list_lock,
+				 &ep->util_ep.ep_fid.fid);
+	}
+
+#if HAVE_RECVMMSG
+	free(ep->rx_batch);
+#endif
+#if HAVE_SENDMMSG
+	free(ep->tx_batch);
+#endif
 	udpx_rx_cirq_free(ep->rxq);
 	ofi_close_socket(ep->sock);
 	ofi_endpoint_close(&ep->util_ep);
@@ -590,6 +894,16 @@ static int udpx_ep_bind_cq(struct udpx_ep *ep, struct util_cq *cq,
 		ofi_atomic_inc32(&cq->ref);
 		ep->tx_comp = cq->wait ? udpx_tx_comp_signal :
 					 udpx_tx_comp;
+#if HAVE_SENDMMSG
+		/* Queued sends are flushed when the TX CQ is progressed */
+		if (ep->tx_batch) {
+			ret = fid_list_insert2(&cq->ep_list,
+					       &cq->ep_list_lock,
+					       &ep->util_ep.ep_fid.fid);
+			if (ret)
+				return ret;
+		}
+#endif
 	}
 
 	if (flags & FI_RECV) {
@@ -713,14 +1027,185 @@ static int udpx_ep_ctrl(struct fid *fid, int command, void *arg)
 	return 0;
 }
 
+#if HAVE_UDPX_SEG
+static int udpx_seg_query(struct fid_ep *ep_fid, size_t *max_cnt,
+			  size_t *max_len)
+{
+	struct udpx_ep *ep;
+	socklen_t len;
+	int val;
+
+	ep = container_of(ep_fid, struct udpx_ep, util_ep.ep_fid);
+	len = sizeof(val);
+	if (getsockopt(ep->sock, IPPROTO_UDP, UDP_SEGMENT, &val, &len))
+		return -FI_ENOSYS;
+
+	*max_cnt = UDPX_MAX_SEG_CNT;
+	*max_len = UDPX_MAX_SEG_LEN;
+	return 0;
+}
+
+static ssize_t udpx_seg_sendv(struct fid_ep *ep_fid, const struct iovec *iov,
+			      void **context, size_t count, fi_addr_t dest_addr)
+{
+	struct udpx_ep *ep;
+	struct msghdr hdr;
+	struct cmsghdr *cmsg;
+	char ctrl[CMSG_SPACE(sizeof(uint16_t))];
+	size_t i;
+	ssize_t ret;
+
+	if (!count || count > UDPX_MAX_SEG_CNT)
+		return -FI_EINVAL;
+
+	ep = container_of(ep_fid, struct udpx_ep, util_ep.ep_fid);
+	hdr.msg_name = (void *) ofi_ip_av_get_addr(ep->util_ep.av,
+						   (int) dest_addr);
+	hdr.msg_namelen = (socklen_t) ep->util_ep.av->addrlen;
+	hdr.msg_iov = (struct iovec *) iov;
+	hdr.msg_iovlen = count;
+	hdr.msg_control = NULL;
+	hdr.msg_controllen = 0;
+	hdr.msg_flags = 0;
+
+	/* The kernel splits the payload into gso_size datagrams */
+	if (count > 1) {
+		memset(ctrl, 0, sizeof(ctrl));
+		hdr.msg_control = ctrl;
+		hdr.msg_controllen = sizeof(ctrl);
+		cmsg = CMSG_FIRSTHDR(&hdr);
+		cmsg->cmsg_level = IPPROTO_UDP;
+		cmsg->cmsg_type = UDP_SEGMENT;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+		*(uint16_t *) CMSG_DATA(cmsg) = (uint16_t) iov[0].iov_len;
+	}
+
+	ofi_genlock_lock(&ep->util_ep.tx_cq->cq_lock);
+	if (ofi_cirque_freecnt(ep->util_ep.tx_cq->cirq) < count) {
+		ret = -FI_EAGAIN;
+		goto out;
+	}
+
+#if HAVE_SENDMMSG
+	if (ep->tx_batch && ep->tx_batch->cnt) {
+		udpx_flush_tx(ep);
+		if (ep->tx_batch->cnt) {
+			ret = -FI_EAGAIN;
+			goto out;
+		}
+	}
+#endif
+
+	ret = udpx_tx_lost(ep) ? 0 : ofi_sendmsg_udp(ep->sock, &hdr, 0);
+	if (ret < 0) {
+		ret = -errno;
+		goto out;
+	}
+
+	for (i = 0; i < count; i++)
+		udpx_tx_comp(ep, context[i]);
+	if (ep->util_ep.tx_cq->wait)
+		ep->util_ep.tx_cq->wait->signal(ep->util_ep.tx_cq->wait);
+	ret = 0;
+out:
+	ofi_genlock_unlock(&ep->util_ep.tx_cq->cq_lock);
+	return ret;
+}
+
+static ssize_t udpx_seg_recv(struct fid_ep *ep_fid, void *buf, size_t len,
+			     void *context, size_t *seg_size)
+{
+	struct udpx_ep *ep;
+	struct udpx_ep_entry *entry;
+	int on = 1;
+	ssize_t ret;
+
+	ep = container_of(ep_fid, struct udpx_ep, util_ep.ep_fid);
+	ofi_genlock_lock(&ep->util_ep.rx_cq->cq_lock);
+	if (!ep->gro) {
+		if (setsockopt(ep->sock, IPPROTO_UDP, UDP_GRO, &on,
+			       sizeof(on))) {
+			ret = -ofi_sockerr();
+			goto out;
+		}
+		ep->gro = 1;
+	}
+
+	if (ofi_cirque_isfull(ep->rxq)) {
+		ret = -FI_EAGAIN;
+		goto out;
+	}
+
+	entry = ofi_cirque_next(ep->rxq);
+	entry->context = context;
+	entry->iov_count = 1;
+	entry->iov[0].iov_base = buf;
+	entry->iov[0].iov_len = len;
+	entry->flags = UDPX_FLAG_SEG;
+	entry->seg_size = seg_size;
+
+	ofi_cirque_commit(ep->rxq);
+	ret = 0;
+out:
+	ofi_genlock_unlock(&ep->util_ep.rx_cq->cq_lock);
+	return ret;
+}
+
+static struct ofi_ops_dgram_seg udpx_seg_ops = {
+	.size = sizeof(struct ofi_ops_dgram_seg),
+	.query = udpx_seg_query,
+	.sendv = udpx_seg_sendv,
+	.recv = udpx_seg_recv,
+};
+#endif
+
+static int udpx_ep_ops_open(struct fid *fid, const char *name, uint64_t flags,
+			    void **ops, void *context)
+{
+	if (flags)
+		return -FI_EBADFLAGS;
+
+#if HAVE_UDPX_SEG
+	if (!strcasecmp(name, OFI_OPS_DGRAM_SEG)) {
+		*ops = &udpx_seg_ops;
+		return 0;
+	}
+#endif
+
+	return -FI_ENOSYS;
+}
+
 static struct fi_ops udpx_ep_fi_ops = {
 	.size = sizeof(struct fi_ops),
 	.close = udpx_ep_close,
 	.bind = udpx_ep_bind,
 	.control = udpx_ep_ctrl,
-	.ops_open = fi_no_ops_open,
+	.ops_open = udpx_ep_ops_open,
 };
 
+static int udpx_ep_init_batch(struct udpx_ep *ep)
+{
+#if HAVE_RECVMMSG
+	if (udpx_env.rx_batch > 1) {
+		ep->rx_batch = calloc(1, sizeof(*ep->rx_batch));
+		if (!ep->rx_batch)
+			return -FI_ENOMEM;
+	}
+#endif
+#if HAVE_SENDMMSG
+	if (udpx_env.tx_batch > 1) {
+		ep->tx_batch = calloc(1, sizeof(*ep->tx_batch));
+		if (!ep->tx_batch) {
+#if HAVE_RECVMMSG
+			free(ep->rx_batch);
+#endif
+			return -FI_ENOMEM;
+		}
+	}
+#endif
+	return 0;
+}
+
 static int udpx_ep_init(struct udpx_ep *ep, struct fi_info *info)
 {
 	int family;
@@ -752,6 +1237,11 @@ static int udpx_ep_init(struct udpx_ep *ep, struct fi_info *info)
 	if (ret)
 		goto err2;
 
+	ret = udpx_ep_init_batch(ep);
+	if (ret)
+		goto err2;
+
+	ep->loss_seed = (uint32_t) ((uintptr_t) ep ^ getpid()) | 1;
 	return 0;
 err2:
 	ofi_close_socket(ep->sock);
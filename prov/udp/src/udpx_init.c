@@ -37,6 +37,10 @@
 
 #include <sys/types.h>
 
+struct udpx_env udpx_env = {
+	.rx_batch = 16,
+	.tx_batch = 16,
+};
 
 static int udpx_getinfo(uint32_t version, const char *node, const char *service,
 			uint64_t flags, const struct fi_info *hints,
@@ -64,6 +68,27 @@ UDP_INI
 {
 	fi_param_define(&udpx_prov, "iface", FI_PARAM_STRING,
 			"Specify interface name");
+	fi_param_define(&udpx_prov, "rx_batch", FI_PARAM_SIZE_T,
+			"Maximum number of posted receives filled by a single "
+			"recvmmsg call during progress.  Set to 1 to receive "
+			"one datagram per call (default: 16)");
+	fi_param_define(&udpx_prov, "tx_batch", FI_PARAM_SIZE_T,
+			"Maximum number of sends posted with FI_MORE that are "
+			"coalesced into a single sendmmsg call.  Set to 1 to "
+			"disable coalescing (default: 16)");
+	fi_param_define(&udpx_prov, "tx_loss", FI_PARAM_INT,
+			"Testing only.  Silently drop about one out of every "
+			"N sent datagrams, to exercise loss recovery in "
+			"providers layered over udp.  A segmentation offload "
+			"send is dropped as a unit.  0 disables (default: 0)");
+
+	fi_param_get_size_t(&udpx_prov, "rx_batch", &udpx_env.rx_batch);
+	fi_param_get_size_t(&udpx_prov, "tx_batch", &udpx_env.tx_batch);
+	fi_param_get_int(&udpx_prov, "tx_loss", &udpx_env.tx_loss);
+	udpx_env.rx_batch = MIN(MAX(udpx_env.rx_batch, 1), UDPX_MAX_BATCH);
+	udpx_env.tx_batch = MIN(MAX(udpx_env.tx_batch, 1), UDPX_MAX_BATCH);
+	if (udpx_env.tx_loss < 0)
+		udpx_env.tx_loss = 0;
 
 	return &udpx_prov;
 }
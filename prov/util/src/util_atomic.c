@@ -1085,6 +1085,206 @@ static void ofi_log_atomic_info(const struct fi_provider *prov)
 
 #endif /* HAVE_BUILTIN_MM_ATOMICS */
 
+/*********************************************************************
+ * Non-atomic reduction handlers
+ *
+ * These apply an operation to a local buffer that the caller has
+ * exclusive access to (e.g. a collective's scratch buffer, or a target
+ * buffer only updated under a serialized progress engine).  The common
+ * reduction ops are processed in vector blocks, with the widest
+ * instruction set supported by the CPU selected at initialization.  All
+ * other op/datatype combinations fall back to the write handlers.
+ *********************************************************************/
+
+#define OFI_RED_MIN(d, s)	((d) > (s) ? (s) : (d))
+#define OFI_RED_MAX(d, s)	((d) < (s) ? (s) : (d))
+#define OFI_RED_SUM(d, s)	((d) + (s))
+#define OFI_RED_PROD(d, s)	((d) * (s))
+#define OFI_RED_BOR(d, s)	((d) | (s))
+#define OFI_RED_BAND(d, s)	((d) & (s))
+#define OFI_RED_BXOR(d, s)	((d) ^ (s))
+
+#ifdef __GNUC__
+
+#define OFI_REDUCE_VEC_SIZE	64
+
+#define OFI_DEF_REDUCE_VEC(type, mask_type)				\
+	typedef type ofi_vec_##type					\
+		__attribute__((vector_size(OFI_REDUCE_VEC_SIZE)));	\
+	typedef mask_type ofi_vmask_##type				\
+		__attribute__((vector_size(OFI_REDUCE_VEC_SIZE)));
+
+OFI_DEF_REDUCE_VEC(int8_t, int8_t)
+OFI_DEF_REDUCE_VEC(uint8_t, int8_t)
+OFI_DEF_REDUCE_VEC(int16_t, int16_t)
+OFI_DEF_REDUCE_VEC(uint16_t, int16_t)
+OFI_DEF_REDUCE_VEC(int32_t, int32_t)
+OFI_DEF_REDUCE_VEC(uint32_t, int32_t)
+OFI_DEF_REDUCE_VEC(int64_t, int64_t)
+OFI_DEF_REDUCE_VEC(uint64_t, int64_t)
+OFI_DEF_REDUCE_VEC(float, int32_t)
+OFI_DEF_REDUCE_VEC(double, int64_t)
+
+/* Vector comparisons return a lane mask, which selects src over dst */
+#define OFI_VRED_SELECT(type, d, s, m)					\
+	((ofi_vec_##type) (((ofi_vmask_##type) (d) & ~(m)) |		\
+			   ((ofi_vmask_##type) (s) & (m))))
+
+#define OFI_VRED_MIN(type, d, s)					\
+	OFI_VRED_SELECT(type, d, s, (ofi_vmask_##type) ((d) > (s)))
+#define OFI_VRED_MAX(type, d, s)					\
+	OFI_VRED_SELECT(type, d, s, (ofi_vmask_##type) ((d) < (s)))
+#define OFI_VRED_SUM(type, d, s)	OFI_RED_SUM(d, s)
+#define OFI_VRED_PROD(type, d, s)	OFI_RED_PROD(d, s)
+#define OFI_VRED_BOR(type, d, s)	OFI_RED_BOR(d, s)
+#define OFI_VRED_BAND(type, d, s)	OFI_RED_BAND(d, s)
+#define OFI_VRED_BXOR(type, d, s)	OFI_RED_BXOR(d, s)
+
+#define OFI_DEF_REDUCE_BODY(op, type)					\
+	type *d = dst;							\
+	const type *s = src;						\
+	ofi_vec_##type vd, vs;						\
+	size_t i;							\
+									\
+	for (i = 0; i + OFI_REDUCE_VEC_SIZE / sizeof(type) <= cnt;	\
+	     i += OFI_REDUCE_VEC_SIZE / sizeof(type)) {			\
+		memcpy(&vd, &d[i], sizeof(vd));				\
+		memcpy(&vs, &s[i], sizeof(vs));				\
+		vd = OFI_VRED_##op(type, vd, vs);			\
+		memcpy(&d[i], &vd, sizeof(vd));				\
+	}								\
+	for (; i < cnt; i++)						\
+		d[i] = OFI_RED_##op(d[i], s[i]);
+
+#else /* __GNUC__ */
+
+#define OFI_DEF_REDUCE_BODY(op, type)					\
+	type *d = dst;							\
+	const type *s = src;						\
+	size_t i;							\
+									\
+	for (i = 0; i < cnt; i++)					\
+		d[i] = OFI_RED_##op(d[i], s[i]);
+
+#endif /* __GNUC__ */
+
+#define OFI_DEF_REDUCE_NAME(isa, attr, op, type)			\
+	ofi_reduce_##isa##_##op##_##type,
+#define OFI_DEF_REDUCE_FUNC(isa, attr, op, type)			\
+	static void attr ofi_reduce_##isa##_##op##_##type		\
+		(void *dst, const void *src, size_t cnt)		\
+	{								\
+		OFI_DEF_REDUCE_BODY(op, type)				\
+	}
+
+#define OFI_DEFINE_REDUCE_INT_HANDLERS(FUNCNAME, isa, attr, op)	\
+	OFI_DEF_REDUCE_##FUNCNAME(isa, attr, op, int8_t)		\
+	OFI_DEF_REDUCE_##FUNCNAME(isa, attr, op, uint8_t)		\
+	OFI_DEF_REDUCE_##FUNCNAME(isa, attr, op, int16_t)		\
+	OFI_DEF_REDUCE_##FUNCNAME(isa, attr, op, uint16_t)		\
+	OFI_DEF_REDUCE_##FUNCNAME(isa, attr, op, int32_t)		\
+	OFI_DEF_REDUCE_##FUNCNAME(isa, attr, op, uint32_t)		\
+	OFI_DEF_REDUCE_##FUNCNAME(isa, attr, op, int64_t)		\
+	OFI_DEF_REDUCE_##FUNCNAME(isa, attr, op, uint64_t)
+
+#define OFI_DEFINE_REDUCE_REAL_HANDLERS(FUNCNAME, isa, attr, op)	\
+	OFI_DEFINE_REDUCE_INT_HANDLERS(FUNCNAME, isa, attr, op)		\
+	OFI_DEF_REDUCE_##FUNCNAME(isa, attr, op, float)			\
+	OFI_DEF_REDUCE_##FUNCNAME(isa, attr, op, double)
+
+#define OFI_DEFINE_REDUCE_TABLE(isa, attr)				\
+	OFI_DEFINE_REDUCE_REAL_HANDLERS(FUNC, isa, attr, MIN)		\
+	OFI_DEFINE_REDUCE_REAL_HANDLERS(FUNC, isa, attr, MAX)		\
+	OFI_DEFINE_REDUCE_REAL_HANDLERS(FUNC, isa, attr, SUM)		\
+	OFI_DEFINE_REDUCE_REAL_HANDLERS(FUNC, isa, attr, PROD)		\
+	OFI_DEFINE_REDUCE_INT_HANDLERS(FUNC, isa, attr, BOR)		\
+	OFI_DEFINE_REDUCE_INT_HANDLERS(FUNC, isa, attr, BAND)		\
+	OFI_DEFINE_REDUCE_INT_HANDLERS(FUNC, isa, attr, BXOR)		\
+									\
+	static void (*ofi_reduce_##isa##_handlers[OFI_WRITE_OP_CNT]	\
+						 [OFI_DATATYPE_CNT])	\
+		(void *dst, const void *src, size_t cnt) =		\
+	{								\
+		[FI_MIN] = { OFI_DEFINE_REDUCE_REAL_HANDLERS(NAME,	\
+					isa, attr, MIN) },		\
+		[FI_MAX] = { OFI_DEFINE_REDUCE_REAL_HANDLERS(NAME,	\
+					isa, attr, MAX) },		\
+		[FI_SUM] = { OFI_DEFINE_REDUCE_REAL_HANDLERS(NAME,	\
+					isa, attr, SUM) },		\
+		[FI_PROD] = { OFI_DEFINE_REDUCE_REAL_HANDLERS(NAME,	\
+					isa, attr, PROD) },		\
+		[FI_BOR] = { OFI_DEFINE_REDUCE_INT_HANDLERS(NAME,	\
+					isa, attr, BOR) },		\
+		[FI_BAND] = { OFI_DEFINE_REDUCE_INT_HANDLERS(NAME,	\
+					isa, attr, BAND) },		\
+		[FI_BXOR] = { OFI_DEFINE_REDUCE_INT_HANDLERS(NAME,	\
+					isa, attr, BXOR) },		\
+	};
+
+/* The generic kernels use the compiler's baseline vector ISA (e.g. SSE2) */
+OFI_DEFINE_REDUCE_TABLE(generic, )
+
+#if defined(__GNUC__) && defined(HAVE_CPUID) && \
+    (defined(__x86_64__) || defined(__amd64__))
+#define OFI_REDUCE_X86 1
+
+OFI_DEFINE_REDUCE_TABLE(avx2, __attribute__((target("avx2"))))
+OFI_DEFINE_REDUCE_TABLE(avx512,
+	__attribute__((target("avx512f,avx512bw,avx512dq"))))
+
+/* XCR0 state components that the OS must save for AVX and AVX-512 */
+#define OFI_XCR0_AVX	0x06
+#define OFI_XCR0_AVX512	0xe6
+
+static int ofi_reduce_os_supports(uint64_t xcr0_mask)
+{
+	if (!ofi_cpu_supports(0x1, OFI_OSXSAVE_REG, OFI_OSXSAVE_BIT))
+		return 0;
+	return (ofi_xgetbv(0) & xcr0_mask) == xcr0_mask;
+}
+
+#else
+#define OFI_REDUCE_X86 0
+#endif
+
+void (*ofi_atomic_reduce_handlers[OFI_WRITE_OP_CNT][OFI_DATATYPE_CNT])
+	(void *dst, const void *src, size_t cnt);
+
+void ofi_atomic_init(void)
+{
+	void (*(*handlers)[OFI_DATATYPE_CNT])
+		(void *dst, const void *src, size_t cnt);
+	const char *isa;
+	int op, dt;
+
+	handlers = ofi_reduce_generic_handlers;
+	isa = "generic";
+#if OFI_REDUCE_X86
+	if (ofi_cpu_supports(0x7, OFI_AVX512F_REG, OFI_AVX512F_BIT) &&
+	    ofi_cpu_supports(0x7, OFI_AVX512BW_REG, OFI_AVX512BW_BIT) &&
+	    ofi_cpu_supports(0x7, OFI_AVX512DQ_REG, OFI_AVX512DQ_BIT) &&
+	    ofi_reduce_os_supports(OFI_XCR0_AVX512)) {
+		handlers = ofi_reduce_avx512_handlers;
+		isa = "avx512";
+	} else if (ofi_cpu_supports(0x7, OFI_AVX2_REG, OFI_AVX2_BIT) &&
+		   ofi_reduce_os_supports(OFI_XCR0_AVX)) {
+		handlers = ofi_reduce_avx2_handlers;
+		isa = "avx2";
+	}
+#endif
+
+	for (op = 0; op < OFI_WRITE_OP_CNT; op++) {
+		for (dt = 0; dt < OFI_DATATYPE_CNT; dt++) {
+			ofi_atomic_reduce_handlers[op][dt] = handlers[op][dt] ?
+				handlers[op][dt] :
+				ofi_atomic_write_handlers[op][dt];
+		}
+	}
+
+	FI_INFO(&core_prov, FI_LOG_CORE,
+		"Using %s reduction kernels\n", isa);
+}
+
 int ofi_atomic_valid(const struct fi_provider *prov,
 		     enum fi_datatype datatype, enum fi_op op, uint64_t flags)
 {
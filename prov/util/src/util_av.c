@@ -298,13 +298,18 @@ int ofi_av_insert_addr_at(struct util_av *av, const void *addr, fi_addr_t fi_add
 	return 0;
 }
 
-int ofi_av_insert_addr(struct util_av *av, const void *addr, fi_addr_t *fi_addr)
+/* The caller hashes the address once for both the lookup and the add, and
+ * decides whether per address INFO logging is wanted.
+ */
+static int util_av_insert_hashed(struct util_av *av, const void *addr,
+				 unsigned hashv, fi_addr_t *fi_addr,
+				 bool log_info)
 {
 	struct util_av_entry *entry = NULL;
 
-	assert(ofi_mutex_held(&av->lock));
-	ofi_av_straddr_log(av, FI_LOG_INFO, "inserting addr", addr);
-	HASH_FIND(hh, av->hash, addr, av->addrlen, entry);
+	if (log_info)
+		ofi_av_straddr_log(av, FI_LOG_INFO, "inserting addr", addr);
+	HASH_FIND_BYHASHVALUE(hh, av->hash, addr, av->addrlen, hashv, entry);
 	if (entry) {
 		if (fi_addr)
 			*fi_addr = ofi_buf_index(entry);
@@ -323,13 +328,52 @@ int ofi_av_insert_addr(struct util_av *av, const void *addr, fi_addr_t *fi_addr)
 			*fi_addr = ofi_buf_index(entry);
 		memcpy(entry->data, addr, av->addrlen);
 		ofi_atomic_initialize32(&entry->use_cnt, 1);
-		HASH_ADD(hh, av->hash, data, av->addrlen, entry);
-		FI_INFO(av->prov, FI_LOG_AV, "fi_addr: %" PRIu64 "\n",
-			ofi_buf_index(entry));
+		HASH_ADD_BYHASHVALUE(hh, av->hash, data, av->addrlen, hashv,
+				     entry);
+		if (log_info)
+			FI_INFO(av->prov, FI_LOG_AV, "fi_addr: %" PRIu64 "\n",
+				ofi_buf_index(entry));
 	}
 	return 0;
 }
 
+int ofi_av_insert_addr(struct util_av *av, const void *addr, fi_addr_t *fi_addr)
+{
+	unsigned hashv;
+
+	assert(ofi_mutex_held(&av->lock));
+	HASH_VALUE(addr, av->addrlen, hashv);
+	return util_av_insert_hashed(av, addr, hashv, fi_addr, true);
+}
+
+/* Size the entry pool and hash table for cnt more addresses, so that a large
+ * insert does not repeatedly grow the pool and rehash the table.  This is
+ * best effort: the regular insert path grows both on demand.  The hash
+ * table only exists once it holds an entry, so callers reserve again after
+ * the first insert into an empty AV.
+ */
+static void util_av_reserve(struct util_av *av, size_t cnt)
+{
+	struct ofi_bufpool *pool = av->av_entry_pool;
+	UT_hash_table *tbl;
+	size_t total;
+
+	assert(ofi_mutex_held(&av->lock));
+	total = HASH_COUNT(av->hash) + cnt;
+	while (pool->entry_cnt < total) {
+		if (ofi_bufpool_grow(pool))
+			break;
+	}
+
+	if (!av->hash)
+		return;
+
+	/* keep the average chain length at or below 2 */
+	tbl = av->hash->hh.tbl;
+	while (!tbl->noexpand && tbl->num_buckets * 2 < total)
+		HASH_EXPAND_BUCKETS(hh, tbl, oomed);
+}
+
 int ofi_av_remove_addr(struct util_av *av, fi_addr_t fi_addr)
 {
 	struct util_av_entry *av_entry;
@@ -574,15 +618,16 @@ fi_addr_t ofi_ip_av_get_fi_addr(struct util_av *av, const void *addr)
 	return ofi_av_lookup_fi_addr(av, addr);
 }
 
+/* Caller must hold av->lock */
 static int ip_av_insert_addr(struct util_av *av, const void *addr,
-			     fi_addr_t *fi_addr, void *context)
+			     fi_addr_t *fi_addr, bool log_info)
 {
+	unsigned hashv;
 	int ret;
 
 	if (ofi_valid_dest_ipaddr(addr)) {
-		ofi_mutex_lock(&av->lock);
-		ret = ofi_av_insert_addr(av, addr, fi_addr);
-		ofi_mutex_unlock(&av->lock);
+		HASH_VALUE(addr, av->addrlen, hashv);
+		ret = util_av_insert_hashed(av, addr, hashv, fi_addr, log_info);
 	} else {
 		ret = -FI_EADDRNOTAVAIL;
 		if (fi_addr)
@@ -604,6 +649,7 @@ int ofi_ip_av_insertv(struct util_av *av, const void *addr, size_t addrlen,
 {
 	int ret, success_cnt = 0;
 	int *sync_err = NULL;
+	bool log_info, had_hash;
 	size_t i;
 
 	if (!count)
@@ -626,14 +672,24 @@ int ofi_ip_av_insertv(struct util_av *av, const void *addr, size_t addrlen,
 		memset(sync_err, 0, sizeof(*sync_err) * count);
 	}
 
+	log_info = fi_log_enabled(av->prov, FI_LOG_INFO, FI_LOG_AV);
+
+	ofi_mutex_lock(&av->lock);
+	if (count > 1)
+		util_av_reserve(av, count);
 	for (i = 0; i < count; i++) {
+		had_hash = av->hash != NULL;
 		ret = ip_av_insert_addr(av, (const char *) addr + i * addrlen,
-					fi_addr ? &fi_addr[i] : NULL, context);
+					fi_addr ? &fi_addr[i] : NULL, log_info);
 		if (!ret)
 			success_cnt++;
 		else if (sync_err)
 			sync_err[i] = -ret;
+
+		if (!had_hash && av->hash && i + 1 < count)
+			util_av_reserve(av, count - i - 1);
 	}
+	ofi_mutex_unlock(&av->lock);
 
 done:
 	FI_DBG(av->prov, FI_LOG_AV, "%d addresses successful\n", success_cnt);
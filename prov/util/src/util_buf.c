@@ -36,6 +36,7 @@
 #include <unistd.h>
 #include <ofi_enosys.h>
 #include <ofi_mem.h>
+#include <ofi_mb.h>
 #include <ofi.h>
 #include <ofi_osd.h>
 
@@ -58,6 +59,47 @@ enum {
 	OFI_BUFPOOL_REGION_CHUNK_CNT = 16
 };
 
+/*
+ * OFI_BUFPOOL_MT region tables are replaced rather than realloc'ed, so
+ * that ofi_bufpool_get_ibuf() can index a table while another thread
+ * grows the pool.  Old tables are kept until the pool is destroyed.
+ */
+struct ofi_bufpool_table {
+	struct slist_entry		entry;
+	struct ofi_bufpool_region	*regions[];
+};
+
+static struct ofi_bufpool_table *
+ofi_bufpool_table(struct ofi_bufpool_region **regions)
+{
+	return container_of(regions, struct ofi_bufpool_table, regions);
+}
+
+static int ofi_bufpool_mt_grow_table(struct ofi_bufpool *pool)
+{
+	struct ofi_bufpool_table *table;
+	size_t size;
+
+	size = pool->region_table_size ? pool->region_table_size * 2 :
+	       OFI_BUFPOOL_REGION_CHUNK_CNT;
+	table = malloc(sizeof(*table) + size * sizeof(*table->regions));
+	if (!table)
+		return -FI_ENOMEM;
+
+	if (pool->region_table) {
+		memcpy(table->regions, pool->region_table,
+		       pool->region_cnt * sizeof(*table->regions));
+		slist_insert_tail(&ofi_bufpool_table(pool->region_table)->entry,
+				  &pool->retired_tables);
+	}
+
+	/* publish the copied entries before the new table */
+	ofi_wmb();
+	pool->region_table = table->regions;
+	pool->region_table_size = size;
+	return 0;
+}
+
 
 static int ofi_bufpool_region_alloc(struct ofi_bufpool_region *buf_region)
 {
@@ -113,6 +155,25 @@ static int ofi_bufpool_region_alloc(struct ofi_bufpool_region *buf_region)
 				pool->alloc_size);
 }
 
+static void ofi_bufpool_region_bind(struct ofi_bufpool_region *buf_region)
+{
+	struct ofi_bufpool *pool = buf_region->pool;
+	int ret;
+
+	if (pool->numa_node < 0 ||
+	    !(buf_region->flags & (OFI_BUFPOOL_HUGEPAGES | OFI_BUFPOOL_NONSHARED)))
+		return;
+
+	ret = ofi_numa_bind(buf_region->alloc_region, pool->alloc_size,
+			    OFI_NUMA_LOCAL, pool->numa_node);
+	if (ret) {
+		FI_DBG(&core_prov, FI_LOG_CORE,
+		       "unable to bind pool %p to node %d: %s\n",
+		       pool, pool->numa_node, fi_strerror(-ret));
+		pool->numa_node = -1;
+	}
+}
+
 static void ofi_bufpool_region_free(struct ofi_bufpool_region *buf_region)
 {
 	int ret;
@@ -131,7 +192,7 @@ static void ofi_bufpool_region_free(struct ofi_bufpool_region *buf_region)
 	}
 }
 
-int ofi_bufpool_grow(struct ofi_bufpool *pool)
+static int ofi_bufpool_grow_region(struct ofi_bufpool *pool)
 {
 	struct ofi_bufpool_region *buf_region;
 	struct ofi_bufpool_hdr *buf_hdr;
@@ -167,6 +228,8 @@ int ofi_bufpool_grow(struct ofi_bufpool *pool)
 
 	mem_allocated += buf_region->pool->alloc_size;
 
+	/* bind before the memset below faults the pages in */
+	ofi_bufpool_region_bind(buf_region);
 	memset(buf_region->alloc_region, 0, pool->alloc_size);
 	buf_region->mem_region = buf_region->alloc_region + pool->entry_size;
 	if (pool->attr.alloc_fn) {
@@ -175,7 +238,15 @@ int ofi_bufpool_grow(struct ofi_bufpool *pool)
 			goto err2;
 	}
 
-	if (!(pool->region_cnt % OFI_BUFPOOL_REGION_CHUNK_CNT)) {
+	if (pool->attr.flags & OFI_BUFPOOL_MT) {
+		if (pool->region_cnt == pool->region_table_size) {
+			ret = ofi_bufpool_mt_grow_table(pool);
+			if (ret)
+				goto err3;
+			mem_allocated += pool->region_table_size *
+					 sizeof(*pool->region_table);
+		}
+	} else if (!(pool->region_cnt % OFI_BUFPOOL_REGION_CHUNK_CNT)) {
 		struct ofi_bufpool_region **new_table;
 
 		new_table = realloc(pool->region_table,
@@ -237,11 +308,148 @@ err1:
 	return ret;
 }
 
+int ofi_bufpool_grow(struct ofi_bufpool *pool)
+{
+	int ret;
+
+	if (!(pool->attr.flags & OFI_BUFPOOL_MT))
+		return ofi_bufpool_grow_region(pool);
+
+	pthread_mutex_lock(&pool->lock);
+	ret = ofi_bufpool_grow_region(pool);
+	pthread_mutex_unlock(&pool->lock);
+	return ret;
+}
+
+/* Link first..last in front of the shared free list.  Caller holds lock. */
+static void ofi_bufpool_put_entries(struct ofi_bufpool *pool,
+				    struct slist_entry *first,
+				    struct slist_entry *last)
+{
+	struct slist *entries = &pool->free_list.entries;
+
+	last->next = entries->head;
+	if (slist_empty(entries))
+		entries->tail = last;
+	entries->head = first;
+}
+
+/* Runs on exit of a thread that used the pool */
+static void ofi_bufpool_mag_release(void *arg)
+{
+	struct ofi_bufpool_mag *mag = arg;
+	struct ofi_bufpool *pool = mag->pool;
+
+	pthread_mutex_lock(&pool->lock);
+	if (!slist_empty(&mag->entries))
+		ofi_bufpool_put_entries(pool, mag->entries.head,
+					mag->entries.tail);
+	dlist_remove(&mag->entry);
+	pthread_mutex_unlock(&pool->lock);
+	free(mag);
+}
+
+static struct ofi_bufpool_mag *ofi_bufpool_mag_create(struct ofi_bufpool *pool)
+{
+	struct ofi_bufpool_mag *mag;
+
+	mag = calloc(1, sizeof(*mag));
+	if (!mag)
+		return NULL;
+
+	slist_init(&mag->entries);
+	mag->pool = pool;
+	if (pthread_setspecific(pool->mag_key, mag)) {
+		free(mag);
+		return NULL;
+	}
+
+	pthread_mutex_lock(&pool->lock);
+	dlist_insert_tail(&mag->entry, &pool->mag_list);
+	pthread_mutex_unlock(&pool->lock);
+	return mag;
+}
+
+struct ofi_bufpool_mag *ofi_bufpool_mag_refill(struct ofi_bufpool *pool,
+					       struct ofi_bufpool_mag *mag)
+{
+	struct slist *entries = &pool->free_list.entries;
+	struct slist_entry *first, *last;
+	size_t cnt;
+
+	if (!mag) {
+		mag = ofi_bufpool_mag_create(pool);
+		if (!mag)
+			return NULL;
+	}
+	assert(!mag->cnt && slist_empty(&mag->entries));
+
+	pthread_mutex_lock(&pool->lock);
+	if (slist_empty(entries) && ofi_bufpool_grow_region(pool)) {
+		pthread_mutex_unlock(&pool->lock);
+		return NULL;
+	}
+
+	first = last = entries->head;
+	for (cnt = 1; cnt < OFI_BUFPOOL_MAG_BATCH && last->next; cnt++)
+		last = last->next;
+
+	entries->head = last->next;
+	if (!entries->head)
+		entries->tail = NULL;
+	pthread_mutex_unlock(&pool->lock);
+
+	last->next = NULL;
+	mag->entries.head = first;
+	mag->entries.tail = last;
+	mag->cnt = cnt;
+	return mag;
+}
+
+void ofi_bufpool_mag_free(struct ofi_bufpool *pool, void *buf)
+{
+	struct ofi_bufpool_mag *mag;
+	struct slist_entry *keep_tail;
+	size_t cnt;
+
+	mag = pthread_getspecific(pool->mag_key);
+	if (!mag) {
+		mag = ofi_bufpool_mag_create(pool);
+		if (!mag) {
+			pthread_mutex_lock(&pool->lock);
+			slist_insert_head(&ofi_buf_hdr(buf)->entry.slist,
+					  &pool->free_list.entries);
+			pthread_mutex_unlock(&pool->lock);
+			return;
+		}
+	}
+
+	if (mag->cnt >= OFI_BUFPOOL_MAG_SIZE) {
+		/* keep the most recently freed, likely cache hot, entries */
+		keep_tail = mag->entries.head;
+		for (cnt = 1; cnt < mag->cnt - OFI_BUFPOOL_MAG_BATCH; cnt++)
+			keep_tail = keep_tail->next;
+
+		pthread_mutex_lock(&pool->lock);
+		ofi_bufpool_put_entries(pool, keep_tail->next,
+					mag->entries.tail);
+		pthread_mutex_unlock(&pool->lock);
+
+		keep_tail->next = NULL;
+		mag->entries.tail = keep_tail;
+		mag->cnt -= OFI_BUFPOOL_MAG_BATCH;
+	}
+
+	slist_insert_head(&ofi_buf_hdr(buf)->entry.slist, &mag->entries);
+	mag->cnt++;
+}
+
 int ofi_bufpool_create_attr(struct ofi_bufpool_attr *attr,
 			      struct ofi_bufpool **buf_pool)
 {
 	struct ofi_bufpool *pool;
 	size_t entry_sz;
+	int ret;
 
 	pool = calloc(1, sizeof(**buf_pool));
 	if (!pool)
@@ -249,6 +457,30 @@ int ofi_bufpool_create_attr(struct ofi_bufpool_attr *attr,
 
 	pool->attr = *attr;
 
+	/* mbind needs page aligned regions that are not shared with malloc */
+	pool->numa_node = -1;
+	if (attr->flags & OFI_BUFPOOL_NUMA_LOCAL) {
+		pool->numa_node = ofi_numa_node();
+		pool->attr.flags |= OFI_BUFPOOL_NONSHARED;
+	}
+
+	if (attr->flags & OFI_BUFPOOL_MT) {
+		if (attr->flags & OFI_BUFPOOL_INDEXED) {
+			free(pool);
+			return -FI_EINVAL;
+		}
+
+		ret = pthread_key_create(&pool->mag_key,
+					 ofi_bufpool_mag_release);
+		if (ret) {
+			free(pool);
+			return -ret;
+		}
+		pthread_mutex_init(&pool->lock, NULL);
+		dlist_init(&pool->mag_list);
+		slist_init(&pool->retired_tables);
+	}
+
 	entry_sz = (attr->size + sizeof(struct ofi_bufpool_hdr));
 	OFI_DBG_ADD(entry_sz, sizeof(struct ofi_bufpool_ftr));
 	if (!attr->alignment)
@@ -278,11 +510,34 @@ int ofi_bufpool_create_attr(struct ofi_bufpool_attr *attr,
 	return FI_SUCCESS;
 }
 
+static void ofi_bufpool_mt_cleanup(struct ofi_bufpool *pool)
+{
+	struct ofi_bufpool_mag *mag;
+	struct slist_entry *entry;
+
+	/* entries cached in magazines are free, only the caches go away */
+	pthread_key_delete(pool->mag_key);
+	while (!dlist_empty(&pool->mag_list)) {
+		dlist_pop_front(&pool->mag_list, struct ofi_bufpool_mag,
+				mag, entry);
+		free(mag);
+	}
+
+	while (!slist_empty(&pool->retired_tables)) {
+		entry = slist_remove_head(&pool->retired_tables);
+		free(container_of(entry, struct ofi_bufpool_table, entry));
+	}
+	pthread_mutex_destroy(&pool->lock);
+}
+
 void ofi_bufpool_destroy(struct ofi_bufpool *pool)
 {
 	struct ofi_bufpool_region *buf_region;
 	size_t i;
 
+	if (pool->attr.flags & OFI_BUFPOOL_MT)
+		ofi_bufpool_mt_cleanup(pool);
+
 	for (i = 0; i < pool->region_cnt; i++) {
 		buf_region = pool->region_table[i];
 
@@ -294,7 +549,12 @@ void ofi_bufpool_destroy(struct ofi_bufpool *pool)
 		ofi_bufpool_region_free(buf_region);
 		free(buf_region);
 	}
-	free(pool->region_table);
+	if (pool->attr.flags & OFI_BUFPOOL_MT) {
+		if (pool->region_table)
+			free(ofi_bufpool_table(pool->region_table));
+	} else {
+		free(pool->region_table);
+	}
 	free(pool);
 }
 
@@ -46,6 +46,12 @@ static void util_cq_insert_aux(struct util_cq *cq,
 			      struct util_cq_aux_entry *entry)
 {
 	assert(ofi_genlock_held(&cq->cq_lock));
+	if (cq->atomq) {
+		slist_insert_tail(&entry->list_entry, &cq->aux_queue);
+		ofi_atomic_inc32(&cq->aux_cnt);
+		return;
+	}
+
 	if (!ofi_cirque_isfull(cq->cirq))
 		ofi_cirque_commit(cq->cirq);
 
@@ -62,7 +68,7 @@ int ofi_cq_write_overflow(struct util_cq *cq, void *context, uint64_t flags,
 
 	assert(ofi_genlock_held(&cq->cq_lock));
 	FI_DBG(cq->domain->prov, FI_LOG_CQ, "writing to CQ overflow list\n");
-	assert(ofi_cirque_freecnt(cq->cirq) <= 1);
+	assert(cq->atomq || ofi_cirque_freecnt(cq->cirq) <= 1);
 
 	entry = calloc(1, sizeof(*entry));
 	if (!entry)
@@ -81,8 +87,8 @@ int ofi_cq_write_overflow(struct util_cq *cq, void *context, uint64_t flags,
 	return 0;
 }
 
-static int util_cq_insert_error(struct util_cq *cq,
-				const struct fi_cq_err_entry *err_entry)
+int ofi_cq_insert_error(struct util_cq *cq,
+			const struct fi_cq_err_entry *err_entry)
 {
 	struct util_cq_aux_entry *entry;
 	void *err_data;
@@ -116,7 +122,7 @@ int ofi_cq_write_error(struct util_cq *cq,
 	int ret;
 
 	ofi_genlock_lock(&cq->cq_lock);
-	ret = util_cq_insert_error(cq, err_entry);
+	ret = ofi_cq_insert_error(cq, err_entry);
 	ofi_genlock_unlock(&cq->cq_lock);
 
 	if (cq->wait)
@@ -260,6 +266,59 @@ static void util_cq_read_tagged(void **dst, void *src)
 	*(char **)dst += sizeof(struct fi_cq_tagged_entry);
 }
 
+/* Entries in the aux queue were written after everything that was in the
+ * atomic queue at the time, so only look at them once it has drained.
+ */
+ssize_t ofi_cq_read_atomq(struct util_cq *cq, void *buf, size_t count,
+			  fi_addr_t *src_addr)
+{
+	struct util_atomq_comp *entry;
+	struct util_cq_aux_entry *aux_entry;
+	int64_t pos;
+	ssize_t i;
+
+	if (cq->err_data) {
+		ofi_genlock_lock(&cq->cq_lock);
+		free(cq->err_data);
+		cq->err_data = NULL;
+		ofi_genlock_unlock(&cq->cq_lock);
+	}
+
+	for (i = 0; i < (ssize_t) count; i++) {
+		if (util_comp_atomq_head(cq->atomq, &entry, &pos))
+			break;
+
+		if (src_addr)
+			src_addr[i] = entry->src;
+		cq->read_entry(&buf, &entry->comp);
+		util_comp_atomq_release(cq->atomq, entry, pos);
+	}
+
+	if (i == (ssize_t) count || !ofi_atomic_get32(&cq->aux_cnt))
+		return i ? i : -FI_EAGAIN;
+
+	ofi_genlock_lock(&cq->cq_lock);
+	for (; i < (ssize_t) count && !slist_empty(&cq->aux_queue); i++) {
+		aux_entry = container_of(cq->aux_queue.head,
+					 struct util_cq_aux_entry, list_entry);
+		if (aux_entry->comp.err) {
+			if (!i)
+				i = -FI_EAVAIL;
+			break;
+		}
+
+		if (src_addr)
+			src_addr[i] = aux_entry->src;
+		cq->read_entry(&buf, &aux_entry->comp);
+		slist_remove_head(&cq->aux_queue);
+		ofi_atomic_dec32(&cq->aux_cnt);
+		free(aux_entry);
+	}
+	ofi_genlock_unlock(&cq->cq_lock);
+
+	return i ? i : -FI_EAGAIN;
+}
+
 ssize_t ofi_cq_readfrom(struct fid_cq *cq_fid, void *buf, size_t count,
 			fi_addr_t *src_addr)
 {
@@ -296,8 +355,13 @@ ssize_t ofi_cq_readerr(struct fid_cq *cq_fid, struct fi_cq_err_entry *buf,
 		cq->err_data = NULL;
 	}
 
-	if (ofi_cirque_isempty(cq->cirq) ||
-	    !(ofi_cirque_head(cq->cirq)->flags & UTIL_FLAG_AUX)) {
+	if (cq->atomq) {
+		if (slist_empty(&cq->aux_queue)) {
+			ret = -FI_EAGAIN;
+			goto unlock;
+		}
+	} else if (ofi_cirque_isempty(cq->cirq) ||
+		   !(ofi_cirque_head(cq->cirq)->flags & UTIL_FLAG_AUX)) {
 		ret = -FI_EAGAIN;
 		goto unlock;
 	}
@@ -305,7 +369,7 @@ ssize_t ofi_cq_readerr(struct fid_cq *cq_fid, struct fi_cq_err_entry *buf,
 	assert(!slist_empty(&cq->aux_queue));
 	aux_entry = container_of(cq->aux_queue.head,
 				 struct util_cq_aux_entry, list_entry);
-	assert(aux_entry->cq_slot == ofi_cirque_head(cq->cirq));
+	assert(cq->atomq || aux_entry->cq_slot == ofi_cirque_head(cq->cirq));
 
 	if (!aux_entry->comp.err) {
 		ret = -FI_EAGAIN;
@@ -334,7 +398,9 @@ ssize_t ofi_cq_readerr(struct fid_cq *cq_fid, struct fi_cq_err_entry *buf,
 	if (aux_entry->comp.err_data_size)
 		free(aux_entry->comp.err_data);
 	free(aux_entry);
-	if (slist_empty(&cq->aux_queue)) {
+	if (cq->atomq) {
+		ofi_atomic_dec32(&cq->aux_cnt);
+	} else if (slist_empty(&cq->aux_queue)) {
 		ofi_cirque_discard(cq->cirq);
 	} else {
 		aux_entry = container_of(cq->aux_queue.head,
@@ -423,7 +489,10 @@ static void util_peer_cq_cleanup(struct util_cq *cq)
 		free(err);
 	}
 
-	util_comp_cirq_free(cq->cirq);
+	if (cq->atomq)
+		util_comp_atomq_free(cq->atomq);
+	else
+		util_comp_cirq_free(cq->cirq);
 	free(cq->src);
 	fi_close(&cq->peer_cq->fid);
 }
@@ -536,18 +605,7 @@ static ssize_t util_peer_cq_write(struct fid_peer_cq *cq, void *context,
 	struct util_cq *util_cq = cq->fid.context;
 	int ret;
 
-	util_cq = cq->fid.context;
-
-	ofi_genlock_lock(&util_cq->cq_lock);
-	if (ofi_cirque_freecnt(util_cq->cirq) > 1) {
-		ofi_cq_write_entry(util_cq, context, flags, len, buf, data,
-				     tag);
-		ret = 0;
-	} else {
-		ret = ofi_cq_write_overflow(util_cq, context, flags, len, buf,
-					      data, tag, FI_ADDR_NOTAVAIL);
-	}
-	ofi_genlock_unlock(&util_cq->cq_lock);
+	ret = ofi_cq_write(util_cq, context, flags, len, buf, data, tag);
 
 	if (util_cq->wait)
 		util_cq->wait->signal(util_cq->wait);
@@ -562,16 +620,8 @@ static ssize_t util_peer_cq_write_src(struct fid_peer_cq *cq, void *context,
 	struct util_cq *util_cq = cq->fid.context;
 	int ret;
 
-	ofi_genlock_lock(&util_cq->cq_lock);
-	if (ofi_cirque_freecnt(util_cq->cirq) > 1) {
-		ofi_cq_write_src_entry(util_cq, context, flags, len, buf, data,
-				       tag, src);
-		ret = 0;
-	} else {
-		ret = ofi_cq_write_overflow(util_cq, context, flags, len, buf,
-					      data, tag, src);
-	}
-	ofi_genlock_unlock(&util_cq->cq_lock);
+	ret = ofi_cq_write_src(util_cq, context, flags, len, buf, data,
+			       tag, src);
 
 	if (util_cq->wait)
 		util_cq->wait->signal(util_cq->wait);
@@ -586,7 +636,7 @@ static ssize_t util_peer_cq_writeerr(struct fid_peer_cq *cq,
 	int ret;
 
 	ofi_genlock_lock(&util_cq->cq_lock);
-	ret = util_cq_insert_error(util_cq, err_entry);
+	ret = ofi_cq_insert_error(util_cq, err_entry);
 	ofi_genlock_unlock(&util_cq->cq_lock);
 
 	if (util_cq->wait)
@@ -644,7 +694,8 @@ static struct fi_ops util_peer_cq_fi_ops = {
 	.ops_open = fi_no_ops_open,
 };
 
-static int util_init_peer_cq(struct util_cq *cq, struct fi_cq_attr *attr)
+static int util_init_peer_cq(struct util_cq *cq, struct fi_cq_attr *attr,
+			     uint64_t init_flags)
 {
 	int ret;
 
@@ -674,18 +725,34 @@ static int util_init_peer_cq(struct util_cq *cq, struct fi_cq_attr *attr)
 		goto free;
 	}
 
-	cq->cirq = util_comp_cirq_create(attr->size == 0 ? UTIL_DEF_CQ_SIZE : attr->size);
-	if (!cq->cirq) {
-		ret = -FI_ENOMEM;
-		goto free;
+	/* The source address is carried in the atomic queue entries */
+	if ((init_flags & OFI_CQ_ATOMIC_QUEUE) &&
+	    cq->cq_lock.lock_type != OFI_LOCK_NOOP) {
+		cq->atomq = util_comp_atomq_create(attr->size == 0 ?
+						   UTIL_DEF_CQ_SIZE :
+						   attr->size);
+		if (!cq->atomq) {
+			ret = -FI_ENOMEM;
+			goto free;
+		}
+		ofi_atomic_initialize32(&cq->aux_cnt, 0);
+	} else {
+		cq->cirq = util_comp_cirq_create(attr->size == 0 ?
+						 UTIL_DEF_CQ_SIZE : attr->size);
+		if (!cq->cirq) {
+			ret = -FI_ENOMEM;
+			goto free;
+		}
 	}
 
 	if (cq->domain->info_domain_caps & FI_SOURCE) {
-		cq->src = calloc(cq->cirq->size, sizeof(*cq->src));
-		if (!cq->src) {
-			util_comp_cirq_free(cq->cirq);
-			ret = -FI_ENOMEM;
-			goto free;
+		if (cq->cirq) {
+			cq->src = calloc(cq->cirq->size, sizeof(*cq->src));
+			if (!cq->src) {
+				util_comp_cirq_free(cq->cirq);
+				ret = -FI_ENOMEM;
+				goto free;
+			}
 		}
 		cq->peer_cq->owner_ops = &util_peer_cq_src_owner_ops;
 	} else {
@@ -702,9 +769,10 @@ free:
 	return ret;
 }
 
-int ofi_cq_init(const struct fi_provider *prov, struct fid_domain *domain,
-		 struct fi_cq_attr *attr, struct util_cq *cq,
-		 ofi_cq_progress_func progress, void *context)
+int ofi_cq_init2(const struct fi_provider *prov, struct fid_domain *domain,
+		  struct fi_cq_attr *attr, struct util_cq *cq,
+		  ofi_cq_progress_func progress, uint64_t init_flags,
+		  void *context)
 {
 	struct fi_wait_attr wait_attr;
 	struct fid_wait *wait;
@@ -721,6 +789,7 @@ int ofi_cq_init(const struct fi_provider *prov, struct fid_domain *domain,
 	cq->cq_fid.ops = &util_cq_ops;
 	cq->progress = progress;
 	cq->err_data = NULL;
+	cq->atomq = NULL;
 
 	cq->domain = container_of(domain, struct util_domain, domain_fid);
 	ofi_atomic_initialize32(&cq->ref, 0);
@@ -751,7 +820,7 @@ int ofi_cq_init(const struct fi_provider *prov, struct fid_domain *domain,
 		cq->peer_cq = ((struct fi_peer_cq_context *) context)->cq;
 		cq->cq_fid.ops = &util_peer_cq_ops;
 	} else {
-		ret = util_init_peer_cq(cq, attr);
+		ret = util_init_peer_cq(cq, attr, init_flags);
 		if (ret)
 			goto destroy2;
 	}
@@ -806,6 +875,13 @@ destroy1:
 	return ret;
 }
 
+int ofi_cq_init(const struct fi_provider *prov, struct fid_domain *domain,
+		 struct fi_cq_attr *attr, struct util_cq *cq,
+		 ofi_cq_progress_func progress, void *context)
+{
+	return ofi_cq_init2(prov, domain, attr, cq, progress, 0, context);
+}
+
 uint64_t ofi_rx_flags[] = {
 	[ofi_op_msg] = FI_MSG | FI_RECV,
 	[ofi_op_tagged] = FI_RECV | FI_TAGGED,
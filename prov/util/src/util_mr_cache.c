@@ -51,6 +51,27 @@ struct ofi_mr_cache_params cache_params = {
 	.ze_monitor_enabled = true,
 };
 
+/*
+ * Cache hits are looked up holding only the read side of the cache's
+ * tree_lock, so that threads hitting in the cache do not serialize on the
+ * global mm_lock.  The tree is only changed with mm_lock held and tree_lock
+ * write locked, so an entry found this way stays cached until the reference
+ * taken on it is released.  Such a lookup cannot touch the LRU list, which
+ * mm_lock protects, and leaves a revived entry on it.  The LRU list may
+ * therefore hold entries that are in use: they are skipped when flushing,
+ * and taken off the list when released.  An idle entry is always on the
+ * LRU list.  use_cnt and the search statistics are updated atomically.
+ */
+#ifdef HAVE_BUILTIN_ATOMICS
+#define util_mr_stat_inc(cnt) ((void) ofi_atomic_add_and_fetch(64, &(cnt), 1))
+#define util_mr_use_inc(entry) ofi_atomic_add_and_fetch(32, &(entry)->use_cnt, 1)
+#define util_mr_use_dec(entry) ofi_atomic_sub_and_fetch(32, &(entry)->use_cnt, 1)
+#else
+#define util_mr_stat_inc(cnt) ((void) (cnt)++)
+#define util_mr_use_inc(entry) (++(entry)->use_cnt)
+#define util_mr_use_dec(entry) (--(entry)->use_cnt)
+#endif
+
 static int util_mr_find_within(struct ofi_rbmap *map, void *key, void *data)
 {
 	struct ofi_mr_entry *entry = data;
@@ -122,6 +143,17 @@ static void util_mr_free_entry(struct ofi_mr_cache *cache,
 	util_mr_entry_free(cache, entry);
 }
 
+/* Caller must hold mm_lock and tree_lock for writing */
+static void util_mr_remove_entry(struct ofi_mr_cache *cache,
+				 struct ofi_mr_entry *entry)
+{
+	ofi_rbmap_delete(&cache->tree, entry->node);
+	entry->node = NULL;
+
+	cache->cached_cnt--;
+	cache->cached_size -= entry->info.iov.iov_len;
+}
+
 static void util_mr_uncache_entry_storage(struct ofi_mr_cache *cache,
 					  struct ofi_mr_entry *entry)
 {
@@ -131,11 +163,25 @@ static void util_mr_uncache_entry_storage(struct ofi_mr_cache *cache,
 	 * notification events, but is harmless to correct operation.
 	 */
 
-	ofi_rbmap_delete(&cache->tree, entry->node);
-	entry->node = NULL;
+	pthread_rwlock_wrlock(&cache->tree_lock);
+	util_mr_remove_entry(cache, entry);
+	pthread_rwlock_unlock(&cache->tree_lock);
+}
 
-	cache->cached_cnt--;
-	cache->cached_size -= entry->info.iov.iov_len;
+/* Uncache an entry taken off the LRU list, unless it was revived by a
+ * lookup without mm_lock.  Returns true if the entry was uncached.
+ */
+static bool util_mr_uncache_idle(struct ofi_mr_cache *cache,
+				 struct ofi_mr_entry *entry)
+{
+	bool idle;
+
+	pthread_rwlock_wrlock(&cache->tree_lock);
+	idle = !entry->use_cnt;
+	if (idle)
+		util_mr_remove_entry(cache, entry);
+	pthread_rwlock_unlock(&cache->tree_lock);
+	return idle;
 }
 
 static void util_mr_uncache_entry(struct ofi_mr_cache *cache,
@@ -180,6 +226,49 @@ static struct ofi_mr_entry *ofi_mr_rbt_overlap(struct ofi_rbmap *tree,
 	return node->data;
 }
 
+/*
+ * Look for a cache hit without taking mm_lock.  Returns NULL if the lookup
+ * must go through the locked path, on a miss or while the tree is being
+ * changed.  The monitor defaults to the one for the entry's interface.
+ */
+static struct ofi_mr_entry *
+util_mr_cache_find_hit(struct ofi_mr_cache *cache,
+		       const struct ofi_mr_info *info,
+		       struct ofi_mem_monitor *monitor)
+{
+#ifdef HAVE_BUILTIN_ATOMICS
+	struct ofi_mr_entry *entry;
+
+	if (pthread_rwlock_tryrdlock(&cache->tree_lock)) {
+		util_mr_stat_inc(cache->contended_cnt);
+		return NULL;
+	}
+
+	entry = ofi_mr_rbt_find(&cache->tree, info);
+	if (entry) {
+		if (!monitor)
+			monitor = cache->monitors[entry->info.iface];
+		if (ofi_iov_within(&info->iov, &entry->info.iov) &&
+		    monitor->valid(monitor, info, entry))
+			util_mr_use_inc(entry);
+		else
+			entry = NULL;
+	}
+	pthread_rwlock_unlock(&cache->tree_lock);
+
+	if (entry) {
+		util_mr_stat_inc(cache->search_cnt);
+		util_mr_stat_inc(cache->hit_cnt);
+	}
+	return entry;
+#else
+	OFI_UNUSED(cache);
+	OFI_UNUSED(info);
+	OFI_UNUSED(monitor);
+	return NULL;
+#endif
+}
+
 /* Caller must hold ofi_mem_monitor lock as well as unsubscribe from the region */
 void ofi_mr_cache_notify(struct ofi_mr_cache *cache, const void *addr, size_t len)
 {
@@ -214,7 +303,8 @@ bool ofi_mr_cache_flush(struct ofi_mr_cache *cache, bool flush_lru)
 		dlist_pop_front(&cache->lru_list, struct ofi_mr_entry,
 				entry, list_entry);
 		dlist_init(&entry->list_entry);
-		util_mr_uncache_entry_storage(cache, entry);
+		if (!util_mr_uncache_idle(cache, entry))
+			continue;
 		dlist_insert_tail(&entry->list_entry, &free_list);
 
 		flush_lru = ofi_mr_cache_full(cache);
@@ -243,7 +333,9 @@ void ofi_mr_cache_delete(struct ofi_mr_cache *cache, struct ofi_mr_entry *entry)
 	pthread_mutex_lock(&mm_lock);
 	cache->delete_cnt++;
 
-	if (--entry->use_cnt == 0) {
+	if (util_mr_use_dec(entry) == 0) {
+		if (!dlist_empty(&entry->list_entry))
+			dlist_remove_init(&entry->list_entry);
 		if (!entry->node) {
 			cache->uncached_cnt--;
 			cache->uncached_size -= entry->info.iov.iov_len;
@@ -286,6 +378,7 @@ util_mr_cache_create(struct ofi_mr_cache *cache, const struct ofi_mr_info *info,
 	(*entry)->node = NULL;
 	(*entry)->info = *info;
 	(*entry)->use_cnt = 1;
+	dlist_init(&(*entry)->list_entry);
 
 	ret = cache->add_region(cache, *entry);
 	if (ret)
@@ -302,8 +395,11 @@ util_mr_cache_create(struct ofi_mr_cache *cache, const struct ofi_mr_info *info,
 		cache->uncached_cnt++;
 		cache->uncached_size += info->iov.iov_len;
 	} else {
-		if (ofi_rbmap_insert(&cache->tree, (void *) &(*entry)->info,
-				     (void *) *entry, &(*entry)->node)) {
+		pthread_rwlock_wrlock(&cache->tree_lock);
+		ret = ofi_rbmap_insert(&cache->tree, (void *) &(*entry)->info,
+				       (void *) *entry, &(*entry)->node);
+		pthread_rwlock_unlock(&cache->tree_lock);
+		if (ret) {
 			ret = -FI_ENOMEM;
 			goto unlock;
 		}
@@ -347,6 +443,10 @@ int ofi_mr_cache_search(struct ofi_mr_cache *cache, const struct ofi_mr_info *in
 	FI_DBG(cache->prov, FI_LOG_MR, "search %p (len: %zu)\n",
 	       info->iov.iov_base, info->iov.iov_len);
 
+	*entry = util_mr_cache_find_hit(cache, info, monitor);
+	if (*entry)
+		return 0;
+
 	do {
 		pthread_mutex_lock(&mm_lock);
 		flush_lru = ofi_mr_cache_full(cache);
@@ -356,7 +456,7 @@ int ofi_mr_cache_search(struct ofi_mr_cache *cache, const struct ofi_mr_info *in
 			pthread_mutex_lock(&mm_lock);
 		}
 
-		cache->search_cnt++;
+		util_mr_stat_inc(cache->search_cnt);
 		*entry = ofi_mr_rbt_find(&cache->tree, info);
 
 		if (*entry &&
@@ -381,8 +481,8 @@ int ofi_mr_cache_search(struct ofi_mr_cache *cache, const struct ofi_mr_info *in
 	return ret;
 
 hit:
-	cache->hit_cnt++;
-	if ((*entry)->use_cnt++ == 0)
+	util_mr_stat_inc(cache->hit_cnt);
+	if (util_mr_use_inc(*entry) == 1)
 		dlist_remove_init(&(*entry)->list_entry);
 	pthread_mutex_unlock(&mm_lock);
 	return 0;
@@ -400,6 +500,12 @@ struct ofi_mr_entry *ofi_mr_cache_find(struct ofi_mr_cache *cache,
 	FI_DBG(cache->prov, FI_LOG_MR, "find %p (len: %zu)\n",
 	       attr->mr_iov->iov_base, attr->mr_iov->iov_len);
 
+	info.peer_id = 0;
+	ofi_mr_info_get_iov_from_mr_attr(&info, attr, flags);
+	entry = util_mr_cache_find_hit(cache, &info, NULL);
+	if (entry)
+		return entry;
+
 	pthread_mutex_lock(&mm_lock);
 
 	if (!dlist_empty(&cache->dead_region_list)) {
@@ -408,10 +514,7 @@ struct ofi_mr_entry *ofi_mr_cache_find(struct ofi_mr_cache *cache,
 		pthread_mutex_lock(&mm_lock);
 	}
 
-	cache->search_cnt++;
-
-	info.peer_id = 0;
-	ofi_mr_info_get_iov_from_mr_attr(&info, attr, flags);
+	util_mr_stat_inc(cache->search_cnt);
 	entry = ofi_mr_rbt_find(&cache->tree, &info);
 	if (!entry) {
 		goto unlock;
@@ -421,8 +524,8 @@ struct ofi_mr_entry *ofi_mr_cache_find(struct ofi_mr_cache *cache,
 
 	if (ofi_iov_within(attr->mr_iov, &entry->info.iov) &&
 	    monitor->valid(monitor, entry->info.iov.iov_base, entry)) {
-		cache->hit_cnt++;
-		if ((entry)->use_cnt++ == 0)
+		util_mr_stat_inc(cache->hit_cnt);
+		if (util_mr_use_inc(entry) == 1)
 			dlist_remove_init(&(entry)->list_entry);
 	} else {
 		while (entry) {
@@ -457,6 +560,7 @@ int ofi_mr_cache_reg(struct ofi_mr_cache *cache, const struct fi_mr_attr *attr,
 	ofi_mr_info_get_iov_from_mr_attr(&(*entry)->info, attr, flags);
 	(*entry)->use_cnt = 1;
 	(*entry)->node = NULL;
+	dlist_init(&(*entry)->list_entry);
 
 	ret = cache->add_region(cache, *entry);
 	if (ret)
@@ -480,13 +584,16 @@ void ofi_mr_cache_cleanup(struct ofi_mr_cache *cache)
 		return;
 
 	FI_INFO(cache->prov, FI_LOG_MR, "MR cache stats: "
-		"searches %zu, deletes %zu, hits %zu notify %zu\n",
+		"searches %zu, deletes %zu, hits %zu, misses %zu, notify %zu, "
+		"contended %zu\n",
 		cache->search_cnt, cache->delete_cnt, cache->hit_cnt,
-		cache->notify_cnt);
+		cache->search_cnt - cache->hit_cnt, cache->notify_cnt,
+		cache->contended_cnt);
 
 	while (ofi_mr_cache_flush(cache, true))
 		;
 
+	pthread_rwlock_destroy(&cache->tree_lock);
 	pthread_mutex_destroy(&cache->lock);
 	ofi_monitors_del_cache(cache);
 	ofi_rbmap_cleanup(&cache->tree);
@@ -511,6 +618,7 @@ int ofi_mr_cache_init(struct util_domain *domain,
 		return -FI_ENOSPC;
 
 	pthread_mutex_init(&cache->lock, NULL);
+	pthread_rwlock_init(&cache->tree_lock, NULL);
 	dlist_init(&cache->lru_list);
 	dlist_init(&cache->dead_region_list);
 	cache->cached_cnt = 0;
@@ -523,6 +631,7 @@ int ofi_mr_cache_init(struct util_domain *domain,
 	cache->delete_cnt = 0;
 	cache->hit_cnt = 0;
 	cache->notify_cnt = 0;
+	cache->contended_cnt = 0;
 	cache->domain = domain;
 	if (domain) {
 		cache->prov = domain->prov;
@@ -552,6 +661,7 @@ destroy:
 		ofi_atomic_dec32(&cache->domain->ref);
 		cache->domain = NULL;
 	}
+	pthread_rwlock_destroy(&cache->tree_lock);
 	pthread_mutex_destroy(&cache->lock);
 	cache->prov = NULL;
 	return ret;
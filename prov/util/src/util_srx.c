@@ -35,6 +35,7 @@
 #include "ofi_enosys.h"
 #include "ofi_iov.h"
 #include "ofi_util.h"
+#include "fasthash.h"
 
 static struct util_rx_entry *util_alloc_rx_entry(struct util_srx_ctx *srx)
 {
@@ -127,9 +128,12 @@ static bool util_adjust_multi_recv(struct util_srx_ctx *srx,
 	return left < srx->min_multi_recv_size;
 }
 
-static struct util_rx_entry *util_process_multi_recv(struct util_srx_ctx *srx,
-		struct slist *queue, struct fi_peer_match_attr *attr,
-		struct util_rx_entry *owner_entry)
+/* Carve an entry for a len byte message out of a multi-receive buffer.
+ * Sets *done if the buffer is used up.
+ */
+static struct util_rx_entry *util_split_multi_recv(struct util_srx_ctx *srx,
+		struct util_rx_entry *owner_entry, fi_addr_t addr, size_t len,
+		bool *done)
 {
 	struct util_rx_entry *util_entry;
 
@@ -137,7 +141,7 @@ static struct util_rx_entry *util_process_multi_recv(struct util_srx_ctx *srx,
 					 owner_entry->peer_entry.iov,
 					 owner_entry->peer_entry.desc,
 					 owner_entry->peer_entry.count,
-					 attr->addr,
+					 addr,
 					 owner_entry->peer_entry.context,
 					 owner_entry->peer_entry.tag,
 					 owner_entry->ignore,
@@ -146,9 +150,7 @@ static struct util_rx_entry *util_process_multi_recv(struct util_srx_ctx *srx,
 	if (!util_entry)
 		return NULL;
 
-	if (util_adjust_multi_recv(srx, &owner_entry->peer_entry,
-				   attr->msg_size))
-		slist_remove_head(queue);
+	*done = util_adjust_multi_recv(srx, &owner_entry->peer_entry, len);
 
 	util_entry->peer_entry.owner_context = owner_entry;
 	owner_entry->multi_recv_ref++;
@@ -156,6 +158,21 @@ static struct util_rx_entry *util_process_multi_recv(struct util_srx_ctx *srx,
 	return util_entry;
 }
 
+static struct util_rx_entry *util_process_multi_recv(struct util_srx_ctx *srx,
+		struct slist *queue, struct fi_peer_match_attr *attr,
+		struct util_rx_entry *owner_entry)
+{
+	struct util_rx_entry *util_entry;
+	bool done;
+
+	util_entry = util_split_multi_recv(srx, owner_entry, attr->addr,
+					   attr->msg_size, &done);
+	if (util_entry && done)
+		slist_remove_head(queue);
+
+	return util_entry;
+}
+
 static int util_match_msg(struct fid_peer_srx *srx,
 			  struct fi_peer_match_attr *attr,
 			  struct fi_peer_rx_entry **rx_entry)
@@ -215,7 +232,7 @@ static int util_get_msg(struct fid_peer_srx *srx,
 	util_entry = container_of(queue->head, struct util_rx_entry,
 				  peer_entry);
 	if (!slist_empty(&srx_ctx->msg_queue)) {
-		any_entry = container_of(&srx_ctx->msg_queue.head,
+		any_entry = container_of(srx_ctx->msg_queue.head,
 					 struct util_rx_entry, peer_entry);
 		if (any_entry->seq_no <= util_entry->seq_no) {
 			queue = &srx_ctx->msg_queue;
@@ -324,6 +341,213 @@ check_any:
 	return ret;
 }
 
+struct util_tag_key {
+	uint64_t	tag;
+	fi_addr_t	addr;
+};
+
+struct util_match_pos {
+	struct slist		*queue;
+	struct slist_entry	*item;
+	struct slist_entry	*prev;
+	struct util_rx_entry	*rx_entry;
+};
+
+static inline struct slist *util_tag_bucket(struct util_srx_ctx *srx,
+					    uint64_t tag, fi_addr_t addr)
+{
+	struct util_tag_key key = {
+		.tag = tag,
+		.addr = addr,
+	};
+
+	return &srx->tag_buckets[fasthash64(&key, sizeof(key), 0) &
+				 (srx->tag_bucket_cnt - 1)];
+}
+
+static struct slist *util_trecv_queue(struct util_srx_ctx *srx,
+				      fi_addr_t addr, uint64_t tag,
+				      uint64_t ignore)
+{
+	if (srx->tag_buckets && !ignore)
+		return util_tag_bucket(srx, tag, addr);
+
+	return addr == FI_ADDR_UNSPEC ? &srx->tag_queue :
+		ofi_array_at(&srx->src_trecv_queues, addr);
+}
+
+/* Every queue is ordered by seq_no, so the search stops as soon as it
+ * passes the best candidate found in a previously searched queue.
+ */
+static void util_search_tag_queue(struct slist *queue, fi_addr_t addr,
+				  uint64_t tag, struct util_match_pos *pos)
+{
+	struct util_rx_entry *rx_entry;
+	struct slist_entry *item, *prev;
+
+	slist_foreach(queue, item, prev) {
+		rx_entry = container_of(item, struct util_rx_entry,
+					peer_entry);
+		if (pos->rx_entry && rx_entry->seq_no > pos->rx_entry->seq_no)
+			return;
+
+		if (rx_entry->peer_entry.addr == addr &&
+		    ofi_match_tag(rx_entry->peer_entry.tag, rx_entry->ignore,
+				  tag)) {
+			pos->queue = queue;
+			pos->item = item;
+			pos->prev = prev;
+			pos->rx_entry = rx_entry;
+			return;
+		}
+	}
+}
+
+static int util_get_tag_hash(struct fid_peer_srx *srx,
+			     struct fi_peer_match_attr *attr,
+			     struct fi_peer_rx_entry **rx_entry)
+{
+	struct util_srx_ctx *srx_ctx;
+	struct util_match_pos pos = {0};
+	struct util_rx_entry *util_entry;
+	struct slist *queue;
+
+	srx_ctx = srx->ep_fid.fid.context;
+	assert(ofi_genlock_held(srx_ctx->lock));
+
+	if (attr->addr != FI_ADDR_UNSPEC) {
+		util_search_tag_queue(util_tag_bucket(srx_ctx, attr->tag,
+						      attr->addr),
+				      attr->addr, attr->tag, &pos);
+		queue = ofi_array_at(&srx_ctx->src_trecv_queues, attr->addr);
+		if (queue)
+			util_search_tag_queue(queue, attr->addr, attr->tag,
+					      &pos);
+	}
+
+	util_search_tag_queue(util_tag_bucket(srx_ctx, attr->tag,
+					      FI_ADDR_UNSPEC),
+			      FI_ADDR_UNSPEC, attr->tag, &pos);
+	util_search_tag_queue(&srx_ctx->tag_queue, FI_ADDR_UNSPEC, attr->tag,
+			      &pos);
+
+	if (!pos.rx_entry) {
+		util_entry = util_init_unexp(srx_ctx, attr,
+					     FI_TAGGED | FI_RECV);
+		if (!util_entry)
+			return -FI_ENOMEM;
+		util_entry->peer_entry.srx = srx;
+		*rx_entry = &util_entry->peer_entry;
+		return -FI_ENOENT;
+	}
+
+	slist_remove(pos.queue, pos.item, pos.prev);
+	util_entry = pos.rx_entry;
+	util_entry->peer_entry.srx = srx;
+	srx_ctx->update_func(srx_ctx, util_entry);
+	*rx_entry = &util_entry->peer_entry;
+	return FI_SUCCESS;
+}
+
+static struct slist *util_claim_queue(struct util_srx_ctx *srx,
+				      fi_addr_t addr, bool tagged)
+{
+	if (addr == FI_ADDR_UNSPEC)
+		return tagged ? &srx->tag_queue : &srx->msg_queue;
+
+	return ofi_array_at(tagged ? &srx->src_trecv_queues :
+			    &srx->src_recv_queues, addr);
+}
+
+/*
+ * Take the receive that the next message from addr would be matched against
+ * out of the receive queues, so the provider can let the sender place data
+ * into it directly.  For tagged receives that is the oldest candidate, which
+ * the message only matches if the tags agree.  Tagged receives are not
+ * claimed when tag hashing is enabled, since the oldest one is not known.
+ * The caller must hold the srx lock until the receive is given back with
+ * util_srx_unclaim_recv() or completed through util_srx_claimed_entry().
+ */
+struct fi_peer_rx_entry *util_srx_claim_recv(struct fid_peer_srx *srx,
+					     fi_addr_t addr, bool tagged,
+					     uint64_t *ignore)
+{
+	struct util_srx_ctx *srx_ctx;
+	struct util_rx_entry *util_entry, *any_entry;
+	struct slist *queue, *any_queue;
+
+	srx_ctx = srx->ep_fid.fid.context;
+	assert(ofi_genlock_held(srx_ctx->lock));
+
+	if (tagged && srx_ctx->tag_buckets)
+		return NULL;
+
+	any_queue = util_claim_queue(srx_ctx, FI_ADDR_UNSPEC, tagged);
+	queue = addr == FI_ADDR_UNSPEC || !srx_ctx->dir_recv ? NULL :
+		util_claim_queue(srx_ctx, addr, tagged);
+
+	if (!queue || slist_empty(queue)) {
+		queue = any_queue;
+	} else if (!slist_empty(any_queue)) {
+		util_entry = container_of(queue->head, struct util_rx_entry,
+					  peer_entry);
+		any_entry = container_of(any_queue->head, struct util_rx_entry,
+					 peer_entry);
+		if (any_entry->seq_no <= util_entry->seq_no)
+			queue = any_queue;
+	}
+
+	if (slist_empty(queue))
+		return NULL;
+
+	util_entry = container_of(slist_remove_head(queue),
+				  struct util_rx_entry, peer_entry);
+	util_entry->peer_entry.srx = srx;
+	*ignore = util_entry->ignore;
+	return &util_entry->peer_entry;
+}
+
+/* Return a claimed receive to the head of the queue it was taken from. */
+void util_srx_unclaim_recv(struct fi_peer_rx_entry *rx_entry, bool tagged)
+{
+	struct util_srx_ctx *srx_ctx = rx_entry->srx->ep_fid.fid.context;
+
+	assert(ofi_genlock_held(srx_ctx->lock));
+	slist_insert_head((struct slist_entry *) rx_entry,
+			  util_claim_queue(srx_ctx, rx_entry->addr, tagged));
+}
+
+/*
+ * Get the entry that completes a msg_size byte message from addr placed into
+ * a claimed receive.  A multi-receive buffer is split, and goes back to its
+ * queue while space remains.
+ */
+struct fi_peer_rx_entry *util_srx_claimed_entry(struct fi_peer_rx_entry *rx_entry,
+						fi_addr_t addr, size_t msg_size,
+						bool tagged)
+{
+	struct util_srx_ctx *srx_ctx = rx_entry->srx->ep_fid.fid.context;
+	struct util_rx_entry *util_entry;
+	bool done;
+
+	assert(ofi_genlock_held(srx_ctx->lock));
+	util_entry = container_of(rx_entry, struct util_rx_entry, peer_entry);
+	if (rx_entry->flags & FI_MULTI_RECV) {
+		util_entry = util_split_multi_recv(srx_ctx, util_entry, addr,
+						   msg_size, &done);
+		if (!util_entry) {
+			util_srx_unclaim_recv(rx_entry, tagged);
+			return NULL;
+		}
+		if (!done)
+			util_srx_unclaim_recv(rx_entry, tagged);
+	}
+
+	util_entry->peer_entry.srx = rx_entry->srx;
+	srx_ctx->update_func(srx_ctx, util_entry);
+	return &util_entry->peer_entry;
+}
+
 static int util_queue_msg(struct fi_peer_rx_entry *rx_entry)
 {
 	struct util_srx_ctx *srx_ctx = rx_entry->srx->ep_fid.fid.context;
@@ -454,6 +678,16 @@ static struct fi_ops_srx_owner util_srx_owner_ops = {
 	.free_entry = util_free_entry,
 };
 
+static struct fi_ops_srx_owner util_srx_hash_owner_ops = {
+	.size = sizeof(struct fi_ops_srx_owner),
+	.get_msg = util_get_msg,
+	.get_tag = util_get_tag_hash,
+	.queue_msg = util_queue_msg,
+	.queue_tag = util_queue_tag,
+	.foreach_unspec_addr = util_foreach_unspec,
+	.free_entry = util_free_entry,
+};
+
 static struct util_rx_entry *util_search_peer_msg(struct util_unexp_peer *peer)
 {
 	struct util_rx_entry *rx_entry;
@@ -690,8 +924,7 @@ ssize_t util_srx_generic_trecv(struct fid_ep *ep_fid, const struct iovec *iov,
 	} else {
 		rx_entry = util_search_unexp_tag(srx, addr, tag, ignore, true);
 		if (!rx_entry) {
-			queue = addr == FI_ADDR_UNSPEC ? &srx->tag_queue:
-				ofi_array_at(&srx->src_trecv_queues, addr);
+			queue = util_trecv_queue(srx, addr, tag, ignore);
 			assert(queue);
 			rx_entry = util_get_recv_entry(srx, iov, desc,
 						iov_count, addr, context, tag,
@@ -918,6 +1151,7 @@ int util_srx_close(struct fid *fid)
 	struct util_unexp_peer *unexp_peer;
 	struct util_rx_entry *rx_entry;
 	struct slist_entry *entry;
+	size_t i;
 
 	srx = container_of(fid, struct util_srx_ctx, peer_srx.ep_fid.fid);
 	if (!srx)
@@ -941,6 +1175,10 @@ int util_srx_close(struct fid *fid)
 				          peer_entry));
 	}
 
+	for (i = 0; srx->tag_buckets && i < srx->tag_bucket_cnt; i++)
+		(void) util_cleanup_queues(NULL, &srx->tag_buckets[i], srx);
+	free(srx->tag_buckets);
+
 	while (!dlist_empty(&srx->unspec_unexp_msg_queue)) {
 		dlist_pop_front(&srx->unspec_unexp_msg_queue,
 				struct util_rx_entry, rx_entry, peer_entry);
@@ -1035,6 +1273,7 @@ static int util_cancel_src(struct ofi_dyn_arr *arr, void *list, void *context)
 static ssize_t util_srx_cancel(fid_t ep_fid, void *context)
 {
 	struct util_srx_ctx *srx;
+	size_t i;
 
 	srx = container_of(ep_fid, struct util_srx_ctx, peer_srx.ep_fid);
 
@@ -1043,6 +1282,12 @@ static ssize_t util_srx_cancel(fid_t ep_fid, void *context)
 			     context))
 		goto out;
 
+	for (i = 0; srx->tag_buckets && i < srx->tag_bucket_cnt; i++) {
+		if (util_cancel_recv(srx, &srx->tag_buckets[i],
+				     FI_TAGGED | FI_RECV, context))
+			goto out;
+	}
+
 	if (util_cancel_recv(srx, &srx->msg_queue, FI_MSG | FI_RECV, context))
 		goto out;
 
@@ -1147,6 +1392,16 @@ int util_ep_srx_context(struct util_domain *domain, size_t rx_size,
 	slist_init(&srx->msg_queue);
 	slist_init(&srx->tag_queue);
 
+	if (ofi_srx_tag_hash) {
+		srx->tag_bucket_cnt = roundup_power_of_two(MAX(rx_size, 1));
+		srx->tag_buckets = calloc(srx->tag_bucket_cnt,
+					  sizeof(*srx->tag_buckets));
+		if (!srx->tag_buckets) {
+			free(srx);
+			return -FI_ENOMEM;
+		}
+	}
+
 	//each entry has the iovs and descriptors stored at the end of the entry
 	//calculate how much space each entry needs based on provider iov limits
 	pool_attr.size = sizeof(struct util_rx_entry) +
@@ -1159,6 +1414,7 @@ int util_ep_srx_context(struct util_domain *domain, size_t rx_size,
 	pool_attr.context = srx;
 	ret = ofi_bufpool_create_attr(&pool_attr, &srx->rx_pool);
 	if (ret) {
+		free(srx->tag_buckets);
 		free(srx);
 		return ret;
 	}
@@ -1169,7 +1425,8 @@ int util_ep_srx_context(struct util_domain *domain, size_t rx_size,
 	srx->update_func = update_func;
 	srx->lock = lock;
 
-	srx->peer_srx.owner_ops = &util_srx_owner_ops;
+	srx->peer_srx.owner_ops = srx->tag_buckets ?
+				  &util_srx_hash_owner_ops : &util_srx_owner_ops;
 	srx->peer_srx.peer_ops = NULL;
 
 	srx->peer_srx.ep_fid.fid.fclass = FI_CLASS_SRX_CTX;
@@ -331,16 +331,14 @@ static int util_wait_update_pollfd(struct util_wait_fd *wait_fd,
 	return -FI_EAGAIN;
 }
 
-static int util_wait_fd_try(struct util_wait *wait)
+static int util_wait_fd_check(struct util_wait_fd *wait_fd)
 {
+	struct util_wait *wait = &wait_fd->util_wait;
 	struct ofi_wait_fid_entry *fid_entry;
 	struct ofi_wait_fd_entry *fd_entry;
-	struct util_wait_fd *wait_fd;
 	void *context;
 	int ret;
 
-	wait_fd = container_of(wait, struct util_wait_fd, util_wait);
-	fd_signal_reset(&wait_fd->signal);
 	ofi_mutex_lock(&wait->lock);
 	dlist_foreach_container(&wait_fd->fd_list, struct ofi_wait_fd_entry,
 				fd_entry, entry) {
@@ -371,11 +369,106 @@ release:
 	return ret;
 }
 
+static int util_wait_fd_try(struct util_wait *wait)
+{
+	struct util_wait_fd *wait_fd;
+
+	wait_fd = container_of(wait, struct util_wait_fd, util_wait);
+	fd_signal_reset(&wait_fd->signal);
+	return util_wait_fd_check(wait_fd);
+}
+
+/*
+ * Adaptive spinning (FI_WAIT_SPIN_USEC): before arming the fds and going
+ * to sleep, keep polling the attached CQs and counters.  The budget is twice
+ * the running average of how long waits took to be satisfied, capped at
+ * spin_max.  While events arrive in bursts most waits finish without a
+ * syscall or wakeup; once waits routinely outlast spin_max the budget drops
+ * to zero and we block right away.  Blocking waits still feed the average,
+ * so spinning resumes when the traffic does.
+ *
+ * The time spent spinning is left out of a blocking wait's sample, since
+ * on an oversubscribed node spinning can be what keeps the peer from
+ * running.  Consecutive misses shrink the budget further, with a full
+ * budget probe every OFI_WAIT_SPIN_PROBE misses.
+ */
+#define OFI_WAIT_SPIN_PROBE	32
+
+static bool util_wait_fd_signaled(struct util_wait_fd *wait)
+{
+	bool signaled;
+
+	ofi_mutex_lock(&wait->signal.lock);
+	signaled = wait->signal.byte_avail;
+	ofi_mutex_unlock(&wait->signal.lock);
+	return signaled;
+}
+
+static int util_wait_fd_spin(struct util_wait_fd *wait, int timeout,
+			     uint64_t start, uint64_t *spun)
+{
+	uint64_t budget, now;
+	int ret = 0;
+
+	ofi_mutex_lock(&wait->util_wait.lock);
+	budget = (wait->spin_avg > wait->spin_max) ? 0 :
+		 MIN(wait->spin_avg * 2, wait->spin_max);
+	if (wait->spin_miss % OFI_WAIT_SPIN_PROBE)
+		budget >>= MIN(wait->spin_miss, 8);
+	ofi_mutex_unlock(&wait->util_wait.lock);
+
+	if (timeout >= 0)
+		budget = MIN(budget, (uint64_t) timeout * 1000000);
+
+	now = start;
+	while (now - start < budget) {
+		/* leave the signal for the next wait_try to consume */
+		if (util_wait_fd_signaled(wait)) {
+			ret = -FI_EAGAIN;
+			break;
+		}
+
+		ret = util_wait_fd_check(wait);
+		if (ret)
+			break;
+		now = ofi_gettime_ns();
+	}
+
+	*spun = now - start;
+	return ret;
+}
+
+static void util_wait_fd_spin_update(struct util_wait_fd *wait,
+				     uint64_t start, uint64_t spun,
+				     bool parked)
+{
+	uint64_t sample;
+
+	sample = ofi_gettime_ns() - start;
+	if (parked)
+		sample -= spun;
+	sample = MIN(sample, wait->spin_max * 2);
+
+	ofi_mutex_lock(&wait->util_wait.lock);
+	wait->spin_avg = wait->spin_avg - wait->spin_avg / 8 + sample / 8;
+	wait->spin_time += spun;
+	if (parked) {
+		wait->parks++;
+		if (spun)
+			wait->spin_miss++;
+	} else {
+		wait->spin_hits++;
+		wait->spin_miss = 0;
+	}
+	ofi_mutex_unlock(&wait->util_wait.lock);
+}
+
 static int util_wait_fd_run(struct fid_wait *wait_fid, int timeout)
 {
 	struct ofi_epollfds_event event;
 	struct util_wait_fd *wait;
-	uint64_t endtime;
+	uint64_t endtime, start = 0, spun = 0;
+	bool parked = false;
 	int ret;
 
 	wait = container_of(wait_fid, struct util_wait_fd, util_wait.wait_fid);
@@ -383,17 +476,38 @@ static int util_wait_fd_run(struct fid_wait *wait_fid, int timeout)
 
 	while (1) {
 		ret = wait->util_wait.wait_try(&wait->util_wait);
-		if (ret)
-			return ret == -FI_EAGAIN ? 0 : ret;
+		if (ret) {
+			ret = (ret == -FI_EAGAIN) ? 0 : ret;
+			break;
+		}
 
-		if (ofi_adjust_timeout(endtime, &timeout))
-			return -FI_ETIMEDOUT;
+		if (ofi_adjust_timeout(endtime, &timeout)) {
+			ret = -FI_ETIMEDOUT;
+			break;
+		}
 
+		if (wait->spin_max && !start) {
+			start = ofi_gettime_ns();
+			ret = util_wait_fd_spin(wait, timeout, start, &spun);
+			if (ret) {
+				ret = (ret == -FI_EAGAIN) ? 0 : ret;
+				break;
+			}
+
+			if (ofi_adjust_timeout(endtime, &timeout)) {
+				ret = -FI_ETIMEDOUT;
+				break;
+			}
+		}
+
+		parked = true;
 		ret = (wait->util_wait.wait_obj == FI_WAIT_FD) ?
 		      ofi_epoll_wait(wait->epoll_fd, &event, 1, timeout) :
 		      ofi_pollfds_wait(wait->pollfds, &event, 1, timeout);
-		if (ret > 0)
-			return FI_SUCCESS;
+		if (ret > 0) {
+			ret = FI_SUCCESS;
+			break;
+		}
 
 		if (ret < 0) {
 #if ENABLE_DEBUG
@@ -403,9 +517,13 @@ static int util_wait_fd_run(struct fid_wait *wait_fid, int timeout)
 #endif
 			FI_WARN(wait->util_wait.prov, FI_LOG_FABRIC,
 				"poll failed\n");
-			return ret;
+			break;
 		}
 	}
+
+	if (start)
+		util_wait_fd_spin_update(wait, start, spun, parked);
+	return ret;
 }
 
 static int util_wait_fd_control(struct fid *fid, int command, void *arg)
@@ -473,6 +591,14 @@ static int util_wait_fd_close(struct fid *fid)
 	if (ret)
 		return ret;
 
+	if (wait->spin_max) {
+		FI_INFO(wait->util_wait.prov, FI_LOG_FABRIC,
+			"wait spin stats: %zu satisfied while spinning, "
+			"%zu parked, %" PRIu64 " us spent spinning, "
+			"average wait %" PRIu64 " ns\n", wait->spin_hits,
+			wait->parks, wait->spin_time / 1000, wait->spin_avg);
+	}
+
 	ofi_wait_fdset_del(wait, wait->signal.fd[FI_READ_FD]);
 	fd_signal_free(&wait->signal);
 
@@ -541,6 +667,10 @@ int ofi_wait_fd_open(struct fid_fabric *fabric_fid, struct fi_wait_attr *attr,
 
 	wait->util_wait.signal = util_wait_fd_signal;
 	wait->util_wait.wait_try = util_wait_fd_try;
+	if (ofi_wait_spin_usec > 0) {
+		wait->spin_max = (uint64_t) ofi_wait_spin_usec * 1000;
+		wait->spin_avg = wait->spin_max;
+	}
 	ret = fd_signal_init(&wait->signal);
 	if (ret)
 		goto err2;
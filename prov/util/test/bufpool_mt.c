@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2026 Intel Corporation.  All rights reserved.
+ *
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+ * Stress test for OFI_BUFPOOL_MT.  Threads allocate entries while the pool
+ * grows, hand batches to a neighbour to be freed there, and check that no
+ * entry is handed out twice.  Once all threads exit, every entry must be
+ * back on the shared free list.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <pthread.h>
+
+#include <rdma/fi_errno.h>
+#include <ofi_mem.h>
+
+enum {
+	TEST_THREADS	= 8,
+	TEST_ITERS	= 2000,
+	TEST_BATCH	= OFI_BUFPOOL_MAG_SIZE - OFI_BUFPOOL_MAG_BATCH / 2,
+	TEST_CHUNK_CNT	= 16,
+};
+
+struct test_entry {
+	uint64_t	stamp;
+	char		data[48];
+};
+
+struct test_slot {
+	pthread_mutex_t		lock;
+	struct test_entry	*entries[TEST_BATCH];
+	int			cnt;
+};
+
+static struct ofi_bufpool *pool;
+static struct test_slot slots[TEST_THREADS];
+static int errors;
+
+#define test_error(fmt, ...)						\
+	do {								\
+		fprintf(stderr, "%s:%d: " fmt "\n", __func__, __LINE__, \
+			##__VA_ARGS__);					\
+		__atomic_add_fetch(&errors, 1, __ATOMIC_RELAXED);	\
+	} while (0)
+
+static void test_stamp(struct test_entry *entry, uint64_t stamp)
+{
+	entry->stamp = stamp;
+	memset(entry->data, (char) stamp, sizeof(entry->data));
+}
+
+static void test_free(struct test_entry *entry)
+{
+	size_t i;
+
+	for (i = 0; i < sizeof(entry->data); i++) {
+		if (entry->data[i] != (char) entry->stamp) {
+			test_error("entry %p stamp %#" PRIx64 " overwritten",
+				   (void *) entry, entry->stamp);
+			break;
+		}
+	}
+	test_stamp(entry, 0);
+	ofi_buf_free(entry);
+}
+
+static void *test_thread(void *arg)
+{
+	struct test_entry *entries[TEST_BATCH];
+	struct test_slot *next, *own;
+	uint64_t id = (uintptr_t) arg;
+	int iter, i;
+
+	own = &slots[id];
+	next = &slots[(id + 1) % TEST_THREADS];
+
+	for (iter = 0; iter < TEST_ITERS; iter++) {
+		for (i = 0; i < TEST_BATCH; i++) {
+			entries[i] = ofi_buf_alloc(pool);
+			if (!entries[i]) {
+				test_error("alloc failed");
+				return NULL;
+			}
+			if (ofi_bufpool_get_ibuf(pool, ofi_buf_index(entries[i])) !=
+			    entries[i])
+				test_error("index lookup mismatch");
+			test_stamp(entries[i], (id + 1) << 32 | iter);
+		}
+
+		/* every other batch is freed by the next thread */
+		pthread_mutex_lock(&next->lock);
+		if (!(iter & 1) && !next->cnt) {
+			memcpy(next->entries, entries, sizeof(entries));
+			next->cnt = TEST_BATCH;
+			i = TEST_BATCH;
+		} else {
+			i = 0;
+		}
+		pthread_mutex_unlock(&next->lock);
+
+		for (; i < TEST_BATCH; i++)
+			test_free(entries[i]);
+
+		pthread_mutex_lock(&own->lock);
+		for (i = 0; i < own->cnt; i++)
+			test_free(own->entries[i]);
+		own->cnt = 0;
+		pthread_mutex_unlock(&own->lock);
+	}
+	return NULL;
+}
+
+/* All entries cached by exited threads must be allocatable without growth */
+static void test_check_all_free(void)
+{
+	struct test_entry **entries;
+	size_t i, cnt = pool->entry_cnt;
+
+	entries = calloc(cnt, sizeof(*entries));
+	if (!entries) {
+		test_error("calloc failed");
+		return;
+	}
+
+	for (i = 0; i < cnt; i++) {
+		entries[i] = ofi_buf_alloc(pool);
+		if (!entries[i]) {
+			test_error("alloc failed");
+			break;
+		}
+		if (entries[i]->stamp)
+			test_error("entry %p still in use", (void *) entries[i]);
+		test_stamp(entries[i], 0xff);
+	}
+	if (pool->entry_cnt != cnt)
+		test_error("pool grew from %zu to %zu entries, entries leaked",
+			   cnt, pool->entry_cnt);
+
+	while (i--)
+		test_free(entries[i]);
+	free(entries);
+}
+
+int main(void)
+{
+	pthread_t threads[TEST_THREADS];
+	uintptr_t i;
+	int ret, j;
+
+	ret = ofi_bufpool_create(&pool, sizeof(struct test_entry), 16, 0,
+				 TEST_CHUNK_CNT, OFI_BUFPOOL_MT);
+	if (ret) {
+		fprintf(stderr, "ofi_bufpool_create: %s\n", fi_strerror(-ret));
+		return EXIT_FAILURE;
+	}
+
+	for (i = 0; i < TEST_THREADS; i++)
+		pthread_mutex_init(&slots[i].lock, NULL);
+
+	for (i = 0; i < TEST_THREADS; i++) {
+		ret = pthread_create(&threads[i], NULL, test_thread, (void *) i);
+		if (ret) {
+			fprintf(stderr, "pthread_create: %s\n", strerror(ret));
+			return EXIT_FAILURE;
+		}
+	}
+
+	for (i = 0; i < TEST_THREADS; i++)
+		pthread_join(threads[i], NULL);
+
+	for (i = 0; i < TEST_THREADS; i++) {
+		for (j = 0; j < slots[i].cnt; j++)
+			test_free(slots[i].entries[j]);
+		pthread_mutex_destroy(&slots[i].lock);
+	}
+
+	test_check_all_free();
+	printf("%s: %d threads, %zu entries, %d errors\n",
+	       errors ? "FAILED" : "PASSED", TEST_THREADS, pool->entry_cnt,
+	       errors);
+	ofi_bufpool_destroy(pool);
+
+	return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
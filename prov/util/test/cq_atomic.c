@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) 2026 Intel Corporation.  All rights reserved.
+ *
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+ * Stress test for util_cq created with OFI_CQ_ATOMIC_QUEUE.  Threads write
+ * completions into a small CQ that a slow reader lets fill up, so writes
+ * spill into the aux queue.  Every completion must be read exactly once
+ * and in the order its writer wrote it.  An error written behind queued
+ * completions must only be reported once they have been read.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <rdma/fi_errno.h>
+#include <ofi_util.h>
+
+enum {
+	TEST_THREADS	= 4,
+	TEST_ITERS	= 20000,
+	TEST_CQ_SIZE	= 16,
+	TEST_READ_CNT	= 8,
+	TEST_STALL	= 64,
+};
+
+static struct fi_provider test_prov = {
+	.name = "cq_atomic",
+	.version = 1,
+	.fi_version = FI_VERSION(1, 18),
+};
+
+static struct util_fabric fabric;
+static struct util_domain domain;
+static struct util_cq cq;
+static int errors;
+
+#define test_error(fmt, ...)						\
+	do {								\
+		fprintf(stderr, "%s:%d: " fmt "\n", __func__, __LINE__, \
+			##__VA_ARGS__);					\
+		__atomic_add_fetch(&errors, 1, __ATOMIC_RELAXED);	\
+	} while (0)
+
+static void test_cq_progress(struct util_cq *util_cq)
+{
+}
+
+static int test_setup(void)
+{
+	struct fi_fabric_attr fabric_attr = {
+		.name = "cq_atomic",
+		.prov_version = 1,
+		.api_version = FI_VERSION(1, 18),
+	};
+	struct fi_domain_attr domain_attr = {
+		.name = "cq_atomic",
+		.threading = FI_THREAD_SAFE,
+		.control_progress = FI_PROGRESS_AUTO,
+		.data_progress = FI_PROGRESS_AUTO,
+	};
+	struct fi_info info = {
+		.domain_attr = &domain_attr,
+		.fabric_attr = &fabric_attr,
+	};
+	struct fi_cq_attr cq_attr = {
+		.format = FI_CQ_FORMAT_DATA,
+		.wait_obj = FI_WAIT_NONE,
+		.size = TEST_CQ_SIZE,
+	};
+	int ret;
+
+	ret = ofi_fabric_init(&test_prov, &fabric_attr, &fabric_attr,
+			      &fabric, NULL);
+	if (ret)
+		return ret;
+	fabric.fabric_fid.api_version = FI_VERSION(1, 18);
+
+	ret = ofi_domain_init(&fabric.fabric_fid, &info, &domain, NULL,
+			      OFI_LOCK_MUTEX);
+	if (ret)
+		return ret;
+
+	ret = ofi_cq_init2(&test_prov, &domain.domain_fid, &cq_attr, &cq,
+			   test_cq_progress, OFI_CQ_ATOMIC_QUEUE, NULL);
+	if (ret)
+		return ret;
+
+	if (!cq.atomq) {
+		fprintf(stderr, "CQ is not backed by the atomic queue\n");
+		return -FI_EINVAL;
+	}
+	return 0;
+}
+
+static void test_cleanup(void)
+{
+	ofi_cq_cleanup(&cq);
+	ofi_domain_close(&domain);
+	ofi_fabric_close(&fabric);
+}
+
+static void *test_writer(void *arg)
+{
+	uint64_t id = (uintptr_t) arg;
+	uint64_t seq;
+	int ret;
+
+	for (seq = 0; seq < TEST_ITERS; seq++) {
+		ret = ofi_cq_write(&cq, NULL, FI_RECV | FI_MSG, 0, NULL,
+				   id << 32 | seq, 0);
+		if (ret) {
+			test_error("ofi_cq_write: %s", fi_strerror(-ret));
+			break;
+		}
+	}
+	return NULL;
+}
+
+/* Read until every writer's completions are in, stalling now and then */
+static void test_read_all(void)
+{
+	struct fi_cq_data_entry comp[TEST_READ_CNT];
+	uint64_t next[TEST_THREADS] = { 0 };
+	uint64_t total = 0, id, seq;
+	int aux_seen = 0, reads = 0;
+	ssize_t i, ret;
+
+	while (total < (uint64_t) TEST_THREADS * TEST_ITERS && !errors) {
+		if (!(++reads % TEST_STALL)) {
+			sched_yield();
+			if (ofi_atomic_get32(&cq.aux_cnt))
+				aux_seen++;
+		}
+
+		ret = fi_cq_read(&cq.cq_fid, comp, TEST_READ_CNT);
+		if (ret == -FI_EAGAIN)
+			continue;
+		if (ret < 0) {
+			test_error("fi_cq_read: %s", fi_strerror((int) -ret));
+			return;
+		}
+
+		for (i = 0; i < ret; i++) {
+			id = comp[i].data >> 32;
+			seq = comp[i].data & UINT32_MAX;
+			if (id >= TEST_THREADS || seq != next[id]) {
+				test_error("writer %" PRIu64 " entry %" PRIu64
+					   " read, expected %" PRIu64, id, seq,
+					   id < TEST_THREADS ? next[id] : 0);
+				return;
+			}
+			next[id]++;
+		}
+		total += ret;
+	}
+
+	if (fi_cq_read(&cq.cq_fid, comp, 1) != -FI_EAGAIN)
+		test_error("CQ not empty after all entries were read");
+	if (!ofi_cq_isempty(&cq))
+		test_error("ofi_cq_isempty false on an empty CQ");
+	if (!aux_seen)
+		printf("note: aux queue not observed in use\n");
+}
+
+/*
+ * Once an entry has spilled into the aux queue, an error must wait behind
+ * the completions queued before it, and so must completions after it.
+ */
+static void test_error_order(void)
+{
+	struct fi_cq_err_entry err_entry = {
+		.op_context = &cq,
+		.flags = FI_RECV,
+		.err = FI_ETRUNC,
+		.prov_errno = FI_ETRUNC,
+	};
+	struct fi_cq_data_entry comp[TEST_CQ_SIZE * 2];
+	uint64_t i;
+	ssize_t ret;
+
+	for (i = 0; i < TEST_CQ_SIZE + 2; i++) {
+		if (ofi_cq_write(&cq, NULL, FI_RECV, 0, NULL, i, 0))
+			test_error("ofi_cq_write failed");
+	}
+	if (!ofi_atomic_get32(&cq.aux_cnt))
+		test_error("full CQ did not spill into the aux queue");
+
+	if (ofi_cq_write_error(&cq, &err_entry))
+		test_error("ofi_cq_write_error failed");
+	if (ofi_cq_write(&cq, NULL, FI_RECV, 0, NULL, i, 0))
+		test_error("ofi_cq_write failed");
+
+	memset(&err_entry, 0, sizeof(err_entry));
+	if (fi_cq_readerr(&cq.cq_fid, &err_entry, 0) != -FI_EAGAIN)
+		test_error("error reported ahead of earlier completions");
+
+	ret = fi_cq_read(&cq.cq_fid, comp, TEST_CQ_SIZE * 2);
+	if (ret != TEST_CQ_SIZE + 2) {
+		test_error("read %zd completions ahead of the error, "
+			   "expected %d", ret, TEST_CQ_SIZE + 2);
+		return;
+	}
+	for (i = 0; i < (uint64_t) ret; i++) {
+		if (comp[i].data != i)
+			test_error("entry %" PRIu64 " read at %" PRIu64,
+				   comp[i].data, i);
+	}
+
+	ret = fi_cq_read(&cq.cq_fid, comp, 1);
+	if (ret != -FI_EAVAIL)
+		test_error("fi_cq_read returned %zd, expected -FI_EAVAIL", ret);
+	ret = fi_cq_readerr(&cq.cq_fid, &err_entry, 0);
+	if (ret != 1 || err_entry.err != FI_ETRUNC ||
+	    err_entry.op_context != &cq)
+		test_error("fi_cq_readerr returned %zd, err %d", ret,
+			   err_entry.err);
+
+	ret = fi_cq_read(&cq.cq_fid, comp, 1);
+	if (ret != 1 || comp[0].data != TEST_CQ_SIZE + 2)
+		test_error("completion after the error not read");
+	if (!ofi_cq_isempty(&cq))
+		test_error("CQ not empty");
+}
+
+int main(void)
+{
+	pthread_t threads[TEST_THREADS];
+	uintptr_t i;
+	int ret;
+
+	ret = test_setup();
+	if (ret) {
+		fprintf(stderr, "setup: %s\n", fi_strerror(-ret));
+		return EXIT_FAILURE;
+	}
+
+	for (i = 0; i < TEST_THREADS; i++) {
+		ret = pthread_create(&threads[i], NULL, test_writer, (void *) i);
+		if (ret) {
+			fprintf(stderr, "pthread_create: %s\n", strerror(ret));
+			return EXIT_FAILURE;
+		}
+	}
+
+	test_read_all();
+
+	for (i = 0; i < TEST_THREADS; i++)
+		pthread_join(threads[i], NULL);
+
+	if (!errors)
+		test_error_order();
+
+	test_cleanup();
+	printf("%s: %d writers, %d entries each, %d errors\n",
+	       errors ? "FAILED" : "PASSED", TEST_THREADS, TEST_ITERS, errors);
+
+	return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2026 Intel Corporation.  All rights reserved.
+ *
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+ * Stress test for MR cache hits looked up without mm_lock.  Threads search
+ * and release a few regions in a cache too small to hold them all, while
+ * another thread uncaches the regions as a memory monitor would and
+ * flushes the cache.  An entry handed out by a search must stay registered
+ * until it is released, an entry must only be deregistered once nobody
+ * uses it, and every registration must be deregistered exactly once.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include <rdma/fi_errno.h>
+#include <ofi_mr.h>
+#include <ofi_mem.h>
+#include <ofi_hmem.h>
+
+enum {
+	TEST_THREADS	= 4,
+	TEST_ITERS	= 100000,
+	TEST_REGIONS	= 16,
+	TEST_CACHE_CNT	= 8,
+	TEST_REGION_SIZE = 4096,
+	TEST_FLUSH	= 16,
+};
+
+#define TEST_MAGIC 0x6d725f6361636865ULL
+
+/* users counts the searches that returned the entry and were not released */
+struct test_region {
+	uint64_t	magic;
+	void		*addr;
+	int		users;
+};
+
+static char buf[TEST_REGIONS][TEST_REGION_SIZE]
+	__attribute__((aligned(TEST_REGION_SIZE)));
+static struct ofi_mr_cache cache;
+static int add_cnt, delete_cnt, hitters;
+static int errors;
+
+#define test_error(fmt, ...)						\
+	do {								\
+		fprintf(stderr, "%s:%d: " fmt "\n", __func__, __LINE__, \
+			##__VA_ARGS__);					\
+		__atomic_add_fetch(&errors, 1, __ATOMIC_RELAXED);	\
+	} while (0)
+
+static int test_start(struct ofi_mem_monitor *monitor)
+{
+	return 0;
+}
+
+static void test_stop(struct ofi_mem_monitor *monitor)
+{
+}
+
+static int test_subscribe(struct ofi_mem_monitor *monitor, const void *addr,
+			  size_t len, union ofi_mr_hmem_info *hmem_info)
+{
+	return 0;
+}
+
+static void test_unsubscribe(struct ofi_mem_monitor *monitor,
+			     const void *addr, size_t len,
+			     union ofi_mr_hmem_info *hmem_info)
+{
+}
+
+static bool test_valid(struct ofi_mem_monitor *monitor,
+		       const struct ofi_mr_info *info,
+		       struct ofi_mr_entry *entry)
+{
+	return true;
+}
+
+static struct ofi_mem_monitor test_monitor = {
+	.iface = FI_HMEM_SYSTEM,
+	.start = test_start,
+	.stop = test_stop,
+	.subscribe = test_subscribe,
+	.unsubscribe = test_unsubscribe,
+	.valid = test_valid,
+	.name = "mr_cache_race",
+};
+
+static int test_add_region(struct ofi_mr_cache *cache,
+			   struct ofi_mr_entry *entry)
+{
+	struct test_region *region = (struct test_region *) entry->data;
+
+	region->magic = TEST_MAGIC;
+	region->addr = entry->info.iov.iov_base;
+	region->users = 0;
+	__atomic_add_fetch(&add_cnt, 1, __ATOMIC_RELAXED);
+	return 0;
+}
+
+static void test_delete_region(struct ofi_mr_cache *cache,
+			       struct ofi_mr_entry *entry)
+{
+	struct test_region *region = (struct test_region *) entry->data;
+
+	if (__atomic_load_n(&region->users, __ATOMIC_ACQUIRE))
+		test_error("region %p deregistered while in use",
+			   region->addr);
+	if (region->magic != TEST_MAGIC)
+		test_error("region %p deregistered twice", region->addr);
+
+	region->magic = 0;
+	__atomic_add_fetch(&delete_cnt, 1, __ATOMIC_RELAXED);
+}
+
+static int test_setup(void)
+{
+	struct ofi_mem_monitor *monitors[OFI_HMEM_MAX] = {
+		[FI_HMEM_SYSTEM] = &test_monitor,
+	};
+
+	ofi_mem_init();
+	ofi_hmem_init();
+	ofi_monitor_init(&test_monitor);
+
+	/* too small for all regions, so misses evict idle entries */
+	cache_params.max_cnt = TEST_CACHE_CNT;
+	cache_params.max_size = TEST_CACHE_CNT * TEST_REGION_SIZE;
+
+	cache.entry_data_size = sizeof(struct test_region);
+	cache.add_region = test_add_region;
+	cache.delete_region = test_delete_region;
+	return ofi_mr_cache_init(NULL, monitors, &cache);
+}
+
+static void test_cleanup(void)
+{
+	ofi_mr_cache_cleanup(&cache);
+	ofi_monitor_cleanup(&test_monitor);
+	ofi_hmem_cleanup();
+	ofi_mem_fini();
+}
+
+static void *test_hitter(void *arg)
+{
+	struct ofi_mr_info info = {
+		.iov.iov_len = TEST_REGION_SIZE,
+		.iface = FI_HMEM_SYSTEM,
+	};
+	struct ofi_mr_entry *entry;
+	struct test_region *region;
+	unsigned int seed = (uintptr_t) arg;
+	int i, ret;
+
+	for (i = 0; i < TEST_ITERS && !errors; i++) {
+		/* mostly a few hot regions, so that most searches hit */
+		info.iov.iov_base = buf[rand_r(&seed) % (i & 1 ?
+					TEST_REGIONS : TEST_CACHE_CNT / 2)];
+
+		ret = ofi_mr_cache_search(&cache, &info, &entry);
+		if (ret) {
+			test_error("ofi_mr_cache_search: %s", fi_strerror(-ret));
+			break;
+		}
+
+		region = (struct test_region *) entry->data;
+		__atomic_add_fetch(&region->users, 1, __ATOMIC_ACQUIRE);
+		if (region->magic != TEST_MAGIC ||
+		    region->addr != info.iov.iov_base)
+			test_error("search for %p returned a region for %p, "
+				   "magic %#" PRIx64, info.iov.iov_base,
+				   region->addr, region->magic);
+		if (__atomic_load_n(&entry->use_cnt, __ATOMIC_RELAXED) < 1)
+			test_error("search returned an unused entry");
+
+		__atomic_sub_fetch(&region->users, 1, __ATOMIC_RELEASE);
+		ofi_mr_cache_delete(&cache, entry);
+	}
+
+	__atomic_sub_fetch(&hitters, 1, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+/* Uncache regions as a memory monitor would, and flush the cache */
+static void test_notifier(void)
+{
+	unsigned int seed = 1;
+	int i;
+
+	for (i = 0; __atomic_load_n(&hitters, __ATOMIC_ACQUIRE); i++) {
+		pthread_mutex_lock(&mm_lock);
+		ofi_mr_cache_notify(&cache, buf[rand_r(&seed) % TEST_REGIONS],
+				    TEST_REGION_SIZE);
+		pthread_mutex_unlock(&mm_lock);
+
+		/* every other flush also prunes the LRU list */
+		if (!(i % TEST_FLUSH))
+			(void) ofi_mr_cache_flush(&cache, (i / TEST_FLUSH) & 1);
+	}
+}
+
+int main(void)
+{
+	pthread_t threads[TEST_THREADS];
+	uintptr_t i;
+	int ret;
+
+	ret = test_setup();
+	if (ret) {
+		fprintf(stderr, "setup: %s\n", fi_strerror(-ret));
+		return EXIT_FAILURE;
+	}
+
+	hitters = TEST_THREADS;
+	for (i = 0; i < TEST_THREADS; i++) {
+		ret = pthread_create(&threads[i], NULL, test_hitter,
+				     (void *) (i + 1));
+		if (ret) {
+			fprintf(stderr, "pthread_create: %s\n", strerror(ret));
+			return EXIT_FAILURE;
+		}
+	}
+
+	test_notifier();
+
+	for (i = 0; i < TEST_THREADS; i++)
+		pthread_join(threads[i], NULL);
+
+	if (cache.hit_cnt == 0)
+		test_error("no cache hits");
+	if (cache.notify_cnt == 0)
+		test_error("no regions uncached");
+
+	printf("searches %zu, hits %zu, notify %zu, contended %zu\n",
+	       cache.search_cnt, cache.hit_cnt, cache.notify_cnt,
+	       cache.contended_cnt);
+
+	test_cleanup();
+	if (add_cnt != delete_cnt)
+		test_error("%d regions registered, %d deregistered",
+			   add_cnt, delete_cnt);
+
+	printf("%s: %d threads, %d searches each, %d errors\n",
+	       errors ? "FAILED" : "PASSED", TEST_THREADS, TEST_ITERS, errors);
+
+	return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
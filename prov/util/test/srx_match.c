@@ -0,0 +1,396 @@
+/*
+ * Copyright (c) 2026 Intel Corporation.  All rights reserved.
+ *
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+ * Receive matching test for util_srx with FI_SRX_TAG_HASH enabled, run
+ * through the shm provider.  Receives posted to the hash buckets, the
+ * wildcard lists and the ignore bit lists must still match in posting
+ * order, and a multi-receive buffer must be carved up until its remainder
+ * drops below FI_OPT_MIN_MULTI_RECV.  Exits 77 (skipped) if shm is not
+ * available.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <rdma/fabric.h>
+#include <rdma/fi_domain.h>
+#include <rdma/fi_endpoint.h>
+#include <rdma/fi_tagged.h>
+#include <rdma/fi_cm.h>
+#include <rdma/fi_errno.h>
+
+enum {
+	TEST_EP_CNT	= 3,
+	TEST_MSG_SIZE	= 300,
+	TEST_MULTI_SIZE	= 1024,
+	TEST_MIN_MULTI	= 256,
+	TEST_POLL_CNT	= 1000000,
+};
+
+static struct fid_fabric *fabric;
+static struct fid_domain *domain;
+static struct fid_av *av;
+static struct fid_cq *cq;
+static struct fid_ep *ep[TEST_EP_CNT];
+static fi_addr_t addr[TEST_EP_CNT];
+static char rx_buf[4][TEST_MULTI_SIZE];
+static int errors;
+
+#define test_error(fmt, ...)						\
+	do {								\
+		fprintf(stderr, "%s:%d: " fmt "\n", __func__, __LINE__, \
+			##__VA_ARGS__);					\
+		errors++;						\
+	} while (0)
+
+static int test_setup(void)
+{
+	struct fi_info *hints, *info;
+	struct fi_av_attr av_attr = { .type = FI_AV_TABLE };
+	struct fi_cq_attr cq_attr = { .format = FI_CQ_FORMAT_TAGGED };
+	size_t min_multi = TEST_MIN_MULTI;
+	char name[FI_NAME_MAX];
+	size_t len;
+	int i, ret;
+
+	hints = fi_allocinfo();
+	if (!hints)
+		return -FI_ENOMEM;
+
+	hints->ep_attr->type = FI_EP_RDM;
+	hints->caps = FI_MSG | FI_TAGGED | FI_DIRECTED_RECV | FI_MULTI_RECV;
+	hints->fabric_attr->prov_name = strdup("shm");
+
+	ret = fi_getinfo(FI_VERSION(1, 18), NULL, NULL, 0, hints, &info);
+	fi_freeinfo(hints);
+	if (ret)
+		return ret;
+
+	ret = fi_fabric(info->fabric_attr, &fabric, NULL);
+	if (ret)
+		goto out;
+	ret = fi_domain(fabric, info, &domain, NULL);
+	if (ret)
+		goto out;
+	ret = fi_av_open(domain, &av_attr, &av, NULL);
+	if (ret)
+		goto out;
+	ret = fi_cq_open(domain, &cq_attr, &cq, NULL);
+	if (ret)
+		goto out;
+
+	for (i = 0; i < TEST_EP_CNT; i++) {
+		ret = fi_endpoint(domain, info, &ep[i], NULL);
+		if (ret)
+			goto out;
+		ret = fi_ep_bind(ep[i], &av->fid, 0);
+		if (ret)
+			goto out;
+		ret = fi_ep_bind(ep[i], &cq->fid, FI_TRANSMIT | FI_RECV);
+		if (ret)
+			goto out;
+		ret = fi_enable(ep[i]);
+		if (ret)
+			goto out;
+
+		len = sizeof(name);
+		ret = fi_getname(&ep[i]->fid, name, &len);
+		if (ret)
+			goto out;
+		if (fi_av_insert(av, name, 1, &addr[i], 0, NULL) != 1) {
+			ret = -FI_EINVAL;
+			goto out;
+		}
+	}
+
+	/* shm sets up its receive context, and this option, on enable */
+	ret = fi_setopt(&ep[0]->fid, FI_OPT_ENDPOINT, FI_OPT_MIN_MULTI_RECV,
+			&min_multi, sizeof(min_multi));
+out:
+	fi_freeinfo(info);
+	return ret;
+}
+
+static void test_cleanup(void)
+{
+	int i;
+
+	for (i = 0; i < TEST_EP_CNT; i++) {
+		if (ep[i])
+			fi_close(&ep[i]->fid);
+	}
+	if (cq)
+		fi_close(&cq->fid);
+	if (av)
+		fi_close(&av->fid);
+	if (domain)
+		fi_close(&domain->fid);
+	if (fabric)
+		fi_close(&fabric->fid);
+}
+
+/* Wait for the next receive completion, send completions are skipped */
+static int test_wait_recv(struct fi_cq_tagged_entry *comp)
+{
+	struct fi_cq_err_entry err_entry = { 0 };
+	ssize_t ret;
+	int i;
+
+	for (i = 0; i < TEST_POLL_CNT; i++) {
+		ret = fi_cq_read(cq, comp, 1);
+		if (ret == 1) {
+			if (comp->flags & FI_RECV ||
+			    comp->flags & FI_MULTI_RECV)
+				return 0;
+			continue;
+		}
+		if (ret == -FI_EAVAIL) {
+			fi_cq_readerr(cq, &err_entry, 0);
+			test_error("completion error %d", err_entry.err);
+			return -FI_EIO;
+		}
+		if (ret != -FI_EAGAIN) {
+			test_error("fi_cq_read: %zd", ret);
+			return (int) ret;
+		}
+	}
+	test_error("timed out");
+	return -FI_ETIMEDOUT;
+}
+
+static void test_send(int src, uint64_t tag, char fill, bool tagged)
+{
+	char buf[TEST_MSG_SIZE];
+	ssize_t ret;
+
+	memset(buf, fill, sizeof(buf));
+	do {
+		if (tagged)
+			ret = fi_tsend(ep[src], buf, sizeof(buf), NULL,
+				       addr[0], tag, NULL);
+		else
+			ret = fi_send(ep[src], buf, sizeof(buf), NULL,
+				      addr[0], NULL);
+		if (ret == -FI_EAGAIN)
+			(void) fi_cq_read(cq, NULL, 0);
+	} while (ret == -FI_EAGAIN);
+
+	if (ret)
+		test_error("send: %zd", ret);
+}
+
+static void test_post(int slot, fi_addr_t src, uint64_t tag, uint64_t ignore,
+		      bool tagged)
+{
+	ssize_t ret;
+
+	memset(rx_buf[slot], 0, sizeof(rx_buf[slot]));
+	if (tagged)
+		ret = fi_trecv(ep[0], rx_buf[slot], TEST_MSG_SIZE, NULL, src,
+			       tag, ignore, &rx_buf[slot]);
+	else
+		ret = fi_recv(ep[0], rx_buf[slot], TEST_MSG_SIZE, NULL, src,
+			      &rx_buf[slot]);
+	if (ret)
+		test_error("post: %zd", ret);
+}
+
+/* The next receive must complete into slot with data filled by fill */
+static void test_expect(int slot, char fill)
+{
+	struct fi_cq_tagged_entry comp;
+
+	if (test_wait_recv(&comp))
+		return;
+
+	if (comp.op_context != &rx_buf[slot]) {
+		test_error("message %c matched the wrong receive", fill);
+		return;
+	}
+	if (rx_buf[slot][0] != fill || rx_buf[slot][TEST_MSG_SIZE - 1] != fill)
+		test_error("slot %d holds %c, expected %c", slot,
+			   rx_buf[slot][0], fill);
+}
+
+/*
+ * For each message the oldest posted receive that matches it wins,
+ * wherever the receives are queued.
+ */
+static void test_posting_order(bool tagged)
+{
+	/* wildcard then directed */
+	test_post(0, FI_ADDR_UNSPEC, 1, 0, tagged);
+	test_post(1, addr[1], 1, 0, tagged);
+	test_send(1, 1, 'a', tagged);
+	test_send(1, 1, 'b', tagged);
+	test_expect(0, 'a');
+	test_expect(1, 'b');
+
+	/* directed then wildcard */
+	test_post(0, addr[1], 1, 0, tagged);
+	test_post(1, FI_ADDR_UNSPEC, 1, 0, tagged);
+	test_send(1, 1, 'c', tagged);
+	test_send(1, 1, 'd', tagged);
+	test_expect(0, 'c');
+	test_expect(1, 'd');
+
+	/* a receive directed at another source is passed over */
+	test_post(0, addr[1], 1, 0, tagged);
+	test_post(1, FI_ADDR_UNSPEC, 1, 0, tagged);
+	test_send(2, 1, 'e', tagged);
+	test_expect(1, 'e');
+	test_send(1, 1, 'f', tagged);
+	test_expect(0, 'f');
+}
+
+/* Receives with ignore bits are not hashed but keep their place in line */
+static void test_ignore_order(void)
+{
+	test_post(0, FI_ADDR_UNSPEC, 0x10, 0xf, true);
+	test_post(1, addr[1], 0x11, 0, true);
+	test_post(2, FI_ADDR_UNSPEC, 0x11, 0, true);
+	test_send(1, 0x11, 'g', true);
+	test_send(1, 0x11, 'h', true);
+	test_send(1, 0x11, 'i', true);
+	test_expect(0, 'g');
+	test_expect(1, 'h');
+	test_expect(2, 'i');
+
+	/* the tag must still match */
+	test_post(0, FI_ADDR_UNSPEC, 0x20, 0, true);
+	test_post(1, FI_ADDR_UNSPEC, 0x21, 0, true);
+	test_send(1, 0x21, 'j', true);
+	test_expect(1, 'j');
+	test_send(1, 0x20, 'k', true);
+	test_expect(0, 'k');
+}
+
+/*
+ * Messages land back to back in a multi-receive buffer.  The completion
+ * that leaves less than FI_OPT_MIN_MULTI_RECV behind is followed by the
+ * FI_MULTI_RECV completion releasing the buffer, and later messages go to
+ * the next receive.
+ */
+static void test_multi_recv(void)
+{
+	struct fi_cq_tagged_entry comp;
+	struct iovec iov = {
+		.iov_base = rx_buf[3],
+		.iov_len = TEST_MULTI_SIZE,
+	};
+	struct fi_msg msg = {
+		.msg_iov = &iov,
+		.iov_count = 1,
+		.addr = FI_ADDR_UNSPEC,
+		.context = &rx_buf[3],
+	};
+	size_t offset = 0;
+	bool released = false;
+	int i, cnt = 0;
+
+	memset(rx_buf[3], 0, sizeof(rx_buf[3]));
+	if (fi_recvmsg(ep[0], &msg, FI_MULTI_RECV)) {
+		test_error("fi_recvmsg failed");
+		return;
+	}
+
+	for (i = 0; i < TEST_MULTI_SIZE / TEST_MSG_SIZE; i++)
+		test_send(1, 0, 'l' + i, false);
+
+	while (!released) {
+		if (test_wait_recv(&comp))
+			return;
+		if (comp.op_context != &rx_buf[3]) {
+			test_error("completion for the wrong receive");
+			return;
+		}
+
+		if (comp.flags & FI_RECV) {
+			if (comp.buf != rx_buf[3] + offset ||
+			    comp.len != TEST_MSG_SIZE)
+				test_error("message %d at offset %td len %zu",
+					   cnt, (char *) comp.buf - rx_buf[3],
+					   comp.len);
+			else if (rx_buf[3][offset] != 'l' + cnt)
+				test_error("message %d holds %c", cnt,
+					   rx_buf[3][offset]);
+			offset += TEST_MSG_SIZE;
+			cnt++;
+		}
+		if (comp.flags & FI_MULTI_RECV)
+			released = true;
+	}
+
+	if (cnt != TEST_MULTI_SIZE / TEST_MSG_SIZE)
+		test_error("buffer released after %d messages", cnt);
+	if (TEST_MULTI_SIZE - offset >= TEST_MIN_MULTI)
+		test_error("buffer released with %zu bytes left",
+			   TEST_MULTI_SIZE - offset);
+
+	/* the remainder must not take any more messages */
+	test_post(0, FI_ADDR_UNSPEC, 0, 0, false);
+	test_send(1, 0, 'z', false);
+	test_expect(0, 'z');
+}
+
+int main(void)
+{
+	int ret;
+
+	setenv("FI_SRX_TAG_HASH", "1", 1);
+
+	ret = test_setup();
+	if (ret) {
+		test_cleanup();
+		if (ret == -FI_ENODATA) {
+			printf("SKIPPED: shm provider not available\n");
+			return 77;
+		}
+		fprintf(stderr, "setup: %s\n", fi_strerror(-ret));
+		return EXIT_FAILURE;
+	}
+
+	test_posting_order(true);
+	test_posting_order(false);
+	test_ignore_order();
+	test_multi_recv();
+
+	test_cleanup();
+	printf("%s: %d errors\n", errors ? "FAILED" : "PASSED", errors);
+
+	return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
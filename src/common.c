@@ -86,6 +86,8 @@ struct ofi_common_locks common_locks = {
 
 size_t ofi_universe_size = 1024;
 int ofi_av_remove_cleanup;
+int ofi_srx_tag_hash;
+int ofi_wait_spin_usec;
 char *ofi_offload_coll_prov_name = NULL;
 
 
@@ -1278,11 +1280,65 @@ int ofi_bsock_sendv(struct ofi_bsock *bsock, const struct iovec *iov,
 	return 0;
 }
 
+void ofi_bsock_put_rbufs(struct ofi_bsock *bsock)
+{
+	struct slist_entry *entry;
+
+	while (!slist_empty(&bsock->rbufs)) {
+		entry = slist_remove_head(&bsock->rbufs);
+		ofi_bufring_put(bsock->bufring,
+				container_of(entry, struct ofi_bufring_buf,
+					     entry));
+	}
+	bsock->rbufs_len = 0;
+	bsock->rbufs_cnt = 0;
+}
+
+/* With a provided buffer ring, the data has already been received by a
+ * multishot receive.  Copy it out and return the buffers to the ring.
+ * The socket is never read directly.
+ */
+static int ofi_bsock_recv_rbufs(struct ofi_bsock *bsock, struct iovec *iov,
+				size_t cnt, size_t *len)
+{
+	struct ofi_bufring_buf *buf;
+	size_t bytes, copied;
+
+	bytes = ofi_byteq_readv(&bsock->rq, iov, cnt, 0);
+	while (!slist_empty(&bsock->rbufs)) {
+		buf = container_of(bsock->rbufs.head, struct ofi_bufring_buf,
+				   entry);
+		copied = ofi_copy_to_iov(iov, cnt, bytes,
+					 ofi_bufring_data(bsock->bufring, buf),
+					 buf->len);
+		bytes += copied;
+		bsock->rbufs_len -= copied;
+		buf->offset += (uint32_t) copied;
+		buf->len -= (uint32_t) copied;
+		if (buf->len)
+			break;
+
+		slist_remove_head(&bsock->rbufs);
+		bsock->rbufs_cnt--;
+		ofi_bufring_put(bsock->bufring, buf);
+	}
+
+	*len = bytes;
+	return bytes ? 0 : -FI_EAGAIN;
+}
+
 int ofi_bsock_recv(struct ofi_bsock *bsock, void *buf, size_t *len)
 {
+	struct iovec iov;
 	size_t bytes, avail = 0;
 	ssize_t ret;
 
+	if (bsock->bufring) {
+		iov.iov_base = buf;
+		iov.iov_len = *len;
+		return ofi_bsock_recv_rbufs(bsock, &iov, 1, len);
+	}
+
 	bytes = ofi_byteq_read(&bsock->rq, buf, *len);
 	if (bytes) {
 		if (bytes == *len) {
@@ -1341,6 +1397,9 @@ int ofi_bsock_recvv(struct ofi_bsock *bsock, struct iovec *iov, size_t cnt,
 		return ofi_bsock_recv(bsock, iov[0].iov_base, len);
 	}
 
+	if (bsock->bufring)
+		return ofi_bsock_recv_rbufs(bsock, iov, cnt, len);
+
 	*len = ofi_total_iov_len(iov, cnt);
 	if (ofi_byteq_readable(&bsock->rq)) {
 		bytes = ofi_byteq_readv(&bsock->rq, iov, cnt, 0);
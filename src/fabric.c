@@ -51,6 +51,7 @@
 #include "ofi_perf.h"
 #include "ofi_hmem.h"
 #include "ofi_mr.h"
+#include "ofi_atomic.h"
 #include <ofi_shm_p2p.h>
 #include <rdma/fi_ext.h>
 
@@ -928,6 +929,7 @@ void fi_ini(void)
 	ofi_osd_init();
 	ofi_mem_init();
 	ofi_pmem_init();
+	ofi_atomic_init();
 	ofi_perf_init();
 	ofi_hook_init();
 	ofi_hmem_init();
@@ -962,6 +964,25 @@ void fi_ini(void)
 			"(default: false)");
 	fi_param_get_bool(NULL, "av_remove_cleanup", &ofi_av_remove_cleanup);
 
+	fi_param_define(NULL, "srx_tag_hash", FI_PARAM_BOOL,
+			"When true, shared receive contexts place tagged "
+			"receives that do not use ignore bits into a hash table "
+			"keyed by tag and source address, instead of searching "
+			"the posted receive list linearly on every incoming "
+			"message.  This reduces matching cost when many "
+			"receives are outstanding.  Receives with ignore bits "
+			"remain in posted order.  (default: false)");
+	fi_param_get_bool(NULL, "srx_tag_hash", &ofi_srx_tag_hash);
+
+	fi_param_define(NULL, "wait_spin_usec", FI_PARAM_INT,
+			"Upper limit in microseconds on how long an fd based "
+			"wait set keeps polling its CQs and counters before "
+			"blocking.  The actual spin time adapts to how quickly "
+			"recent waits were satisfied, and drops to zero when "
+			"events arrive less often than this limit.  "
+			"(default: 0, always block)");
+	fi_param_get_int(NULL, "wait_spin_usec", &ofi_wait_spin_usec);
+
 	fi_param_define(NULL, "offload_coll_provider", FI_PARAM_STRING,
 			"The name of a colective offload provider (default: \
 			empty - no provider)");
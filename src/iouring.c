@@ -35,8 +35,38 @@
 
 #include <liburing.h>
 
+#include <ofi_iov.h>
+#include <ofi_mem.h>
 #include <ofi_net.h>
 
+#ifdef HAVE_LIBURING_FIXED
+static void ofi_sockctx_uring_set_file(struct ofi_sockapi_uring *uring,
+				       struct io_uring_sqe *sqe,
+				       struct ofi_sockctx *ctx)
+{
+	if (ctx->uring_fixed < 0)
+		return;
+
+	sqe->fd = ctx->uring_fixed;
+	sqe->flags |= IOSQE_FIXED_FILE;
+	uring->send_fixed_file_cnt++;
+}
+
+static bool ofi_sockctx_uring_fixed_buf(struct ofi_sockapi_uring *uring,
+					struct ofi_sockctx *ctx,
+					const void *buf, size_t len)
+{
+	struct iovec *iov;
+
+	if (ctx->uring_fixed < 0)
+		return false;
+
+	iov = &uring->fixed_bufs[ctx->uring_fixed];
+	return (const char *) buf >= (char *) iov->iov_base &&
+	       (const char *) buf + len <= (char *) iov->iov_base + iov->iov_len;
+}
+#endif
+
 int ofi_sockapi_connect_uring(struct ofi_sockapi *sockapi, SOCKET sock,
 			      const struct sockaddr *addr, socklen_t addrlen,
 			      struct ofi_sockctx *ctx)
@@ -92,14 +122,32 @@ ssize_t ofi_sockapi_send_uring(struct ofi_sockapi *sockapi, SOCKET sock,
 	if (ctx->uring_sqe_inuse || uring->credits == 0)
 		return -FI_EAGAIN;
 
-	/* MSG_NOSIGNAL would return ENOTSUP with io_uring */
-	flags &= ~MSG_NOSIGNAL;
+	/* MSG_NOSIGNAL would return ENOTSUP with io_uring.  Zero-copy is
+	 * selected by size below, and does not use the socket error queue.
+	 */
+	flags &= ~(MSG_NOSIGNAL | OFI_ZEROCOPY);
 
 	sqe = io_uring_get_sqe(uring->io_uring);
 	if (!sqe)
 		return -FI_EOVERFLOW;
 
+#ifdef HAVE_LIBURING_FIXED
+	if (len > uring->zc_size) {
+		io_uring_prep_send_zc(sqe, sock, buf, len, flags, 0);
+		ctx->uring_zc = true;
+		uring->send_zc_cnt++;
+	} else if (!flags && ofi_sockctx_uring_fixed_buf(uring, ctx, buf, len)) {
+		io_uring_prep_write_fixed(sqe, sock, buf, (unsigned int) len,
+					  0, ctx->uring_fixed);
+		uring->send_fixed_buf_cnt++;
+	} else {
+		io_uring_prep_send(sqe, sock, buf, len, flags);
+	}
+	ofi_sockctx_uring_set_file(uring, sqe, ctx);
+#else
 	io_uring_prep_send(sqe, sock, buf, len, flags);
+#endif
+	uring->send_cnt++;
 	io_uring_sqe_set_data(sqe, ctx);
 	ctx->uring_sqe_inuse = true;
 	uring->credits--;
@@ -117,14 +165,30 @@ ssize_t ofi_sockapi_sendv_uring(struct ofi_sockapi *sockapi, SOCKET sock,
 	if (ctx->uring_sqe_inuse || uring->credits == 0)
 		return -FI_EAGAIN;
 
-	/* MSG_NOSIGNAL would return ENOTSUP with io_uring */
-	flags &= ~MSG_NOSIGNAL;
+	/* See ofi_sockapi_send_uring() */
+	flags &= ~(MSG_NOSIGNAL | OFI_ZEROCOPY);
 
 	sqe = io_uring_get_sqe(uring->io_uring);
 	if (!sqe)
 		return -FI_EOVERFLOW;
 
+#ifdef HAVE_LIBURING_FIXED
+	if (ofi_total_iov_len(iov, cnt) > uring->zc_size) {
+		/* The message header is read when the request is submitted */
+		memset(&ctx->uring_msg, 0, sizeof(ctx->uring_msg));
+		ctx->uring_msg.msg_iov = (struct iovec *) iov;
+		ctx->uring_msg.msg_iovlen = cnt;
+		io_uring_prep_sendmsg_zc(sqe, sock, &ctx->uring_msg, flags);
+		ctx->uring_zc = true;
+		uring->send_zc_cnt++;
+	} else {
+		io_uring_prep_writev(sqe, sock, iov, cnt, flags);
+	}
+	ofi_sockctx_uring_set_file(uring, sqe, ctx);
+#else
 	io_uring_prep_writev(sqe, sock, iov, cnt, flags);
+#endif
+	uring->send_cnt++;
 	io_uring_sqe_set_data(sqe, ctx);
 	ctx->uring_sqe_inuse = true;
 	uring->credits--;
@@ -252,3 +316,217 @@ int ofi_uring_destroy(ofi_io_uring_t *io_uring)
 	return 0;
 }
 
+
+#ifdef HAVE_LIBURING_FIXED
+/*
+ * Reserve cnt sparse slots in the registered file and buffer tables.  Each
+ * socket registered through ofi_sockctx_uring_register() gets one slot,
+ * holding its file and optionally a staging buffer.  The tables are
+ * released with the ring.
+ */
+int ofi_uring_init_fixed(struct ofi_sockapi_uring *uring, unsigned int cnt)
+{
+	int ret;
+
+	if (!cnt)
+		return -FI_EINVAL;
+
+	uring->fixed_free = calloc(cnt, sizeof(*uring->fixed_free));
+	uring->fixed_bufs = calloc(cnt, sizeof(*uring->fixed_bufs));
+	if (!uring->fixed_free || !uring->fixed_bufs) {
+		ret = -FI_ENOMEM;
+		goto free;
+	}
+
+	ret = io_uring_register_files_sparse(uring->io_uring, cnt);
+	if (ret)
+		goto free;
+
+	ret = io_uring_register_buffers_sparse(uring->io_uring, cnt);
+	if (ret) {
+		(void) io_uring_unregister_files(uring->io_uring);
+		goto free;
+	}
+
+	for (uring->fixed_free_cnt = 0; uring->fixed_free_cnt < cnt;
+	     uring->fixed_free_cnt++)
+		uring->fixed_free[uring->fixed_free_cnt] =
+			cnt - uring->fixed_free_cnt - 1;
+	return 0;
+
+free:
+	free(uring->fixed_bufs);
+	free(uring->fixed_free);
+	uring->fixed_bufs = NULL;
+	uring->fixed_free = NULL;
+	return ret;
+}
+
+void ofi_uring_cleanup_fixed(struct ofi_sockapi_uring *uring)
+{
+	free(uring->fixed_bufs);
+	free(uring->fixed_free);
+	uring->fixed_bufs = NULL;
+	uring->fixed_free = NULL;
+	uring->fixed_free_cnt = 0;
+}
+
+int ofi_sockctx_uring_register(struct ofi_sockapi_uring *uring,
+			       struct ofi_sockctx *ctx, SOCKET sock,
+			       void *buf, size_t len)
+{
+	struct iovec iov = { .iov_base = buf, .iov_len = len };
+	__u64 tag = 0;
+	int ret, slot;
+
+	assert(ctx->uring_fixed < 0);
+	if (!uring->fixed_free_cnt)
+		return -FI_ENOSPC;
+
+	slot = uring->fixed_free[uring->fixed_free_cnt - 1];
+	ret = io_uring_register_files_update(uring->io_uring, slot, &sock, 1);
+	if (ret < 0)
+		return ret;
+
+	/* Pinning may fail, e.g. on RLIMIT_MEMLOCK.  The file is still used. */
+	if (buf && io_uring_register_buffers_update_tag(uring->io_uring, slot,
+							&iov, &tag, 1) == 1)
+		uring->fixed_bufs[slot] = iov;
+
+	uring->fixed_free_cnt--;
+	ctx->uring_fixed = slot;
+	return 0;
+}
+
+void ofi_sockctx_uring_unregister(struct ofi_sockapi_uring *uring,
+				  struct ofi_sockctx *ctx)
+{
+	struct iovec iov = { 0 };
+	__u64 tag = 0;
+	int fd = -1;
+
+	if (ctx->uring_fixed < 0)
+		return;
+
+	/* The registered file holds a reference to the socket */
+	(void) io_uring_register_files_update(uring->io_uring,
+					      ctx->uring_fixed, &fd, 1);
+	if (uring->fixed_bufs[ctx->uring_fixed].iov_base) {
+		(void) io_uring_register_buffers_update_tag(uring->io_uring,
+							    ctx->uring_fixed,
+							    &iov, &tag, 1);
+		uring->fixed_bufs[ctx->uring_fixed] = iov;
+	}
+
+	uring->fixed_free[uring->fixed_free_cnt++] = ctx->uring_fixed;
+	ctx->uring_fixed = -1;
+}
+#endif
+
+#ifdef HAVE_LIBURING_BUFRING
+int ofi_bufring_init(struct ofi_bufring *bufring, ofi_io_uring_t *io_uring,
+		     unsigned int cnt, size_t buf_size, int bgid)
+{
+	unsigned int i;
+	int ret;
+
+	/* The kernel limits a buffer ring to 32K power of two entries */
+	if (!cnt || cnt > 32768 || (cnt & (cnt - 1)) || !buf_size ||
+	    buf_size > UINT32_MAX)
+		return -FI_EINVAL;
+
+	bufring->bufs = calloc(cnt, sizeof(*bufring->bufs));
+	if (!bufring->bufs)
+		return -FI_ENOMEM;
+
+	ret = ofi_memalign((void **) &bufring->data, ofi_get_page_size(),
+			   cnt * buf_size);
+	if (ret) {
+		ret = -FI_ENOMEM;
+		goto free_bufs;
+	}
+
+	bufring->ring = io_uring_setup_buf_ring(io_uring, cnt, bgid, 0, &ret);
+	if (!bufring->ring)
+		goto free_data;
+
+	bufring->io_uring = io_uring;
+	bufring->buf_size = buf_size;
+	bufring->cnt = cnt;
+	bufring->avail = 0;
+	bufring->bgid = bgid;
+
+	for (i = 0; i < cnt; i++)
+		ofi_bufring_put(bufring, &bufring->bufs[i]);
+	return 0;
+
+free_data:
+	ofi_freealign(bufring->data);
+free_bufs:
+	free(bufring->bufs);
+	return ret;
+}
+
+void ofi_bufring_cleanup(struct ofi_bufring *bufring)
+{
+	io_uring_free_buf_ring(bufring->io_uring, bufring->ring,
+			       bufring->cnt, bufring->bgid);
+	ofi_freealign(bufring->data);
+	free(bufring->bufs);
+}
+
+void ofi_bufring_put(struct ofi_bufring *bufring, struct ofi_bufring_buf *buf)
+{
+	unsigned short bid = (unsigned short) (buf - bufring->bufs);
+
+	assert(bufring->avail < bufring->cnt);
+	io_uring_buf_ring_add(bufring->ring,
+			      bufring->data + bid * bufring->buf_size,
+			      (unsigned int) bufring->buf_size, bid,
+			      io_uring_buf_ring_mask(bufring->cnt), 0);
+	io_uring_buf_ring_advance(bufring->ring, 1);
+	bufring->avail++;
+}
+
+struct ofi_bufring_buf *ofi_bufring_get(struct ofi_bufring *bufring,
+					uint32_t cqe_flags, size_t len)
+{
+	struct ofi_bufring_buf *buf;
+
+	assert(cqe_flags & IORING_CQE_F_BUFFER);
+	assert(len <= bufring->buf_size);
+	buf = &bufring->bufs[cqe_flags >> IORING_CQE_BUFFER_SHIFT];
+	buf->offset = 0;
+	buf->len = (uint32_t) len;
+	assert(bufring->avail);
+	bufring->avail--;
+	return buf;
+}
+
+/*
+ * A multishot receive stays armed until it fails (e.g. -ENOBUFS when the
+ * ring runs dry) or the connection is closed.  Each completion carries the
+ * id of the buffer that the kernel filled.
+ */
+int ofi_sockctx_uring_recv_multishot(struct ofi_sockapi_uring *uring,
+				     SOCKET sock, struct ofi_bufring *bufring,
+				     struct ofi_sockctx *ctx)
+{
+	struct io_uring_sqe *sqe;
+
+	if (ctx->uring_sqe_inuse || uring->credits == 0)
+		return -FI_EAGAIN;
+
+	sqe = io_uring_get_sqe(uring->io_uring);
+	if (!sqe)
+		return -FI_EOVERFLOW;
+
+	io_uring_prep_recv_multishot(sqe, sock, NULL, 0, 0);
+	sqe->flags |= IOSQE_BUFFER_SELECT;
+	sqe->buf_group = bufring->bgid;
+	io_uring_sqe_set_data(sqe, ctx);
+	ctx->uring_sqe_inuse = true;
+	uring->credits--;
+	return -OFI_EINPROGRESS_URING;
+}
+#endif
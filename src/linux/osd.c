@@ -146,6 +146,99 @@ ssize_t ofi_get_hugepage_size(void)
 	return val * 1024;
 }
 
+/* Values from linux/mempolicy.h, see mbind(2) */
+#define OFI_MPOL_PREFERRED	1
+#define OFI_MPOL_INTERLEAVE	3
+#define OFI_NUMA_MAX_NODES	1024
+#define OFI_NUMA_MASK_BITS	(8 * sizeof(unsigned long))
+
+int ofi_numa_node(void)
+{
+	unsigned int cpu, node;
+
+	if (syscall(__NR_getcpu, &cpu, &node, NULL))
+		return -1;
+
+	return (int) node;
+}
+
+/* Parse a sysfs node list, such as "0-1,4", into a node mask */
+static int ofi_numa_parse_nodes(const char *list, unsigned long *mask)
+{
+	int first, last, len, cnt = 0;
+
+	while (sscanf(list, "%d%n", &first, &len) == 1) {
+		list += len;
+		last = first;
+		if (*list == '-') {
+			if (sscanf(++list, "%d%n", &last, &len) != 1)
+				break;
+			list += len;
+		}
+
+		for (; first <= last && first < OFI_NUMA_MAX_NODES; first++) {
+			mask[first / OFI_NUMA_MASK_BITS] |=
+				1UL << (first % OFI_NUMA_MASK_BITS);
+			cnt++;
+		}
+
+		if (*list++ != ',')
+			break;
+	}
+	return cnt;
+}
+
+/*
+ * Set the placement policy of a page aligned range.  Only pages that are
+ * faulted in after the call are affected, so callers bind before first
+ * touch.  Local binding is a preference: allocation falls back to other
+ * nodes rather than failing when the node is out of memory.
+ */
+int ofi_numa_bind(void *addr, size_t len, int policy, int node)
+{
+	unsigned long mask[OFI_NUMA_MAX_NODES / OFI_NUMA_MASK_BITS] = { 0 };
+	char buf[256];
+	int mode, ret;
+
+	switch (policy) {
+	case OFI_NUMA_LOCAL:
+		if (node < 0 || node >= OFI_NUMA_MAX_NODES)
+			return -FI_EINVAL;
+		mask[node / OFI_NUMA_MASK_BITS] = 1UL << (node % OFI_NUMA_MASK_BITS);
+		mode = OFI_MPOL_PREFERRED;
+		break;
+	case OFI_NUMA_INTERLEAVE:
+		ret = fi_read_file("/sys/devices/system/node", "has_memory",
+				   buf, sizeof(buf) - 1);
+		if (ret <= 0)
+			return -FI_ENOENT;
+		buf[ret] = '\0';
+		if (!ofi_numa_parse_nodes(buf, mask))
+			return -FI_EINVAL;
+		mode = OFI_MPOL_INTERLEAVE;
+		break;
+	default:
+		return -FI_EINVAL;
+	}
+
+	/* the kernel reads maxnode - 1 bits */
+	ret = syscall(__NR_mbind, addr, len, mode, mask,
+		      OFI_NUMA_MAX_NODES + 1, 0);
+	return ret ? -errno : 0;
+}
+
+/* Returns the node backing a resident page, or -1 */
+int ofi_numa_addr_node(const void *addr)
+{
+	void *page = (void *) addr;
+	int status;
+
+	if (syscall(__NR_move_pages, 0, 1, &page, NULL, &status, 0))
+		return -1;
+
+	return status >= 0 ? status : -1;
+}
+
 #ifdef HAVE_ETHTOOL
 
 #if HAVE_DECL_ETHTOOL_CMD_SPEED